@@ -16,14 +16,14 @@
 #include <sys/mman.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <time.h>
 
 #include "utils.h"
 #include "config.h"
+#include "snd_convert.h"
 
 #include <pthread.h>
 
-extern pthread_mutex_t audio_mutex;
-
 ///////////////////////////////
 
 void LOG_note(int level, const char* fmt, ...) {
@@ -182,11 +182,9 @@ static struct SND_Context {
 	SND_Frame* buffer;	// buf
 	size_t frame_count; // buf_len
 
-	int frame_in;	  // buf_w
-	int frame_out;	  // buf_r
-	int frame_filled; // max_buf_w
+	SNDRing ring; // buffer, fed by the emulation thread, drained by the SDL audio thread
 
-	int device_id; // SDL device id
+	int device_id __attribute__((aligned(SND_RING_CACHELINE))); // SDL device id
 } snd = {0};
 
 ///////////////////////////////
@@ -196,6 +194,7 @@ static int _;
 static double current_fps = SCREEN_FPS;
 static int fps_counter = 0;
 PerfProfile perf = {0};
+const int perf_pacing_bucket_us[PERF_PACING_BUCKETS] = {50, 100, 250, 500, 1000, 2000, 4000, INT32_MAX};
 
 int currentshaderpass = 0;
 int currentshadersrcw = 0;
@@ -240,6 +239,9 @@ int GFX_loadSystemFont(const char* fontPath) {
 	if (!TTF_WasInit())
 		TTF_Init();
 
+	// cached glyphs are keyed by font, which is about to be freed
+	GFX_flushGlyphCache();
+
 	TTF_CloseFont(font.xlarge);
 	TTF_CloseFont(font.title);
 	TTF_CloseFont(font.large);
@@ -369,6 +371,7 @@ SDL_Surface* GFX_init(int mode) {
 	return gfx.screen;
 }
 void GFX_quit(void) {
+	GFX_flushGlyphCache();
 	TTF_CloseFont(font.large);
 	TTF_CloseFont(font.medium);
 	TTF_CloseFont(font.small);
@@ -527,6 +530,7 @@ void GFX_flip(SDL_Surface* screen) {
 		double elapsed_time_s = (double)frame_duration / performance_frequency;
 		double frame_ms = elapsed_time_s * 1000.0;
 		//LOG_info("GFX_flip: Frame time before flip: %.2f ms\n", frame_ms);
+		perf.busy_ms = frame_ms;
 	}
 	PLAT_flip(screen, 0);
 
@@ -583,6 +587,7 @@ void GFX_GL_Swap() {
 		double elapsed_time_s = (double)frame_duration / performance_frequency;
 		double frame_ms = elapsed_time_s * 1000.0;
 		//LOG_info("GFX_GL_Swap: Frame time before flip: %.2f ms\n", frame_ms);
+		perf.busy_ms = frame_ms;
 	}
 	PLAT_GL_Swap();
 
@@ -646,26 +651,83 @@ void GFX_sync(void) {
 	}
 }
 
+// Frame pacer: sleep on an absolute deadline, then spin only for the wake-up
+// slack this device has been measured to need. Slack grows quickly when a
+// sleep overshoots and decays slowly while wake-ups stay early, so a quiet
+// system spins for tens of microseconds instead of a fixed 2ms.
+#define PACER_SLACK_MIN_NS 50000LL
+#define PACER_SLACK_MAX_NS 4000000LL
+#define PACER_SLACK_INITIAL_NS 1000000LL
+#define PACER_SLACK_MARGIN_NS 20000LL
+
+static struct {
+	int64_t slack_ns;
+	double spin_ns; // moving average
+} pacer = {PACER_SLACK_INITIAL_NS, 0.0};
+
+static int64_t pacer_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+static void pacer_learn(int64_t oversleep_ns) {
+	int64_t want = oversleep_ns + PACER_SLACK_MARGIN_NS;
+	if (want > pacer.slack_ns)
+		pacer.slack_ns += (want - pacer.slack_ns) / 2;
+	else
+		pacer.slack_ns -= (pacer.slack_ns - want) / 64;
+	pacer.slack_ns = MAX(PACER_SLACK_MIN_NS, MIN(PACER_SLACK_MAX_NS, pacer.slack_ns));
+}
+static void pacer_record(int64_t late_ns, int64_t spin_ns) {
+	int late_us = late_ns > 0 ? (int)(MIN(late_ns / 1000, INT32_MAX)) : 0;
+	int bucket = 0;
+	while (bucket < PERF_PACING_BUCKETS - 1 && late_us >= perf_pacing_bucket_us[bucket])
+		bucket++;
+	perf.pacing_hist[bucket]++;
+
+	pacer.spin_ns = pacer.spin_ns * 0.95 + spin_ns * 0.05;
+	perf.pacing_spin_us = pacer.spin_ns / 1000.0;
+	perf.pacing_slack_us = pacer.slack_ns / 1000.0;
+}
+static void pacer_wait(int64_t deadline_ns) {
+	int64_t wake_ns = deadline_ns - pacer.slack_ns;
+	int64_t now = pacer_now();
+	if (now < wake_ns) {
+		struct timespec ts = {wake_ns / 1000000000LL, wake_ns % 1000000000LL};
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+			;
+		now = pacer_now();
+		pacer_learn(now - wake_ns);
+	}
+
+	int64_t spin_start = now;
+	while (now < deadline_ns)
+		now = pacer_now();
+	pacer_record(now - deadline_ns, now - spin_start);
+}
+
 void GFX_flip_fixed_rate(SDL_Surface* screen, double target_fps) {
 	if (target_fps == 0.0)
 		target_fps = SCREEN_FPS;
-	double frame_budget_ms = 1000.0 / target_fps;
 
 	static int64_t frame_index = -1;
 	static int64_t first_frame_start_time = 0;
 	static double last_target_fps = 0.0;
 
 	int64_t perf_freq = SDL_GetPerformanceFrequency();
-	int64_t now = SDL_GetPerformanceCounter();
+	int64_t now = pacer_now();
+	perf.busy_ms = (double)(SDL_GetPerformanceCounter() - per_frame_start) * 1000.0 / perf_freq;
 
 	if (++frame_index == 0 || target_fps != last_target_fps) {
+		if (target_fps != last_target_fps)
+			memset(perf.pacing_hist, 0, sizeof(perf.pacing_hist));
 		frame_index = 0;
 		first_frame_start_time = now;
 		last_target_fps = target_fps;
 	}
 
-	int64_t frame_duration = perf_freq / target_fps;
-	int64_t time_of_frame = first_frame_start_time + frame_index * frame_duration;
+	double frame_duration = 1e9 / target_fps;
+	int64_t time_of_frame = first_frame_start_time + (int64_t)(frame_index * frame_duration);
 	int64_t offset = now - time_of_frame;
 	const int max_lost_frames = 2;
 
@@ -682,25 +744,14 @@ void GFX_flip_fixed_rate(SDL_Surface* screen, double target_fps) {
 			last_target_fps = 0.0;
 			LOG_debug("%s: lost sync by more than %d frames (late) @%llu -> reset\n\n", __FUNCTION__, max_lost_frames, SDL_GetPerformanceCounter());
 		}
+		pacer_record(offset, 0);
 	} else {
 		if (offset < -max_lost_frames * frame_duration) {
 			frame_index = -1;
 			last_target_fps = 0.0;
 			LOG_debug("%s: lost sync by more than %d frames (early ?!) @%llu -> reset\n\n", __FUNCTION__, max_lost_frames, SDL_GetPerformanceCounter());
 		} else if (offset < 0) {
-			useconds_t time_to_sleep_us = (useconds_t)((time_of_frame - now) * 1e6 / perf_freq);
-
-			// The OS scheduling algorithm cannot guarantee that
-			// the sleep will last the exact amount of requested time.
-			// We sleep as much as we can using the OS primitive.
-			const useconds_t min_waiting_time = 2000;
-			if (time_to_sleep_us > min_waiting_time) {
-				usleep(time_to_sleep_us - min_waiting_time);
-			}
-
-			while (SDL_GetPerformanceCounter() < time_of_frame) {
-				// nothing...
-			}
+			pacer_wait(time_of_frame);
 		}
 	}
 	PLAT_GL_Swap();
@@ -764,14 +815,13 @@ FALLBACK_IMPLEMENTATION void PLAT_setEffectColor(int next_color) {}
 int GFX_truncateText(TTF_Font* font, const char* in_name, char* out_name, int max_width, int padding) {
 	int text_width;
 	strcpy(out_name, in_name);
-	TTF_SizeUTF8(font, out_name, &text_width, NULL);
-	text_width += padding;
+	// measured from cached glyph advances, a TTF_SizeUTF8 layout per dropped char adds up
+	text_width = GFX_sizeGlyphs(font, out_name) + padding;
 
 	while (text_width > max_width) {
 		int len = strlen(out_name);
 		strcpy(&out_name[len - 4], "...\0");
-		TTF_SizeUTF8(font, out_name, &text_width, NULL);
-		text_width += padding;
+		text_width = GFX_sizeGlyphs(font, out_name) + padding;
 	}
 
 	return text_width;
@@ -779,16 +829,15 @@ int GFX_truncateText(TTF_Font* font, const char* in_name, char* out_name, int ma
 int GFX_getTextHeight(TTF_Font* font, const char* in_name, char* out_name, int max_width, int padding) {
 	int text_height;
 	strcpy(out_name, in_name);
-	TTF_SizeUTF8(font, out_name, NULL, &text_height);
-	text_height += padding;
+	// a single line is always the font's height, no need to lay it out
+	text_height = TTF_FontHeight(font) + padding;
 
 	return text_height;
 }
 int GFX_getTextWidth(TTF_Font* font, const char* in_name, char* out_name, int max_width, int padding) {
 	int text_width;
 	strcpy(out_name, in_name);
-	TTF_SizeUTF8(font, out_name, &text_width, NULL);
-	text_width += padding;
+	text_width = GFX_sizeGlyphs(font, out_name) + padding;
 
 	return text_width;
 }
@@ -802,7 +851,7 @@ int GFX_wrapText(TTF_Font* font, char* str, int max_width, int max_lines) {
 	char* line = str;
 	char buffer[MAX_PATH];
 
-	TTF_SizeUTF8(font, line, &line_width, NULL);
+	line_width = GFX_sizeGlyphs(font, line);
 	if (line_width <= max_width) {
 		line_width = GFX_truncateText(font, line, buffer, max_width, 0);
 		strcpy(line, buffer);
@@ -817,7 +866,7 @@ int GFX_wrapText(TTF_Font* font, char* str, int max_width, int max_lines) {
 		tmp = strchr(tmp, ' ');
 		if (!tmp) {
 			if (prev) {
-				TTF_SizeUTF8(font, line, &line_width, NULL);
+				line_width = GFX_sizeGlyphs(font, line);
 				if (line_width >= max_width) {
 					if (line_width > max_line_width)
 						max_line_width = line_width;
@@ -829,7 +878,7 @@ int GFX_wrapText(TTF_Font* font, char* str, int max_width, int max_lines) {
 		}
 		tmp[0] = '\0';
 
-		TTF_SizeUTF8(font, line, &line_width, NULL);
+		line_width = GFX_sizeGlyphs(font, line);
 
 		if (line_width >= max_width) { // wrap
 			if (line_width > max_line_width)
@@ -1916,8 +1965,7 @@ void GFX_sizeText(TTF_Font* font, const char* str, int leading, int* w, int* h)
 		}
 
 		if (len) {
-			int lw;
-			TTF_SizeUTF8(font, line, &lw, NULL);
+			int lw = GFX_sizeGlyphs(font, line);
 			if (lw > mw)
 				mw = lw;
 		}
@@ -1941,7 +1989,6 @@ void GFX_blitText(TTF_Font* font, const char* str, int leading, SDL_Color color,
 	int x = dst_rect->x;
 	int y = dst_rect->y;
 
-	SDL_Surface* text;
 	char line[256];
 	for (int i = 0; i < count; i++) {
 		int len;
@@ -1956,11 +2003,223 @@ void GFX_blitText(TTF_Font* font, const char* str, int leading, SDL_Color color,
 		}
 
 		if (len) {
-			text = TTF_RenderUTF8_Blended(font, line, color);
-			SDL_BlitSurface(text, NULL, dst, &(SDL_Rect){x + ((dst_rect->w - text->w) / 2), y + (i * leading)});
+			int lw = GFX_sizeGlyphs(font, line);
+			GFX_blitGlyphs(font, line, color, dst, x + ((dst_rect->w - lw) / 2), y + (i * leading), 0);
+		}
+	}
+}
+
+///////////////////////////////
+
+// Glyph cache. Each (font, codepoint) is rasterized once in white into an
+// atlas page and text is composed from those cells with a color mod, so
+// redrawing the same list or now-playing screen every frame doesn't go
+// through SDL_ttf or allocate a surface per string.
+
+#define GLYPH_PAGE_SIZE 512
+#define GLYPH_MAX_PAGES 4
+#define GLYPH_TABLE_SIZE 4096 // power of two, flushed at 3/4 load
+
+typedef struct {
+	TTF_Font* font; // NULL = empty slot
+	uint32_t codepoint;
+	int16_t page;
+	int16_t x, y, w, h;
+	int16_t advance;
+} Glyph;
+
+static struct {
+	Glyph table[GLYPH_TABLE_SIZE];
+	int count;
+	SDL_Surface* pages[GLYPH_MAX_PAGES];
+	int page_count;
+	int shelf_x, shelf_y, shelf_h; // packing cursor in the last page
+} glyphs;
+
+void GFX_flushGlyphCache(void) {
+	for (int i = 0; i < glyphs.page_count; i++)
+		SDL_FreeSurface(glyphs.pages[i]);
+	memset(&glyphs, 0, sizeof(glyphs));
+}
+
+static uint32_t GFX_decodeUTF8(const char** str) {
+	const uint8_t* s = (const uint8_t*)*str;
+	uint32_t c = *s++;
+	int extra = 0;
+	if (c >= 0xF0) {
+		c &= 0x07;
+		extra = 3;
+	} else if (c >= 0xE0) {
+		c &= 0x0F;
+		extra = 2;
+	} else if (c >= 0xC0) {
+		c &= 0x1F;
+		extra = 1;
+	} else if (c >= 0x80) {
+		c = 0xFFFD; // stray continuation byte
+	}
+	while (extra-- > 0) {
+		if ((*s & 0xC0) != 0x80) {
+			c = 0xFFFD; // truncated sequence, don't eat the next char
+			break;
+		}
+		c = (c << 6) | (*s++ & 0x3F);
+	}
+	*str = (const char*)s;
+	return c;
+}
+
+static int GFX_glyphAdvance(TTF_Font* font, uint32_t c) {
+	int advance = 0;
+#if defined(SDL_TTF_COMPILEDVERSION) && SDL_TTF_COMPILEDVERSION >= SDL_VERSIONNUM(2, 0, 18)
+	TTF_GlyphMetrics32(font, c, NULL, NULL, NULL, NULL, &advance);
+#else
+	TTF_GlyphMetrics(font, c > 0xFFFF ? 0xFFFD : (Uint16)c, NULL, NULL, NULL, NULL, &advance);
+#endif
+	return advance;
+}
+
+static int GFX_glyphKerning(TTF_Font* font, uint32_t prev, uint32_t c) {
+	if (!prev)
+		return 0;
+#if defined(SDL_TTF_COMPILEDVERSION) && SDL_TTF_COMPILEDVERSION >= SDL_VERSIONNUM(2, 0, 18)
+	return TTF_GetFontKerningSizeGlyphs32(font, prev, c);
+#else
+	return TTF_GetFontKerningSizeGlyphs(font, prev > 0xFFFF ? 0xFFFD : (Uint16)prev, c > 0xFFFF ? 0xFFFD : (Uint16)c);
+#endif
+}
+
+// reserves a w x h cell in the atlas, returns the page or -1 if it's full
+static int GFX_packGlyph(int w, int h, int* x, int* y) {
+	if (w > GLYPH_PAGE_SIZE || h > GLYPH_PAGE_SIZE)
+		return -1;
+	if (glyphs.page_count && glyphs.shelf_x + w > GLYPH_PAGE_SIZE) {
+		glyphs.shelf_x = 0;
+		glyphs.shelf_y += glyphs.shelf_h;
+		glyphs.shelf_h = 0;
+	}
+	if (!glyphs.page_count || glyphs.shelf_y + h > GLYPH_PAGE_SIZE) {
+		if (glyphs.page_count == GLYPH_MAX_PAGES)
+			return -1;
+		SDL_Surface* page = SDL_CreateRGBSurfaceWithFormat(0, GLYPH_PAGE_SIZE, GLYPH_PAGE_SIZE, 32, SDL_PIXELFORMAT_ARGB8888);
+		if (!page)
+			return -1;
+		SDL_SetSurfaceBlendMode(page, SDL_BLENDMODE_BLEND);
+		glyphs.pages[glyphs.page_count++] = page;
+		glyphs.shelf_x = glyphs.shelf_y = glyphs.shelf_h = 0;
+	}
+	*x = glyphs.shelf_x;
+	*y = glyphs.shelf_y;
+	glyphs.shelf_x += w;
+	if (h > glyphs.shelf_h)
+		glyphs.shelf_h = h;
+	return glyphs.page_count - 1;
+}
+
+static Glyph* GFX_getGlyph(TTF_Font* font, uint32_t c) {
+	uint32_t hash = (uint32_t)(((uintptr_t)font >> 4) * 2654435761u) ^ (c * 40503u);
+	for (int probe = 0;; probe++) {
+		Glyph* g = &glyphs.table[(hash + probe) & (GLYPH_TABLE_SIZE - 1)];
+		if (g->font == font && g->codepoint == c)
+			return g;
+		if (g->font)
+			continue;
+
+		// miss, rasterize it once in white (color is applied at blit time)
+		if (glyphs.count >= GLYPH_TABLE_SIZE * 3 / 4) {
+			GFX_flushGlyphCache();
+			return GFX_getGlyph(font, c);
+		}
+
+		char utf8[5] = {0};
+		if (c < 0x80) {
+			utf8[0] = c;
+		} else if (c < 0x800) {
+			utf8[0] = 0xC0 | (c >> 6);
+			utf8[1] = 0x80 | (c & 0x3F);
+		} else if (c < 0x10000) {
+			utf8[0] = 0xE0 | (c >> 12);
+			utf8[1] = 0x80 | ((c >> 6) & 0x3F);
+			utf8[2] = 0x80 | (c & 0x3F);
+		} else {
+			utf8[0] = 0xF0 | (c >> 18);
+			utf8[1] = 0x80 | ((c >> 12) & 0x3F);
+			utf8[2] = 0x80 | ((c >> 6) & 0x3F);
+			utf8[3] = 0x80 | (c & 0x3F);
+		}
+
+		g->font = font;
+		g->codepoint = c;
+		g->page = -1;
+		g->w = g->h = 0;
+		g->advance = GFX_glyphAdvance(font, c);
+		glyphs.count += 1;
+
+		// rendering the single char string keeps SDL_ttf's own baseline and bearing
+		SDL_Surface* text = (c == ' ') ? NULL : TTF_RenderUTF8_Blended(font, utf8, COLOR_WHITE);
+		if (text) {
+			int x, y;
+			int page = GFX_packGlyph(text->w, text->h, &x, &y);
+			if (page < 0 && glyphs.page_count == GLYPH_MAX_PAGES) {
+				// atlas is full, start over with this glyph
+				SDL_FreeSurface(text);
+				GFX_flushGlyphCache();
+				return GFX_getGlyph(font, c);
+			}
+			if (page >= 0) {
+				SDL_SetSurfaceBlendMode(text, SDL_BLENDMODE_NONE);
+				SDL_BlitSurface(text, NULL, glyphs.pages[page], &(SDL_Rect){x, y, text->w, text->h});
+				g->page = page;
+				g->x = x;
+				g->y = y;
+				g->w = text->w;
+				g->h = text->h;
+			}
 			SDL_FreeSurface(text);
 		}
+		return g;
+	}
+}
+
+int GFX_sizeGlyphs(TTF_Font* font, const char* str) {
+	if (!font || !str)
+		return 0;
+	int w = 0;
+	uint32_t prev = 0;
+	while (*str) {
+		uint32_t c = GFX_decodeUTF8(&str);
+		if (c == '\n')
+			break;
+		w += GFX_glyphKerning(font, prev, c) + GFX_getGlyph(font, c)->advance;
+		prev = c;
 	}
+	return w;
+}
+
+int GFX_blitGlyphs(TTF_Font* font, const char* str, SDL_Color color, SDL_Surface* dst, int x, int y, int max_width) {
+	if (!font || !str || !dst)
+		return 0;
+	int limit = max_width > 0 ? x + max_width : INT32_MAX;
+	int pen = x;
+	uint32_t prev = 0;
+	while (*str && pen < limit) {
+		uint32_t c = GFX_decodeUTF8(&str);
+		if (c == '\n')
+			break;
+		pen += GFX_glyphKerning(font, prev, c);
+		Glyph* g = GFX_getGlyph(font, c);
+		if (g->page >= 0) {
+			// set per glyph, a flush mid string may have replaced the page
+			SDL_Surface* page = glyphs.pages[g->page];
+			SDL_SetSurfaceColorMod(page, color.r, color.g, color.b);
+			SDL_SetSurfaceAlphaMod(page, color.a);
+			SDL_Rect src = {g->x, g->y, MIN(g->w, limit - pen), g->h};
+			SDL_BlitSurface(page, &src, dst, &(SDL_Rect){pen, y, 0, 0});
+		}
+		pen += g->advance;
+		prev = c;
+	}
+	return MIN(pen, limit) - x;
 }
 
 SDL_Color GFX_mapColor(uint32_t c) {
@@ -1982,7 +2241,10 @@ SDL_Color GFX_mapColor(uint32_t c) {
 
 #define ms SDL_GetTicks
 
-pthread_mutex_t audio_mutex = PTHREAD_MUTEX_INITIALIZER;
+// occupancy as seen from either side, safe to call from any thread
+static int SND_framesQueued(void) {
+	return SNDRing_queued(&snd.ring);
+}
 
 static void SND_audioCallback(void* userdata, uint8_t* stream, int len) {
 	if (snd.frame_count == 0)
@@ -1990,22 +2252,12 @@ static void SND_audioCallback(void* userdata, uint8_t* stream, int len) {
 	if (!snd.initialized)
 		LOG_error("Calling callback without audio device\n");
 
-	int16_t* out = (int16_t*)stream;
-	len /= (sizeof(int16_t) * 2);
-
-	pthread_mutex_lock(&audio_mutex);
-	while (snd.frame_out != snd.frame_in && len > 0) {
-		*out++ = snd.buffer[snd.frame_out].left;
-		*out++ = snd.buffer[snd.frame_out].right;
-		snd.frame_out += 1;
-		len -= 1;
-		if (snd.frame_out >= snd.frame_count)
-			snd.frame_out = 0;
-	}
-	pthread_mutex_unlock(&audio_mutex);
+	SND_Frame* out = (SND_Frame*)stream;
+	len /= sizeof(SND_Frame);
 
-	if (len > 0)
-		memset(out, 0, len * (sizeof(int16_t) * 2));
+	int count = SNDRing_read(&snd.ring, out, len);
+	if (len > count)
+		memset(out + count, 0, (len - count) * sizeof(SND_Frame));
 }
 static void SND_resizeBuffer(void) { // plat_sound_resize_buffer
 
@@ -2027,8 +2279,8 @@ static void SND_resizeBuffer(void) { // plat_sound_resize_buffer
 
 	memset(snd.buffer, 0, buffer_bytes);
 
-	snd.frame_in = 0;
-	snd.frame_out = 0;
+	// callback is locked out here, nobody else is touching the indices
+	SNDRing_reset(&snd.ring, snd.buffer, snd.frame_count);
 
 #if defined(USE_SDL2)
 	SDL_UnlockAudioDevice(snd.device_id);
@@ -2043,98 +2295,130 @@ void SND_setQuality(int quality) {
 	soundQuality = qualityLevels[quality];
 	resetSrcState = 1;
 }
+// Persistent resampler context. The scratch buffers are sized once from the
+// largest batch SND_batchSamples hands us (see SND_init), so the emulator
+// audio path no longer touches the heap for every BATCH_SIZE chunk.
+static struct SND_Resampler {
+	SRC_STATE* state;
+	double ratio;
+	int in_capacity;  // in input frames
+	int out_capacity; // in output frames
+	float* in;
+	float* out;
+	SND_Frame* frames;
+} resampler = {0};
+
+// SND_batchSamples clamps its buffer adjustment ratio to this
+#define RESAMPLER_MAX_RATIO 1.5
+
+static int SND_reserveResampler(int input_frames, int output_frames) {
+	if (input_frames > resampler.in_capacity) {
+		float* in = realloc(resampler.in, input_frames * 2 * sizeof(float));
+		if (!in)
+			return 0;
+		resampler.in = in;
+		resampler.in_capacity = input_frames;
+	}
+	if (output_frames > resampler.out_capacity) {
+		float* out = realloc(resampler.out, output_frames * 2 * sizeof(float));
+		if (!out)
+			return 0;
+		resampler.out = out;
+		SND_Frame* frames = realloc(resampler.frames, output_frames * sizeof(SND_Frame));
+		if (!frames)
+			return 0;
+		resampler.frames = frames;
+		resampler.out_capacity = output_frames;
+	}
+	return 1;
+}
+static void SND_freeResampler(void) {
+	if (resampler.state)
+		src_delete(resampler.state);
+	free(resampler.in);
+	free(resampler.out);
+	free(resampler.frames);
+	memset(&resampler, 0, sizeof(resampler));
+}
+
+// returned frames point into the resampler scratch, valid until the next call
 ResampledFrames resample_audio(const SND_Frame* input_frames,
 							   int input_frame_count, int input_sample_rate,
 							   int output_sample_rate, double ratio) {
 	int error;
-	static double previous_ratio = 1.0;
-	static SRC_STATE* src_state = NULL;
+	ResampledFrames resampled = {NULL, 0};
 
+	uint64_t start = SDL_GetPerformanceCounter();
 	double final_ratio = ((double)output_sample_rate / input_sample_rate) * ratio;
 
-	if (!src_state || resetSrcState) {
+	if (!resampler.state || resetSrcState) {
 		resetSrcState = 0;
-		src_state = src_new(soundQuality, 2, &error);
-		if (src_state == NULL) {
+		if (resampler.state)
+			src_delete(resampler.state);
+		resampler.state = src_new(soundQuality, 2, &error);
+		if (resampler.state == NULL) {
 			fprintf(stderr, "Error initializing SRC state: %s\n",
 					src_strerror(error));
 			exit(1);
 		}
+		resampler.ratio = 0.0;
 	}
 
-	if (previous_ratio != final_ratio) {
-		if (src_set_ratio(src_state, final_ratio) != 0) {
+	if (resampler.ratio != final_ratio) {
+		if (src_set_ratio(resampler.state, final_ratio) != 0) {
 			fprintf(stderr, "Error setting resampling ratio: %s\n",
-					src_strerror(src_error(src_state)));
+					src_strerror(src_error(resampler.state)));
 			exit(1);
 		}
-		previous_ratio = final_ratio;
+		resampler.ratio = final_ratio;
 	}
 
 	int max_output_frames = (int)(input_frame_count * final_ratio + 1);
 
-	float* input_buffer = (float*)malloc(input_frame_count * 2 * sizeof(float));
-	float* output_buffer = (float*)malloc(max_output_frames * 2 * sizeof(float));
-	if (!input_buffer || !output_buffer) {
+	// only grows if SND_init's estimate was too small, eg. a wild ratio
+	if (!SND_reserveResampler(input_frame_count, max_output_frames)) {
 		fprintf(stderr, "Error allocating buffers\n");
-		free(input_buffer);
-		free(output_buffer);
-		src_delete(src_state);
+		SND_freeResampler();
 		exit(1);
 	}
 
-	for (int i = 0; i < input_frame_count; i++) {
-		input_buffer[2 * i] = input_frames[i].left / 32768.0f;
-		input_buffer[2 * i + 1] = input_frames[i].right / 32768.0f;
-	}
+	SND_s16ToFloat((const int16_t*)input_frames, resampler.in, input_frame_count * 2);
 
 	SRC_DATA src_data = {
-		.data_in = input_buffer,
-		.data_out = output_buffer,
+		.data_in = resampler.in,
+		.data_out = resampler.out,
 		.input_frames = input_frame_count,
 		.output_frames = max_output_frames,
 		.src_ratio = final_ratio,
 		.end_of_input = 0};
 
-	if (src_process(src_state, &src_data) != 0) {
+	if (src_process(resampler.state, &src_data) != 0) {
 		fprintf(stderr, "Error resampling: %s\n",
-				src_strerror(src_error(src_state)));
-		free(input_buffer);
-		free(output_buffer);
+				src_strerror(src_error(resampler.state)));
 		exit(1);
 	}
 
 	int output_frame_count = src_data.output_frames_gen;
+	SND_floatToS16(resampler.out, (int16_t*)resampler.frames, output_frame_count * 2);
 
-	SND_Frame* output_frames = (SND_Frame*)malloc(output_frame_count * sizeof(SND_Frame));
-	if (!output_frames) {
-		fprintf(stderr, "Error allocating output frames\n");
-		free(input_buffer);
-		free(output_buffer);
-		exit(1);
-	}
-
-	for (int i = 0; i < output_frame_count; i++) {
-		float left = output_buffer[2 * i];
-		float right = output_buffer[2 * i + 1];
-
-		left = fmaxf(-1.0f, fminf(1.0f, left));
-		right = fmaxf(-1.0f, fminf(1.0f, right));
+	resampled.frames = resampler.frames;
+	resampled.frame_count = output_frame_count;
 
-		output_frames[i].left = (int16_t)(left * 32767.0f);
-		output_frames[i].right = (int16_t)(right * 32767.0f);
+	// exponential moving average, shown in the debug hud
+	if (input_frame_count > 0) {
+		double ns = (double)(SDL_GetPerformanceCounter() - start) * 1e9 / SDL_GetPerformanceFrequency() / input_frame_count;
+		perf.resample_ns = perf.resample_ns > 0.0 ? perf.resample_ns * 0.95 + ns * 0.05 : ns;
 	}
 
-	free(input_buffer);
-	free(output_buffer);
-
-	ResampledFrames resampled;
-	resampled.frames = output_frames;
-	resampled.frame_count = output_frame_count;
-
 	return resampled;
 }
 
+// Producer side only (emulation thread). Returns the number of frames written,
+// whatever doesn't fit is dropped.
+static int SND_writeFrames(const SND_Frame* frames, int count) {
+	return SNDRing_write(&snd.ring, frames, count);
+}
+
 #define ROLLING_AVERAGE_WINDOW_SIZE 120
 static float adjustment_history[ROLLING_AVERAGE_WINDOW_SIZE] = {0.0f};
 static int adjustment_index = 0;
@@ -2185,10 +2469,6 @@ float calculateBufferAdjustment(float remaining_space, float targetbuffer_over,
 	return rolling_average;
 }
 
-static SND_Frame tmpbuffer[BATCH_SIZE];
-static SND_Frame* unwritten_frames = NULL;
-static int unwritten_frame_count = 0;
-
 size_t SND_batchSamples(const SND_Frame* frames, size_t frame_count) {
 	int framecount = (int)frame_count;
 	int consumed = 0;
@@ -2199,25 +2479,7 @@ size_t SND_batchSamples(const SND_Frame* frames, size_t frame_count) {
 		snd.frame_count = 4096; // idk some random samples nr this should never hit tho, just to be safe
 	}
 
-	pthread_mutex_lock(&audio_mutex);
-	if (snd.frame_in < 0 || snd.frame_in >= snd.frame_count) {
-		snd.frame_in = 0;
-	}
-
-	if (snd.frame_out < 0 || snd.frame_out >= snd.frame_count) {
-		snd.frame_out = 0;
-	}
-
-	float remaining_space = 0.0f;
-	int frame_in_snapshot = snd.frame_in;
-	int frame_out_snapshot = snd.frame_out;
-	pthread_mutex_unlock(&audio_mutex);
-
-	if (frame_in_snapshot >= frame_out_snapshot) {
-		remaining_space = snd.frame_count - (frame_in_snapshot - frame_out_snapshot);
-	} else {
-		remaining_space = frame_out_snapshot - frame_in_snapshot;
-	}
+	float remaining_space = snd.frame_count - SND_framesQueued();
 	perf.buffer_free = remaining_space;
 
 	// let audio buffer fill a little first and then unpause audio so no underruns occur
@@ -2267,32 +2529,15 @@ size_t SND_batchSamples(const SND_Frame* frames, size_t frame_count) {
 	while (framecount > 0) {
 		int amount = MIN(BATCH_SIZE, framecount);
 
-		// Copy frames to tmpbuffer for resampling
-		for (int i = 0; i < amount; i++) {
-			tmpbuffer[i] = frames[consumed + i];
-		}
+		ResampledFrames resampled = resample_audio(
+			frames + consumed, amount, snd.sample_rate_in, snd.sample_rate_out, ratio);
 		consumed += amount;
 		framecount -= amount;
 
-		ResampledFrames resampled = resample_audio(
-			tmpbuffer, amount, snd.sample_rate_in, snd.sample_rate_out, ratio);
-
-		int written_frames = 0;
-		pthread_mutex_lock(&audio_mutex);
-		for (int i = 0; i < resampled.frame_count; i++) {
-			// Check if buffer full (leave one slot free)
-			if ((snd.frame_in + 1) % snd.frame_count == snd.frame_out) {
-				// Buffer full, break early
-				break;
-			}
-			snd.buffer[snd.frame_in] = resampled.frames[i];
-			snd.frame_in = (snd.frame_in + 1) % snd.frame_count;
-			written_frames++;
-		}
-		pthread_mutex_unlock(&audio_mutex);
+		// frames that don't fit are dropped, buffer full
+		int written_frames = SND_writeFrames(resampled.frames, resampled.frame_count);
 
 		total_consumed_frames += written_frames;
-		free(resampled.frames);
 	}
 
 	return total_consumed_frames;
@@ -2317,14 +2562,7 @@ size_t SND_batchSamples_fixed_rate(const SND_Frame* frames, size_t frame_count)
 
 	// int full = 0;
 
-	float remaining_space = snd.frame_count;
-	pthread_mutex_lock(&audio_mutex);
-	if (snd.frame_in >= snd.frame_out) {
-		remaining_space = snd.frame_count - (snd.frame_in - snd.frame_out);
-	} else {
-		remaining_space = snd.frame_out - snd.frame_in;
-	}
-	pthread_mutex_unlock(&audio_mutex);
+	float remaining_space = snd.frame_count - SND_framesQueued();
 	// printf("    actual free: %g\n", remaining_space);
 	perf.buffer_free = remaining_space;
 	// let audio buffer fill up a little before playing audio, so no underruns occur. Target fill rate of buffer is about 50% so start playing when about 40% full
@@ -2378,32 +2616,15 @@ size_t SND_batchSamples_fixed_rate(const SND_Frame* frames, size_t frame_count)
 	while (framecount > 0) {
 		int amount = MIN(BATCH_SIZE, framecount);
 
-		for (int i = 0; i < amount; i++) {
-			tmpbuffer[i] = frames[consumed + i];
-		}
+		ResampledFrames resampled = resample_audio(
+			frames + consumed, amount, snd.sample_rate_in, snd.sample_rate_out, ratio);
 		consumed += amount;
 		framecount -= amount;
 
-		ResampledFrames resampled = resample_audio(
-			tmpbuffer, amount, snd.sample_rate_in, snd.sample_rate_out, ratio);
-
-		// Write resampled frames to the buffer
-		int written_frames = 0;
-
-		pthread_mutex_lock(&audio_mutex);
-		for (int i = 0; i < resampled.frame_count; i++) {
-			if ((snd.frame_in + 1) % snd.frame_count == snd.frame_out) {
-				// Buffer is full, break. This should never happen tho, but just to be safe
-				break;
-			}
-			snd.buffer[snd.frame_in] = resampled.frames[i];
-			snd.frame_in = (snd.frame_in + 1) % snd.frame_count;
-			written_frames++;
-		}
-		pthread_mutex_unlock(&audio_mutex);
+		// Write resampled frames to the buffer. Should never be full, but just to be safe
+		int written_frames = SND_writeFrames(resampled.frames, resampled.frame_count);
 
 		total_consumed_frames += written_frames;
-		// No need to free - using static buffers
 	}
 
 	return total_consumed_frames;
@@ -2474,6 +2695,11 @@ void SND_init(double sample_rate, double frame_rate) { // plat_sound_init
 
 	SND_resizeBuffer();
 
+	// size the resampler scratch for the worst case batch up front
+	int max_output_frames = (int)(BATCH_SIZE * ((double)snd.sample_rate_out / MAX(1, snd.sample_rate_in)) * RESAMPLER_MAX_RATIO + 1);
+	if (!SND_reserveResampler(BATCH_SIZE, max_output_frames))
+		LOG_error("SND_init: failed to allocate resampler buffers\n");
+
 	// start with audiodevice paused so buffer can fill a little, snd_batchsamples will unpause it
 	SND_pauseAudio(true);
 	LOG_info("sample rate: %i (req) %i (rec) [samples %i]\n", snd.sample_rate_in, snd.sample_rate_out, SAMPLES);
@@ -2501,9 +2727,11 @@ void SND_quit(void) {
 	snd.initialized = 0;
 
 	if (snd.buffer) {
+		SNDRing_reset(&snd.ring, NULL, 0);
 		free(snd.buffer);
 		snd.buffer = NULL;
 	}
+	SND_freeResampler();
 }
 
 void SND_resetAudio(double sample_rate, double frame_rate) {
@@ -5,6 +5,7 @@
 #include "scaler.h"
 #include "config.h"
 #include "defines.h"
+#include "snd_ring.h"
 #include <stdbool.h>
 
 ///////////////////////////////
@@ -85,6 +86,8 @@ extern uint32_t THEME_COLOR6;
 extern uint32_t THEME_COLOR7;
 extern SDL_Color ALT_BUTTON_TEXT_COLOR;
 
+#define PERF_PACING_BUCKETS 8
+
 typedef struct {
 	float ratio;
 	int buffer_free;
@@ -107,8 +110,18 @@ typedef struct {
 	int frame_drops;
 	double avg_frame_ms;
 	double max_frame_ms;
+	double busy_ms;		   // last frame up to the flip, without pacing
+	double resample_ns; // per input frame, moving average
+	double serialize_ms;   // run-ahead snapshot cost, moving average
+	double unserialize_ms; // run-ahead restore cost, moving average
+	// GFX_flip_fixed_rate() pacing
+	double pacing_slack_us;					 // learned wake-up slack spun through after sleeping
+	double pacing_spin_us;					 // busy-wait per frame, moving average
+	int pacing_hist[PERF_PACING_BUCKETS];	 // lateness past each deadline, see perf_pacing_bucket_us
 } PerfProfile;
 
+extern const int perf_pacing_bucket_us[PERF_PACING_BUCKETS]; // upper bound of each bucket, last is open
+
 extern PerfProfile perf;
 
 // TODO: do we need that many free externs? This should move
@@ -389,6 +402,18 @@ char** GFX_getHardwareHintPairs(IndicatorType show_setting);
 void GFX_assetRect(int asset, SDL_Rect* dst_rect);
 void GFX_sizeText(TTF_Font* font, const char* str, int leading, int* w, int* h);
 void GFX_blitText(TTF_Font* font, const char* str, int leading, SDL_Color color, SDL_Surface* dst, SDL_Rect* dst_rect);
+
+/**
+ * Draws a single line of text from the shared glyph cache instead of
+ * rasterizing it with SDL_ttf. Stops at the first newline.
+ * @param max_width Clip width in pixels, 0 for none
+ * @return Width drawn in pixels
+ */
+int GFX_blitGlyphs(TTF_Font* font, const char* str, SDL_Color color, SDL_Surface* dst, int x, int y, int max_width);
+// Width of a single line of text as GFX_blitGlyphs would draw it
+int GFX_sizeGlyphs(TTF_Font* font, const char* str);
+// Drops every cached glyph, must be called before closing a font that was drawn with
+void GFX_flushGlyphCache(void);
 void GFX_setAmbientColor(const void* data, unsigned width, unsigned height, size_t pitch, int mode);
 
 void GFX_ApplyRoundedCorners(SDL_Surface* surface, SDL_Rect* rect, int radius);
@@ -399,11 +424,6 @@ void GFX_ApplyRoundedCorners_4444(SDL_Surface* surface, SDL_Rect* rect, int radi
 void GFX_ApplyRoundedCorners_8888(SDL_Surface* surface, SDL_Rect* rect, int radius);
 ///////////////////////////////
 
-typedef struct SND_Frame {
-	int16_t left;
-	int16_t right;
-} SND_Frame;
-
 typedef struct {
 	SND_Frame* frames;
 	int frame_count;
@@ -31,6 +31,8 @@
 #define RESUME_SLOT_DEFAULT 8
 #define AUTO_RESUME_SLOT 9
 #define GAME_SWITCHER_PERSIST_PATH SHARED_USERDATA_PATH "/.minui/game_switcher.txt"
+#define ROMINDEX_CACHE_PATH USERDATA_PATH "/romindex.bin" // per platform, installed emu paks differ
+#define THUMB_CACHE_PATH USERDATA_PATH "/.thumbcache" // scaled boxart, per platform screen size
 
 #define FAUX_RECENT_PATH SDCARD_PATH "/Recently Played"
 #define COLLECTIONS_PATH SDCARD_PATH "/Collections"
@@ -39,8 +41,7 @@
 #define CHANGE_DISC_PATH "/tmp/change_disc.txt"
 #define RESUME_SLOT_PATH "/tmp/resume_slot.txt"
 #define NOUI_PATH "/tmp/noui"
-#define EMULIST_CACHE_PATH "/tmp/emulist_cache.txt"
-#define ROMINDEX_CACHE_PATH "/tmp/romindex_cache.txt"
+#define ROMINDEX_CHECKED_PATH "/tmp/romindex_checked" // rom index listed once this boot
 
 #define TRIAD_WHITE 0xff, 0xff, 0xff
 #define TRIAD_BLACK 0x00, 0x00, 0x00
@@ -0,0 +1,141 @@
+#ifndef __FB_MIRROR_H__
+#define __FB_MIRROR_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+//
+//	frame mirror shared between the renderer (producer) and
+//	screenshot/screenrecorder (consumers) through a MAP_SHARED file
+//
+//	layout:	FBMirrorHeader, padded to FB_MIRROR_HEADER_SIZE
+//		FB_MIRROR_SLOTS * frame_size bytes of raw bottom-to-top RGBA
+//
+//	each slot is guarded by a seqlock: the producer makes slot.seq odd,
+//	copies the pixels, makes it even again and only then publishes the
+//	frame number in header.latest. readers copy a slot and retry if its
+//	seq moved, so they never keep a half-written frame and the producer
+//	never waits on them. header.latest doubles as a futex word so readers
+//	can sleep until the next frame instead of polling.
+//
+
+#define FB_MIRROR_PATH "/tmp/fb_mirror.raw"
+#define FB_MIRROR_MAGIC 0x524D4246 // "FBMR"
+#define FB_MIRROR_VERSION 1
+#define FB_MIRROR_SLOTS 3
+#define FB_MIRROR_HEADER_SIZE 4096
+#define FB_MIRROR_READ_RETRIES 8
+
+typedef struct FBMirrorSlot {
+	uint32_t seq;		   // odd while the producer is writing the slot
+	uint32_t frame;		   // frame number held by the slot
+	uint32_t timestamp_ms; // CLOCK_MONOTONIC time of the readback
+	uint32_t reserved;
+} FBMirrorSlot;
+
+typedef struct FBMirrorHeader {
+	uint32_t magic; // written last, once the rest of the header is valid
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t pitch;
+	uint32_t frame_size;
+	uint32_t slot_count;
+	uint32_t latest;  // newest complete frame number, 0 until the first frame (futex word)
+	uint32_t waiters; // readers sleeping on latest
+	uint32_t reserved[7];
+	FBMirrorSlot slots[FB_MIRROR_SLOTS];
+} FBMirrorHeader;
+
+static inline size_t FBMirror_mapSize(uint32_t frame_size) {
+	return FB_MIRROR_HEADER_SIZE + (size_t)frame_size * FB_MIRROR_SLOTS;
+}
+static inline uint8_t* FBMirror_pixels(FBMirrorHeader* mirror, uint32_t slot) {
+	return (uint8_t*)mirror + FB_MIRROR_HEADER_SIZE + (size_t)mirror->frame_size * slot;
+}
+
+// producer: call once on a freshly truncated mapping of FBMirror_mapSize() bytes
+static inline void FBMirror_init(FBMirrorHeader* mirror, uint32_t width, uint32_t height) {
+	memset(mirror, 0, sizeof(FBMirrorHeader));
+	mirror->version = FB_MIRROR_VERSION;
+	mirror->width = width;
+	mirror->height = height;
+	mirror->pitch = width * 4;
+	mirror->frame_size = width * height * 4;
+	mirror->slot_count = FB_MIRROR_SLOTS;
+	__atomic_store_n(&mirror->magic, FB_MIRROR_MAGIC, __ATOMIC_RELEASE);
+}
+
+// producer: never blocks, slot for the next frame is one readers aren't expected to hold
+static inline void FBMirror_publish(FBMirrorHeader* mirror, const void* pixels, uint32_t timestamp_ms) {
+	uint32_t frame = __atomic_load_n(&mirror->latest, __ATOMIC_RELAXED) + 1;
+	if (frame == 0)
+		frame = 1; // 0 means "no frame yet"
+	FBMirrorSlot* slot = &mirror->slots[frame % FB_MIRROR_SLOTS];
+
+	uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	memcpy(FBMirror_pixels(mirror, frame % FB_MIRROR_SLOTS), pixels, mirror->frame_size);
+	slot->frame = frame;
+	slot->timestamp_ms = timestamp_ms;
+
+	__atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+	__atomic_store_n(&mirror->latest, frame, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n(&mirror->waiters, __ATOMIC_SEQ_CST))
+		syscall(SYS_futex, &mirror->latest, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+// reader: sleeps until a frame newer than last_frame is published,
+// returns the newest frame number or 0 on timeout/signal
+static inline uint32_t FBMirror_wait(FBMirrorHeader* mirror, uint32_t last_frame, int timeout_ms) {
+	uint32_t latest = __atomic_load_n(&mirror->latest, __ATOMIC_ACQUIRE);
+	if (latest != last_frame)
+		return latest;
+
+	struct timespec timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+	__atomic_add_fetch(&mirror->waiters, 1, __ATOMIC_SEQ_CST);
+	latest = __atomic_load_n(&mirror->latest, __ATOMIC_SEQ_CST);
+	if (latest == last_frame)
+		syscall(SYS_futex, &mirror->latest, FUTEX_WAIT, last_frame, &timeout, NULL, 0);
+	__atomic_sub_fetch(&mirror->waiters, 1, __ATOMIC_SEQ_CST);
+
+	latest = __atomic_load_n(&mirror->latest, __ATOMIC_ACQUIRE);
+	return latest != last_frame ? latest : 0;
+}
+
+// reader: copies the newest complete frame into dst (frame_size bytes),
+// returns its frame number or 0 if the producer kept overwriting it
+static inline uint32_t FBMirror_read(FBMirrorHeader* mirror, void* dst, uint32_t* timestamp_ms) {
+	for (int i = 0; i < FB_MIRROR_READ_RETRIES; i++) {
+		uint32_t frame = __atomic_load_n(&mirror->latest, __ATOMIC_ACQUIRE);
+		if (frame == 0)
+			return 0;
+
+		FBMirrorSlot* slot = &mirror->slots[frame % FB_MIRROR_SLOTS];
+		uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if ((seq & 1) || slot->frame != frame)
+			continue;
+
+		memcpy(dst, FBMirror_pixels(mirror, frame % FB_MIRROR_SLOTS), mirror->frame_size);
+		uint32_t ts = slot->timestamp_ms;
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq)
+			continue; // torn, try the newer frame
+
+		if (timestamp_ms)
+			*timestamp_ms = ts;
+		return frame;
+	}
+	return 0;
+}
+
+#endif
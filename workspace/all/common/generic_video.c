@@ -18,6 +18,7 @@
 #include "platform.h"
 #include "api.h"
 #include "utils.h"
+#include "fb_mirror.h"
 #include <stdlib.h>
 #include <pthread.h>
 #include <stdint.h>
@@ -121,7 +122,7 @@ static uint32_t SDL_transparentBlack = 0;
 static int capture_rec_fd = -1;		 // fd for recording frames file
 static FILE* capture_ts_file = NULL; // timestamp file for recording
 static int capture_shm_fd = -1;
-static uint8_t* capture_shm_ptr = NULL;
+static FBMirrorHeader* capture_shm_ptr = NULL; // frame ring read by screenshot/screenrecorder
 static uint8_t* capture_buf_a = NULL; // double-buffer A (render thread fills)
 static uint8_t* capture_buf_b = NULL; // double-buffer B (worker processes)
 static size_t capture_frame_size = 0;
@@ -768,7 +769,7 @@ void PLAT_quitVideo(void) {
 		capture_buf_b = NULL;
 	}
 	if (capture_shm_ptr) {
-		munmap(capture_shm_ptr, capture_frame_size);
+		munmap(capture_shm_ptr, FBMirror_mapSize(capture_frame_size));
 		capture_shm_ptr = NULL;
 	}
 	if (capture_shm_fd >= 0) {
@@ -1704,7 +1705,7 @@ static void* capture_worker_func(void* arg) {
 		// ffmpeg handles vflip + format conversion at encode time
 
 		if (capture_shm_ptr)
-			memcpy(capture_shm_ptr, capture_buf_b, frame_size);
+			FBMirror_publish(capture_shm_ptr, capture_buf_b, ts);
 		if (local_rec_fd >= 0) {
 			size_t remaining = frame_size;
 			const uint8_t* ptr = capture_buf_b;
@@ -1759,16 +1760,21 @@ static void capture_check(void) {
 			capture_buf_a = malloc(capture_frame_size);
 		if (!capture_buf_b)
 			capture_buf_b = malloc(capture_frame_size);
-		// Open+mmap shared file for screenshots
+		// Open+mmap shared frame ring for screenshots and recordings
 		if (capture_shm_fd < 0) {
-			capture_shm_fd = open("/tmp/fb_mirror.raw", O_CREAT | O_RDWR | O_TRUNC, 0666);
+			// fresh inode: readers still mapping an old ring must not see it shrink under them
+			unlink(FB_MIRROR_PATH);
+			capture_shm_fd = open(FB_MIRROR_PATH, O_CREAT | O_RDWR | O_TRUNC, 0666);
 			if (capture_shm_fd >= 0) {
-				if (ftruncate(capture_shm_fd, capture_frame_size) == 0) {
-					capture_shm_ptr = mmap(NULL, capture_frame_size,
+				size_t map_size = FBMirror_mapSize(capture_frame_size);
+				if (ftruncate(capture_shm_fd, map_size) == 0) {
+					capture_shm_ptr = mmap(NULL, map_size,
 										   PROT_READ | PROT_WRITE, MAP_SHARED,
 										   capture_shm_fd, 0);
 					if (capture_shm_ptr == MAP_FAILED)
 						capture_shm_ptr = NULL;
+					else
+						FBMirror_init(capture_shm_ptr, device_width, device_height);
 				}
 			}
 		}
@@ -1792,7 +1798,7 @@ static void capture_check(void) {
 			capture_worker_running = false;
 		}
 		if (capture_shm_ptr) {
-			munmap(capture_shm_ptr, capture_frame_size);
+			munmap(capture_shm_ptr, FBMirror_mapSize(capture_frame_size));
 			capture_shm_ptr = NULL;
 		}
 		if (capture_shm_fd >= 0) {
@@ -1807,7 +1813,7 @@ static void capture_check(void) {
 			free(capture_buf_b);
 			capture_buf_b = NULL;
 		}
-		unlink("/tmp/fb_mirror.raw");
+		unlink(FB_MIRROR_PATH);
 		capture_active = false;
 	}
 }
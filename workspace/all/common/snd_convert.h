@@ -0,0 +1,86 @@
+#ifndef __SND_CONVERT_H__
+#define __SND_CONVERT_H__
+
+#include <stdint.h>
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//
+//	int16 <-> float conversion around the emulator audio resampler,
+//	interleaved samples (not frames). NEON on device, SSE2 on desktop, the
+//	scalar loops handle the tails and are the reference: the vector paths
+//	match them bit for bit for every input, NaN and infinities included.
+//	test/snd_resample_bench.c checks that.
+//
+
+static inline void SND_s16ToFloat(const int16_t* src, float* dst, int count) {
+	int i = 0;
+#if defined(__ARM_NEON) || defined(__aarch64__)
+	const float32x4_t scale = vdupq_n_f32(1.0f / 32768.0f);
+	for (; i + 8 <= count; i += 8) {
+		int16x8_t s = vld1q_s16(src + i);
+		vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))), scale));
+		vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))), scale));
+	}
+#elif defined(__SSE2__)
+	const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+	for (; i + 8 <= count; i += 8) {
+		__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+		_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+	}
+#endif
+	for (; i < count; i++)
+		dst[i] = src[i] / 32768.0f;
+}
+
+// clamp to [-1,1], scale by 32767 and truncate toward zero. Comparisons
+// rather than fminf/fmaxf so every path treats NaN the same: a NaN fails
+// "<= 1" and comes out as 32767. That matches fminf for quiet NaNs, the only
+// kind the resampler's arithmetic produces (glibc's fminf turns a signaling
+// NaN into -32767)
+static inline void SND_floatToS16(const float* src, int16_t* dst, int count) {
+	int i = 0;
+#if defined(__ARM_NEON) || defined(__aarch64__)
+	// compare and select, vminq/vmaxq would pass a NaN through
+	const float32x4_t lo = vdupq_n_f32(-1.0f);
+	const float32x4_t hi = vdupq_n_f32(1.0f);
+	const float32x4_t scale = vdupq_n_f32(32767.0f);
+	for (; i + 8 <= count; i += 8) {
+		float32x4_t a = vld1q_f32(src + i);
+		float32x4_t b = vld1q_f32(src + i + 4);
+		a = vbslq_f32(vcleq_f32(a, hi), a, hi);
+		b = vbslq_f32(vcleq_f32(b, hi), b, hi);
+		a = vmulq_f32(vbslq_f32(vcltq_f32(a, lo), lo, a), scale);
+		b = vmulq_f32(vbslq_f32(vcltq_f32(b, lo), lo, b), scale);
+		vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(vcvtq_s32_f32(a)), vqmovn_s32(vcvtq_s32_f32(b))));
+	}
+#elif defined(__SSE2__)
+	// minps/maxps return their second operand when either is NaN, so the
+	// sample goes first and a NaN becomes the upper bound
+	const __m128 lo = _mm_set1_ps(-1.0f);
+	const __m128 hi = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(32767.0f);
+	for (; i + 8 <= count; i += 8) {
+		__m128 a = _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i), hi), lo), scale);
+		__m128 b = _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i + 4), hi), lo), scale);
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+	}
+#endif
+	for (; i < count; i++) {
+		float sample = src[i];
+		if (!(sample <= 1.0f))
+			sample = 1.0f;
+		if (sample < -1.0f)
+			sample = -1.0f;
+		dst[i] = (int16_t)(sample * 32767.0f);
+	}
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef __SND_RING_H__
+#define __SND_RING_H__
+
+#include <stdint.h>
+#include <string.h>
+
+//
+//	emulator audio ring between the emulation thread (producer) and the
+//	SDL audio callback (consumer), lock free so the audio thread never
+//	waits on the emulation thread
+//
+//	frame_in is only written by the producer and frame_out only by the
+//	consumer. indices are published with release stores and read with
+//	acquire loads so the frames they cover are visible before the index.
+//	one slot is always left empty so frame_in == frame_out means empty.
+//
+
+#define SND_RING_CACHELINE 64
+
+typedef struct SND_Frame {
+	int16_t left;
+	int16_t right;
+} SND_Frame;
+
+typedef struct SNDRing {
+	SND_Frame* buffer;
+	int capacity; // frames, 0 until a buffer is attached
+
+	// each sits on its own cache line so the two threads don't bounce it
+	int frame_in __attribute__((aligned(SND_RING_CACHELINE)));	// buf_w
+	int frame_out __attribute__((aligned(SND_RING_CACHELINE))); // buf_r
+} __attribute__((aligned(SND_RING_CACHELINE))) SNDRing;
+
+// neither thread may be using the ring, e.g. audio device locked
+static inline void SNDRing_reset(SNDRing* ring, SND_Frame* buffer, int capacity) {
+	ring->buffer = buffer;
+	ring->capacity = buffer ? capacity : 0;
+	__atomic_store_n(&ring->frame_in, 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&ring->frame_out, 0, __ATOMIC_RELEASE);
+}
+
+// occupancy as seen from either side, safe to call from any thread
+static inline int SNDRing_queued(SNDRing* ring) {
+	int capacity = ring->capacity;
+	if (capacity <= 0)
+		return 0;
+	int in = __atomic_load_n(&ring->frame_in, __ATOMIC_ACQUIRE);
+	int out = __atomic_load_n(&ring->frame_out, __ATOMIC_ACQUIRE);
+	int queued = in - out;
+	return queued < 0 ? queued + capacity : queued;
+}
+
+// producer: bulk copy in, at most two memcpy's around the wrap. returns
+// the number of frames written, whatever doesn't fit is dropped
+static inline int SNDRing_write(SNDRing* ring, const SND_Frame* frames, int count) {
+	int capacity = ring->capacity;
+	int frame_in = __atomic_load_n(&ring->frame_in, __ATOMIC_RELAXED);
+	int frame_out = __atomic_load_n(&ring->frame_out, __ATOMIC_ACQUIRE);
+	int available = frame_out - frame_in - 1;
+	if (available < 0)
+		available += capacity;
+	if (count > available)
+		count = available;
+	if (count <= 0)
+		return 0;
+
+	int first = count < capacity - frame_in ? count : capacity - frame_in;
+	memcpy(&ring->buffer[frame_in], frames, first * sizeof(SND_Frame));
+	if (count > first)
+		memcpy(ring->buffer, frames + first, (count - first) * sizeof(SND_Frame));
+	__atomic_store_n(&ring->frame_in, (frame_in + count) % capacity, __ATOMIC_RELEASE);
+	return count;
+}
+
+// consumer: bulk copy out, returns the number of frames read
+static inline int SNDRing_read(SNDRing* ring, SND_Frame* out, int count) {
+	int capacity = ring->capacity;
+	int frame_out = __atomic_load_n(&ring->frame_out, __ATOMIC_RELAXED);
+	int frame_in = __atomic_load_n(&ring->frame_in, __ATOMIC_ACQUIRE);
+	int available = frame_in - frame_out;
+	if (available < 0)
+		available += capacity;
+	if (count > available)
+		count = available;
+	if (count <= 0)
+		return 0;
+
+	int first = count < capacity - frame_out ? count : capacity - frame_out;
+	memcpy(out, &ring->buffer[frame_out], first * sizeof(SND_Frame));
+	if (count > first)
+		memcpy(out + first, ring->buffer, (count - first) * sizeof(SND_Frame));
+	__atomic_store_n(&ring->frame_out, (frame_out + count) % capacity, __ATOMIC_RELEASE);
+	return count;
+}
+
+#endif
@@ -0,0 +1,238 @@
+// Checks that fb_mirror.h readers never keep a frame mixed from two writes.
+// Every pixel encodes its frame number, so a torn copy can't pass for a
+// complete one.
+//  1. The reader's pixel copy is intercepted halfway (memcpy is routed
+//     through hookedMemcpy below) and the producer publishes frames right
+//     there, so the slot being read is rewritten under it on every run,
+//     however the scheduler behaves.
+//  2. The renderer/screenrecorder setup: a producer publishes into a
+//     MAP_SHARED mirror as fast as it can while forked readers wait on the
+//     futex and copy frames out.
+// Run from an empty directory.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define MIRROR_PATH "fb_mirror.raw" // not FB_MIRROR_PATH, a device may be using that
+#define WIDTH 320
+#define HEIGHT 240
+#define FRAME_BYTES (WIDTH * HEIGHT * 4)
+#define PATTERN_COUNT 8 // precomputed so the producer publishes at memcpy speed
+#define FRAME_COUNT 20000
+#define READER_COUNT 2
+#define WAIT_MS 200
+
+static int hook_copies = 0; // reader copies left to interrupt, -1 for all of them
+static int hook_frames = 0; // frames published in the middle of each
+static int publishing = 0;
+static void publishFrames(int count);
+
+static void* hookedMemcpy(void* dst, const void* src, size_t size) {
+	if (!hook_copies || publishing || size != FRAME_BYTES)
+		return memcpy(dst, src, size);
+	if (hook_copies > 0)
+		hook_copies -= 1;
+	memcpy(dst, src, size / 2);
+	publishFrames(hook_frames);
+	memcpy((uint8_t*)dst + size / 2, (const uint8_t*)src + size / 2, size - size / 2);
+	return dst;
+}
+#define memcpy hookedMemcpy
+
+#include "fb_mirror.h"
+
+static int failures = 0;
+
+static void expect(int ok, const char* what) {
+	printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok)
+		failures += 1;
+}
+
+// Differs between any two frames less than PATTERN_COUNT apart at every
+// pixel, the slots are reused every FB_MIRROR_SLOTS frames
+static uint32_t pixel(uint32_t frame, size_t i) {
+	return (frame % PATTERN_COUNT) * 0x9E3779B1u ^ (uint32_t)i;
+}
+
+static uint32_t* patterns[PATTERN_COUNT];
+static FBMirrorHeader* mirror;
+static uint32_t published = 0;
+
+static void publishFrames(int count) {
+	publishing = 1;
+	for (int i = 0; i < count; i++) {
+		published += 1;
+		FBMirror_publish(mirror, patterns[published % PATTERN_COUNT], published);
+	}
+	publishing = 0;
+}
+
+static int isComplete(const uint32_t* pixels, uint32_t frame, uint32_t timestamp) {
+	if (timestamp != frame)
+		return 0;
+	for (size_t i = 0; i < WIDTH * HEIGHT; i++) {
+		if (pixels[i] != pixel(frame, i))
+			return 0;
+	}
+	return 1;
+}
+
+static FBMirrorHeader* mapMirror(int create) {
+	size_t size = FBMirror_mapSize(FRAME_BYTES);
+	int fd = open(MIRROR_PATH, create ? O_CREAT | O_RDWR | O_TRUNC : O_RDWR, 0644);
+	if (fd < 0)
+		return NULL;
+	if (create && ftruncate(fd, size) != 0) {
+		close(fd);
+		return NULL;
+	}
+	void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	return map == MAP_FAILED ? NULL : map;
+}
+
+///////////////////////////////
+// 1. Writes landing in the middle of a read
+
+typedef struct {
+	const char* name;
+	int copies;
+	int frames;
+	int expect_frame; // relative to the newest frame when the read started, -1 = gives up
+} HookCase;
+
+static const HookCase hook_cases[] = {
+	{"one frame published mid-copy, slot untouched", 1, 1, 0},
+	{"slot rewritten mid-copy, retries on the newer frame", 1, FB_MIRROR_SLOTS, FB_MIRROR_SLOTS},
+	{"slot rewritten mid-copy twice, retries again", 2, FB_MIRROR_SLOTS, 2 * FB_MIRROR_SLOTS},
+	{"slot rewritten mid-copy on every retry, gives up", -1, FB_MIRROR_SLOTS, -1},
+};
+#define HOOK_CASE_COUNT (int)(sizeof(hook_cases) / sizeof(hook_cases[0]))
+
+static void testInterruptedReads(void) {
+	uint32_t* pixels = malloc(FRAME_BYTES);
+	char what[128];
+	for (int c = 0; c < HOOK_CASE_COUNT; c++) {
+		const HookCase* test = &hook_cases[c];
+		publishFrames(1);
+		uint32_t start = published;
+
+		hook_copies = test->copies;
+		hook_frames = test->frames;
+		uint32_t timestamp = 0;
+		uint32_t frame = FBMirror_read(mirror, pixels, &timestamp);
+		hook_copies = 0;
+
+		snprintf(what, sizeof(what), "%s: read frame %+d", test->name, test->expect_frame);
+		expect(test->expect_frame < 0 ? frame == 0 : frame == start + test->expect_frame, what);
+		if (frame) {
+			snprintf(what, sizeof(what), "%s: frame complete", test->name);
+			expect(isComplete(pixels, frame, timestamp), what);
+		}
+	}
+	free(pixels);
+}
+
+///////////////////////////////
+// 2. Producer and readers in separate processes
+
+typedef struct {
+	uint32_t frames; // complete frames read
+	uint32_t torn;	 // frames whose pixels or timestamp didn't match their number
+	uint32_t backwards;
+	uint32_t gave_up; // FBMirror_read kept losing to the producer
+	uint32_t last;
+} ReaderStats;
+
+// Runs in a forked child, stats go back through a pipe
+static void reader(int out) {
+	ReaderStats stats = {0};
+	FBMirrorHeader* shared = mapMirror(0);
+	uint32_t* pixels = malloc(FRAME_BYTES);
+	int timeouts = 0;
+	while (shared && stats.last < published + FRAME_COUNT && timeouts < 10) {
+		if (!FBMirror_wait(shared, stats.last, WAIT_MS)) {
+			timeouts += 1;
+			continue;
+		}
+		uint32_t timestamp = 0;
+		uint32_t frame = FBMirror_read(shared, pixels, &timestamp);
+		if (!frame) {
+			stats.gave_up += 1;
+			continue;
+		}
+		stats.torn += !isComplete(pixels, frame, timestamp);
+		stats.backwards += frame < stats.last;
+		stats.frames += 1;
+		stats.last = frame;
+	}
+	if (write(out, &stats, sizeof(stats)) != sizeof(stats))
+		_exit(EXIT_FAILURE);
+	_exit(EXIT_SUCCESS);
+}
+
+static void testReaderProcesses(void) {
+	int pipes[READER_COUNT][2];
+	pid_t pids[READER_COUNT];
+	for (int r = 0; r < READER_COUNT; r++) {
+		if (pipe(pipes[r]) != 0) {
+			expect(0, "pipe");
+			return;
+		}
+		pids[r] = fork();
+		if (pids[r] == 0)
+			reader(pipes[r][1]);
+		close(pipes[r][1]);
+	}
+
+	uint32_t last = published + FRAME_COUNT;
+	publishFrames(FRAME_COUNT);
+
+	char what[128];
+	for (int r = 0; r < READER_COUNT; r++) {
+		ReaderStats stats = {0};
+		int status = 0;
+		int got = read(pipes[r][0], &stats, sizeof(stats)) == sizeof(stats);
+		waitpid(pids[r], &status, 0);
+		close(pipes[r][0]);
+
+		printf("reader %d: %u frames, %u reads gave up\n", r, stats.frames, stats.gave_up);
+		snprintf(what, sizeof(what), "reader %d saw the last frame", r);
+		expect(got && WIFEXITED(status) && WEXITSTATUS(status) == 0 && stats.last == last, what);
+		snprintf(what, sizeof(what), "reader %d never kept a frame mixed from two writes", r);
+		expect(got && stats.frames > 0 && stats.torn == 0, what);
+		snprintf(what, sizeof(what), "reader %d frames only moved forward", r);
+		expect(got && stats.backwards == 0, what);
+	}
+}
+
+int main(int argc, char* argv[]) {
+	mirror = mapMirror(1);
+	if (!mirror) {
+		printf("can't map %s\nFAILED\n", MIRROR_PATH);
+		return EXIT_FAILURE;
+	}
+	FBMirror_init(mirror, WIDTH, HEIGHT);
+	for (int p = 0; p < PATTERN_COUNT; p++) {
+		patterns[p] = malloc(FRAME_BYTES);
+		for (size_t i = 0; i < WIDTH * HEIGHT; i++)
+			patterns[p][i] = pixel(p, i);
+	}
+
+	testInterruptedReads();
+	testReaderProcesses();
+
+	for (int p = 0; p < PATTERN_COUNT; p++)
+		free(patterns[p]);
+	munmap(mirror, FBMirror_mapSize(FRAME_BYTES));
+	unlink(MIRROR_PATH);
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
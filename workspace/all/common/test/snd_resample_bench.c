@@ -0,0 +1,224 @@
+// Checks the snd_convert.h NEON/SSE2 kernels bit for bit against their
+// scalar tails and the loops they replaced, over every int16 and a float
+// sweep with NaN, infinities and out of range samples. Then times what
+// SND_batchSamples does around the resampler per BATCH_SIZE chunk, before
+// and after it went allocation free: int16 -> float, float -> int16 and
+// the copy into the audio ring. libsamplerate isn't part of this,
+// src_process costs the same both ways and a memcpy stands in for it.
+// Host build: make -C test, device build: make -C test device
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "snd_ring.h"
+#include "snd_convert.h"
+
+#define BATCH_SIZE 100 // api.c
+#define RING_FRAMES 6400 // snd.frame_count at 48 kHz
+#define BENCH_FRAMES (48000 * 60) // a minute of audio
+#define SWEEP_COUNT (1 << 20)
+
+static int failures = 0;
+
+static void expect(int ok, const char* what) {
+	printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok)
+		failures += 1;
+}
+
+static uint32_t rng_state = 0x12345678;
+static uint32_t rng(void) {
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+///////////////////////////////
+// Correctness
+
+static int checkS16ToFloat(void) {
+	int16_t* in = malloc(65536 * sizeof(int16_t));
+	float* out = malloc(65536 * sizeof(float));
+	for (int i = 0; i < 65536; i++)
+		in[i] = (int16_t)(i - 32768);
+	SND_s16ToFloat(in, out, 65536);
+
+	int ok = 1;
+	for (int i = 0; i < 65536 && ok; i++) {
+		float expected = in[i] / 32768.0f;
+		ok = memcmp(&out[i], &expected, sizeof(float)) == 0;
+	}
+	free(in);
+	free(out);
+	return ok;
+}
+
+static int isSignalingNaN(float sample) {
+	uint32_t bits;
+	memcpy(&bits, &sample, sizeof(bits));
+	return isnan(sample) && !(bits & 0x00400000);
+}
+
+// Against the scalar tail of SND_floatToS16 (vector path vs tail, every
+// input), and against the fminf/fmaxf loop resample_audio used before
+// (every input but signaling NaNs, see snd_convert.h)
+static int checkFloatToS16(void) {
+	static const float special[] = {
+		0.0f, -0.0f, 1.0f, -1.0f, 0.5f, -0.5f, 1.0001f, -1.0001f, 2.0f, -2.0f,
+		FLT_MIN, -FLT_MIN, FLT_MAX, -FLT_MAX, 1e-40f, -1e-40f, // denormals
+		INFINITY, -INFINITY, NAN, -NAN,
+	};
+	int special_count = sizeof(special) / sizeof(special[0]);
+
+	// Specials at every lane and in the scalar tail, then random bit
+	// patterns (anything goes, NaNs included) and samples around [-1,1]
+	float* in = malloc(SWEEP_COUNT * sizeof(float));
+	int16_t* out = malloc(SWEEP_COUNT * sizeof(int16_t));
+	int16_t* tail = malloc(SWEEP_COUNT * sizeof(int16_t));
+	for (int i = 0; i < SWEEP_COUNT; i++) {
+		if (i < special_count * 9)
+			in[i] = special[i / 9];
+		else if (i % 2) {
+			uint32_t bits = rng();
+			memcpy(&in[i], &bits, sizeof(float));
+		} else
+			in[i] = ((int32_t)rng() / 2147483648.0f) * 1.25f;
+	}
+	SND_floatToS16(in, out, SWEEP_COUNT);
+	for (int i = 0; i < SWEEP_COUNT; i++)
+		SND_floatToS16(&in[i], &tail[i], 1); // shorter than a vector, tail only
+
+	int ok = 1;
+	for (int i = 0; i < SWEEP_COUNT && ok; i++) {
+		int16_t before = (int16_t)(fmaxf(-1.0f, fminf(1.0f, in[i])) * 32767.0f);
+		if (out[i] != tail[i] || (out[i] != before && !isSignalingNaN(in[i]))) {
+			uint32_t bits;
+			memcpy(&bits, &in[i], sizeof(bits));
+			printf("%.9g (0x%08x) converted to %d, scalar tail %d, before %d\n", in[i], bits, out[i], tail[i], before);
+			ok = 0;
+		}
+	}
+	free(in);
+	free(out);
+	free(tail);
+	return ok;
+}
+
+///////////////////////////////
+// Per chunk work, before: resample_audio mallocs its buffers and converts
+// one sample at a time, SND_batchSamples copies frame by frame into the
+// ring under audio_mutex
+
+static pthread_mutex_t audio_mutex = PTHREAD_MUTEX_INITIALIZER;
+static SND_Frame old_buffer[RING_FRAMES];
+static int old_in = 0;
+static int old_out = 0;
+
+static int chunkBefore(const SND_Frame* frames, int count) {
+	float* input_buffer = (float*)malloc(count * 2 * sizeof(float));
+	float* output_buffer = (float*)malloc((count + 1) * 2 * sizeof(float));
+	for (int i = 0; i < count; i++) {
+		input_buffer[2 * i] = frames[i].left / 32768.0f;
+		input_buffer[2 * i + 1] = frames[i].right / 32768.0f;
+	}
+	memcpy(output_buffer, input_buffer, count * 2 * sizeof(float)); // src_process
+
+	SND_Frame* output_frames = (SND_Frame*)malloc(count * sizeof(SND_Frame));
+	for (int i = 0; i < count; i++) {
+		float left = output_buffer[2 * i];
+		float right = output_buffer[2 * i + 1];
+		left = fmaxf(-1.0f, fminf(1.0f, left));
+		right = fmaxf(-1.0f, fminf(1.0f, right));
+		output_frames[i].left = (int16_t)(left * 32767.0f);
+		output_frames[i].right = (int16_t)(right * 32767.0f);
+	}
+	free(input_buffer);
+	free(output_buffer);
+
+	int written = 0;
+	pthread_mutex_lock(&audio_mutex);
+	for (int i = 0; i < count; i++) {
+		if ((old_in + 1) % RING_FRAMES == old_out)
+			break;
+		old_buffer[old_in] = output_frames[i];
+		old_in = (old_in + 1) % RING_FRAMES;
+		written++;
+	}
+	pthread_mutex_unlock(&audio_mutex);
+	free(output_frames);
+	return written;
+}
+
+///////////////////////////////
+// After: persistent scratch, snd_convert.h kernels, two memcpy's into SNDRing
+
+static SNDRing ring;
+static SND_Frame ring_buffer[RING_FRAMES];
+static float scratch_in[BATCH_SIZE * 2];
+static float scratch_out[(BATCH_SIZE + 1) * 2];
+static SND_Frame scratch_frames[BATCH_SIZE + 1];
+
+static int chunkAfter(const SND_Frame* frames, int count) {
+	SND_s16ToFloat((const int16_t*)frames, scratch_in, count * 2);
+	memcpy(scratch_out, scratch_in, count * 2 * sizeof(float)); // src_process
+	SND_floatToS16(scratch_out, (int16_t*)scratch_frames, count * 2);
+	return SNDRing_write(&ring, scratch_frames, count);
+}
+
+static double now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+typedef int (*ChunkFunc)(const SND_Frame* frames, int count);
+
+// ns per input frame; the ring is drained once it is half full like the
+// audio callback would, outside the timed part
+static double bench(ChunkFunc chunk, const SND_Frame* audio, int* written) {
+	static SND_Frame drain[RING_FRAMES];
+	double elapsed = 0.0;
+	*written = 0;
+	for (int done = 0; done < BENCH_FRAMES; done += BATCH_SIZE) {
+		double start = now_ns();
+		*written += chunk(audio + done, BATCH_SIZE);
+		elapsed += now_ns() - start;
+
+		if (SNDRing_queued(&ring) > RING_FRAMES / 2)
+			SNDRing_read(&ring, drain, RING_FRAMES);
+		int old_queued = (old_in - old_out + RING_FRAMES) % RING_FRAMES;
+		if (old_queued > RING_FRAMES / 2)
+			old_out = old_in;
+	}
+	return elapsed / BENCH_FRAMES;
+}
+
+int main(int argc, char* argv[]) {
+	expect(checkS16ToFloat(), "int16 -> float matches the scalar loop for every sample");
+	expect(checkFloatToS16(), "float -> int16 matches the scalar loop, NaN and infinities included");
+
+	SND_Frame* audio = malloc(BENCH_FRAMES * sizeof(SND_Frame));
+	for (int i = 0; i < BENCH_FRAMES; i++) {
+		audio[i].left = (int16_t)rng();
+		audio[i].right = (int16_t)rng();
+	}
+	SNDRing_reset(&ring, ring_buffer, RING_FRAMES);
+
+	int written_before, written_after;
+	double before = bench(chunkBefore, audio, &written_before);
+	double after = bench(chunkAfter, audio, &written_after);
+	expect(written_before == BENCH_FRAMES && written_after == BENCH_FRAMES, "no frames dropped");
+	printf("%d frame chunks, around src_process: before %.2f ns/frame, after %.2f ns/frame\n",
+		   BATCH_SIZE, before, after);
+
+	free(audio);
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+// Stress test for the lock free audio ring in snd_ring.h: an emulation
+// thread stand-in pushes a numbered stream of frames while an audio
+// callback stand-in drains it, each in random sized batches and switching
+// between outrunning and lagging the other. The consumer must see every
+// frame exactly once and in order. Built with -fsanitize=thread so a
+// missing acquire/release shows up as a race report.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "snd_ring.h"
+
+#define RING_FRAMES 1001 // odd so batches land all over the wrap
+#define STREAM_FRAMES (2 * 1000 * 1000)
+#define BATCH_MAX 400	 // bigger than what fits when nearly full
+#define PHASE_FRAMES 50000 // how long one side stays the faster one
+
+static SNDRing ring;
+static int failures = 0;
+
+static void expect(int ok, const char* what) {
+	printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok)
+		failures += 1;
+}
+
+static uint32_t rng(uint32_t* state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static SND_Frame numbered(uint32_t n) {
+	SND_Frame frame = {(int16_t)(n & 0xffff), (int16_t)(n >> 16)};
+	return frame;
+}
+
+static uint32_t number(SND_Frame frame) {
+	return (uint16_t)frame.left | (uint32_t)(uint16_t)frame.right << 16;
+}
+
+// Alternate phases: in even ones the producer sleeps between batches
+static int slowPhase(uint32_t frames, int even) {
+	return (frames / PHASE_FRAMES) % 2 == (even ? 0 : 1);
+}
+
+typedef struct {
+	uint32_t full_writes; // batches the ring couldn't take whole
+} ProducerStats;
+
+static void* producer(void* arg) {
+	ProducerStats* stats = arg;
+	uint32_t state = 0x1234567;
+	SND_Frame batch[BATCH_MAX];
+	uint32_t sent = 0;
+	while (sent < STREAM_FRAMES) {
+		int count = 1 + rng(&state) % BATCH_MAX;
+		if (count > STREAM_FRAMES - sent)
+			count = STREAM_FRAMES - sent;
+		for (int i = 0; i < count; i++)
+			batch[i] = numbered(sent + i);
+
+		// SND_batchSamples drops what doesn't fit, this retries the rest
+		// so the stream stays gapless and checkable
+		int done = 0;
+		while (done < count) {
+			int written = SNDRing_write(&ring, batch + done, count - done);
+			if (written < count - done) {
+				stats->full_writes += 1;
+				sched_yield();
+			}
+			done += written;
+		}
+		sent += count;
+		if (slowPhase(sent, 1))
+			usleep(rng(&state) % 50);
+	}
+	return NULL;
+}
+
+int main(int argc, char* argv[]) {
+	SND_Frame* buffer = calloc(RING_FRAMES, sizeof(SND_Frame));
+	SNDRing_reset(&ring, buffer, RING_FRAMES);
+	expect(SNDRing_queued(&ring) == 0, "empty after reset");
+
+	ProducerStats stats = {0};
+	pthread_t thread;
+	pthread_create(&thread, NULL, producer, &stats);
+
+	uint32_t state = 0x7654321;
+	SND_Frame out[BATCH_MAX];
+	uint32_t received = 0;
+	uint32_t empty_reads = 0;
+	int in_order = 1;
+	int queued_ok = 1;
+	while (received < STREAM_FRAMES && in_order) {
+		int queued = SNDRing_queued(&ring);
+		if (queued < 0 || queued > RING_FRAMES - 1)
+			queued_ok = 0;
+
+		int count = SNDRing_read(&ring, out, 1 + rng(&state) % BATCH_MAX);
+		if (count == 0) {
+			empty_reads += 1;
+			sched_yield();
+			continue;
+		}
+		for (int i = 0; i < count; i++) {
+			if (number(out[i]) != received + i) {
+				printf("frame %u read as %u\n", received + i, number(out[i]));
+				in_order = 0;
+				break;
+			}
+		}
+		received += count;
+		if (slowPhase(received, 0))
+			usleep(rng(&state) % 50);
+	}
+	pthread_join(thread, NULL);
+
+	printf("%u frames through a %d frame ring, %u writes hit a full ring, %u reads found it empty\n",
+		   received, RING_FRAMES, stats.full_writes, empty_reads);
+	expect(in_order && received == STREAM_FRAMES, "every frame arrived once and in order");
+	expect(queued_ok, "occupancy stayed within the ring");
+	expect(stats.full_writes > 0 && empty_reads > 0, "ran both full and empty");
+	expect(SNDRing_queued(&ring) == 0 && SNDRing_read(&ring, out, BATCH_MAX) == 0, "empty once drained");
+
+	free(buffer);
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -111,12 +111,7 @@ void ScrollText_render(ScrollTextState* state, TTF_Font* font, SDL_Color color,
 
 	if (!state->needs_scroll) {
 		GFX_clearLayers(LAYER_SCROLLTEXT);
-		SDL_Surface* surf = TTF_RenderUTF8_Blended(font, state->text, color);
-		if (surf) {
-			SDL_Rect src = {0, 0, surf->w > state->max_width ? state->max_width : surf->w, surf->h};
-			SDL_BlitSurface(surf, &src, screen, &(SDL_Rect){x, y, 0, 0});
-			SDL_FreeSurface(surf);
-		}
+		GFX_blitGlyphs(font, state->text, color, screen, x, y, state->max_width);
 		return;
 	}
 
@@ -264,12 +259,7 @@ void UI_renderListItemText(SDL_Surface* screen, ScrollTextState* scroll_state,
 		ScrollText_update(scroll_state, text, font, max_text_width,
 						  text_color, screen, text_x, text_y, true);
 	} else {
-		SDL_Surface* text_surf = TTF_RenderUTF8_Blended(font, text, text_color);
-		if (text_surf) {
-			SDL_Rect src = {0, 0, text_surf->w > max_text_width ? max_text_width : text_surf->w, text_surf->h};
-			SDL_BlitSurface(text_surf, &src, screen, &(SDL_Rect){text_x, text_y, 0, 0});
-			SDL_FreeSurface(text_surf);
-		}
+		GFX_blitGlyphs(font, text, text_color, screen, text_x, text_y, max_text_width);
 	}
 
 	if (old_clip.w > 0 && old_clip.h > 0)
@@ -436,12 +426,8 @@ void UI_renderSettingsPage(SDL_Surface* screen, ListLayout* layout,
 		int msg_row_y = layout->list_y + count * layout->item_h;
 		int empty_h = (layout->items_per_page - count) * layout->item_h;
 		int msg_y = msg_row_y + (empty_h - TTF_FontHeight(font.small)) / 2;
-		SDL_Surface* msg_surf = TTF_RenderUTF8_Blended(font.small, status_msg, COLOR_GRAY);
-		if (msg_surf) {
-			int msg_x = (hw - msg_surf->w) / 2;
-			SDL_BlitSurface(msg_surf, NULL, screen, &(SDL_Rect){msg_x, msg_y, 0, 0});
-			SDL_FreeSurface(msg_surf);
-		}
+		int msg_x = (hw - GFX_sizeGlyphs(font.small, status_msg)) / 2;
+		GFX_blitGlyphs(font.small, status_msg, COLOR_GRAY, screen, msg_x, msg_y, 0);
 	}
 
 	// Description text in the last row (row 9)
@@ -454,12 +440,8 @@ void UI_renderSettingsPage(SDL_Surface* screen, ListLayout* layout,
 		char truncated_desc[256];
 		GFX_truncateText(font.tiny, items[selected].desc, truncated_desc, desc_max_w, 0);
 
-		SDL_Surface* desc_surf = TTF_RenderUTF8_Blended(font.tiny, truncated_desc, COLOR_GRAY);
-		if (desc_surf) {
-			int desc_x = (hw - desc_surf->w) / 2;
-			SDL_BlitSurface(desc_surf, NULL, screen, &(SDL_Rect){desc_x, desc_y, 0, 0});
-			SDL_FreeSurface(desc_surf);
-		}
+		int desc_x = (hw - GFX_sizeGlyphs(font.tiny, truncated_desc)) / 2;
+		GFX_blitGlyphs(font.tiny, truncated_desc, COLOR_GRAY, screen, desc_x, desc_y, 0);
 	}
 }
 
@@ -497,11 +479,7 @@ int UI_renderSettingsRow(SDL_Surface* screen, ListLayout* layout,
 			GFX_blitRectColor(ASSET_BUTTON, screen, &label_pill_rect, THEME_COLOR1);
 
 			// Label text
-			SDL_Surface* label_surf = TTF_RenderUTF8_Blended(f, label, selected_text_color);
-			if (label_surf) {
-				SDL_BlitSurface(label_surf, NULL, screen, &(SDL_Rect){text_x, text_y, 0, 0});
-				SDL_FreeSurface(label_surf);
-			}
+			GFX_blitGlyphs(f, label, selected_text_color, screen, text_x, text_y, 0);
 
 			// Value with arrows, right-aligned, white text
 			int value_x = hw - SCALE1(PADDING) - SCALE1(SETTINGS_ROW_PADDING);
@@ -521,34 +499,22 @@ int UI_renderSettingsRow(SDL_Surface* screen, ListLayout* layout,
 				value_x -= swatch_size + SCALE1(4);
 			}
 
-			SDL_Surface* val_surf = TTF_RenderUTF8_Blended(font.tiny, value, COLOR_WHITE);
-			if (val_surf) {
-				value_x -= val_surf->w;
-				SDL_BlitSurface(val_surf, NULL, screen, &(SDL_Rect){value_x, val_text_y, 0, 0});
-				SDL_FreeSurface(val_surf);
-			}
+			value_x -= GFX_sizeGlyphs(font.tiny, value);
+			GFX_blitGlyphs(font.tiny, value, COLOR_WHITE, screen, value_x, val_text_y, 0);
 			return value_x;
 		} else {
 			// Single label rect only
 			SDL_Rect label_pill_rect = {SCALE1(PADDING), y, label_pill_width, pill_h};
 			GFX_blitRectColor(ASSET_BUTTON, screen, &label_pill_rect, THEME_COLOR1);
 
-			SDL_Surface* label_surf = TTF_RenderUTF8_Blended(f, label, selected_text_color);
-			if (label_surf) {
-				SDL_BlitSurface(label_surf, NULL, screen, &(SDL_Rect){text_x, text_y, 0, 0});
-				SDL_FreeSurface(label_surf);
-			}
+			GFX_blitGlyphs(f, label, selected_text_color, screen, text_x, text_y, 0);
 			return text_x;
 		}
 	} else {
 		// Unselected: no background
 		SDL_Color text_color = UI_getListTextColor(0);
 
-		SDL_Surface* label_surf = TTF_RenderUTF8_Blended(f, label, text_color);
-		if (label_surf) {
-			SDL_BlitSurface(label_surf, NULL, screen, &(SDL_Rect){text_x, text_y, 0, 0});
-			SDL_FreeSurface(label_surf);
-		}
+		GFX_blitGlyphs(f, label, text_color, screen, text_x, text_y, 0);
 
 		if (value) {
 			int value_x = hw - SCALE1(PADDING) - SCALE1(SETTINGS_ROW_PADDING);
@@ -568,12 +534,8 @@ int UI_renderSettingsRow(SDL_Surface* screen, ListLayout* layout,
 				value_x -= swatch_size + SCALE1(4);
 			}
 
-			SDL_Surface* val_surf = TTF_RenderUTF8_Blended(font.tiny, value, text_color);
-			if (val_surf) {
-				value_x -= val_surf->w;
-				SDL_BlitSurface(val_surf, NULL, screen, &(SDL_Rect){value_x, val_text_y, 0, 0});
-				SDL_FreeSurface(val_surf);
-			}
+			value_x -= GFX_sizeGlyphs(font.tiny, value);
+			GFX_blitGlyphs(font.tiny, value, text_color, screen, value_x, val_text_y, 0);
 			return value_x;
 		}
 		return text_x;
@@ -5,9 +5,13 @@
 #include <string.h>
 #include <unistd.h>
 #include <time.h>
+#include <fcntl.h>
+#include <strings.h>
+#include <poll.h>
 #include <sys/stat.h>
 #include "defines.h"
 #include "api.h"
+#include "utils.h"
 
 // Path to wget binary in shared system bin
 #define WGET_BIN SHARED_BIN_PATH "/wget"
@@ -30,6 +34,13 @@ static void shell_escape_single(const char* src, char* dst, int dst_size) {
 	dst[j] = '\0';
 }
 
+// Unique temp file per call, fetches run on several threads at once
+static void make_temp_path(char* path, int path_size) {
+	static volatile int counter = 0;
+	int n = __sync_fetch_and_add(&counter, 1);
+	snprintf(path, path_size, "/tmp/wget_%d_%d.tmp", getpid(), n);
+}
+
 int wget_fetch(const char* url, uint8_t* buffer, int buffer_size) {
 	if (!url || !buffer || buffer_size <= 0) {
 		LOG_error("[WgetFetch] Invalid parameters\n");
@@ -39,7 +50,7 @@ int wget_fetch(const char* url, uint8_t* buffer, int buffer_size) {
 	// Use temp file approach (reliable from within app process, same as selfupdate.c)
 	// popen + "-O -" has pipe issues when called from SDL/audio threads
 	char tmpfile[128];
-	snprintf(tmpfile, sizeof(tmpfile), "/tmp/wget_%d.tmp", getpid());
+	make_temp_path(tmpfile, sizeof(tmpfile));
 
 	char safe_url[4096];
 	shell_escape_single(url, safe_url, sizeof(safe_url));
@@ -277,3 +288,181 @@ int wget_download_file(const char* url, const char* filepath,
 
 	return result;
 }
+
+// Copy a validator into a request header value, dropping anything that
+// could end the header line
+static void copy_header_value(char* dst, int dst_size, const char* src) {
+	int j = 0;
+	for (int i = 0; src[i] && j < dst_size - 1; i++) {
+		if ((unsigned char)src[i] >= 0x20)
+			dst[j++] = src[i];
+	}
+	dst[j] = '\0';
+}
+
+static void copy_trimmed(char* dst, int dst_size, const char* src) {
+	while (*src == ' ' || *src == '\t')
+		src++;
+	int len = strlen(src);
+	while (len > 0 && (src[len - 1] == '\r' || src[len - 1] == '\n' || src[len - 1] == ' '))
+		len--;
+	if (len > dst_size - 1)
+		len = dst_size - 1;
+	memcpy(dst, src, len);
+	dst[len] = '\0';
+}
+
+// Read status and validators from wget -S output. Only the last response
+// counts, earlier ones are redirects.
+static void parse_response_headers(const char* path, WgetFetchInfo* info) {
+	FILE* hf = fopen(path, "r");
+	if (!hf)
+		return;
+
+	char line[512];
+	int status = 0;
+	while (fgets(line, sizeof(line), hf)) {
+		const char* p = line;
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (strncmp(p, "HTTP/", 5) == 0) {
+			const char* code = strchr(p, ' ');
+			status = code ? atoi(code + 1) : 0;
+			info->etag[0] = '\0';
+			info->last_modified[0] = '\0';
+		} else if (strncasecmp(p, "ETag:", 5) == 0) {
+			copy_trimmed(info->etag, sizeof(info->etag), p + 5);
+		} else if (strncasecmp(p, "Last-Modified:", 14) == 0) {
+			copy_trimmed(info->last_modified, sizeof(info->last_modified), p + 14);
+		}
+	}
+	fclose(hf);
+	info->not_modified = (status == 304);
+}
+
+int wget_fetch_stream(const char* url, const char* etag, const char* last_modified,
+					  WgetStreamCallback callback, void* userdata, WgetFetchInfo* info) {
+	if (!url || !callback) {
+		LOG_error("[WgetFetch] stream: invalid parameters\n");
+		return -1;
+	}
+
+	// Build the conditional headers first: etag/last_modified may point into info
+	char conditional[1024] = "";
+	char value[128];
+	char safe_value[512];
+	if (etag && etag[0]) {
+		copy_header_value(value, sizeof(value), etag);
+		shell_escape_single(value, safe_value, sizeof(safe_value));
+		snprintf(conditional + strlen(conditional), sizeof(conditional) - strlen(conditional),
+				 " --header='If-None-Match: %s'", safe_value);
+	}
+	if (last_modified && last_modified[0]) {
+		copy_header_value(value, sizeof(value), last_modified);
+		shell_escape_single(value, safe_value, sizeof(safe_value));
+		snprintf(conditional + strlen(conditional), sizeof(conditional) - strlen(conditional),
+				 " --header='If-Modified-Since: %s'", safe_value);
+	}
+
+	WgetFetchInfo local_info;
+	if (!info)
+		info = &local_info;
+	memset(info, 0, sizeof(*info));
+
+	char body_fifo[128];
+	char headers_file[160];
+	char done_marker[160];
+	make_temp_path(body_fifo, sizeof(body_fifo));
+	snprintf(headers_file, sizeof(headers_file), "%s.headers", body_fifo);
+	snprintf(done_marker, sizeof(done_marker), "%s.done", body_fifo);
+
+	// wget writes the body into a fifo, so nothing is spooled to /tmp and
+	// each chunk reaches the callback as soon as it arrives. Our end is
+	// opened first and non-blocking, a wget that fails before it opens
+	// the fifo can't hang the read.
+	unlink(body_fifo);
+	if (mkfifo(body_fifo, 0600) != 0) {
+		LOG_error("[WgetFetch] stream: mkfifo failed for: %s\n", url);
+		return -1;
+	}
+	int fd = open(body_fifo, O_RDONLY | O_NONBLOCK);
+	if (fd < 0) {
+		LOG_error("[WgetFetch] stream: can't open fifo for: %s\n", url);
+		unlink(body_fifo);
+		return -1;
+	}
+
+	char safe_url[4096];
+	shell_escape_single(url, safe_url, sizeof(safe_url));
+
+	// Same background + completion marker approach as wget_download_file,
+	// but the marker carries wget's exit status so a transfer cut off
+	// midway isn't taken for a complete one. -S writes the response
+	// headers to stderr. A single try: a retry could rewrite body bytes
+	// that were already delivered.
+	char cmd[8192];
+	snprintf(cmd, sizeof(cmd),
+			 "(" WGET_BIN " --no-check-certificate -nv -S -T 15 -t 1%s"
+			 " -O '%s' '%s' 2>'%s'; echo $? >'%s.part'; mv '%s.part' '%s') &",
+			 conditional, body_fifo, safe_url, headers_file, done_marker, done_marker, done_marker);
+	system(cmd);
+
+	uint8_t chunk[16 * 1024];
+	int total = 0;
+	bool stopped = false;
+	bool finished = false;
+	struct pollfd pfd = {.fd = fd, .events = POLLIN};
+	while (!stopped) {
+		// Wakes up for data or once wget closes the fifo, the timeout is
+		// only for a wget that exits without ever opening it
+		int ready = poll(&pfd, 1, 100);
+		if (!finished)
+			finished = access(done_marker, F_OK) == 0;
+		if (ready <= 0 && !finished)
+			continue;
+
+		ssize_t n;
+		while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+			total += n;
+			if (!callback(chunk, (int)n, userdata)) {
+				stopped = true;
+				break;
+			}
+		}
+		// 0 = wget closed its end (or never opened it and has exited)
+		if (n == 0 && (finished || (pfd.revents & POLLHUP)))
+			break;
+	}
+	close(fd);
+
+	if (stopped && access(done_marker, F_OK) != 0) {
+		// Closing the fifo stops wget on its next write, don't wait for that.
+		// Anchored to the binary so the subshell survives to write the marker.
+		snprintf(cmd, sizeof(cmd), "pkill -f '^" WGET_BIN " .*%s' 2>/dev/null", body_fifo);
+		system(cmd);
+	}
+	// Let the subshell record the exit status before cleaning up
+	for (int i = 0; i < 250 && access(done_marker, F_OK) != 0; i++)
+		usleep(20000);
+
+	char status_text[16] = "";
+	getFile(done_marker, status_text, sizeof(status_text));
+	int status = status_text[0] ? atoi(status_text) : -1;
+
+	parse_response_headers(headers_file, info);
+	unlink(body_fifo);
+	unlink(headers_file);
+	unlink(done_marker);
+
+	if (info->not_modified)
+		return 0;
+	if (!stopped && status != 0) {
+		LOG_error("[WgetFetch] stream: wget failed (%d) after %d bytes: %s\n", status, total, url);
+		return -1;
+	}
+	if (total <= 0) {
+		LOG_error("[WgetFetch] stream: empty response for: %s\n", url);
+		return -1;
+	}
+	return total;
+}
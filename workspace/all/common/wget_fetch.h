@@ -32,4 +32,34 @@ int wget_download_file(const char* url, const char* filepath,
 					   volatile int* progress_pct, volatile bool* should_stop,
 					   volatile int* speed_bps_out, volatile int* eta_sec_out);
 
+/**
+ * Response validators for conditional requests (ETag / Last-Modified).
+ */
+typedef struct {
+	char etag[128];
+	char last_modified[64];
+	bool not_modified; // Server answered 304, no body was delivered
+} WgetFetchInfo;
+
+/**
+ * Receives each chunk of the body as it arrives.
+ * Return false to stop the transfer (the remaining body is not downloaded).
+ */
+typedef bool (*WgetStreamCallback)(const uint8_t* data, int len, void* userdata);
+
+/**
+ * Fetch URL content in chunks without buffering the whole body.
+ * Sends If-None-Match / If-Modified-Since when validators are given.
+ *
+ * @param url           The URL to fetch
+ * @param etag          ETag from the previous fetch, can be NULL or empty
+ * @param last_modified Last-Modified from the previous fetch, can be NULL or empty
+ * @param callback      Called for every chunk of the body
+ * @param userdata      Passed to callback
+ * @param info          Optional, receives the new validators and 304 status
+ * @return              Bytes delivered (0 if not modified), -1 on failure
+ */
+int wget_fetch_stream(const char* url, const char* etag, const char* last_modified,
+					  WgetStreamCallback callback, void* userdata, WgetFetchInfo* info);
+
 #endif // WGET_FETCH_H
@@ -0,0 +1,62 @@
+#include "atomic_file.h"
+#include "defines.h"
+#include "api.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef HAS_SRM
+#include "streams/rzip_stream.h"
+#include "streams/file_stream.h"
+#endif
+
+int AtomicFile_write(const char* filename, const void* data, size_t size, int compress) {
+	char tmp_path[MAX_PATH + 8];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", filename);
+
+	int ok = 1;
+#ifdef HAS_SRM
+	if (compress) {
+		if (!rzipstream_write_file(tmp_path, data, size)) {
+			LOG_error("rzipstream: Error writing data to file: %s\n", tmp_path);
+			ok = 0;
+		}
+	} else {
+		if (!filestream_write_file(tmp_path, data, size)) {
+			LOG_error("filestream: Error writing data to file: %s\n", tmp_path);
+			ok = 0;
+		}
+	}
+#else
+	(void)compress;
+	FILE* file = fopen(tmp_path, "w");
+	if (!file) {
+		LOG_error("Error opening file: %s (%s)\n", tmp_path, strerror(errno));
+		return 0;
+	}
+	if (size != fwrite(data, 1, size, file)) {
+		LOG_error("Error writing data to file: %s (%s)\n", tmp_path, strerror(errno));
+		ok = 0;
+	}
+	if (fclose(file) != 0)
+		ok = 0;
+#endif
+	if (ok) {
+		int fd = open(tmp_path, O_RDONLY);
+		if (fd >= 0) {
+			if (fsync(fd) != 0)
+				ok = 0;
+			close(fd);
+		}
+	}
+	if (ok && rename(tmp_path, filename) != 0) {
+		LOG_error("Error replacing file: %s (%s)\n", filename, strerror(errno));
+		ok = 0;
+	}
+	if (!ok)
+		unlink(tmp_path);
+	return ok;
+}
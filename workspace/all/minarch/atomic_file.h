@@ -0,0 +1,16 @@
+#ifndef __ATOMIC_FILE_H__
+#define __ATOMIC_FILE_H__
+
+#include <stddef.h>
+
+/**
+ * Write data next to filename and rename it into place once it is on disk,
+ * so an interrupted write (crash, battery death) never replaces the previous
+ * file with a truncated one. Only this file is fsync'd, not the whole card.
+ *
+ * @param compress Write with rzipstream (only on platforms with HAS_SRM)
+ * @return 1 if filename now holds data, 0 if it was left untouched
+ */
+int AtomicFile_write(const char* filename, const void* data, size_t size, int compress);
+
+#endif
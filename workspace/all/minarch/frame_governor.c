@@ -0,0 +1,306 @@
+#include "frame_governor.h"
+#include "defines.h"
+#include "api.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GOV_LOG_INFO(fmt, ...) LOG_info("[GOV] " fmt, ##__VA_ARGS__)
+#define GOV_LOG_ERROR(fmt, ...) LOG_error("[GOV] " fmt, ##__VA_ARGS__)
+
+#define GOV_MAX_OPPS 32
+#define GOV_RING_SIZE 64	  // Power of two, > frames per GOV_POLL_MS
+#define GOV_HISTORY_SIZE 256  // Enough for GOV_WINDOW_MS at 240 fps
+#define GOV_POLL_MS 100		  // Evaluate at least this often
+#define GOV_WINDOW_MS 1000	  // Frames a lower frequency has to fit
+#define GOV_UP_HOLD_MS 1000	  // No step down this soon after a step up
+#define GOV_DOWN_STEP_MS 250  // Time between two step downs
+#define GOV_HYSTERESIS 1.10	  // A lower frequency needs 10% spare on top of the headroom
+#define GOV_DEFAULT_HEADROOM 20
+
+/*****************************************************************************
+ * State
+ *****************************************************************************/
+
+typedef struct {
+	float busy_ms;
+	float budget_ms; // 0 = no deadline
+	int khz;		 // Frequency the frame ran at
+	uint32_t time_ms;
+} FrameSample;
+
+static struct {
+	bool available;
+	char min_path[256];
+	char max_path[256];
+	int opps[GOV_MAX_OPPS]; // kHz, ascending
+	int opp_count;
+
+	volatile int headroom;
+	volatile int current_khz; // What the reporting thread assumes frames run at
+
+	// Single producer (main thread), single consumer (governor thread)
+	FrameSample ring[GOV_RING_SIZE];
+	volatile unsigned ring_head;
+	unsigned ring_tail;
+
+	// Owned by the governor thread
+	FrameSample history[GOV_HISTORY_SIZE];
+	unsigned history_head;
+	int current; // Index into opps, -1 = not set yet
+	uint32_t hold_until_ms;
+
+	pthread_t thread;
+	sem_t wake;
+	volatile bool running;
+} gov = {
+	.headroom = GOV_DEFAULT_HEADROOM,
+	.current = -1,
+};
+
+static uint32_t now_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static int compare_int(const void* a, const void* b) {
+	return *(const int*)a - *(const int*)b;
+}
+
+/*****************************************************************************
+ * Frequency
+ *****************************************************************************/
+
+static void apply(int index) {
+	if (index == gov.current)
+		return;
+
+	int khz = gov.opps[index];
+	// The kernel rejects min > max, so move the bound on the far side first
+	if (gov.current < 0 || index > gov.current) {
+		putInt(gov.max_path, khz);
+		putInt(gov.min_path, khz);
+	} else {
+		putInt(gov.min_path, khz);
+		putInt(gov.max_path, khz);
+	}
+	gov.current = index;
+	gov.current_khz = khz;
+}
+
+// Lowest operating point that runs `kcycles` (busy ms * kHz) within `ms`
+static int lowest_fitting(double kcycles, double ms) {
+	for (int i = 0; i < gov.opp_count; i++) {
+		if (kcycles <= gov.opps[i] * ms)
+			return i;
+	}
+	return gov.opp_count - 1;
+}
+
+static double usable_ms(const FrameSample* sample) {
+	return sample->budget_ms * (100 - gov.headroom) / 100.0;
+}
+
+static void evaluate(void) {
+	uint32_t now = now_ms();
+	int target = gov.current;
+	bool raise = false;
+
+	unsigned head = gov.ring_head;
+	__sync_synchronize();
+	if (head - gov.ring_tail > GOV_RING_SIZE)
+		gov.ring_tail = head - GOV_RING_SIZE; // Fell behind, the oldest frames are gone
+
+	for (; gov.ring_tail != head; gov.ring_tail++) {
+		FrameSample sample = gov.ring[gov.ring_tail & (GOV_RING_SIZE - 1)];
+		gov.history[gov.history_head++ & (GOV_HISTORY_SIZE - 1)] = sample;
+
+		if (sample.budget_ms <= 0) {
+			target = gov.opp_count - 1;
+			raise = true;
+			continue;
+		}
+
+		double kcycles = (double)sample.busy_ms * sample.khz;
+		int needed = lowest_fitting(kcycles, usable_ms(&sample));
+		if (sample.busy_ms > sample.budget_ms && needed < gov.opp_count - 1)
+			needed++; // Missed outright, the estimate was optimistic
+		if (needed > target) {
+			target = needed;
+			raise = true;
+		}
+	}
+
+	if (raise) {
+		gov.hold_until_ms = now + GOV_UP_HOLD_MS;
+	} else if (gov.current > 0 && (int32_t)(now - gov.hold_until_ms) >= 0) {
+		// Step down once every frame of the last window fits one point lower
+		int lower = gov.opps[gov.current - 1];
+		bool fits = false;
+		for (unsigned i = 0; i < GOV_HISTORY_SIZE; i++) {
+			const FrameSample* sample = &gov.history[(gov.history_head - 1 - i) & (GOV_HISTORY_SIZE - 1)];
+			if (sample->khz == 0 || now - sample->time_ms > GOV_WINDOW_MS)
+				break;
+			if (sample->budget_ms <= 0) {
+				fits = false;
+				break;
+			}
+			fits = (double)sample->busy_ms * sample->khz * GOV_HYSTERESIS <= lower * usable_ms(sample);
+			if (!fits)
+				break;
+		}
+		if (fits) {
+			target = gov.current - 1;
+			gov.hold_until_ms = now + GOV_DOWN_STEP_MS;
+		}
+	}
+
+	apply(target);
+}
+
+static void* governor_thread(void* arg) {
+	PWR_pinToCores(CPU_CORE_EFFICIENCY);
+
+	while (gov.running) {
+		struct timespec deadline;
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_nsec += GOV_POLL_MS * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+		while (sem_timedwait(&gov.wake, &deadline) != 0 && errno == EINTR)
+			;
+		if (!gov.running)
+			break;
+		evaluate();
+	}
+	return NULL;
+}
+
+/*****************************************************************************
+ * Public API
+ *****************************************************************************/
+
+bool FrameGov_init(const char* cpufreq_path) {
+	FrameGov_quit();
+	if (!cpufreq_path || !cpufreq_path[0])
+		return false;
+
+	char path[256];
+	char buffer[512] = {0};
+	snprintf(path, sizeof(path), "%s/scaling_available_frequencies", cpufreq_path);
+	getFile(path, buffer, sizeof(buffer));
+
+	int count = 0;
+	char* cursor = buffer;
+	while (count < GOV_MAX_OPPS) {
+		char* end;
+		long khz = strtol(cursor, &end, 10);
+		if (end == cursor)
+			break;
+		if (khz > 0)
+			gov.opps[count++] = (int)khz;
+		cursor = end;
+	}
+	qsort(gov.opps, count, sizeof(int), compare_int);
+
+	gov.opp_count = 0;
+	for (int i = 0; i < count; i++) {
+		if (gov.opp_count == 0 || gov.opps[gov.opp_count - 1] != gov.opps[i])
+			gov.opps[gov.opp_count++] = gov.opps[i];
+	}
+
+	snprintf(gov.min_path, sizeof(gov.min_path), "%s/scaling_min_freq", cpufreq_path);
+	snprintf(gov.max_path, sizeof(gov.max_path), "%s/scaling_max_freq", cpufreq_path);
+	if (gov.opp_count < 2 || access(gov.min_path, W_OK) != 0 || access(gov.max_path, W_OK) != 0) {
+		GOV_LOG_INFO("Not available for %s\n", cpufreq_path);
+		return false;
+	}
+
+	if (sem_init(&gov.wake, 0, 0) != 0)
+		return false;
+
+	gov.available = true;
+	GOV_LOG_INFO("%d operating points, %d-%d kHz\n", gov.opp_count, gov.opps[0], gov.opps[gov.opp_count - 1]);
+	return true;
+}
+
+void FrameGov_quit(void) {
+	FrameGov_stop();
+	if (gov.available)
+		sem_destroy(&gov.wake);
+	gov.available = false;
+	gov.opp_count = 0;
+}
+
+void FrameGov_start(void) {
+	if (!gov.available || gov.running)
+		return;
+
+	// Start from the top and let the frames bring it down
+	gov.current = -1;
+	apply(gov.opp_count - 1);
+	gov.hold_until_ms = now_ms() + GOV_UP_HOLD_MS;
+	gov.ring_tail = gov.ring_head;
+	memset(gov.history, 0, sizeof(gov.history));
+	gov.history_head = 0;
+
+	gov.running = true;
+	if (pthread_create(&gov.thread, NULL, governor_thread, NULL) != 0) {
+		GOV_LOG_ERROR("Failed to start thread\n");
+		gov.running = false;
+	}
+}
+
+void FrameGov_stop(void) {
+	if (!gov.running)
+		return;
+	gov.running = false;
+	sem_post(&gov.wake);
+	pthread_join(gov.thread, NULL);
+}
+
+bool FrameGov_isRunning(void) {
+	return gov.running;
+}
+
+void FrameGov_setHeadroom(int percent) {
+	if (percent < 0)
+		percent = 0;
+	if (percent > 90)
+		percent = 90;
+	gov.headroom = percent;
+}
+
+void FrameGov_reportFrame(double busy_ms, double budget_ms) {
+	if (!gov.running)
+		return;
+
+	int khz = gov.current_khz;
+	unsigned head = gov.ring_head;
+	FrameSample* sample = &gov.ring[head & (GOV_RING_SIZE - 1)];
+	sample->busy_ms = busy_ms;
+	sample->budget_ms = budget_ms;
+	sample->khz = khz;
+	sample->time_ms = now_ms();
+	__sync_synchronize();
+	gov.ring_head = head + 1;
+
+	// Don't wait for the next poll when the clock is already too low
+	bool top = khz >= gov.opps[gov.opp_count - 1];
+	if (!top && (budget_ms <= 0 || busy_ms > budget_ms * (100 - gov.headroom) / 100.0)) {
+		int pending = 0;
+		if (sem_getvalue(&gov.wake, &pending) == 0 && pending == 0)
+			sem_post(&gov.wake);
+	}
+}
@@ -0,0 +1,60 @@
+#ifndef __FRAME_GOVERNOR_H__
+#define __FRAME_GOVERNOR_H__
+
+#include <stdbool.h>
+
+// Userspace CPU frequency governor driven by frame deadlines.
+//
+// The main thread reports how long each frame's work took (core.run() and
+// video, without the pacing wait). A background thread converts that into
+// cycles and pins scaling_min_freq/scaling_max_freq to the lowest
+// operating point that finishes the frame with the configured headroom
+// left. A frame that comes close to its deadline raises the clock at
+// once; the clock only steps down, one operating point at a time, after
+// the last second of frames would have fit comfortably.
+
+/**
+ * Read the operating points from a cpufreq directory
+ * (e.g. /sys/devices/system/cpu/cpu0/cpufreq, or a fake one on desktop).
+ *
+ * @param cpufreq_path Directory with scaling_available_frequencies,
+ *                     scaling_min_freq and scaling_max_freq
+ * @return true if the governor can be used
+ */
+bool FrameGov_init(const char* cpufreq_path);
+
+/**
+ * Release everything, stops the thread if running.
+ */
+void FrameGov_quit(void);
+
+/**
+ * Start adjusting the frequency. Does nothing if already running or if
+ * FrameGov_init() failed.
+ */
+void FrameGov_start(void);
+
+/**
+ * Stop adjusting the frequency. The last one set stays until the caller
+ * picks another preset.
+ */
+void FrameGov_stop(void);
+
+bool FrameGov_isRunning(void);
+
+/**
+ * Share of the frame budget to keep free, in percent (default 20).
+ */
+void FrameGov_setHeadroom(int percent);
+
+/**
+ * Report a finished frame. Cheap enough to call every frame from the main
+ * thread; never blocks on sysfs.
+ *
+ * @param busy_ms   Time the frame spent working
+ * @param budget_ms Time available per frame, 0 when there is no deadline
+ *                  (fast forward), which asks for the highest frequency
+ */
+void FrameGov_reportFrame(double busy_ms, double budget_ms);
+
+#endif
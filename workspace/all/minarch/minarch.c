@@ -9,6 +9,7 @@
 #include <libgen.h>
 #include <time.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <errno.h>
 #include <zip.h>
 #include <pthread.h>
@@ -31,6 +32,9 @@
 #include "config.h"
 #include "ra_integration.h"
 #include "ra_badges.h"
+#include "frame_governor.h"
+#include "atomic_file.h"
+#include "rewind_delta.h"
 #include <dirent.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
@@ -71,6 +75,13 @@ enum {
 #define REWIND_MAX_BUFFER_MB 256					   // max rewind buffer size
 #define REWIND_MAX_LZ4_ACCELERATION 64				   // max LZ4 acceleration value
 
+// run-ahead
+#define RUNAHEAD_MAX_FRAMES 4
+enum {
+	RUNAHEAD_SINGLE, // snapshot, run ahead, restore on the one core instance
+	RUNAHEAD_SECOND, // keep a second core instance ahead, resync only on input change
+};
+
 // default frontend options
 static int screen_scaling = SCALE_ASPECT;
 static int resampling_quality = 2;
@@ -98,7 +109,11 @@ static int rewind_cfg_granularity = MINARCH_DEFAULT_REWIND_GRANULARITY;
 static int rewind_cfg_audio = MINARCH_DEFAULT_REWIND_AUDIO;
 static int rewind_cfg_compress = 1;
 static int rewind_cfg_lz4_acceleration = MINARCH_DEFAULT_REWIND_LZ4_ACCELERATION;
+static int sram_flush_interval = 30; // seconds, 0 = only on menu, sleep and quit
+static int runahead_frames = 0; // 0 = off
+static int runahead_mode = RUNAHEAD_SINGLE;
 static int overclock = 3; // auto
+static int cpu_headroom = 20; // percent of the frame budget kept free by the Adaptive CPU speed
 static int has_custom_controllers = 0;
 static int gamepad_type = 0; // index in gamepad_labels/gamepad_values
 
@@ -120,6 +135,7 @@ static struct Core {
 	const char name[128];		// eg. gambatte
 	const char version[128];	// eg. Gambatte (v0.5.0-netlink 7e02df6)
 	const char extensions[128]; // eg. gb|gbc|dmg
+	const char path[MAX_PATH];	// eg. /mnt/sdcard/.system/rg35xx/cores/gambatte_libretro.so
 
 	const char config_dir[MAX_PATH];   // eg. /mnt/sdcard/.userdata/rg35xx/GB-gambatte
 	const char states_dir[MAX_PATH];   // eg. /mnt/sdcard/.userdata/arm-480/GB-gambatte
@@ -158,7 +174,42 @@ static struct Core {
 	// retro_audio_buffer_status_callback_t audio_buffer_status;
 } core;
 
+// run-ahead bookkeeping, see RunAhead_runFrame()
+static struct {
+	int active; // a run-ahead sequence of retro_run() calls is in progress
+	int replay; // input was already polled for this sequence
+	int video;	// present video from the current retro_run()
+	int audio;	// queue audio from the current retro_run()
+	int resync; // second instance must be reloaded from the main instance
+	int failed; // core can't serialize, run-ahead stays off until relaunch
+
+	void* state;
+	size_t state_size;
+
+	uint32_t last_buttons;
+	int last_axes[4];
+
+	// second instance
+	struct {
+		void* handle;
+		char dir[MAX_PATH];		  // private temp dir, removed with the instance
+		char path[MAX_PATH];	  // private copy of the core so dlopen() maps it again
+		char saves_dir[MAX_PATH]; // throwaway save directory, only the main instance persists
+		int loaded;
+		int variables_changed;
+		void (*init)(void);
+		void (*deinit)(void);
+		void (*run)(void);
+		size_t (*serialize_size)(void);
+		bool (*unserialize)(const void* data, size_t size);
+		bool (*load_game)(const struct retro_game_info* game);
+		void (*unload_game)(void);
+		void (*set_controller_port_device)(unsigned port, unsigned device);
+	} second;
+} runahead;
+
 int extract_zip(char** extensions);
+static int Game_unzipToMemory(char** extensions);
 static bool getAlias(char* path, char* alias);
 
 static struct Game {
@@ -166,11 +217,43 @@ static struct Game {
 	char name[MAX_PATH];	 // TODO: rename to basename?
 	char alt_name[MAX_PATH]; // alternate name, eg. unzipped rom file name
 	char m3u_path[MAX_PATH];
-	char tmp_path[MAX_PATH]; // location of unzipped file
+	char tmp_path[MAX_PATH]; // location of unzipped file, or "archive.zip#entry" when unzipped to memory
 	void* data;
 	size_t size;
+	int mapped; // data is an mmap()ed rom or unzipped image, not malloc()ed
 	int is_open;
 } game;
+
+// Maps the rom instead of reading it into the heap. MAP_PRIVATE because
+// retro_game_info.data is const but not every core honors that, any page
+// a core scribbles on gets copied and the file stays untouched.
+static int Game_mapFile(const char* path) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		LOG_error("Error opening game: %s\n\t%s\n", path, strerror(errno));
+		return 0;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		LOG_error("Error reading game size: %s\n", path);
+		close(fd);
+		return 0;
+	}
+
+	void* data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		LOG_error("Couldn't map game: %s (%s)\n", path, strerror(errno));
+		return 0;
+	}
+	madvise(data, st.st_size, MADV_WILLNEED);
+
+	game.data = data;
+	game.size = st.st_size;
+	game.mapped = 1;
+	return 1;
+}
 static void Game_open(char* path) {
 	int skipzip = 0;
 	memset(&game, 0, sizeof(game));
@@ -219,7 +302,11 @@ static void Game_open(char* path) {
 		extensions[i] = NULL;
 
 		// if the core doesn't support zip files natively
-		if (!supports_zip) {
+		// cores that load from memory get the rom unzipped straight into RAM
+		if (!supports_zip && !core.need_fullpath) {
+			if (!Game_unzipToMemory(extensions))
+				return;
+		} else if (!supports_zip) {
 			// extract zip file located at game.path to game.tmp_path
 			// game.tmp_path is temp dir generated by mkdtemp
 			if (!extract_zip(extensions))
@@ -232,28 +319,10 @@ static void Game_open(char* path) {
 
 	// some cores handle opening files themselves, eg. pcsx_rearmed
 	// if the frontend tries to load a 500MB file itself bad things happen
-	if (!core.need_fullpath) {
+	if (!core.need_fullpath && !game.data) {
 		path = game.tmp_path[0] == '\0' ? game.path : game.tmp_path;
-
-		FILE* file = fopen(path, "r");
-		if (file == NULL) {
-			LOG_error("Error opening game: %s\n\t%s\n", path, strerror(errno));
-			return;
-		}
-
-		fseek(file, 0, SEEK_END);
-		game.size = ftell(file);
-
-		rewind(file);
-		game.data = malloc(game.size);
-		if (game.data == NULL) {
-			LOG_error("Couldn't allocate memory for file: %s\n", path);
+		if (!Game_mapFile(path))
 			return;
-		}
-
-		fread(game.data, sizeof(uint8_t), game.size, file);
-
-		fclose(file);
 	}
 
 	// m3u-based?
@@ -289,8 +358,12 @@ static void Game_open(char* path) {
 	game.is_open = 1;
 }
 static void Game_close(void) {
-	if (game.data)
-		free(game.data);
+	if (game.data) {
+		if (game.mapped)
+			munmap(game.data, game.size);
+		else
+			free(game.data);
+	}
 	// why delete tempfile? keep it for next time when loading the game its much faster from /tmp ram folder
 	// if (game.tmp_path[0]) remove(game.tmp_path);
 	game.is_open = 0;
@@ -426,6 +499,93 @@ int extract_zip(char** extensions) {
 	return 0;
 }
 
+// Decompresses the first rom in the zip into an anonymous mapping, so
+// cores that load from memory skip the /tmp/nextarch copy and the rom
+// isn't held in RAM twice (tmpfs + heap). game.tmp_path is set to the
+// RetroArch style "archive.zip#entry" so cores can still sniff the extension.
+static int Game_unzipToMemory(char** extensions) {
+	struct zip* za;
+	int ze;
+	if ((za = zip_open(game.path, 0, &ze)) == NULL) {
+		zip_error_t error;
+		zip_error_init_with_code(&error, ze);
+		LOG_error("can't open zip archive `%s': %s\n", game.path, zip_error_strerror(&error));
+		return 0;
+	}
+
+	int success = 0;
+	struct zip_stat sb;
+	zip_int64_t count = zip_get_num_entries(za, 0);
+	for (zip_int64_t i = 0; i < count; i++) {
+		if (zip_stat_index(za, i, 0, &sb) != 0)
+			continue;
+
+		int len = strlen(sb.name);
+		if (!len || sb.name[len - 1] == '/')
+			continue;
+
+		int found = 0;
+		char extension[8];
+		for (int e = 0; extensions[e]; e++) {
+			sprintf(extension, ".%s", extensions[e]);
+			if (suffixMatch(extension, sb.name)) {
+				found = 1;
+				break;
+			}
+		}
+		if (!found)
+			continue;
+
+		if (!sb.size) {
+			LOG_error("zip entry is empty: %s\n", sb.name);
+			break;
+		}
+
+		void* data = mmap(NULL, sb.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (data == MAP_FAILED) {
+			LOG_error("Couldn't map memory for %s (%s)\n", sb.name, strerror(errno));
+			break;
+		}
+
+		struct zip_file* zf = zip_fopen_index(za, i, 0);
+		if (!zf) {
+			LOG_error("zip_fopen_index failed\n");
+			munmap(data, sb.size);
+			break;
+		}
+
+		zip_uint64_t sum = 0;
+		while (sum < sb.size) {
+			zip_int64_t read = zip_fread(zf, (uint8_t*)data + sum, sb.size - sum);
+			if (read <= 0)
+				break;
+			sum += read;
+		}
+		zip_fclose(zf);
+
+		if (sum != sb.size) {
+			LOG_error("zip_fread failed\n");
+			munmap(data, sb.size);
+			break;
+		}
+
+		game.data = data;
+		game.size = sb.size;
+		game.mapped = 1;
+
+		snprintf(game.tmp_path, sizeof(game.tmp_path), "%s#%s", game.path, sb.name);
+		if (CFG_getUseExtractedFileName()) {
+			char* name = strrchr(sb.name, '/');
+			snprintf(game.alt_name, sizeof(game.alt_name), "%s", name ? name + 1 : sb.name);
+		}
+		success = 1;
+		break;
+	}
+
+	zip_close(za);
+	return success;
+}
+
 ///////////////////////////////////////
 // based on picoarch/cheat.c
 
@@ -789,6 +949,30 @@ static void SRAM_getPath(char* filename) {
 	}
 }
 
+// background save RAM checkpointing, see SRAM_checkpoint()
+static struct {
+	pthread_t worker;
+	pthread_mutex_t mx; // guards the job fields and last_flush
+	pthread_cond_t cv;
+	pthread_mutex_t write_mx; // one writer of the save file at a time
+	int running;
+	int stop;
+	int pending; // job is waiting for the worker
+	int busy;	 // worker is writing job
+	void* shadow; // save RAM as of the last flush, emulation thread only
+	void* job;	  // snapshot handed to the worker
+	size_t size;
+	char path[MAX_PATH];
+	int compress;
+	uint32_t last_check;
+	time_t last_flush;
+} sram_ckpt = {
+	.mx = PTHREAD_MUTEX_INITIALIZER,
+	.cv = PTHREAD_COND_INITIALIZER,
+	.write_mx = PTHREAD_MUTEX_INITIALIZER,
+};
+static char sram_flush_desc[256] = "Periodically write in-game saves to the SD card.";
+
 static void SRAM_read(void) {
 	size_t sram_size = core.get_memory_size(RETRO_MEMORY_SAVE_RAM);
 	if (!sram_size)
@@ -835,6 +1019,10 @@ static void SRAM_read(void) {
 #endif
 }
 
+static int SRAM_compressed(void) {
+	return CFG_getSaveFormat() == SAVE_FORMAT_SRM;
+}
+
 static void SRAM_write(void) {
 	size_t sram_size = core.get_memory_size(RETRO_MEMORY_SAVE_RAM);
 	if (!sram_size)
@@ -845,28 +1033,148 @@ static void SRAM_write(void) {
 	printf("sav path (write): %s\n", filename);
 
 	void* sram = core.get_memory_data(RETRO_MEMORY_SAVE_RAM);
+	if (!sram) {
+		LOG_error("Error writing SRAM data to file\n");
+		return;
+	}
 
-#ifdef HAS_SRM
-	// srm, compressed
-	if (CFG_getSaveFormat() == SAVE_FORMAT_SRM) {
-		if (!rzipstream_write_file(filename, sram, sram_size))
-			LOG_error("rzipstream: Error writing SRAM data to file\n");
-	} else {
-		if (!filestream_write_file(filename, sram, sram_size))
-			LOG_error("filestream: Error writing SRAM data to file\n");
+	// drop a queued checkpoint (it's older than this) and wait out one being written
+	pthread_mutex_lock(&sram_ckpt.mx);
+	sram_ckpt.pending = 0;
+	pthread_mutex_unlock(&sram_ckpt.mx);
+
+	pthread_mutex_lock(&sram_ckpt.write_mx);
+	int ok = AtomicFile_write(filename, sram, sram_size, SRAM_compressed());
+	pthread_mutex_unlock(&sram_ckpt.write_mx);
+
+	if (ok) {
+		if (sram_ckpt.shadow && sram_ckpt.size == sram_size)
+			memcpy(sram_ckpt.shadow, sram, sram_size);
+		pthread_mutex_lock(&sram_ckpt.mx);
+		sram_ckpt.last_flush = time(NULL);
+		pthread_mutex_unlock(&sram_ckpt.mx);
 	}
-#else
-	FILE* sram_file = fopen(filename, "w");
-	if (!sram_file) {
-		LOG_error("Error opening SRAM file: %s\n", strerror(errno));
+	sync();
+}
+
+static void* SRAM_worker(void* arg) {
+	(void)arg;
+	pthread_mutex_lock(&sram_ckpt.mx);
+	while (1) {
+		while (!sram_ckpt.stop && !sram_ckpt.pending)
+			pthread_cond_wait(&sram_ckpt.cv, &sram_ckpt.mx);
+		if (sram_ckpt.stop)
+			break;
+
+		char filename[MAX_PATH];
+		strcpy(filename, sram_ckpt.path);
+		size_t size = sram_ckpt.size;
+		sram_ckpt.pending = 0;
+		sram_ckpt.busy = 1;
+		// taken before mx is released so SRAM_write() can't slip in and be overwritten by this older copy
+		pthread_mutex_lock(&sram_ckpt.write_mx);
+		pthread_mutex_unlock(&sram_ckpt.mx);
+
+		int ok = AtomicFile_write(filename, sram_ckpt.job, size, sram_ckpt.compress);
+		pthread_mutex_unlock(&sram_ckpt.write_mx);
+
+		pthread_mutex_lock(&sram_ckpt.mx);
+		sram_ckpt.busy = 0;
+		if (ok)
+			sram_ckpt.last_flush = time(NULL);
+	}
+	pthread_mutex_unlock(&sram_ckpt.mx);
+	return NULL;
+}
+
+static void SRAM_stopCheckpoint(void) {
+	if (sram_ckpt.running) {
+		pthread_mutex_lock(&sram_ckpt.mx);
+		sram_ckpt.stop = 1;
+		pthread_cond_signal(&sram_ckpt.cv);
+		pthread_mutex_unlock(&sram_ckpt.mx);
+		pthread_join(sram_ckpt.worker, NULL);
+		sram_ckpt.running = 0;
+		sram_ckpt.stop = 0;
+	}
+	free(sram_ckpt.shadow);
+	free(sram_ckpt.job);
+	sram_ckpt.shadow = NULL;
+	sram_ckpt.job = NULL;
+	sram_ckpt.size = 0;
+}
+
+// Takes the clean reference copy that later checkpoints compare against, call after SRAM_read()
+static void SRAM_resetCheckpoint(void) {
+	SRAM_stopCheckpoint();
+
+	size_t sram_size = core.get_memory_size(RETRO_MEMORY_SAVE_RAM);
+	void* sram = core.get_memory_data(RETRO_MEMORY_SAVE_RAM);
+	if (!sram_size || !sram)
+		return;
+
+	sram_ckpt.shadow = malloc(sram_size);
+	sram_ckpt.job = malloc(sram_size);
+	if (!sram_ckpt.shadow || !sram_ckpt.job) {
+		SRAM_stopCheckpoint();
 		return;
 	}
-	if (!sram || sram_size != fwrite(sram, 1, sram_size, sram_file)) {
-		LOG_error("Error writing SRAM data to file\n");
+	memcpy(sram_ckpt.shadow, sram, sram_size);
+	sram_ckpt.size = sram_size;
+	sram_ckpt.last_check = SDL_GetTicks();
+
+	if (pthread_create(&sram_ckpt.worker, NULL, SRAM_worker, NULL) != 0) {
+		LOG_error("SRAM: failed to start checkpoint thread\n");
+		SRAM_stopCheckpoint();
+		return;
+	}
+	sram_ckpt.running = 1;
+}
+
+// Called every frame: every sram_flush_interval seconds, snapshot save RAM if the
+// game changed it and let the worker write it out without stalling the frame loop
+static void SRAM_checkpoint(void) {
+	if (!sram_flush_interval || !sram_ckpt.running)
+		return;
+
+	uint32_t now = SDL_GetTicks();
+	if (now - sram_ckpt.last_check < (uint32_t)sram_flush_interval * 1000)
+		return;
+	sram_ckpt.last_check = now;
+
+	size_t sram_size = core.get_memory_size(RETRO_MEMORY_SAVE_RAM);
+	void* sram = core.get_memory_data(RETRO_MEMORY_SAVE_RAM);
+	if (!sram || sram_size != sram_ckpt.size)
+		return;
+	if (memcmp(sram_ckpt.shadow, sram, sram_size) == 0)
+		return;
+
+	pthread_mutex_lock(&sram_ckpt.mx);
+	if (!sram_ckpt.pending && !sram_ckpt.busy) {
+		// still dirty next interval if the worker is busy, shadow is only updated once handed off
+		memcpy(sram_ckpt.job, sram, sram_size);
+		memcpy(sram_ckpt.shadow, sram_ckpt.job, sram_size);
+		SRAM_getPath(sram_ckpt.path);
+		sram_ckpt.compress = SRAM_compressed();
+		sram_ckpt.pending = 1;
+		pthread_cond_signal(&sram_ckpt.cv);
+	}
+	pthread_mutex_unlock(&sram_ckpt.mx);
+}
+
+static void SRAM_describeFlush(void) {
+	pthread_mutex_lock(&sram_ckpt.mx);
+	time_t last_flush = sram_ckpt.last_flush;
+	pthread_mutex_unlock(&sram_ckpt.mx);
+
+	if (!sram_ckpt.size) {
+		strcpy(sram_flush_desc, "Periodically write in-game saves to the SD card.\nThis game has no save RAM.");
+	} else if (!last_flush) {
+		strcpy(sram_flush_desc, "Periodically write in-game saves to the SD card.\nNot saved yet this session.");
+	} else {
+		struct tm* t = localtime(&last_flush);
+		snprintf(sram_flush_desc, sizeof(sram_flush_desc), "Periodically write in-game saves to the SD card.\nLast saved at %02d:%02d:%02d.", t->tm_hour, t->tm_min, t->tm_sec);
 	}
-	fclose(sram_file);
-#endif
-	sync();
 }
 
 ///////////////////////////////////////
@@ -967,6 +1275,39 @@ static void State_getPath(char* filename) {
 	}
 }
 
+// asynchronous savestate persistence, see State_write()
+#define STATE_ARENA_COUNT 2
+enum {
+	STATE_JOB_FREE,
+	STATE_JOB_FILLING, // emulation thread is serializing into it
+	STATE_JOB_QUEUED,
+	STATE_JOB_WRITING,
+};
+typedef struct StateJob {
+	void* data;
+	size_t capacity;
+	size_t size;
+	char path[MAX_PATH];
+	int compress;
+	int status;
+	uint32_t seq; // queue order
+} StateJob;
+static struct {
+	pthread_t worker;
+	pthread_mutex_t mx;
+	pthread_cond_t cv;		// a job was queued or stop requested
+	pthread_cond_t idle_cv; // a job went back to STATE_JOB_FREE
+	int running;
+	int stop;
+	uint32_t seq;
+	StateJob jobs[STATE_ARENA_COUNT];
+} state_io = {
+	.mx = PTHREAD_MUTEX_INITIALIZER,
+	.cv = PTHREAD_COND_INITIALIZER,
+	.idle_cv = PTHREAD_COND_INITIALIZER,
+};
+static void State_flush(void);
+
 #define RASTATE_HEADER_SIZE 16
 static int State_read(void) { // from picoarch
 	// Block load states in RetroAchievements hardcore mode
@@ -980,6 +1321,9 @@ static int State_read(void) { // from picoarch
 	if (!state_size)
 		return 0;
 
+	// the slot may still be on its way to disk
+	State_flush();
+
 	int was_ff = fast_forward;
 	fast_forward = 0;
 
@@ -1076,6 +1420,84 @@ error:
 	return success;
 }
 
+static void* State_worker(void* arg) {
+	(void)arg;
+	pthread_mutex_lock(&state_io.mx);
+	while (1) {
+		StateJob* job = NULL;
+		while (!state_io.stop) {
+			for (int i = 0; i < STATE_ARENA_COUNT; i++) {
+				StateJob* candidate = &state_io.jobs[i];
+				if (candidate->status == STATE_JOB_QUEUED && (!job || candidate->seq < job->seq))
+					job = candidate;
+			}
+			if (job)
+				break;
+			pthread_cond_wait(&state_io.cv, &state_io.mx);
+		}
+		if (!job)
+			break; // stop requested and nothing left to write
+
+		job->status = STATE_JOB_WRITING;
+		pthread_mutex_unlock(&state_io.mx);
+
+		if (!AtomicFile_write(job->path, job->data, job->size, job->compress))
+			LOG_error("Error writing state data to file: %s\n", job->path);
+
+		pthread_mutex_lock(&state_io.mx);
+		job->status = STATE_JOB_FREE;
+		pthread_cond_broadcast(&state_io.idle_cv);
+	}
+	pthread_mutex_unlock(&state_io.mx);
+	return NULL;
+}
+
+// Blocks until every queued state has been written, eg. before reading one back or exiting
+static void State_flush(void) {
+	pthread_mutex_lock(&state_io.mx);
+	while (1) {
+		int busy = 0;
+		for (int i = 0; i < STATE_ARENA_COUNT; i++) {
+			if (state_io.jobs[i].status != STATE_JOB_FREE)
+				busy = 1;
+		}
+		if (!busy)
+			break;
+		pthread_cond_wait(&state_io.idle_cv, &state_io.mx);
+	}
+	pthread_mutex_unlock(&state_io.mx);
+}
+static int State_isPending(const char* filename) {
+	int pending = 0;
+	pthread_mutex_lock(&state_io.mx);
+	for (int i = 0; i < STATE_ARENA_COUNT; i++) {
+		StateJob* job = &state_io.jobs[i];
+		if ((job->status == STATE_JOB_QUEUED || job->status == STATE_JOB_WRITING) && exactMatch(job->path, filename))
+			pending = 1;
+	}
+	pthread_mutex_unlock(&state_io.mx);
+	return pending;
+}
+static void State_quit(void) {
+	if (state_io.running) {
+		pthread_mutex_lock(&state_io.mx);
+		state_io.stop = 1;
+		pthread_cond_signal(&state_io.cv);
+		pthread_mutex_unlock(&state_io.mx);
+		pthread_join(state_io.worker, NULL); // drains the queue first
+		state_io.running = 0;
+		state_io.stop = 0;
+	}
+	for (int i = 0; i < STATE_ARENA_COUNT; i++) {
+		free(state_io.jobs[i].data);
+		state_io.jobs[i].data = NULL;
+		state_io.jobs[i].capacity = 0;
+	}
+}
+
+// Serializes on the emulation thread into one of two reusable arenas and
+// leaves compression and the disk write to State_worker(), so saving costs
+// about one retro_serialize() instead of a visible hitch.
 static int State_write(void) { // from picoarch
 	// Block save states in RetroAchievements hardcore mode
 	if (RA_isHardcoreModeActive()) {
@@ -1083,64 +1505,80 @@ static int State_write(void) { // from picoarch
 		return 0;
 	}
 
-	int success = 0;
 	size_t state_size = core.serialize_size();
 	if (!state_size)
 		return 0;
 
-	int was_ff = fast_forward;
-	fast_forward = 0;
-
-	void* state = calloc(1, state_size);
-	if (!state) {
-		LOG_error("Couldn't allocate memory for state\n");
-		goto error;
-	}
-
-	if (!core.serialize(state, state_size)) {
-		LOG_error("Error serializing save state\n");
-		goto error;
+	if (!state_io.running) {
+		if (pthread_create(&state_io.worker, NULL, State_worker, NULL) == 0)
+			state_io.running = 1;
+		else
+			LOG_error("Couldn't start state writer, saving synchronously\n");
 	}
 
 	char filename[MAX_PATH];
 	State_getPath(filename);
-#ifdef HAS_SRM
-	if (CFG_getStateFormat() == STATE_FORMAT_SRM || CFG_getStateFormat() == STATE_FORMAT_SRM_EXTRADOT) {
-		if (!rzipstream_write_file(filename, state, state_size)) {
-			LOG_error("rzipstream: Error writing state data to file: %s\n", filename);
-			goto error;
+
+	// an unstarted write of the same slot is simply superseded, otherwise take a free arena
+	pthread_mutex_lock(&state_io.mx);
+	StateJob* job = NULL;
+	while (!job) {
+		for (int i = 0; i < STATE_ARENA_COUNT && !job; i++) {
+			if (state_io.jobs[i].status == STATE_JOB_QUEUED && exactMatch(state_io.jobs[i].path, filename))
+				job = &state_io.jobs[i];
 		}
-		success = 1;
-	} else {
-		if (!filestream_write_file(filename, state, state_size)) {
-			LOG_error("filestream: Error writing state data to file: %s\n", filename);
+		for (int i = 0; i < STATE_ARENA_COUNT && !job; i++) {
+			if (state_io.jobs[i].status == STATE_JOB_FREE)
+				job = &state_io.jobs[i];
+		}
+		if (!job)
+			pthread_cond_wait(&state_io.idle_cv, &state_io.mx);
+	}
+	job->status = STATE_JOB_FILLING;
+	pthread_mutex_unlock(&state_io.mx);
+
+	int success = 0;
+	int was_ff = fast_forward;
+	fast_forward = 0;
+
+	if (job->capacity < state_size) {
+		void* data = realloc(job->data, state_size);
+		if (!data) {
+			LOG_error("Couldn't allocate memory for state\n");
 			goto error;
 		}
-		success = 1;
+		job->data = data;
+		job->capacity = state_size;
 	}
+	memset(job->data, 0, state_size);
 
-error:
-	if (state)
-		free(state);
-#else
-	FILE* state_file = fopen(filename, "w");
-	if (!state_file) {
-		LOG_error("Error opening state file: %s (%s)\n", filename, strerror(errno));
+	if (!core.serialize(job->data, state_size)) {
+		LOG_error("Error serializing save state\n");
 		goto error;
 	}
-	if (state_size != fwrite(state, 1, state_size, state_file)) {
-		LOG_error("Error writing state data to file: %s (%s)\n", filename, strerror(errno));
+
+	strcpy(job->path, filename);
+	job->size = state_size;
+	job->compress = CFG_getStateFormat() == STATE_FORMAT_SRM || CFG_getStateFormat() == STATE_FORMAT_SRM_EXTRADOT;
+
+	if (!state_io.running) {
+		success = AtomicFile_write(job->path, job->data, job->size, job->compress);
 		goto error;
 	}
-	success = 1;
-error:
-	if (state)
-		free(state);
-	if (state_file)
-		fclose(state_file);
-#endif
 
-	sync();
+	pthread_mutex_lock(&state_io.mx);
+	job->seq = ++state_io.seq;
+	job->status = STATE_JOB_QUEUED;
+	pthread_cond_signal(&state_io.cv);
+	pthread_mutex_unlock(&state_io.mx);
+	fast_forward = was_ff;
+	return 1;
+
+error:
+	pthread_mutex_lock(&state_io.mx);
+	job->status = STATE_JOB_FREE;
+	pthread_cond_broadcast(&state_io.idle_cv);
+	pthread_mutex_unlock(&state_io.mx);
 	fast_forward = was_ff;
 	return success;
 }
@@ -1191,9 +1629,12 @@ typedef struct {
 	size_t scratch_size;
 
 	// Delta compression: store XOR of current vs previous state
+	// A delta entry is a bitmap with one bit per REWIND_DELTA_BLOCK_SIZE block
+	// followed by the XOR of only the blocks that changed, then LZ4'd.
 	uint8_t* prev_state_enc; // previous state for delta encoding (compression)
 	uint8_t* prev_state_dec; // previous state for delta decoding (decompression)
-	uint8_t* delta_buf;		 // scratch buffer for XOR result
+	uint8_t* delta_buf;		 // scratch buffer for bitmap + XOR result
+	size_t delta_map_size;	 // bytes of block bitmap at the start of a delta
 	int has_prev_enc;		 // 1 if prev_state_enc is valid
 	int has_prev_dec;		 // 1 if prev_state_dec is valid
 
@@ -1395,6 +1836,7 @@ static int Rewind_entry_overlaps_range(int entry_idx, size_t range_start, size_t
 static int Rewind_write_entry_locked(const uint8_t* compressed, size_t dest_len, int is_keyframe) {
 	if (dest_len >= rewind_ctx.capacity) {
 		LOG_error("Rewind: state does not fit in buffer\n");
+		rewind_ctx.has_prev_enc = 0; // the next delta would build on this dropped entry
 		return 0;
 	}
 
@@ -1435,6 +1877,7 @@ static int Rewind_write_entry_locked(const uint8_t* compressed, size_t dest_len,
 	// Safety check: if we still can't fit, there's a logic error
 	if (Rewind_free_space_locked() <= dest_len && rewind_ctx.entry_count > 0) {
 		LOG_error("Rewind: unable to make room for entry (need %zu, have %zu)\n", dest_len, Rewind_free_space_locked());
+		rewind_ctx.has_prev_enc = 0;
 		return 0;
 	}
 
@@ -1476,35 +1919,36 @@ static int Rewind_compress_state(const uint8_t* src, size_t* dest_len, int* is_k
 	}
 
 	// Delta compression: XOR current state with previous state
-	// The result is mostly zeros for similar consecutive states, which compresses much faster
+	// Most of a state doesn't change between captures, so unchanged blocks are
+	// dropped entirely and only the changed ones go through LZ4
 	const uint8_t* compress_src = src;
+	size_t compress_len = rewind_ctx.state_size;
 	int used_delta = 0;
 	if (rewind_ctx.has_prev_enc && rewind_ctx.prev_state_enc && rewind_ctx.delta_buf) {
-		size_t state_size = rewind_ctx.state_size;
-		uint8_t* delta = rewind_ctx.delta_buf;
-		const uint8_t* prev = rewind_ctx.prev_state_enc;
-		// Byte-by-byte XOR to avoid unaligned memory access issues
-		for (size_t i = 0; i < state_size; i++) {
-			delta[i] = src[i] ^ prev[i];
-		}
-		compress_src = delta;
+		// also brings prev_state_enc up to date
+		compress_len = RewindDelta_encode(rewind_ctx.delta_buf, rewind_ctx.prev_state_enc, src, rewind_ctx.state_size);
+		compress_src = rewind_ctx.delta_buf;
 		used_delta = 1;
 	}
 
 	int max_dst = (int)rewind_ctx.scratch_size;
 	// acceleration: 1=default speed, higher=faster but slightly lower ratio
 	int accel = rewind_ctx.lz4_acceleration > 0 ? rewind_ctx.lz4_acceleration : MINARCH_DEFAULT_REWIND_LZ4_ACCELERATION;
-	int res = LZ4_compress_fast((const char*)compress_src, (char*)rewind_ctx.scratch, (int)rewind_ctx.state_size, max_dst, accel);
-	if (res <= 0)
+	int res = LZ4_compress_fast((const char*)compress_src, (char*)rewind_ctx.scratch, (int)compress_len, max_dst, accel);
+	if (res <= 0) {
+		// prev_state_enc already moved on to src, which no entry holds,
+		// so start the next capture over with a keyframe
+		rewind_ctx.has_prev_enc = 0;
 		return -1;
+	}
 	*dest_len = (size_t)res;
 
 	// Report whether this was a keyframe (full state) or delta
 	if (is_keyframe_out)
 		*is_keyframe_out = used_delta ? 0 : 1;
 
-	// Update prev_state_enc with the current state for next delta
-	if (rewind_ctx.prev_state_enc) {
+	// Keyframe: prev_state_enc becomes the current state for next delta
+	if (!used_delta && rewind_ctx.prev_state_enc) {
 		memcpy(rewind_ctx.prev_state_enc, src, rewind_ctx.state_size);
 		rewind_ctx.has_prev_enc = 1;
 	}
@@ -1562,7 +2006,10 @@ static int Rewind_init(size_t state_size) {
 		return 0;
 	}
 
-	rewind_ctx.scratch_size = LZ4_compressBound((int)state_size);
+	rewind_ctx.delta_map_size = RewindDelta_mapSize(state_size);
+
+	// a delta with every block changed is slightly larger than the state itself
+	rewind_ctx.scratch_size = LZ4_compressBound((int)(state_size + rewind_ctx.delta_map_size));
 	if (!rewind_ctx.compress)
 		rewind_ctx.scratch_size = state_size;
 	rewind_ctx.scratch = calloc(1, rewind_ctx.scratch_size);
@@ -1575,7 +2022,7 @@ static int Rewind_init(size_t state_size) {
 	// Allocate delta compression buffers (separate for encode/decode to avoid race conditions)
 	rewind_ctx.prev_state_enc = calloc(1, state_size);
 	rewind_ctx.prev_state_dec = calloc(1, state_size);
-	rewind_ctx.delta_buf = calloc(1, state_size);
+	rewind_ctx.delta_buf = calloc(1, state_size + rewind_ctx.delta_map_size);
 	if (!rewind_ctx.prev_state_enc || !rewind_ctx.prev_state_dec || !rewind_ctx.delta_buf) {
 		LOG_error("Rewind: failed to allocate delta buffers\n");
 		Rewind_free();
@@ -1891,11 +2338,12 @@ static int Rewind_step_back(void) {
 	RewindEntry* e = &rewind_ctx.entries[idx];
 
 	int decode_ok = 1;
+	const uint8_t* restore = rewind_ctx.state_buf;
 	if (rewind_ctx.compress) {
 		// Decompress into delta_buf first (it may contain XOR delta or full state)
 		int res = LZ4_decompress_safe((const char*)rewind_ctx.buffer + e->offset,
-									  (char*)rewind_ctx.delta_buf, (int)e->size, (int)rewind_ctx.state_size);
-		if (res < (int)rewind_ctx.state_size) {
+									  (char*)rewind_ctx.delta_buf, (int)e->size, (int)(rewind_ctx.state_size + rewind_ctx.delta_map_size));
+		if (res < 0 || (e->is_keyframe && res < (int)rewind_ctx.state_size)) {
 			LOG_error("Rewind: decompress failed (res=%i, want=%zu, compressed=%zu, offset=%zu, idx=%d head=%d tail=%d count=%d buf_head=%zu buf_tail=%zu)\n",
 					  res, rewind_ctx.state_size, e->size, e->offset, idx, rewind_ctx.entry_head, rewind_ctx.entry_tail, rewind_ctx.entry_count, rewind_ctx.head, rewind_ctx.tail);
 			decode_ok = 0;
@@ -1910,25 +2358,20 @@ static int Rewind_step_back(void) {
 			// Delta decompression: XOR the delta with prev_state_dec to recover the actual state
 			// prev_state_dec holds the current state (state N), delta = state_N XOR state_(N-1)
 			// So: state_(N-1) = delta XOR state_N = delta XOR prev_state_dec
-			size_t state_size = rewind_ctx.state_size;
-			uint8_t* result = rewind_ctx.state_buf;
-			const uint8_t* delta = rewind_ctx.delta_buf;
-			const uint8_t* prev = rewind_ctx.prev_state_dec;
-			// Byte-by-byte XOR to avoid unaligned memory access issues
-			for (size_t i = 0; i < state_size; i++) {
-				result[i] = delta[i] ^ prev[i];
+			// Done in place on the changed blocks, prev_state_dec then is the state we
+			// just recovered (for next rewind step) and gets restored directly
+			if (RewindDelta_apply(rewind_ctx.prev_state_dec, rewind_ctx.delta_buf, (size_t)res, rewind_ctx.state_size) != 0) {
+				LOG_error("Rewind: malformed delta (len=%i, idx=%d)\n", res, idx);
+				rewind_ctx.has_prev_dec = 0;
+				decode_ok = 0;
+			} else {
+				restore = rewind_ctx.prev_state_dec;
 			}
-			// Update prev_state_dec to the state we just recovered (for next rewind step)
-			memcpy(rewind_ctx.prev_state_dec, result, state_size);
 		} else {
 			// Delta frame but no previous state - this shouldn't happen with proper keyframe tracking
-			// Fall back to treating it as a full state (may produce incorrect results)
-			LOG_warn("Rewind: delta frame without previous state, results may be incorrect\n");
-			memcpy(rewind_ctx.state_buf, rewind_ctx.delta_buf, rewind_ctx.state_size);
-			if (rewind_ctx.prev_state_dec) {
-				memcpy(rewind_ctx.prev_state_dec, rewind_ctx.state_buf, rewind_ctx.state_size);
-				rewind_ctx.has_prev_dec = 1;
-			}
+			// A block delta can't stand in for a full state, so drop it
+			LOG_warn("Rewind: delta frame without previous state, dropping it\n");
+			decode_ok = 0;
 		}
 	} else {
 		if (e->size != rewind_ctx.state_size) {
@@ -1950,7 +2393,7 @@ static int Rewind_step_back(void) {
 		return REWIND_STEP_EMPTY;
 	}
 
-	if (!core.unserialize(rewind_ctx.state_buf, rewind_ctx.state_size)) {
+	if (!core.unserialize(restore, rewind_ctx.state_size)) {
 		LOG_error("Rewind: unserialize failed\n");
 		Rewind_drop_oldest_locked();
 		pthread_mutex_unlock(&rewind_ctx.lock);
@@ -1996,6 +2439,7 @@ static void Rewind_sync_encode_state(void) {
 static void Rewind_on_state_change(void) {
 	Rewind_reset();
 	Rewind_push(1);
+	runahead.resync = 1;
 }
 
 ///////////////////////////////
@@ -2146,6 +2590,37 @@ static char* max_ff_labels[] = {
 	"8x",
 	NULL,
 };
+static char* sram_flush_labels[] = {
+	"Off",
+	"10 seconds",
+	"30 seconds",
+	"1 minute",
+	"2 minutes",
+	"5 minutes",
+	NULL,
+};
+static char* sram_flush_values[] = {
+	"0",
+	"10",
+	"30",
+	"60",
+	"120",
+	"300",
+	NULL,
+};
+static char* runahead_labels[] = {
+	"Off",
+	"1 frame",
+	"2 frames",
+	"3 frames",
+	"4 frames",
+	NULL,
+};
+static char* runahead_mode_labels[] = {
+	"Single instance",
+	"Second instance",
+	NULL,
+};
 static char* offset_labels[] = {
 	"-64",
 	"-63",
@@ -2317,6 +2792,7 @@ enum {
 	FE_OPT_SHARPNESS,
 	FE_OPT_SYNC_REFERENCE,
 	FE_OPT_OVERCLOCK,
+	FE_OPT_CPU_HEADROOM,
 	FE_OPT_DEBUG,
 	FE_OPT_MAXFF,
 	FE_OPT_FF_AUDIO,
@@ -2326,6 +2802,9 @@ enum {
 	FE_OPT_REWIND_COMPRESSION,
 	FE_OPT_REWIND_COMPRESSION_ACCEL,
 	FE_OPT_REWIND_AUDIO,
+	FE_OPT_RUNAHEAD,
+	FE_OPT_RUNAHEAD_MODE,
+	FE_OPT_SRAM_FLUSH,
 	FE_OPT_COUNT,
 };
 
@@ -2499,6 +2978,14 @@ static char* overclock_labels[] = {
 	"Normal",
 	"Performance",
 	"Auto",
+	"Adaptive",
+	NULL,
+};
+static char* cpu_headroom_labels[] = {
+	"10%",
+	"20%",
+	"30%",
+	"40%",
 	NULL,
 };
 
@@ -2644,13 +3131,23 @@ static struct Config {
 					 [FE_OPT_OVERCLOCK] = {
 						 .key = "minarch_cpu_speed",
 						 .name = "CPU Speed",
-						 .desc = "Over- or underclock the CPU to prioritize\npure performance or power savings.",
+						 .desc = "Over- or underclock the CPU to prioritize\npure performance or power savings.\n\"Adaptive\" picks the lowest speed that\nkeeps up with the game's frame rate.",
 						 .default_value = 3,
 						 .value = 3,
-						 .count = 4,
+						 .count = 5,
 						 .values = overclock_labels,
 						 .labels = overclock_labels,
 					 },
+					 [FE_OPT_CPU_HEADROOM] = {
+						 .key = "minarch_cpu_headroom",
+						 .name = "Adaptive Headroom",
+						 .desc = "Share of each frame the Adaptive CPU\nspeed keeps free. Raise it if a game\nstutters, lower it to save battery.",
+						 .default_value = 1, // 20%
+						 .value = 1,
+						 .count = 4,
+						 .values = cpu_headroom_labels,
+						 .labels = cpu_headroom_labels,
+					 },
 					 [FE_OPT_DEBUG] = {
 						 .key = "minarch_debug_hud",
 						 .name = "Debug HUD",
@@ -2741,6 +3238,36 @@ static struct Config {
 						 .values = onoff_labels,
 						 .labels = onoff_labels,
 					 },
+					 [FE_OPT_RUNAHEAD] = {
+						 .key = "minarch_runahead",
+						 .name = "Run-ahead",
+						 .desc = "Hide the game's internal input lag by running\nframes ahead and rolling back each frame.\nUses a lot of extra CPU, set per core.",
+						 .default_value = 0,
+						 .value = 0,
+						 .count = RUNAHEAD_MAX_FRAMES + 1,
+						 .values = runahead_labels,
+						 .labels = runahead_labels,
+					 },
+					 [FE_OPT_RUNAHEAD_MODE] = {
+						 .key = "minarch_runahead_mode",
+						 .name = "Run-ahead Mode",
+						 .desc = "Second instance avoids audio glitches and\nrolls back only when input changes,\nbut loads the core twice.",
+						 .default_value = RUNAHEAD_SINGLE,
+						 .value = RUNAHEAD_SINGLE,
+						 .count = 2,
+						 .values = runahead_mode_labels,
+						 .labels = runahead_mode_labels,
+					 },
+					 [FE_OPT_SRAM_FLUSH] = {
+						 .key = "minarch_sram_flush_interval",
+						 .name = "Save RAM Autoflush",
+						 .desc = sram_flush_desc,
+						 .default_value = 2, // 30 seconds
+						 .value = 2,
+						 .count = 6,
+						 .values = sram_flush_values,
+						 .labels = sram_flush_labels,
+					 },
 					 [FE_OPT_COUNT] = {NULL}}},
 	.core = {
 		// (OptionList)
@@ -2981,6 +3508,8 @@ static int Config_getValue(char* cfg, const char* key, char* out_value, int* loc
 
 static void setOverclock(int i) {
 	overclock = i;
+	if (i != 4)
+		FrameGov_stop();
 	switch (i) {
 	case 0:
 		PWR_setCPUSpeed(CPU_SPEED_POWERSAVE);
@@ -2994,6 +3523,13 @@ static void setOverclock(int i) {
 	case 3:
 		PWR_setCPUSpeedAuto();
 		break;
+	case 4:
+		if (FrameGov_isRunning())
+			break;
+		FrameGov_start();
+		if (!FrameGov_isRunning())
+			PWR_setCPUSpeedAuto(); // no usable cpufreq interface
+		break;
 	}
 }
 static void Config_syncFrontend(char* key, int value) {
@@ -3049,6 +3585,11 @@ static void Config_syncFrontend(char* key, int value) {
 	} else if (exactMatch(key, config.frontend.options[FE_OPT_OVERCLOCK].key)) {
 		overclock = value;
 		i = FE_OPT_OVERCLOCK;
+	} else if (exactMatch(key, config.frontend.options[FE_OPT_CPU_HEADROOM].key)) {
+		if (value >= 0 && value < config.frontend.options[FE_OPT_CPU_HEADROOM].count)
+			cpu_headroom = strtol(cpu_headroom_labels[value], NULL, 10);
+		FrameGov_setHeadroom(cpu_headroom);
+		i = FE_OPT_CPU_HEADROOM;
 	} else if (exactMatch(key, config.frontend.options[FE_OPT_DEBUG].key)) {
 		show_debug = value;
 		i = FE_OPT_DEBUG;
@@ -3070,6 +3611,18 @@ static void Config_syncFrontend(char* key, int value) {
 		i = FE_OPT_REWIND_COMPRESSION;
 	} else if (exactMatch(key, config.frontend.options[FE_OPT_REWIND_COMPRESSION_ACCEL].key)) {
 		i = FE_OPT_REWIND_COMPRESSION_ACCEL;
+	} else if (exactMatch(key, config.frontend.options[FE_OPT_RUNAHEAD].key)) {
+		runahead_frames = value;
+		runahead.failed = 0;
+		i = FE_OPT_RUNAHEAD;
+	} else if (exactMatch(key, config.frontend.options[FE_OPT_RUNAHEAD_MODE].key)) {
+		runahead_mode = value;
+		runahead.failed = 0;
+		i = FE_OPT_RUNAHEAD_MODE;
+	} else if (exactMatch(key, config.frontend.options[FE_OPT_SRAM_FLUSH].key)) {
+		if (value >= 0 && value < config.frontend.options[FE_OPT_SRAM_FLUSH].count)
+			sram_flush_interval = strtol(sram_flush_values[value], NULL, 10);
+		i = FE_OPT_SRAM_FLUSH;
 	}
 	if (i == -1)
 		return;
@@ -4184,6 +4737,10 @@ static int setFastForward(int enable) {
 static uint32_t buttons = 0; // RETRO_DEVICE_ID_JOYPAD_* buttons
 static int ignore_menu = 0;
 static void input_poll_callback(void) {
+	// run-ahead replays reuse the input sampled by the first retro_run() of the frame
+	if (runahead.replay)
+		return;
+
 	PAD_poll();
 
 	IndicatorType show_setting = INDICATOR_NONE;
@@ -4584,6 +5141,8 @@ static bool environment_callback(unsigned cmd, void* data) { // copied from pico
 		bool* out = (bool*)data;
 		if (out) {
 			*out = config.core.changed;
+			if (config.core.changed)
+				runahead.second.variables_changed = 1;
 			config.core.changed = 0;
 		}
 		break;
@@ -4658,8 +5217,12 @@ static bool environment_callback(unsigned cmd, void* data) { // copied from pico
 		int* out_p = (int*)data;
 		if (out_p) {
 			int out = 0;
-			out |= RETRO_AV_ENABLE_VIDEO;
-			out |= RETRO_AV_ENABLE_AUDIO;
+			if (!runahead.active || runahead.video)
+				out |= RETRO_AV_ENABLE_VIDEO;
+			if (!runahead.active || runahead.audio)
+				out |= RETRO_AV_ENABLE_AUDIO;
+			if (runahead.active)
+				out |= RETRO_AV_ENABLE_FAST_SAVESTATES;
 			*out_p = out;
 		}
 		break;
@@ -5579,6 +6142,10 @@ static void screen_flip(SDL_Surface* screen) {
 		GFX_GL_Swap();
 		// GFX_flip(screen);
 	}
+
+	// fast forward has no deadline, the governor runs it at full speed
+	double fps = use_core_fps && core.fps > 0 ? core.fps : SCREEN_FPS;
+	FrameGov_reportFrame(perf.busy_ms, fast_forward ? 0 : 1000.0 / fps);
 }
 
 // couple of animation functions for pixel data keeping them all cause wanna use them later
@@ -5632,8 +6199,8 @@ static void drawDebugHud(const void* data, unsigned width, unsigned height, size
 		sprintf(debug_text, "%ix%i %ix %i/%i", renderer.src_w, renderer.src_h, scale, perf.samplerate_in, perf.samplerate_out);
 		blitBitmapText(debug_text, x, y, (uint32_t*)data, pitch / 4, width, height);
 
-		sprintf(debug_text, "%.03f/%i/%.0f/%i/%i/%i", perf.ratio,
-				perf.buffer_size, perf.buffer_ms, perf.buffer_free, perf.buffer_target, perf.avg_buffer_free);
+		sprintf(debug_text, "%.03f/%i/%.0f/%i/%i/%i %.0fns", perf.ratio,
+				perf.buffer_size, perf.buffer_ms, perf.buffer_free, perf.buffer_target, perf.avg_buffer_free, perf.resample_ns);
 		blitBitmapText(debug_text, x, y + 14, (uint32_t*)data, pitch / 4, width,
 					   height);
 
@@ -5665,6 +6232,11 @@ static void drawDebugHud(const void* data, unsigned width, unsigned height, size
 			blitBitmapText(debug_text, x, -y - 42, (uint32_t*)data, pitch / 4, width, height);
 		}
 
+		if (runahead_frames && !runahead.failed) {
+			sprintf(debug_text, "RA:%i%s S:%.2f U:%.2f", runahead_frames, runahead_mode == RUNAHEAD_SECOND ? "x2" : "", perf.serialize_ms, perf.unserialize_ms);
+			blitBitmapText(debug_text, -x, -y - 14, (uint32_t*)data, pitch / 4, width, height);
+		}
+
 		double buffer_fill = (double)(perf.buffer_size - perf.buffer_free) / (double)perf.buffer_size;
 		drawGauge(x, y + 30, buffer_fill, width / 2, 8, (uint32_t*)data, pitch / 4);
 	}
@@ -5895,6 +6467,10 @@ static void video_refresh_callback(const void* data, unsigned width, unsigned he
 	if (quit)
 		return;
 
+	// only the last run-ahead frame reaches the screen
+	if (runahead.active && !runahead.video)
+		return;
+
 	// Allocate RGBA buffer if needed
 	if (!rgbaData || rgbaDataSize != width * height) {
 		if (rgbaData)
@@ -5939,6 +6515,8 @@ static void video_refresh_callback(const void* data, unsigned width, unsigned he
 static void audio_sample_callback(int16_t left, int16_t right) {
 	if (rewinding && !rewind_ctx.audio)
 		return;
+	if (runahead.active && !runahead.audio)
+		return;
 	if (!fast_forward || ff_audio) {
 		if (use_core_fps || fast_forward) {
 			SND_batchSamples_fixed_rate(&(const SND_Frame){left, right}, 1);
@@ -5950,6 +6528,8 @@ static void audio_sample_callback(int16_t left, int16_t right) {
 static size_t audio_sample_batch_callback(const int16_t* data, size_t frames) {
 	if (rewinding && !rewind_ctx.audio)
 		return frames;
+	if (runahead.active && !runahead.audio)
+		return frames;
 	if (!fast_forward || ff_audio) {
 		if (use_core_fps || fast_forward) {
 			return SND_batchSamples_fixed_rate((const SND_Frame*)data, frames);
@@ -6009,6 +6589,7 @@ void Core_open(const char* core_path, const char* tag_name) {
 	struct retro_system_info info = {};
 	core.get_system_info(&info);
 
+	strcpy((char*)core.path, core_path);
 	Core_getName((char*)core_path, (char*)core.name);
 	sprintf((char*)core.version, "%s (%s)", info.library_name, info.library_version);
 	strcpy((char*)core.tag, tag_name);
@@ -6084,6 +6665,7 @@ void Core_load(void) {
 		Core_applyCheats(&cheatcodes);
 
 	SRAM_read();
+	SRAM_resetCheckpoint();
 	RTC_read();
 	// NOTE: must be called after core.load_game!
 	core.set_controller_port_device(0, RETRO_DEVICE_JOYPAD); // set a default, may update after loading configs
@@ -6102,6 +6684,8 @@ void Core_unload(void) {
 void Core_quit(void) {
 	if (core.initialized) {
 		SRAM_write();
+		SRAM_stopCheckpoint();
+		State_quit();
 		Cheats_free();
 		RTC_write();
 		core.unload_game();
@@ -6109,7 +6693,240 @@ void Core_quit(void) {
 		core.initialized = 0;
 	}
 }
+
+// second instance for run-ahead: a private copy of the core that is kept
+// runahead_frames ahead of the main instance and only presents video
+
+static bool second_set_rumble_state(unsigned port, enum retro_rumble_effect effect, uint16_t strength) {
+	return 1;
+}
+static bool second_environment_callback(unsigned cmd, void* data) {
+	switch (cmd) {
+	// the main instance owns everything the frontend shows or persists
+	case RETRO_ENVIRONMENT_SET_MESSAGE:
+	case RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS:
+	case RETRO_ENVIRONMENT_SET_DISK_CONTROL_INTERFACE:
+	case RETRO_ENVIRONMENT_SET_DISK_CONTROL_EXT_INTERFACE:
+	case RETRO_ENVIRONMENT_SET_VARIABLES:
+	case RETRO_ENVIRONMENT_SET_VARIABLE:
+	case RETRO_ENVIRONMENT_SET_CORE_OPTIONS:
+	case RETRO_ENVIRONMENT_SET_CORE_OPTIONS_INTL:
+	case RETRO_ENVIRONMENT_SET_CORE_OPTIONS_V2:
+	case RETRO_ENVIRONMENT_SET_CORE_OPTIONS_V2_INTL:
+	case RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY:
+	case RETRO_ENVIRONMENT_SET_CORE_OPTIONS_UPDATE_DISPLAY_CALLBACK:
+	case RETRO_ENVIRONMENT_SET_CONTROLLER_INFO:
+	case RETRO_ENVIRONMENT_SET_MEMORY_MAPS:
+	case RETRO_ENVIRONMENT_SET_CONTENT_INFO_OVERRIDE:
+		return true;
+	case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE: {
+		bool* out = (bool*)data;
+		if (out) {
+			*out = runahead.second.variables_changed;
+			runahead.second.variables_changed = 0;
+		}
+		return true;
+	}
+	case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE: {
+		int* out_p = (int*)data;
+		if (out_p) {
+			int out = RETRO_AV_ENABLE_FAST_SAVESTATES | RETRO_AV_ENABLE_HARD_DISABLE_AUDIO;
+			if (runahead.video)
+				out |= RETRO_AV_ENABLE_VIDEO;
+			*out_p = out;
+		}
+		return true;
+	}
+	case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY: {
+		// cores that write their own saves (memory cards, etc) would otherwise
+		// overwrite the main instance's with frames that get rolled back
+		const char** out = (const char**)data;
+		if (out)
+			*out = runahead.second.saves_dir;
+		return true;
+	}
+	case RETRO_ENVIRONMENT_GET_RUMBLE_INTERFACE: {
+		// the speculative frames would rumble ahead of the real ones
+		struct retro_rumble_interface* iface = (struct retro_rumble_interface*)data;
+		if (iface)
+			iface->set_rumble_state = second_set_rumble_state;
+		return true;
+	}
+	case RETRO_ENVIRONMENT_SET_HW_RENDER:
+		// the second instance can't share the main instance's GL context, a
+		// hardware rendered core fails to load here and run-ahead falls back to
+		// single instance mode
+		return false;
+	default:
+		return environment_callback(cmd, data);
+	}
+}
+static void second_video_refresh_callback(const void* data, unsigned width, unsigned height, size_t pitch) {
+	if (runahead.video)
+		video_refresh_callback(data, width, height, pitch);
+}
+static void second_audio_sample_callback(int16_t left, int16_t right) {
+}
+static size_t second_audio_sample_batch_callback(const int16_t* data, size_t frames) {
+	return frames;
+}
+static void second_input_poll_callback(void) {
+	// input is polled once per frame by the main instance
+}
+
+static int Core_copyFile(const char* src_path, const char* dst_path) {
+	int src = open(src_path, O_RDONLY);
+	if (src < 0)
+		return 0;
+	int dst = open(dst_path, O_WRONLY | O_CREAT | O_TRUNC, 0755);
+	if (dst < 0) {
+		close(src);
+		return 0;
+	}
+
+	char buffer[64 * 1024];
+	ssize_t n;
+	int ok = 1;
+	while ((n = read(src, buffer, sizeof(buffer))) > 0) {
+		if (write(dst, buffer, n) != n) {
+			ok = 0;
+			break;
+		}
+	}
+	if (n < 0)
+		ok = 0;
+
+	close(src);
+	if (close(dst) != 0)
+		ok = 0;
+	return ok;
+}
+
+static void Core_removeDir(const char* path) {
+	DIR* dir = opendir(path);
+	if (!dir)
+		return;
+
+	struct dirent* entry;
+	char entry_path[MAX_PATH];
+	while ((entry = readdir(dir)) != NULL) {
+		if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+			continue;
+		snprintf(entry_path, sizeof(entry_path), "%s/%s", path, entry->d_name);
+		struct stat st;
+		if (lstat(entry_path, &st) == 0 && S_ISDIR(st.st_mode))
+			Core_removeDir(entry_path);
+		else
+			unlink(entry_path);
+	}
+	closedir(dir);
+	rmdir(path);
+}
+
+void Core_closeSecond(void) {
+	if (runahead.second.loaded) {
+		runahead.second.unload_game();
+		runahead.second.deinit();
+		runahead.second.loaded = 0;
+	}
+	if (runahead.second.handle) {
+		dlclose(runahead.second.handle);
+		runahead.second.handle = NULL;
+	}
+	if (runahead.second.dir[0]) {
+		Core_removeDir(runahead.second.dir); // the core copy and anything saved
+		runahead.second.dir[0] = '\0';
+	}
+	runahead.second.path[0] = '\0';
+	runahead.second.saves_dir[0] = '\0';
+}
+int Core_openSecond(void) {
+	if (runahead.second.loaded)
+		return 1;
+
+	strcpy(runahead.second.dir, "/tmp/minarch_runahead_XXXXXX");
+	if (!mkdtemp(runahead.second.dir)) {
+		LOG_error("Run-ahead: unable to create %s (%s)\n", runahead.second.dir, strerror(errno));
+		runahead.second.dir[0] = '\0';
+		return 0;
+	}
+	snprintf(runahead.second.saves_dir, sizeof(runahead.second.saves_dir), "%s/saves", runahead.second.dir);
+	if (mkdir(runahead.second.saves_dir, 0755) != 0) {
+		LOG_error("Run-ahead: unable to create %s (%s)\n", runahead.second.saves_dir, strerror(errno));
+		Core_closeSecond();
+		return 0;
+	}
+
+	// dlopen() hands back the already mapped main instance for the same path,
+	// so the second instance gets its own copy of the library
+	snprintf(runahead.second.path, sizeof(runahead.second.path), "%s/%s.so", runahead.second.dir, core.name);
+	if (!Core_copyFile(core.path, runahead.second.path)) {
+		LOG_error("Run-ahead: unable to copy core to %s\n", runahead.second.path);
+		Core_closeSecond();
+		return 0;
+	}
+
+	void* handle = dlopen(runahead.second.path, RTLD_LAZY | RTLD_LOCAL);
+	if (!handle) {
+		LOG_error("Run-ahead: %s\n", dlerror());
+		Core_closeSecond();
+		return 0;
+	}
+	runahead.second.handle = handle;
+
+	runahead.second.init = dlsym(handle, "retro_init");
+	runahead.second.deinit = dlsym(handle, "retro_deinit");
+	runahead.second.run = dlsym(handle, "retro_run");
+	runahead.second.serialize_size = dlsym(handle, "retro_serialize_size");
+	runahead.second.unserialize = dlsym(handle, "retro_unserialize");
+	runahead.second.load_game = dlsym(handle, "retro_load_game");
+	runahead.second.unload_game = dlsym(handle, "retro_unload_game");
+	runahead.second.set_controller_port_device = dlsym(handle, "retro_set_controller_port_device");
+
+	void (*set_environment_callback)(retro_environment_t) = dlsym(handle, "retro_set_environment");
+	void (*set_video_refresh_callback)(retro_video_refresh_t) = dlsym(handle, "retro_set_video_refresh");
+	void (*set_audio_sample_callback)(retro_audio_sample_t) = dlsym(handle, "retro_set_audio_sample");
+	void (*set_audio_sample_batch_callback)(retro_audio_sample_batch_t) = dlsym(handle, "retro_set_audio_sample_batch");
+	void (*set_input_poll_callback)(retro_input_poll_t) = dlsym(handle, "retro_set_input_poll");
+	void (*set_input_state_callback)(retro_input_state_t) = dlsym(handle, "retro_set_input_state");
+
+	if (!runahead.second.init || !runahead.second.run || !runahead.second.unserialize || !runahead.second.load_game || !set_environment_callback) {
+		LOG_error("Run-ahead: second instance is missing libretro symbols\n");
+		Core_closeSecond();
+		return 0;
+	}
+
+	set_environment_callback(second_environment_callback);
+	set_video_refresh_callback(second_video_refresh_callback);
+	set_audio_sample_callback(second_audio_sample_callback);
+	set_audio_sample_batch_callback(second_audio_sample_batch_callback);
+	set_input_poll_callback(second_input_poll_callback);
+	set_input_state_callback(input_state_callback);
+
+	runahead.second.init();
+
+	struct retro_game_info game_info;
+	game_info.path = game.tmp_path[0] ? game.tmp_path : game.path;
+	game_info.data = game.data;
+	game_info.size = game.size;
+	game_info.meta = NULL;
+	if (!runahead.second.load_game(&game_info)) {
+		LOG_error("Run-ahead: second instance failed to load %s\n", game_info.path);
+		runahead.second.deinit();
+		Core_closeSecond();
+		return 0;
+	}
+	runahead.second.loaded = 1;
+	int device = has_custom_controllers ? strtol(gamepad_values[gamepad_type], NULL, 0) : RETRO_DEVICE_JOYPAD;
+	runahead.second.set_controller_port_device(0, device);
+	runahead.resync = 1;
+
+	LOG_info("Run-ahead: second instance loaded from %s\n", runahead.second.path);
+	return 1;
+}
+
 void Core_close(void) {
+	Core_closeSecond();
 	if (core.handle)
 		dlclose(core.handle);
 }
@@ -6229,8 +7046,10 @@ void Menu_beforeSleep() {
 	SRAM_write();
 	RTC_write();
 	State_autosave();
+	State_flush(); // the resume state has to be on disk before we may lose power
 	putFile(AUTO_RESUME_PATH, game.path + strlen(SDCARD_PATH));
 
+	FrameGov_stop();
 	PWR_setCPUSpeed(CPU_SPEED_MENU);
 }
 void Menu_afterSleep() {
@@ -6361,6 +7180,7 @@ static int OptionFrontend_openMenu(MenuList* list, int i) {
 			item->value = option->value;
 		}
 	}
+	SRAM_describeFlush(); // item desc points at sram_flush_desc
 	Menu_options(&OptionFrontend_menu);
 	return MENU_CALLBACK_NOP;
 }
@@ -6537,6 +7357,8 @@ static int OptionControls_optionChanged(MenuList* list, int i) {
 		gamepad_type = item->value;
 		int device = strtol(gamepad_values[item->value], NULL, 0);
 		core.set_controller_port_device(0, device);
+		if (runahead.second.loaded)
+			runahead.second.set_controller_port_device(0, device);
 	}
 	return MENU_CALLBACK_NOP;
 }
@@ -8201,7 +9023,7 @@ static void Menu_updateState(void) {
 	sprintf(menu.bmp_path, "%s/%s.%d.bmp", menu.minui_dir, game.name, menu.slot);
 	sprintf(menu.txt_path, "%s/%s.%d.txt", menu.minui_dir, game.name, menu.slot);
 
-	menu.save_exists = exists(save_path);
+	menu.save_exists = exists(save_path) || State_isPending(save_path);
 	menu.preview_exists = menu.save_exists && exists(menu.bmp_path);
 }
 
@@ -8369,6 +9191,7 @@ static void Menu_loop(void) {
 	RTC_write();
 	if (!HAS_POWER_BUTTON)
 		PWR_enableSleep();
+	FrameGov_stop();
 	PWR_setCPUSpeed(CPU_SPEED_MENU); // set Hz directly
 
 	GFX_setEffect(EFFECT_NONE);
@@ -8703,10 +9526,110 @@ static void limitFF(void) {
 	last_time = now;
 }
 
+static void RunAhead_track(double* avg_ms, uint64_t start) {
+	double ms = (getMicroseconds() - start) / 1000.0;
+	*avg_ms = *avg_ms > 0.0 ? *avg_ms * 0.95 + ms * 0.05 : ms;
+}
+static int RunAhead_serialize(void) {
+	size_t size = core.serialize_size();
+	if (size == 0)
+		return 0;
+	if (size > runahead.state_size) {
+		void* state = realloc(runahead.state, size);
+		if (!state)
+			return 0;
+		runahead.state = state;
+		runahead.state_size = size;
+	}
+
+	uint64_t start = getMicroseconds();
+	int ok = core.serialize(runahead.state, size);
+	RunAhead_track(&perf.serialize_ms, start);
+	return ok;
+}
+static int RunAhead_unserialize(bool (*unserialize)(const void* data, size_t size)) {
+	uint64_t start = getMicroseconds();
+	int ok = unserialize(runahead.state, core.serialize_size());
+	RunAhead_track(&perf.unserialize_ms, start);
+	return ok;
+}
+static int RunAhead_inputChanged(void) {
+	int axes[4] = {pad.laxis.x, pad.laxis.y, pad.raxis.x, pad.raxis.y};
+	int changed = buttons != runahead.last_buttons || memcmp(axes, runahead.last_axes, sizeof(axes));
+	runahead.last_buttons = buttons;
+	memcpy(runahead.last_axes, axes, sizeof(axes));
+	return changed;
+}
+static void RunAhead_fail(const char* reason) {
+	LOG_warn("Run-ahead disabled: %s\n", reason);
+	runahead.failed = 1;
+	Core_closeSecond();
+}
+static void RunAhead_reset(void) {
+	runahead.resync = 1;
+	if (runahead.second.handle && !runahead_frames)
+		Core_closeSecond();
+}
+
+// runs one emulated frame but presents the frame runahead_frames later,
+// hiding that many frames of the game's own input lag
+static void RunAhead_runFrame(void) {
+	int second = runahead_mode == RUNAHEAD_SECOND;
+	if (!second && runahead.second.handle)
+		Core_closeSecond();
+	if (second && !Core_openSecond()) {
+		LOG_warn("Run-ahead: falling back to single instance\n");
+		runahead_mode = RUNAHEAD_SINGLE;
+		second = 0;
+	}
+
+	runahead.active = 1;
+
+	// the real frame: advances the game and produces its audio
+	runahead.video = 0;
+	runahead.audio = 1;
+	core.run();
+	runahead.replay = 1;
+	runahead.audio = 0;
+
+	int changed = RunAhead_inputChanged();
+	if (!second) {
+		if (!RunAhead_serialize()) {
+			RunAhead_fail("core failed to serialize");
+		} else {
+			for (int i = 0; i < runahead_frames; i++) {
+				runahead.video = i == runahead_frames - 1;
+				core.run();
+			}
+			if (!RunAhead_unserialize(core.unserialize))
+				RunAhead_fail("core failed to unserialize");
+		}
+	} else if (changed || runahead.resync) {
+		// prediction (input held from the previous frame) was wrong, roll the second instance back
+		if (!RunAhead_serialize() || !RunAhead_unserialize(runahead.second.unserialize)) {
+			RunAhead_fail("second instance failed to sync");
+		} else {
+			runahead.resync = 0;
+			for (int i = 0; i < runahead_frames; i++) {
+				runahead.video = i == runahead_frames - 1;
+				runahead.second.run();
+			}
+		}
+	} else {
+		runahead.video = 1;
+		runahead.second.run();
+	}
+
+	runahead.active = 0;
+	runahead.replay = 0;
+	runahead.video = 0;
+}
+
 static void Rewind_run_frame(void) {
 	// if rewind is toggled, fast-forward toggle must stay off; fast-forward hold pauses rewind
 	int do_rewind = (rewind_pressed || rewind_toggle) && !(rewind_toggle && ff_hold_active);
 	if (do_rewind) {
+		runahead.resync = 1;
 		int was_rewinding = rewinding;
 		int rewind_result = Rewind_step_back();
 		if (rewind_result == REWIND_STEP_OK) {
@@ -8761,9 +9684,15 @@ static void Rewind_run_frame(void) {
 			ff_runs = max_ff_speed ? max_ff_speed + 1 : 2;
 		}
 
-		for (int ff_step = 0; ff_step < ff_runs; ff_step++) {
-			core.run();
+		if (runahead_frames && !fast_forward && !runahead.failed && core.serialize_size) {
+			RunAhead_runFrame();
 			Rewind_push(0);
+		} else {
+			RunAhead_reset();
+			for (int ff_step = 0; ff_step < ff_runs; ff_step++) {
+				core.run();
+				Rewind_push(0);
+			}
 		}
 	}
 	limitFF();
@@ -8841,6 +9770,14 @@ int main(int argc, char* argv[]) {
 	PWR_init();
 	if (!HAS_POWER_BUTTON)
 		PWR_disableSleep();
+
+	const char* cpufreq_path = getenv("MINARCH_CPUFREQ_PATH"); // eg. a fake cpufreq dir on desktop
+#ifdef CPU_FREQ_PATH
+	if (!cpufreq_path)
+		cpufreq_path = CPU_FREQ_PATH;
+#endif
+	FrameGov_init(cpufreq_path);
+
 	MSG_init();
 	IMG_Init(IMG_INIT_PNG);
 	Core_open(core_path, tag_name);
@@ -8927,6 +9864,7 @@ int main(int argc, char* argv[]) {
 		GFX_startFrame();
 
 		Rewind_run_frame();
+		SRAM_checkpoint();
 
 		// Process RetroAchievements for this frame
 		RA_doFrame();
@@ -9032,6 +9970,7 @@ finish:
 	Config_quit();
 	Special_quit();
 	MSG_quit();
+	FrameGov_quit();
 	PWR_quit();
 	VIB_quit();
 	SND_removeDeviceWatcher();
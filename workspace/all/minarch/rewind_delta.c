@@ -0,0 +1,89 @@
+#include "rewind_delta.h"
+
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+size_t RewindDelta_mapSize(size_t state_size) {
+	size_t blocks = (state_size + REWIND_DELTA_BLOCK_SIZE - 1) / REWIND_DELTA_BLOCK_SIZE;
+	return (blocks + 7) / 8;
+}
+
+int RewindDelta_xor(uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t len) {
+	size_t i = 0;
+	uint64_t diff = 0;
+#if defined(__ARM_NEON) || defined(__aarch64__)
+	uint8x16_t acc = vdupq_n_u8(0);
+	for (; i + 16 <= len; i += 16) {
+		uint8x16_t x = veorq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+		vst1q_u8(dst + i, x);
+		acc = vorrq_u8(acc, x);
+	}
+	uint64x2_t acc64 = vreinterpretq_u64_u8(acc);
+	diff = vgetq_lane_u64(acc64, 0) | vgetq_lane_u64(acc64, 1);
+#elif defined(__SSE2__)
+	__m128i acc = _mm_setzero_si128();
+	for (; i + 16 <= len; i += 16) {
+		__m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+		_mm_storeu_si128((__m128i*)(dst + i), x);
+		acc = _mm_or_si128(acc, x);
+	}
+	diff = _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF;
+#endif
+	// word-wise, memcpy keeps it safe for unaligned states and compiles to plain loads
+	for (; i + 8 <= len; i += 8) {
+		uint64_t x, y;
+		memcpy(&x, a + i, 8);
+		memcpy(&y, b + i, 8);
+		x ^= y;
+		memcpy(dst + i, &x, 8);
+		diff |= x;
+	}
+	for (; i < len; i++) {
+		dst[i] = a[i] ^ b[i];
+		diff |= dst[i];
+	}
+	return diff != 0;
+}
+
+size_t RewindDelta_encode(uint8_t* delta, uint8_t* prev, const uint8_t* src, size_t state_size) {
+	size_t map_size = RewindDelta_mapSize(state_size);
+	uint8_t* map = delta;
+	uint8_t* out = delta + map_size;
+	memset(map, 0, map_size);
+
+	for (size_t offset = 0, block = 0; offset < state_size; offset += REWIND_DELTA_BLOCK_SIZE, block++) {
+		size_t len = state_size - offset < REWIND_DELTA_BLOCK_SIZE ? state_size - offset : REWIND_DELTA_BLOCK_SIZE;
+		// written in place, only kept (out advanced) if the block changed
+		if (RewindDelta_xor(out, src + offset, prev + offset, len)) {
+			map[block >> 3] |= 1 << (block & 7);
+			memcpy(prev + offset, src + offset, len);
+			out += len;
+		}
+	}
+	return (size_t)(out - delta);
+}
+
+int RewindDelta_apply(uint8_t* state, const uint8_t* delta, size_t delta_len, size_t state_size) {
+	size_t map_size = RewindDelta_mapSize(state_size);
+	if (delta_len < map_size)
+		return -1;
+	const uint8_t* map = delta;
+	const uint8_t* in = delta + map_size;
+	const uint8_t* end = delta + delta_len;
+
+	for (size_t offset = 0, block = 0; offset < state_size; offset += REWIND_DELTA_BLOCK_SIZE, block++) {
+		if (!(map[block >> 3] & (1 << (block & 7))))
+			continue;
+		size_t len = state_size - offset < REWIND_DELTA_BLOCK_SIZE ? state_size - offset : REWIND_DELTA_BLOCK_SIZE;
+		if ((size_t)(end - in) < len)
+			return -1;
+		RewindDelta_xor(state + offset, state + offset, in, len);
+		in += len;
+	}
+	return in == end ? 0 : -1;
+}
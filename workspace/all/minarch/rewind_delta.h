@@ -0,0 +1,43 @@
+#ifndef __REWIND_DELTA_H__
+#define __REWIND_DELTA_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Delta stage of the rewind encoder. A delta is a bitmap with one bit per
+// REWIND_DELTA_BLOCK_SIZE block of the state, followed by the XOR of only
+// the blocks that changed; unchanged blocks cost one bit and never reach
+// LZ4. The XOR is vectorized (NEON on device, SSE2 on desktop) and fused
+// with the changed-block test, so each block is read once.
+
+#define REWIND_DELTA_BLOCK_SIZE 4096 // unchanged blocks of this size are skipped in deltas
+
+/**
+ * @return Bytes of block bitmap at the start of a delta for state_size
+ */
+size_t RewindDelta_mapSize(size_t state_size);
+
+/**
+ * dst = a ^ b, dst may alias a.
+ *
+ * @return Non-zero if any byte differed
+ */
+int RewindDelta_xor(uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t len);
+
+/**
+ * Build the delta of src against prev and bring prev up to date as it
+ * goes (only the changed blocks are copied).
+ *
+ * @param delta Room for RewindDelta_mapSize(state_size) + state_size bytes
+ * @return Delta length
+ */
+size_t RewindDelta_encode(uint8_t* delta, uint8_t* prev, const uint8_t* src, size_t state_size);
+
+/**
+ * Apply a delta from RewindDelta_encode to state in place.
+ *
+ * @return 0 on success, -1 if the delta length doesn't match its bitmap
+ */
+int RewindDelta_apply(uint8_t* state, const uint8_t* delta, size_t delta_len, size_t state_size);
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef __API_H__
+#define __API_H__
+
+// The logging atomic_file.c uses, printed by state_write_test.c
+
+enum {
+	LOG_DEBUG = 0,
+	LOG_INFO,
+	LOG_WARN,
+	LOG_ERROR,
+};
+
+#define LOG_error(fmt, ...) LOG_note(LOG_ERROR, fmt, ##__VA_ARGS__)
+void LOG_note(int level, const char* fmt, ...);
+
+#endif
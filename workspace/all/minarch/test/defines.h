@@ -0,0 +1,6 @@
+#ifndef __DEFINES_H__
+#define __DEFINES_H__
+
+#define MAX_PATH 512
+
+#endif
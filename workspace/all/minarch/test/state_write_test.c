@@ -0,0 +1,177 @@
+// Interrupts AtomicFile_write between writing the temp file and renaming it
+// into place, by failing or SIGKILLing inside fwrite, fsync and rename, and
+// checks that the state slot it was replacing still loads.
+// atomic_file.c is built with those calls renamed to the fault_* below.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "atomic_file.h"
+
+#define SLOT_PATH "slot.st0"
+#define TMP_PATH SLOT_PATH ".tmp"
+#define STATE_SIZE (256 * 1024)
+#define RASTATE_HEADER_SIZE 16
+
+enum {
+	FAULT_NONE,
+	FAULT_KILL_IN_WRITE, // power lost halfway through the temp file
+	FAULT_KILL_AT_FSYNC,
+	FAULT_KILL_AT_RENAME, // temp file complete, slot not replaced yet
+	FAULT_FAIL_WRITE,	  // card full
+	FAULT_FAIL_FSYNC,
+	FAULT_FAIL_RENAME,
+};
+
+static int fault = FAULT_NONE;
+
+size_t fault_fwrite(const void* data, size_t size, size_t count, FILE* file) {
+	if (fault == FAULT_KILL_IN_WRITE) {
+		fwrite(data, size, count / 2, file);
+		fflush(file);
+		raise(SIGKILL);
+	}
+	if (fault == FAULT_FAIL_WRITE) {
+		size_t written = fwrite(data, size, count / 2, file);
+		errno = ENOSPC;
+		return written;
+	}
+	return fwrite(data, size, count, file);
+}
+
+int fault_fsync(int fd) {
+	if (fault == FAULT_KILL_AT_FSYNC)
+		raise(SIGKILL);
+	if (fault == FAULT_FAIL_FSYNC) {
+		errno = EIO;
+		return -1;
+	}
+	return fsync(fd);
+}
+
+int fault_rename(const char* from, const char* to) {
+	if (fault == FAULT_KILL_AT_RENAME)
+		raise(SIGKILL);
+	if (fault == FAULT_FAIL_RENAME) {
+		errno = EIO;
+		return -1;
+	}
+	return rename(from, to);
+}
+
+void LOG_note(int level, const char* fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+}
+
+///////////////////////////////
+
+// A RASTATE header and a payload every byte of which depends on generation
+static void makeState(uint8_t* state, int generation) {
+	memset(state, 0, RASTATE_HEADER_SIZE);
+	memcpy(state, "RASTATE", 7);
+	state[7] = 1;
+	for (size_t i = RASTATE_HEADER_SIZE; i < STATE_SIZE; i++)
+		state[i] = (uint8_t)(i * 31 + generation * 7);
+}
+
+// What State_read needs from the slot: the header, then a full state
+static int loadsGeneration(int generation) {
+	uint8_t* expected = malloc(STATE_SIZE);
+	uint8_t* loaded = malloc(STATE_SIZE + 1);
+	makeState(expected, generation);
+
+	int ok = 0;
+	FILE* file = fopen(SLOT_PATH, "r");
+	if (file) {
+		size_t size = fread(loaded, 1, STATE_SIZE + 1, file);
+		ok = size == STATE_SIZE && memcmp(loaded, "RASTATE", 7) == 0 && memcmp(loaded, expected, STATE_SIZE) == 0;
+		fclose(file);
+	}
+	free(expected);
+	free(loaded);
+	return ok;
+}
+
+// Returns the child's exit code, or 128 + signal if it was killed
+static int writeInChild(int with_fault, int generation) {
+	pid_t pid = fork();
+	if (pid == 0) {
+		uint8_t* state = malloc(STATE_SIZE);
+		makeState(state, generation);
+		fault = with_fault;
+		_exit(AtomicFile_write(SLOT_PATH, state, STATE_SIZE, 0) ? 0 : 1);
+	}
+	int status = 0;
+	waitpid(pid, &status, 0);
+	return WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+}
+
+static int failures = 0;
+
+static void expect(int ok, const char* what) {
+	printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok)
+		failures += 1;
+}
+
+typedef struct {
+	int fault;
+	const char* name;
+	int killed;
+} FaultCase;
+
+static const FaultCase cases[] = {
+	{FAULT_KILL_IN_WRITE, "killed halfway through the temp file", 1},
+	{FAULT_KILL_AT_FSYNC, "killed before fsync", 1},
+	{FAULT_KILL_AT_RENAME, "killed between the temp write and the rename", 1},
+	{FAULT_FAIL_WRITE, "short write", 0},
+	{FAULT_FAIL_FSYNC, "fsync failed", 0},
+	{FAULT_FAIL_RENAME, "rename failed", 0},
+};
+#define CASE_COUNT (int)(sizeof(cases) / sizeof(cases[0]))
+
+int main(int argc, char* argv[]) {
+	char what[256];
+	unlink(SLOT_PATH);
+	unlink(TMP_PATH);
+
+	int generation = 1;
+	expect(writeInChild(FAULT_NONE, generation) == 0 && loadsGeneration(generation), "first save loads");
+
+	for (int i = 0; i < CASE_COUNT; i++) {
+		const FaultCase* test = &cases[i];
+		int result = writeInChild(test->fault, generation + 1);
+
+		snprintf(what, sizeof(what), "%s: %s", test->name, test->killed ? "writer died" : "write reported failure");
+		expect(test->killed ? result == 128 + SIGKILL : result == 1, what);
+
+		snprintf(what, sizeof(what), "%s: previous slot still loads", test->name);
+		expect(loadsGeneration(generation), what);
+
+		if (!test->killed) {
+			snprintf(what, sizeof(what), "%s: temp file removed", test->name);
+			expect(access(TMP_PATH, F_OK) != 0, what);
+		}
+
+		// The next save goes over whatever an interrupted one left behind
+		generation += 1;
+		snprintf(what, sizeof(what), "%s: next save replaces the slot", test->name);
+		expect(writeInChild(FAULT_NONE, generation) == 0 && loadsGeneration(generation), what);
+		expect(access(TMP_PATH, F_OK) != 0, "no temp file after a save");
+	}
+
+	unlink(SLOT_PATH);
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -308,6 +308,14 @@ typedef struct MP4D_demux_tag {
 		// Cover art (JPEG or PNG data)
 		unsigned char* cover;
 		unsigned int cover_size;
+		// Gapless info: iTunSMPB freeform tag text and the pgap flag
+		unsigned char* smpb;
+		int gapless;
+		// ReplayGain freeform tags (text, e.g. "-6.54 dB")
+		unsigned char* replaygain_track_gain;
+		unsigned char* replaygain_album_gain;
+		unsigned char* replaygain_track_peak;
+		unsigned char* replaygain_album_peak;
 	} tag;
 #endif
 
@@ -628,6 +636,7 @@ enum {
 	BOX_tvsn = FOUR_CHAR_INT('t', 'v', 's', 'n'),	 // tv season (byte)
 	BOX_purd = FOUR_CHAR_INT('p', 'u', 'r', 'd'),	 // purchase date
 	BOX_pgap = FOUR_CHAR_INT('p', 'g', 'a', 'p'),	 // Gapless Playback (byte)
+	BOX_frfm = FOUR_CHAR_INT('-', '-', '-', '-'),	 // freeform tag (mean + name + data)
 
 	//BOX_aart   = FOUR_CHAR_INT( 'a', 'a', 'r', 't' ),     // Album artist
 	BOX_cART = FOUR_CHAR_INT('\xa9', 'A', 'R', 'T'), // artist
@@ -2924,6 +2933,59 @@ int MP4D_open(MP4D_demux_t* mp4, int (*read_callback)(int64_t offset, void* buff
 			}
 			break;
 
+		case BOX_pgap:
+			// Structure: size(4) + 'data'(4) + type(4) + reserved(4) + flag(1)
+			if (payload_bytes > 16) {
+				SKIP(16);
+				mp4->tag.gapless = READ(1) != 0;
+			}
+			break;
+
+		case BOX_frfm: {
+			// Freeform tag: 'mean' + 'name' + 'data' children, only iTunSMPB and ReplayGain are kept
+			char key[32] = {0};
+			while (payload_bytes > 8 && !eof_flag) {
+				unsigned sub_bytes = READ(4);
+				uint32_t sub_name = READ(4);
+				if (sub_bytes < 8 || sub_bytes - 8 > payload_bytes)
+					break;
+				unsigned sub_payload = sub_bytes - 8;
+				unsigned char** dest = NULL;
+				if (sub_name == BOX_data) {
+					if (!strcmp(key, "itunsmpb"))
+						dest = &mp4->tag.smpb;
+					else if (!strcmp(key, "replaygain_track_gain"))
+						dest = &mp4->tag.replaygain_track_gain;
+					else if (!strcmp(key, "replaygain_album_gain"))
+						dest = &mp4->tag.replaygain_album_gain;
+					else if (!strcmp(key, "replaygain_track_peak"))
+						dest = &mp4->tag.replaygain_track_peak;
+					else if (!strcmp(key, "replaygain_album_peak"))
+						dest = &mp4->tag.replaygain_album_peak;
+				}
+				if (sub_name == BOX_name && sub_payload > 4) {
+					SKIP(4); // version/flags
+					for (i = 0; i < sub_payload - 4; i++) {
+						char c = (char)READ(1);
+						if (c >= 'A' && c <= 'Z')
+							c += 'a' - 'A'; // taggers disagree on the case
+						if (i < sizeof(key) - 1)
+							key[i] = c;
+					}
+				} else if (dest && !*dest && sub_payload > 8) {
+					SKIP(8); // type + locale
+					MALLOC(unsigned char*, *dest, sub_payload - 8 + 1);
+					for (i = 0; i < sub_payload - 8; i++) {
+						(*dest)[i] = READ(1);
+					}
+					(*dest)[i] = 0;
+				} else {
+					SKIP(sub_payload);
+				}
+			}
+			break;
+		}
+
 #endif
 
 		case BOX_stsd:
@@ -3234,6 +3296,11 @@ void MP4D_close(MP4D_demux_t* mp4) {
 	FREE(mp4->tag.comment);
 	FREE(mp4->tag.genre);
 	FREE(mp4->tag.cover);
+	FREE(mp4->tag.smpb);
+	FREE(mp4->tag.replaygain_track_gain);
+	FREE(mp4->tag.replaygain_album_gain);
+	FREE(mp4->tag.replaygain_track_peak);
+	FREE(mp4->tag.replaygain_album_peak);
 #endif
 }
 
@@ -36,6 +36,32 @@ static int compare_entries(const void* a, const void* b) {
 	return strcasecmp(ea->name, eb->name);
 }
 
+BrowserEntryKind Browser_classifyEntry(const char* full_path, const struct dirent* ent, bool follow_links) {
+	switch (ent->d_type) {
+	case DT_DIR:
+		return BROWSER_ENTRY_DIR;
+	case DT_REG:
+		return BROWSER_ENTRY_FILE;
+	case DT_LNK:
+		if (!follow_links)
+			return BROWSER_ENTRY_OTHER;
+		break;
+	case DT_UNKNOWN:
+		break;
+	default:
+		return BROWSER_ENTRY_OTHER;
+	}
+
+	struct stat st;
+	if ((follow_links ? stat(full_path, &st) : lstat(full_path, &st)) != 0)
+		return BROWSER_ENTRY_OTHER;
+	if (S_ISDIR(st.st_mode))
+		return BROWSER_ENTRY_DIR;
+	if (S_ISREG(st.st_mode))
+		return BROWSER_ENTRY_FILE;
+	return BROWSER_ENTRY_OTHER;
+}
+
 // Load directory contents
 void Browser_loadDirectory(BrowserContext* ctx, const char* path, const char* music_root) {
 	Browser_freeEntries(ctx);
@@ -55,45 +81,12 @@ void Browser_loadDirectory(BrowserContext* ctx, const char* path, const char* mu
 		return;
 	}
 
-	// First pass: count entries (separate count for dirs and audio files)
-	int dir_count = 0;
-	int audio_count = 0;
-	struct dirent* ent;
-	while ((ent = readdir(dir)) != NULL) {
-		if (ent->d_name[0] == '.')
-			continue; // Skip hidden files
-
-		char full_path[1024]; // Increased to handle longer paths
-		int path_len = snprintf(full_path, sizeof(full_path), "%s/%s", path, ent->d_name);
-		if (path_len < 0 || path_len >= (int)sizeof(full_path)) {
-			continue; // Path too long, skip this entry
-		}
-
-		struct stat st;
-		if (stat(full_path, &st) != 0)
-			continue;
-
-		if (S_ISDIR(st.st_mode)) {
-			dir_count++;
-		} else if (Browser_isAudioFile(ent->d_name)) {
-			audio_count++;
-		}
-	}
-
-	int count = dir_count + audio_count;
-
 	// Add parent directory entry if not at root
 	bool has_parent = (strcmp(path, music_root) != 0);
-	if (has_parent)
-		count++;
 
-	// Add "Play All" entry if there are subdirectories
-	bool add_play_all = (dir_count > 0);
-	if (add_play_all)
-		count++;
-
-	// Allocate
-	ctx->entries = malloc(sizeof(FileEntry) * count);
+	// Room for "..", the entries and "Play All", grown as needed
+	int capacity = 64;
+	ctx->entries = malloc(sizeof(FileEntry) * capacity);
 	if (!ctx->entries) {
 		closedir(dir);
 		return;
@@ -118,11 +111,12 @@ void Browser_loadDirectory(BrowserContext* ctx, const char* path, const char* mu
 		idx++;
 	}
 
-	// Second pass: fill entries
-	rewinddir(dir);
+	// Single pass, d_type tells files from folders without a stat() per entry
+	int dir_count = 0;
+	struct dirent* ent;
 	while ((ent = readdir(dir)) != NULL) {
 		if (ent->d_name[0] == '.')
-			continue;
+			continue; // Skip hidden files
 
 		char full_path[1024]; // Increased to handle longer paths
 		int path_len = snprintf(full_path, sizeof(full_path), "%s/%s", path, ent->d_name);
@@ -130,24 +124,42 @@ void Browser_loadDirectory(BrowserContext* ctx, const char* path, const char* mu
 			continue; // Path too long, skip this entry
 		}
 
-		struct stat st;
-		if (stat(full_path, &st) != 0)
-			continue;
-
-		bool is_dir = S_ISDIR(st.st_mode);
 		AudioFormat fmt = AUDIO_FORMAT_UNKNOWN;
-
-		if (!is_dir) {
+		BrowserEntryKind kind;
+		if (ent->d_type == DT_REG) {
+			// Most entries are plain files, skip the ones we can't play before anything else
 			fmt = Player_detectFormat(ent->d_name);
 			if (fmt == AUDIO_FORMAT_UNKNOWN)
 				continue;
+			kind = BROWSER_ENTRY_FILE;
+		} else {
+			kind = Browser_classifyEntry(full_path, ent, true);
+			if (kind == BROWSER_ENTRY_FILE) {
+				fmt = Player_detectFormat(ent->d_name);
+				if (fmt == AUDIO_FORMAT_UNKNOWN)
+					continue;
+			} else if (kind != BROWSER_ENTRY_DIR) {
+				continue;
+			}
 		}
 
-		strncpy(ctx->entries[idx].name, ent->d_name, sizeof(ctx->entries[idx].name) - 1);
-		strncpy(ctx->entries[idx].path, full_path, sizeof(ctx->entries[idx].path) - 1);
-		ctx->entries[idx].is_dir = is_dir;
-		ctx->entries[idx].is_play_all = false;
-		ctx->entries[idx].format = fmt;
+		// Keep one slot free for "Play All"
+		if (idx + 1 >= capacity) {
+			capacity *= 2;
+			FileEntry* new_entries = realloc(ctx->entries, sizeof(FileEntry) * capacity);
+			if (!new_entries)
+				break;
+			ctx->entries = new_entries;
+		}
+
+		FileEntry* entry = &ctx->entries[idx];
+		snprintf(entry->name, sizeof(entry->name), "%s", ent->d_name);
+		snprintf(entry->path, sizeof(entry->path), "%s", full_path);
+		entry->is_dir = (kind == BROWSER_ENTRY_DIR);
+		entry->is_play_all = false;
+		entry->format = fmt;
+		if (entry->is_dir)
+			dir_count++;
 		idx++;
 	}
 
@@ -160,8 +172,8 @@ void Browser_loadDirectory(BrowserContext* ctx, const char* path, const char* mu
 			  sizeof(FileEntry), compare_entries);
 	}
 
-	// Add "Play All" entry at the end if applicable
-	if (add_play_all) {
+	// Add "Play All" entry at the end if there are subdirectories
+	if (dir_count > 0) {
 		strncpy(ctx->entries[idx].name, "Play All", sizeof(ctx->entries[idx].name) - 1);
 		ctx->entries[idx].name[sizeof(ctx->entries[idx].name) - 1] = '\0';
 		strncpy(ctx->entries[idx].path, path, sizeof(ctx->entries[idx].path) - 1);
@@ -230,16 +242,13 @@ static bool has_audio_recursive(const char* path, int depth) {
 		if (snprintf(full_path, sizeof(full_path), "%s/%s", path, ent->d_name) >= (int)sizeof(full_path))
 			continue;
 
-		struct stat st;
-		if (stat(full_path, &st) != 0)
-			continue;
-
-		if (S_ISDIR(st.st_mode)) {
+		BrowserEntryKind kind = Browser_classifyEntry(full_path, ent, true);
+		if (kind == BROWSER_ENTRY_DIR) {
 			if (has_audio_recursive(full_path, depth + 1)) {
 				closedir(dir);
 				return true;
 			}
-		} else if (Browser_isAudioFile(ent->d_name)) {
+		} else if (kind == BROWSER_ENTRY_FILE && Browser_isAudioFile(ent->d_name)) {
 			closedir(dir);
 			return true;
 		}
@@ -2,8 +2,16 @@
 #define __BROWSER_H__
 
 #include <stdbool.h>
+#include <dirent.h>
 #include "player.h" // For AudioFormat
 
+// What a directory entry is, see Browser_classifyEntry()
+typedef enum {
+	BROWSER_ENTRY_OTHER = 0,
+	BROWSER_ENTRY_DIR,
+	BROWSER_ENTRY_FILE
+} BrowserEntryKind;
+
 // File entry structure
 typedef struct {
 	char name[256];
@@ -47,4 +55,8 @@ bool Browser_hasParent(const BrowserContext* ctx);
 // Recursively check if any audio files exist under a directory
 bool Browser_hasAudioRecursive(const char* path);
 
+// Classify a readdir() entry from its d_type, only stat()ing when the
+// filesystem doesn't report one. Symlinks are skipped unless follow_links.
+BrowserEntryKind Browser_classifyEntry(const char* full_path, const struct dirent* ent, bool follow_links);
+
 #endif
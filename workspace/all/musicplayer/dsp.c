@@ -0,0 +1,302 @@
+#include <string.h>
+#include <math.h>
+
+#include "dsp.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define DSP_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DSP_SSE2 1
+#endif
+
+// Frames per pass: each stage runs over a block while it's still in L1
+#define DSP_BLOCK_FRAMES 256
+
+void DSP_init(DSPChain* dsp) {
+	memset(dsp, 0, sizeof(DSPChain));
+	dsp->gain_q = 1 << DSP_GAIN_SHIFT;
+}
+
+void DSP_setGain(DSPChain* dsp, float gain) {
+	if (gain < 0.0f)
+		gain = 0.0f;
+	if (gain > DSP_GAIN_MAX)
+		gain = DSP_GAIN_MAX;
+	dsp->gain_q = (int32_t)(gain * (1 << DSP_GAIN_SHIFT) + 0.5f);
+}
+
+void DSP_reset(DSPChain* dsp) {
+	for (int ch = 0; ch < DSP_CHANNELS; ch++) {
+		dsp->w1[ch] = 0.0f;
+		dsp->w2[ch] = 0.0f;
+	}
+}
+
+void DSP_setHighPass(DSPChain* dsp, int sample_rate, int cutoff_hz) {
+	if (cutoff_hz == dsp->hpf_hz && sample_rate == dsp->hpf_rate)
+		return;
+	dsp->hpf_rate = sample_rate;
+	dsp->hpf_hz = cutoff_hz;
+	DSP_reset(dsp);
+	if (cutoff_hz <= 0 || sample_rate <= 0)
+		return;
+
+	// 2nd-order Butterworth high-pass
+	const float fc = (float)cutoff_hz;
+	const float Q = 0.7071f; // Butterworth
+	float omega = 2.0f * M_PI * fc / (float)sample_rate;
+	float sin_w = sinf(omega);
+	float cos_w = cosf(omega);
+	float alpha = sin_w / (2.0f * Q);
+
+	float a0 = 1.0f + alpha;
+	dsp->b0 = ((1.0f + cos_w) / 2.0f) / a0;
+	dsp->b1 = (-(1.0f + cos_w)) / a0;
+	dsp->b2 = ((1.0f + cos_w) / 2.0f) / a0;
+	dsp->a1 = (-2.0f * cos_w) / a0;
+	dsp->a2 = (1.0f - alpha) / a0;
+}
+
+void DSP_setLimiter(DSPChain* dsp, float threshold) {
+	dsp->limit_threshold = threshold > 0.0f ? threshold : 0.0f;
+	dsp->limit_headroom = 1.0f - dsp->limit_threshold;
+}
+
+// ============ SCALAR KERNELS ============
+
+static inline int16_t gain_sample(int16_t sample, int32_t gain_q) {
+	int32_t v = (sample * gain_q + (1 << (DSP_GAIN_SHIFT - 1))) >> DSP_GAIN_SHIFT;
+	if (v > 32767)
+		v = 32767;
+	if (v < -32768)
+		v = -32768;
+	return (int16_t)v;
+}
+
+// Linear below threshold, asymptotically compressed above
+static inline int16_t limit_sample(int16_t sample, float threshold, float headroom) {
+	float x = sample * (1.0f / 32768.0f);
+	float abs_x = fabsf(x);
+	if (abs_x <= threshold)
+		return sample;
+
+	float sign = (x >= 0.0f) ? 1.0f : -1.0f;
+	float over = abs_x - threshold;
+	// Asymptotic curve: smoothly approaches 1.0 but never reaches it
+	float compressed = threshold + headroom * over / (over + headroom);
+
+	return (int16_t)(sign * compressed * 32767.0f);
+}
+
+static void gain_scalar(int16_t* samples, size_t count, int32_t gain_q) {
+	for (size_t i = 0; i < count; i++)
+		samples[i] = gain_sample(samples[i], gain_q);
+}
+
+static void highpass_scalar(DSPChain* dsp, int16_t* samples, size_t frames) {
+	for (size_t i = 0; i < frames; i++) {
+		for (int ch = 0; ch < DSP_CHANNELS; ch++) {
+			float x = (float)samples[i * DSP_CHANNELS + ch];
+			float y = dsp->b0 * x + dsp->w1[ch];
+			dsp->w1[ch] = dsp->b1 * x - dsp->a1 * y + dsp->w2[ch];
+			dsp->w2[ch] = dsp->b2 * x - dsp->a2 * y;
+
+			if (y > 32767.0f)
+				y = 32767.0f;
+			if (y < -32768.0f)
+				y = -32768.0f;
+			samples[i * DSP_CHANNELS + ch] = (int16_t)y;
+		}
+	}
+}
+
+static void limit_scalar(DSPChain* dsp, int16_t* samples, size_t count) {
+	for (size_t i = 0; i < count; i++)
+		samples[i] = limit_sample(samples[i], dsp->limit_threshold, dsp->limit_headroom);
+}
+
+// ============ SIMD KERNELS ============
+
+#if defined(DSP_NEON)
+
+static void gain_simd(int16_t* samples, size_t count, int32_t gain_q) {
+	int32x4_t g = vdupq_n_s32(gain_q);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		int16x8_t v = vld1q_s16(samples + i);
+		int32x4_t lo = vmulq_s32(vmovl_s16(vget_low_s16(v)), g);
+		int32x4_t hi = vmulq_s32(vmovl_s16(vget_high_s16(v)), g);
+		// Rounding shift with saturating narrow, same as gain_sample
+		vst1q_s16(samples + i, vcombine_s16(vqrshrn_n_s32(lo, DSP_GAIN_SHIFT), vqrshrn_n_s32(hi, DSP_GAIN_SHIFT)));
+	}
+	gain_scalar(samples + i, count - i, gain_q);
+}
+
+// Left and right run side by side in the two lanes
+static void highpass_simd(DSPChain* dsp, int16_t* samples, size_t frames) {
+	float32x2_t b0 = vdup_n_f32(dsp->b0), b1 = vdup_n_f32(dsp->b1), b2 = vdup_n_f32(dsp->b2);
+	float32x2_t a1 = vdup_n_f32(dsp->a1), a2 = vdup_n_f32(dsp->a2);
+	float32x2_t w1 = vld1_f32(dsp->w1), w2 = vld1_f32(dsp->w2);
+	float32x2_t hi = vdup_n_f32(32767.0f), lo = vdup_n_f32(-32768.0f);
+
+	for (size_t i = 0; i < frames; i++) {
+		int16_t* frame = samples + i * DSP_CHANNELS;
+		int32x2_t xi = {frame[0], frame[1]};
+		float32x2_t x = vcvt_f32_s32(xi);
+		float32x2_t y = vadd_f32(vmul_f32(b0, x), w1);
+		w1 = vadd_f32(vsub_f32(vmul_f32(b1, x), vmul_f32(a1, y)), w2);
+		w2 = vsub_f32(vmul_f32(b2, x), vmul_f32(a2, y));
+
+		int32x2_t out = vcvt_s32_f32(vmax_f32(vmin_f32(y, hi), lo));
+		frame[0] = (int16_t)vget_lane_s32(out, 0);
+		frame[1] = (int16_t)vget_lane_s32(out, 1);
+	}
+	vst1_f32(dsp->w1, w1);
+	vst1_f32(dsp->w2, w2);
+}
+
+static inline int32x4_t limit_lanes(int32x4_t v, float32x4_t threshold, float32x4_t headroom) {
+	float32x4_t x = vmulq_n_f32(vcvtq_f32_s32(v), 1.0f / 32768.0f);
+	float32x4_t abs_x = vabsq_f32(x);
+	float32x4_t over = vsubq_f32(abs_x, threshold);
+	float32x4_t compressed = vaddq_f32(threshold, vdivq_f32(vmulq_f32(headroom, over), vaddq_f32(over, headroom)));
+	float32x4_t scaled = vmulq_n_f32(compressed, 32767.0f);
+	scaled = vbslq_f32(vcltq_f32(x, vdupq_n_f32(0.0f)), vnegq_f32(scaled), scaled);
+	return vbslq_s32(vcleq_f32(abs_x, threshold), v, vcvtq_s32_f32(scaled));
+}
+
+static void limit_simd(DSPChain* dsp, int16_t* samples, size_t count) {
+	float32x4_t threshold = vdupq_n_f32(dsp->limit_threshold);
+	float32x4_t headroom = vdupq_n_f32(dsp->limit_headroom);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		int16x8_t v = vld1q_s16(samples + i);
+		int32x4_t lo = limit_lanes(vmovl_s16(vget_low_s16(v)), threshold, headroom);
+		int32x4_t hi = limit_lanes(vmovl_s16(vget_high_s16(v)), threshold, headroom);
+		vst1q_s16(samples + i, vcombine_s16(vmovn_s32(lo), vmovn_s32(hi)));
+	}
+	limit_scalar(dsp, samples + i, count - i);
+}
+
+#elif defined(DSP_SSE2)
+
+static void gain_simd(int16_t* samples, size_t count, int32_t gain_q) {
+	// SSE2 has no 32-bit multiply: split the gain into two int16 halves and let
+	// madd compute x * g1 + x * g2 = x * gain exactly
+	int32_t g1 = gain_q > 32767 ? 32767 : gain_q;
+	int32_t g2 = gain_q - g1;
+	__m128i g = _mm_set1_epi32((g2 << 16) | (g1 & 0xFFFF));
+	__m128i round = _mm_set1_epi32(1 << (DSP_GAIN_SHIFT - 1));
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(samples + i));
+		__m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(v, v), g);
+		__m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(v, v), g);
+		lo = _mm_srai_epi32(_mm_add_epi32(lo, round), DSP_GAIN_SHIFT);
+		hi = _mm_srai_epi32(_mm_add_epi32(hi, round), DSP_GAIN_SHIFT);
+		_mm_storeu_si128((__m128i*)(samples + i), _mm_packs_epi32(lo, hi));
+	}
+	gain_scalar(samples + i, count - i, gain_q);
+}
+
+// Left and right run side by side in the two low lanes
+static void highpass_simd(DSPChain* dsp, int16_t* samples, size_t frames) {
+	__m128 b0 = _mm_set1_ps(dsp->b0), b1 = _mm_set1_ps(dsp->b1), b2 = _mm_set1_ps(dsp->b2);
+	__m128 a1 = _mm_set1_ps(dsp->a1), a2 = _mm_set1_ps(dsp->a2);
+	__m128 w1 = _mm_setr_ps(dsp->w1[0], dsp->w1[1], 0.0f, 0.0f);
+	__m128 w2 = _mm_setr_ps(dsp->w2[0], dsp->w2[1], 0.0f, 0.0f);
+	__m128 hi = _mm_set1_ps(32767.0f), lo = _mm_set1_ps(-32768.0f);
+
+	for (size_t i = 0; i < frames; i++) {
+		int16_t* frame = samples + i * DSP_CHANNELS;
+		__m128 x = _mm_cvtepi32_ps(_mm_setr_epi32(frame[0], frame[1], 0, 0));
+		__m128 y = _mm_add_ps(_mm_mul_ps(b0, x), w1);
+		w1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), w2);
+		w2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+
+		__m128i out = _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(y, hi), lo));
+		frame[0] = (int16_t)_mm_cvtsi128_si32(out);
+		frame[1] = (int16_t)_mm_cvtsi128_si32(_mm_srli_si128(out, 4));
+	}
+
+	float state[4];
+	_mm_storeu_ps(state, w1);
+	dsp->w1[0] = state[0];
+	dsp->w1[1] = state[1];
+	_mm_storeu_ps(state, w2);
+	dsp->w2[0] = state[0];
+	dsp->w2[1] = state[1];
+}
+
+static inline __m128i limit_lanes(__m128i v, __m128 threshold, __m128 headroom) {
+	const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	__m128 x = _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.0f / 32768.0f));
+	__m128 abs_x = _mm_andnot_ps(sign_mask, x);
+	__m128 over = _mm_sub_ps(abs_x, threshold);
+	__m128 compressed = _mm_add_ps(threshold, _mm_div_ps(_mm_mul_ps(headroom, over), _mm_add_ps(over, headroom)));
+	// Scale, then give it the sign of x (x is never 0 where this is used)
+	__m128 scaled = _mm_or_ps(_mm_mul_ps(compressed, _mm_set1_ps(32767.0f)), _mm_and_ps(sign_mask, x));
+	__m128i limited = _mm_cvttps_epi32(scaled);
+	__m128i keep = _mm_castps_si128(_mm_cmple_ps(abs_x, threshold));
+	return _mm_or_si128(_mm_and_si128(keep, v), _mm_andnot_si128(keep, limited));
+}
+
+static void limit_simd(DSPChain* dsp, int16_t* samples, size_t count) {
+	__m128 threshold = _mm_set1_ps(dsp->limit_threshold);
+	__m128 headroom = _mm_set1_ps(dsp->limit_headroom);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(samples + i));
+		// Sign extend to 32 bits
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+		lo = limit_lanes(lo, threshold, headroom);
+		hi = limit_lanes(hi, threshold, headroom);
+		_mm_storeu_si128((__m128i*)(samples + i), _mm_packs_epi32(lo, hi));
+	}
+	limit_scalar(dsp, samples + i, count - i);
+}
+
+#endif
+
+// ============ CHAIN ============
+
+void DSP_processScalar(DSPChain* dsp, int16_t* samples, size_t frames) {
+	bool gain = dsp->gain_q != (1 << DSP_GAIN_SHIFT);
+	bool highpass = dsp->hpf_hz > 0;
+	bool limit = dsp->limit_threshold > 0.0f;
+
+	for (size_t done = 0; done < frames; done += DSP_BLOCK_FRAMES) {
+		size_t n = frames - done < DSP_BLOCK_FRAMES ? frames - done : DSP_BLOCK_FRAMES;
+		int16_t* block = samples + done * DSP_CHANNELS;
+		if (gain)
+			gain_scalar(block, n * DSP_CHANNELS, dsp->gain_q);
+		if (highpass)
+			highpass_scalar(dsp, block, n);
+		if (limit)
+			limit_scalar(dsp, block, n * DSP_CHANNELS);
+	}
+}
+
+void DSP_process(DSPChain* dsp, int16_t* samples, size_t frames) {
+#if defined(DSP_NEON) || defined(DSP_SSE2)
+	bool gain = dsp->gain_q != (1 << DSP_GAIN_SHIFT);
+	bool highpass = dsp->hpf_hz > 0;
+	bool limit = dsp->limit_threshold > 0.0f;
+
+	for (size_t done = 0; done < frames; done += DSP_BLOCK_FRAMES) {
+		size_t n = frames - done < DSP_BLOCK_FRAMES ? frames - done : DSP_BLOCK_FRAMES;
+		int16_t* block = samples + done * DSP_CHANNELS;
+		if (gain)
+			gain_simd(block, n * DSP_CHANNELS, dsp->gain_q);
+		if (highpass)
+			highpass_simd(dsp, block, n);
+		if (limit)
+			limit_simd(dsp, block, n * DSP_CHANNELS);
+	}
+#else
+	DSP_processScalar(dsp, samples, frames);
+#endif
+}
@@ -0,0 +1,53 @@
+#ifndef __DSP_H__
+#define __DSP_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Output post-processing chain for stereo interleaved int16:
+// gain -> speaker high-pass -> speaker soft limiter.
+// NEON kernels on device (aarch64), SSE2 on desktop, scalar elsewhere.
+// All paths produce the same samples as the scalar one.
+
+#define DSP_CHANNELS 2
+#define DSP_GAIN_SHIFT 14 // Gain is Q14 fixed point
+#define DSP_GAIN_MAX 3.98f // +12 dB, keeps sample * gain inside 32 bits
+
+typedef struct {
+	int32_t gain_q; // Q14, (1 << DSP_GAIN_SHIFT) is unity
+
+	// 2nd order Butterworth high-pass, Direct Form II Transposed (0 Hz = off)
+	int hpf_rate;
+	int hpf_hz;
+	float b0, b1, b2, a1, a2;
+	float w1[DSP_CHANNELS];
+	float w2[DSP_CHANNELS];
+
+	// Soft limiter (threshold 0 = off), headroom = 1 - threshold
+	float limit_threshold;
+	float limit_headroom;
+} DSPChain;
+
+// Unity gain, filter and limiter off
+void DSP_init(DSPChain* dsp);
+
+// Linear gain, clamped to DSP_GAIN_MAX
+void DSP_setGain(DSPChain* dsp, float gain);
+
+// Coefficients are only recalculated (and the filter state cleared) when
+// the rate or cutoff changes
+void DSP_setHighPass(DSPChain* dsp, int sample_rate, int cutoff_hz);
+
+// Clear the filter state (audio device reopened)
+void DSP_reset(DSPChain* dsp);
+
+void DSP_setLimiter(DSPChain* dsp, float threshold);
+
+// Run the chain in place
+void DSP_process(DSPChain* dsp, int16_t* samples, size_t frames);
+
+// Scalar chain, the reference the SIMD kernels are checked against
+void DSP_processScalar(DSPChain* dsp, int16_t* samples, size_t frames);
+
+#endif
@@ -0,0 +1,1138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sqlite3.h>
+
+#include "defines.h"
+#include "api.h"
+#include "library.h"
+#include "browser.h"
+
+// Bump when the schema or the tag reader changes in a way that needs a full rescan
+#define LIBRARY_SCHEMA_VERSION 2
+
+#define LIBRARY_MAX_DEPTH 16			 // Maximum recursion depth for the scanner
+#define LIBRARY_BATCH_SIZE 200			 // Rows per write transaction while scanning
+#define LIBRARY_TEXT_FRAME_MAX 1024		 // Larger ID3 text frames are skipped
+#define LIBRARY_COMMENT_MAX (64 * 1024)	 // Vorbis comment bytes read (pictures are skipped)
+#define LIBRARY_OGG_TAIL (64 * 1024)	 // Bytes searched for the last Ogg page
+#define LIBRARY_OGG_PAGE_MAX (255 * 255)	 // Largest Ogg page body
+
+#define UNKNOWN_ARTIST "Unknown Artist"
+#define UNKNOWN_ALBUM "Unknown Album"
+#define UNKNOWN_GENRE "Unknown Genre"
+
+// Index state
+static struct {
+	sqlite3* db; // UI thread connection, the scanner opens its own
+	char music_root[512];
+
+	pthread_t scanner;
+	pthread_mutex_t mutex;
+	bool scanning;
+	bool scanner_joinable;
+	bool stop;
+} library = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+// ============ TAG READING ============
+
+static uint32_t read_be32(const uint8_t* p) {
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint32_t read_le32(const uint8_t* p) {
+	return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+}
+
+static uint16_t read_le16(const uint8_t* p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_syncsafe(const uint8_t* p) {
+	return ((uint32_t)(p[0] & 0x7F) << 21) | ((uint32_t)(p[1] & 0x7F) << 14) |
+		   ((uint32_t)(p[2] & 0x7F) << 7) | (uint32_t)(p[3] & 0x7F);
+}
+
+// Append one code point as UTF-8, returns false when dest is full
+static bool put_utf8(char* dest, size_t max_len, size_t* j, uint32_t cp) {
+	char buf[4];
+	size_t n;
+	if (cp < 0x80) {
+		buf[0] = (char)cp;
+		n = 1;
+	} else if (cp < 0x800) {
+		buf[0] = (char)(0xC0 | (cp >> 6));
+		buf[1] = (char)(0x80 | (cp & 0x3F));
+		n = 2;
+	} else if (cp < 0x10000) {
+		buf[0] = (char)(0xE0 | (cp >> 12));
+		buf[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		buf[2] = (char)(0x80 | (cp & 0x3F));
+		n = 3;
+	} else {
+		buf[0] = (char)(0xF0 | (cp >> 18));
+		buf[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+		buf[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		buf[3] = (char)(0x80 | (cp & 0x3F));
+		n = 4;
+	}
+	if (*j + n >= max_len)
+		return false;
+	memcpy(dest + *j, buf, n);
+	*j += n;
+	return true;
+}
+
+static void trim_tag(char* tag) {
+	size_t len = strlen(tag);
+	while (len > 0 && tag[len - 1] == ' ')
+		tag[--len] = '\0';
+}
+
+// Copy a tag value, stopping at the first NUL and trimming trailing spaces
+static void set_tag(char* dest, size_t max_len, const char* src, size_t src_len) {
+	size_t len = 0;
+	while (len < src_len && src[len])
+		len++;
+	if (len >= max_len)
+		len = max_len - 1;
+	memcpy(dest, src, len);
+	dest[len] = '\0';
+	trim_tag(dest);
+}
+
+static void latin1_to_utf8(char* dest, size_t max_len, const uint8_t* src, size_t src_len) {
+	size_t j = 0;
+	for (size_t i = 0; i < src_len && src[i]; i++) {
+		if (!put_utf8(dest, max_len, &j, src[i]))
+			break;
+	}
+	dest[j] = '\0';
+}
+
+static void utf16_to_utf8(char* dest, size_t max_len, const uint8_t* src, size_t src_len, bool big_endian) {
+	size_t j = 0;
+	for (size_t i = 0; i + 1 < src_len; i += 2) {
+		uint32_t cp = big_endian ? (src[i] << 8) | src[i + 1] : src[i] | (src[i + 1] << 8);
+		if (cp == 0)
+			break;
+		if (cp >= 0xD800 && cp < 0xDC00 && i + 3 < src_len) {
+			uint32_t lo = big_endian ? (src[i + 2] << 8) | src[i + 3] : src[i + 2] | (src[i + 3] << 8);
+			if (lo >= 0xDC00 && lo < 0xE000) {
+				cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+				i += 2;
+			}
+		}
+		if (!put_utf8(dest, max_len, &j, cp))
+			break;
+	}
+	dest[j] = '\0';
+}
+
+// ID3v1 genre list (also used by ID3v2 "(n)" genres and M4A gnre atoms)
+static const char* id3_genres[] = {
+	"Blues", "Classic Rock", "Country", "Dance", "Disco", "Funk", "Grunge", "Hip-Hop",
+	"Jazz", "Metal", "New Age", "Oldies", "Other", "Pop", "R&B", "Rap",
+	"Reggae", "Rock", "Techno", "Industrial", "Alternative", "Ska", "Death Metal", "Pranks",
+	"Soundtrack", "Euro-Techno", "Ambient", "Trip-Hop", "Vocal", "Jazz+Funk", "Fusion", "Trance",
+	"Classical", "Instrumental", "Acid", "House", "Game", "Sound Clip", "Gospel", "Noise",
+	"AlternRock", "Bass", "Soul", "Punk", "Space", "Meditative", "Instrumental Pop", "Instrumental Rock",
+	"Ethnic", "Gothic", "Darkwave", "Techno-Industrial", "Electronic", "Pop-Folk", "Eurodance", "Dream",
+	"Southern Rock", "Comedy", "Cult", "Gangsta", "Top 40", "Christian Rap", "Pop/Funk", "Jungle",
+	"Native American", "Cabaret", "New Wave", "Psychadelic", "Rave", "Showtunes", "Trailer", "Lo-Fi",
+	"Tribal", "Acid Punk", "Acid Jazz", "Polka", "Retro", "Musical", "Rock & Roll", "Hard Rock",
+};
+#define ID3_GENRE_COUNT (int)(sizeof(id3_genres) / sizeof(id3_genres[0]))
+
+// Turn "17", "(17)" or "(17)Refinement" into a genre name
+static void normalize_genre(char* genre, size_t max_len) {
+	const char* p = genre;
+	if (*p == '(')
+		p++;
+	char* end;
+	long id = strtol(p, &end, 10);
+	if (end == p)
+		return;
+	if (*end == ')' && end[1]) {
+		memmove(genre, end + 1, strlen(end + 1) + 1);
+	} else if ((*end == ')' || *end == '\0') && id >= 0 && id < ID3_GENRE_COUNT) {
+		snprintf(genre, max_len, "%s", id3_genres[id]);
+	}
+}
+
+// Decode an ID3v2 text frame body (encoding byte + text)
+static void id3_text(const uint8_t* data, size_t len, char* out, size_t out_len) {
+	if (len < 1)
+		return;
+	uint8_t encoding = data[0];
+	data++;
+	len--;
+
+	// 0 = ISO-8859-1, 1 = UTF-16 with BOM, 2 = UTF-16BE, 3 = UTF-8
+	if (encoding == 0) {
+		latin1_to_utf8(out, out_len, data, len);
+	} else if (encoding == 1 || encoding == 2) {
+		bool big_endian = (encoding == 2);
+		if (len >= 2 && data[0] == 0xFE && data[1] == 0xFF) {
+			big_endian = true;
+			data += 2;
+			len -= 2;
+		} else if (len >= 2 && data[0] == 0xFF && data[1] == 0xFE) {
+			big_endian = false;
+			data += 2;
+			len -= 2;
+		}
+		utf16_to_utf8(out, out_len, data, len, big_endian);
+	} else {
+		set_tag(out, out_len, (const char*)data, len);
+	}
+}
+
+// Read the ID3v2 text frames we index, seeking past pictures and other
+// large frames instead of loading the whole tag.
+// Returns the size of the tag (where the audio starts), 0 if there is none.
+static long read_id3v2(FILE* f, LibraryTags* tags) {
+	uint8_t header[10];
+	if (fseek(f, 0, SEEK_SET) != 0 || fread(header, 1, 10, f) != 10 || memcmp(header, "ID3", 3) != 0)
+		return 0;
+
+	uint8_t version = header[3]; // 2 = ID3v2.2, 3 = ID3v2.3, 4 = ID3v2.4
+	uint8_t flags = header[5];
+	long end = 10 + read_syncsafe(&header[6]);
+	long tag_size = end + ((flags & 0x10) ? 10 : 0); // footer
+
+	long pos = 10;
+	if ((flags & 0x40) && version >= 3) { // extended header
+		uint8_t ext[4];
+		if (fread(ext, 1, 4, f) != 4)
+			return tag_size;
+		pos += (version == 4) ? read_syncsafe(ext) : read_be32(ext) + 4;
+	}
+
+	int frame_header = (version == 2) ? 6 : 10;
+	char track[32] = "";
+	char length[32] = "";
+
+	while (pos + frame_header <= end) {
+		uint8_t fh[10];
+		if (fseek(f, pos, SEEK_SET) != 0 || fread(fh, 1, frame_header, f) != (size_t)frame_header)
+			break;
+		if (fh[0] == '\0')
+			break; // padding
+
+		char id[5] = {0};
+		uint32_t frame_size;
+		if (version == 2) {
+			static const char* v22_ids[][2] = {
+				{"TT2", "TIT2"}, {"TP1", "TPE1"}, {"TAL", "TALB"}, {"TCO", "TCON"}, {"TRK", "TRCK"}, {"TLE", "TLEN"}};
+			for (int i = 0; i < 6; i++) {
+				if (memcmp(fh, v22_ids[i][0], 3) == 0)
+					memcpy(id, v22_ids[i][1], 4);
+			}
+			frame_size = (fh[3] << 16) | (fh[4] << 8) | fh[5];
+		} else {
+			memcpy(id, fh, 4);
+			frame_size = (version == 4) ? read_syncsafe(&fh[4]) : read_be32(&fh[4]);
+		}
+		pos += frame_header;
+
+		if (frame_size == 0 || pos + (long)frame_size > end)
+			break;
+
+		char* field = NULL;
+		size_t field_len = 0;
+		if (strcmp(id, "TIT2") == 0) {
+			field = tags->title;
+			field_len = sizeof(tags->title);
+		} else if (strcmp(id, "TPE1") == 0) {
+			field = tags->artist;
+			field_len = sizeof(tags->artist);
+		} else if (strcmp(id, "TPE2") == 0) {
+			field = tags->album_artist;
+			field_len = sizeof(tags->album_artist);
+		} else if (strcmp(id, "TALB") == 0) {
+			field = tags->album;
+			field_len = sizeof(tags->album);
+		} else if (strcmp(id, "TCON") == 0) {
+			field = tags->genre;
+			field_len = sizeof(tags->genre);
+		} else if (strcmp(id, "TRCK") == 0) {
+			field = track;
+			field_len = sizeof(track);
+		} else if (strcmp(id, "TLEN") == 0) {
+			field = length;
+			field_len = sizeof(length);
+		}
+
+		if (field && frame_size <= LIBRARY_TEXT_FRAME_MAX) {
+			uint8_t data[LIBRARY_TEXT_FRAME_MAX];
+			if (fread(data, 1, frame_size, f) == frame_size)
+				id3_text(data, frame_size, field, field_len);
+		}
+
+		pos += frame_size;
+	}
+
+	if (track[0])
+		tags->track_no = atoi(track); // "3/12" reads as 3
+	if (length[0])
+		tags->duration_ms = atoi(length);
+	if (tags->genre[0])
+		normalize_genre(tags->genre, sizeof(tags->genre));
+
+	return tag_size;
+}
+
+// Fill fields the ID3v2 tag didn't have from an ID3v1 tag.
+// Returns true if the file ends in an ID3v1 tag.
+static bool read_id3v1(FILE* f, LibraryTags* tags) {
+	uint8_t tag[128];
+	if (fseek(f, -128, SEEK_END) != 0 || fread(tag, 1, 128, f) != 128 || memcmp(tag, "TAG", 3) != 0)
+		return false;
+
+	// ID3v1 layout: TAG(3) + Title(30) + Artist(30) + Album(30) + Year(4) + Comment(30) + Genre(1)
+	if (!tags->title[0])
+		latin1_to_utf8(tags->title, sizeof(tags->title), &tag[3], 30);
+	if (!tags->artist[0])
+		latin1_to_utf8(tags->artist, sizeof(tags->artist), &tag[33], 30);
+	if (!tags->album[0])
+		latin1_to_utf8(tags->album, sizeof(tags->album), &tag[63], 30);
+	if (!tags->track_no && tag[125] == 0 && tag[126])
+		tags->track_no = tag[126]; // ID3v1.1
+	if (!tags->genre[0] && tag[127] < ID3_GENRE_COUNT)
+		snprintf(tags->genre, sizeof(tags->genre), "%s", id3_genres[tag[127]]);
+
+	trim_tag(tags->title);
+	trim_tag(tags->artist);
+	trim_tag(tags->album);
+	return true;
+}
+
+// MP3 duration from the Xing/Info or VBRI header of the first frame,
+// or estimated from the bitrate for CBR files without one
+static int mp3_duration(FILE* f, long audio_start, long audio_end) {
+	static const uint16_t bitrates[2][3][15] = {
+		{// MPEG1: layer I, II, III
+		 {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+		 {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+		 {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320}},
+		{// MPEG2/2.5: layer I, II, III
+		 {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+		 {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+		 {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160}},
+	};
+	static const int sample_rates[3] = {44100, 48000, 32000};
+
+	uint8_t buf[4096];
+	if (fseek(f, audio_start, SEEK_SET) != 0)
+		return 0;
+	size_t n = fread(buf, 1, sizeof(buf), f);
+
+	for (size_t i = 0; i + 64 < n; i++) {
+		if (buf[i] != 0xFF || (buf[i + 1] & 0xE0) != 0xE0)
+			continue;
+
+		int version = (buf[i + 1] >> 3) & 3; // 3 = MPEG1, 2 = MPEG2, 0 = MPEG2.5
+		int layer = (buf[i + 1] >> 1) & 3;	 // 3 = I, 2 = II, 1 = III
+		int bitrate_index = buf[i + 2] >> 4;
+		int rate_index = (buf[i + 2] >> 2) & 3;
+		if (version == 1 || layer == 0 || bitrate_index == 0 || bitrate_index == 15 || rate_index == 3)
+			continue;
+
+		bool mpeg1 = (version == 3);
+		int sample_rate = sample_rates[rate_index] >> (mpeg1 ? 0 : (version == 2 ? 1 : 2));
+		int bitrate = bitrates[mpeg1 ? 0 : 1][3 - layer][bitrate_index];
+		int samples_per_frame = (layer == 3) ? 384 : (layer == 1 && !mpeg1) ? 576 : 1152;
+		bool mono = (buf[i + 3] >> 6) == 3;
+
+		const uint8_t* frame = &buf[i];
+		int xing = 4 + (mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17));
+		uint32_t frames = 0;
+		if ((memcmp(frame + xing, "Xing", 4) == 0 || memcmp(frame + xing, "Info", 4) == 0) &&
+			(read_be32(frame + xing + 4) & 1)) {
+			frames = read_be32(frame + xing + 8);
+		} else if (memcmp(frame + 36, "VBRI", 4) == 0) {
+			frames = read_be32(frame + 36 + 14);
+		}
+
+		if (frames)
+			return (int)((uint64_t)frames * samples_per_frame * 1000 / sample_rate);
+
+		long audio_bytes = audio_end - (audio_start + (long)i);
+		return audio_bytes > 0 ? (int)((uint64_t)audio_bytes * 8 / bitrate) : 0;
+	}
+	return 0;
+}
+
+// Parse a Vorbis comment block (shared by FLAC, Ogg Vorbis and Opus)
+static void parse_vorbis_comments(const uint8_t* data, size_t len, LibraryTags* tags) {
+	if (len < 8)
+		return;
+	size_t pos = 4 + read_le32(data); // vendor string
+	if (pos + 4 > len)
+		return;
+	uint32_t count = read_le32(data + pos);
+	pos += 4;
+
+	for (uint32_t i = 0; i < count && pos + 4 <= len; i++) {
+		uint32_t comment_len = read_le32(data + pos);
+		pos += 4;
+		if (comment_len > len - pos)
+			break; // truncated, eg. a cover picture past LIBRARY_COMMENT_MAX
+
+		const char* comment = (const char*)data + pos;
+		const char* eq = memchr(comment, '=', comment_len);
+		pos += comment_len;
+		if (!eq)
+			continue;
+
+		size_t key_len = eq - comment;
+		const char* value = eq + 1;
+		size_t value_len = comment_len - key_len - 1;
+
+		if (key_len == 5 && strncasecmp(comment, "TITLE", 5) == 0) {
+			set_tag(tags->title, sizeof(tags->title), value, value_len);
+		} else if (key_len == 6 && strncasecmp(comment, "ARTIST", 6) == 0) {
+			set_tag(tags->artist, sizeof(tags->artist), value, value_len);
+		} else if (key_len == 5 && strncasecmp(comment, "ALBUM", 5) == 0) {
+			set_tag(tags->album, sizeof(tags->album), value, value_len);
+		} else if ((key_len == 11 && strncasecmp(comment, "ALBUMARTIST", 11) == 0) ||
+				   (key_len == 12 && strncasecmp(comment, "ALBUM ARTIST", 12) == 0)) {
+			set_tag(tags->album_artist, sizeof(tags->album_artist), value, value_len);
+		} else if (key_len == 5 && strncasecmp(comment, "GENRE", 5) == 0) {
+			set_tag(tags->genre, sizeof(tags->genre), value, value_len);
+		} else if (key_len == 11 && strncasecmp(comment, "TRACKNUMBER", 11) == 0) {
+			char track[16];
+			set_tag(track, sizeof(track), value, value_len);
+			tags->track_no = atoi(track);
+		}
+	}
+}
+
+static void read_flac(FILE* f, long start, LibraryTags* tags) {
+	uint8_t magic[4];
+	if (fseek(f, start, SEEK_SET) != 0 || fread(magic, 1, 4, f) != 4 || memcmp(magic, "fLaC", 4) != 0)
+		return;
+
+	long pos = start + 4;
+	bool last = false;
+	while (!last) {
+		uint8_t header[4];
+		if (fseek(f, pos, SEEK_SET) != 0 || fread(header, 1, 4, f) != 4)
+			break;
+		last = header[0] & 0x80;
+		int type = header[0] & 0x7F;
+		uint32_t len = (header[1] << 16) | (header[2] << 8) | header[3];
+		pos += 4;
+
+		if (type == 0 && len >= 18) { // STREAMINFO
+			uint8_t info[18];
+			if (fread(info, 1, 18, f) == 18) {
+				uint32_t sample_rate = (info[10] << 12) | (info[11] << 4) | (info[12] >> 4);
+				uint64_t total = ((uint64_t)(info[13] & 0x0F) << 32) | read_be32(&info[14]);
+				if (sample_rate)
+					tags->duration_ms = (int)(total * 1000 / sample_rate);
+			}
+		} else if (type == 4) { // VORBIS_COMMENT
+			size_t want = len < LIBRARY_COMMENT_MAX ? len : LIBRARY_COMMENT_MAX;
+			uint8_t* data = malloc(want);
+			if (data) {
+				if (fread(data, 1, want, f) == want)
+					parse_vorbis_comments(data, want, tags);
+				free(data);
+			}
+		}
+		pos += len;
+	}
+}
+
+// Ogg Vorbis/Opus: reassemble the identification and comment packets
+// from the first pages, then take the duration from the last page
+static void read_ogg(FILE* f, long file_size, LibraryTags* tags) {
+	// Holds one page body while reading the headers, then the whole tail
+	uint8_t* page = malloc(LIBRARY_OGG_TAIL > LIBRARY_OGG_PAGE_MAX ? LIBRARY_OGG_TAIL : LIBRARY_OGG_PAGE_MAX);
+	uint8_t* packet = malloc(LIBRARY_COMMENT_MAX);
+	if (!page || !packet) {
+		free(page);
+		free(packet);
+		return;
+	}
+
+	size_t packet_len = 0;
+	int packet_no = 0;
+	int sample_rate = 0;
+	int pre_skip = 0;
+	bool opus = false;
+	long pos = 0;
+
+	while (packet_no < 2) {
+		uint8_t header[27];
+		uint8_t lacing[255];
+		if (fseek(f, pos, SEEK_SET) != 0 || fread(header, 1, 27, f) != 27 || memcmp(header, "OggS", 4) != 0)
+			break;
+		int segments = header[26];
+		if (fread(lacing, 1, segments, f) != (size_t)segments)
+			break;
+
+		size_t body_len = 0;
+		for (int s = 0; s < segments; s++)
+			body_len += lacing[s];
+		if (fread(page, 1, body_len, f) != body_len)
+			break;
+		pos += 27 + segments + body_len;
+
+		size_t offset = 0;
+		for (int s = 0; s < segments && packet_no < 2; s++) {
+			size_t seg = lacing[s];
+			if (packet_len + seg <= LIBRARY_COMMENT_MAX)
+				memcpy(packet + packet_len, page + offset, seg);
+			packet_len += seg;
+			offset += seg;
+			if (seg == 255)
+				continue; // packet continues
+
+			size_t len = packet_len < LIBRARY_COMMENT_MAX ? packet_len : LIBRARY_COMMENT_MAX;
+			if (packet_no == 0) {
+				if (len >= 16 && memcmp(packet, "\x01vorbis", 7) == 0) {
+					sample_rate = read_le32(packet + 12);
+				} else if (len >= 19 && memcmp(packet, "OpusHead", 8) == 0) {
+					opus = true;
+					sample_rate = 48000; // Opus granule positions are always 48kHz
+					pre_skip = read_le16(packet + 10);
+				}
+			} else {
+				if (!opus && len > 7 && memcmp(packet, "\x03vorbis", 7) == 0)
+					parse_vorbis_comments(packet + 7, len - 7, tags);
+				else if (opus && len > 8 && memcmp(packet, "OpusTags", 8) == 0)
+					parse_vorbis_comments(packet + 8, len - 8, tags);
+			}
+			packet_no++;
+			packet_len = 0;
+		}
+	}
+
+	if (sample_rate > 0) {
+		long tail = file_size < LIBRARY_OGG_TAIL ? file_size : LIBRARY_OGG_TAIL;
+		if (fseek(f, file_size - tail, SEEK_SET) == 0 && fread(page, 1, tail, f) == (size_t)tail) {
+			for (long i = tail - 27; i >= 0; i--) {
+				if (memcmp(page + i, "OggS", 4) != 0)
+					continue;
+				int64_t granule = (int64_t)((uint64_t)read_le32(page + i + 10) << 32 | read_le32(page + i + 6));
+				if (granule < 0)
+					continue; // -1: no packet ends on this page
+				if (granule > pre_skip)
+					tags->duration_ms = (int)((granule - pre_skip) * 1000 / sample_rate);
+				break;
+			}
+		}
+	}
+
+	free(page);
+	free(packet);
+}
+
+static void read_wav(FILE* f, LibraryTags* tags) {
+	uint8_t header[12];
+	if (fseek(f, 0, SEEK_SET) != 0 || fread(header, 1, 12, f) != 12 ||
+		memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+		return;
+
+	uint32_t byte_rate = 0;
+	uint32_t data_size = 0;
+	long pos = 12;
+	uint8_t chunk[8];
+	while (fseek(f, pos, SEEK_SET) == 0 && fread(chunk, 1, 8, f) == 8) {
+		uint32_t size = read_le32(chunk + 4);
+
+		if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+			uint8_t fmt[16];
+			if (fread(fmt, 1, 16, f) == 16)
+				byte_rate = read_le32(fmt + 8);
+		} else if (memcmp(chunk, "data", 4) == 0) {
+			data_size = size;
+		} else if (memcmp(chunk, "LIST", 4) == 0 && size > 4 && size <= LIBRARY_TEXT_FRAME_MAX * 4) {
+			uint8_t* list = malloc(size);
+			if (list && fread(list, 1, size, f) == size && memcmp(list, "INFO", 4) == 0) {
+				for (uint32_t p = 4; p + 8 <= size;) {
+					uint32_t len = read_le32(list + p + 4);
+					if (len > size - p - 8)
+						break;
+					const char* value = (const char*)list + p + 8;
+					if (memcmp(list + p, "INAM", 4) == 0)
+						set_tag(tags->title, sizeof(tags->title), value, len);
+					else if (memcmp(list + p, "IART", 4) == 0)
+						set_tag(tags->artist, sizeof(tags->artist), value, len);
+					else if (memcmp(list + p, "IPRD", 4) == 0)
+						set_tag(tags->album, sizeof(tags->album), value, len);
+					else if (memcmp(list + p, "IGNR", 4) == 0)
+						set_tag(tags->genre, sizeof(tags->genre), value, len);
+					else if (memcmp(list + p, "ITRK", 4) == 0) {
+						char track[16];
+						set_tag(track, sizeof(track), value, len);
+						tags->track_no = atoi(track);
+					}
+					p += 8 + len + (len & 1);
+				}
+			}
+			free(list);
+		}
+
+		pos += 8 + size + (size & 1);
+	}
+
+	if (byte_rate)
+		tags->duration_ms = (int)((uint64_t)data_size * 1000 / byte_rate);
+}
+
+// Walk MP4 atoms by seeking, only moov/mvhd and the iTunes ilst items are read
+static void m4a_walk(FILE* f, long start, long end, bool in_ilst, int depth, LibraryTags* tags) {
+	if (depth > 6)
+		return;
+
+	long pos = start;
+	while (pos + 8 <= end) {
+		uint8_t header[16];
+		if (fseek(f, pos, SEEK_SET) != 0 || fread(header, 1, 8, f) != 8)
+			return;
+
+		uint64_t size = read_be32(header);
+		long header_len = 8;
+		if (size == 1) {
+			if (fread(header + 8, 1, 8, f) != 8)
+				return;
+			size = ((uint64_t)read_be32(header + 8) << 32) | read_be32(header + 12);
+			header_len = 16;
+		} else if (size == 0) {
+			size = end - pos; // extends to the end of the file
+		}
+		if (size < (uint64_t)header_len || pos + (long)size > end)
+			return;
+
+		const uint8_t* type = header + 4;
+		long body = pos + header_len;
+		long body_end = pos + (long)size;
+
+		if (in_ilst) {
+			// item atom holding a "data" atom: size(4) "data" type(4) locale(4) value
+			uint8_t data[16 + 256];
+			size_t want = body_end - body < (long)sizeof(data) ? (size_t)(body_end - body) : sizeof(data);
+			if (want > 16 && fread(data, 1, want, f) == want && memcmp(data + 4, "data", 4) == 0) {
+				size_t value_len = read_be32(data) > 16 ? read_be32(data) - 16 : 0;
+				if (value_len > want - 16)
+					value_len = want - 16;
+				const char* value = (const char*)data + 16;
+
+				if (memcmp(type, "\xa9nam", 4) == 0)
+					set_tag(tags->title, sizeof(tags->title), value, value_len);
+				else if (memcmp(type, "\xa9" "ART", 4) == 0)
+					set_tag(tags->artist, sizeof(tags->artist), value, value_len);
+				else if (memcmp(type, "\xa9" "alb", 4) == 0)
+					set_tag(tags->album, sizeof(tags->album), value, value_len);
+				else if (memcmp(type, "aART", 4) == 0)
+					set_tag(tags->album_artist, sizeof(tags->album_artist), value, value_len);
+				else if (memcmp(type, "\xa9gen", 4) == 0)
+					set_tag(tags->genre, sizeof(tags->genre), value, value_len);
+				else if (memcmp(type, "gnre", 4) == 0 && value_len >= 2) {
+					int id = ((uint8_t)value[0] << 8 | (uint8_t)value[1]) - 1;
+					if (!tags->genre[0] && id >= 0 && id < ID3_GENRE_COUNT)
+						snprintf(tags->genre, sizeof(tags->genre), "%s", id3_genres[id]);
+				} else if (memcmp(type, "trkn", 4) == 0 && value_len >= 4)
+					tags->track_no = (uint8_t)value[2] << 8 | (uint8_t)value[3];
+			}
+		} else if (memcmp(type, "moov", 4) == 0 || memcmp(type, "udta", 4) == 0) {
+			m4a_walk(f, body, body_end, false, depth + 1, tags);
+		} else if (memcmp(type, "meta", 4) == 0) {
+			m4a_walk(f, body + 4, body_end, false, depth + 1, tags); // full box: version + flags
+		} else if (memcmp(type, "ilst", 4) == 0) {
+			m4a_walk(f, body, body_end, true, depth + 1, tags);
+		} else if (memcmp(type, "mvhd", 4) == 0) {
+			uint8_t mvhd[32];
+			if (fread(mvhd, 1, sizeof(mvhd), f) == sizeof(mvhd)) {
+				uint32_t timescale;
+				uint64_t duration;
+				if (mvhd[0] == 1) {
+					timescale = read_be32(mvhd + 20);
+					duration = ((uint64_t)read_be32(mvhd + 24) << 32) | read_be32(mvhd + 28);
+				} else {
+					timescale = read_be32(mvhd + 12);
+					duration = read_be32(mvhd + 16);
+				}
+				if (timescale)
+					tags->duration_ms = (int)(duration * 1000 / timescale);
+			}
+		}
+
+		pos = body_end;
+	}
+}
+
+bool Library_readTags(const char* path, LibraryTags* tags) {
+	memset(tags, 0, sizeof(*tags));
+	tags->format = Player_detectFormat(path);
+	if (tags->format == AUDIO_FORMAT_UNKNOWN)
+		return false;
+
+	FILE* f = fopen(path, "rb");
+	if (!f)
+		return false;
+
+	fseek(f, 0, SEEK_END);
+	long file_size = ftell(f);
+
+	switch (tags->format) {
+	case AUDIO_FORMAT_MP3: {
+		long audio_start = read_id3v2(f, tags);
+		bool has_id3v1 = read_id3v1(f, tags);
+		if (!tags->duration_ms)
+			tags->duration_ms = mp3_duration(f, audio_start, file_size - (has_id3v1 ? 128 : 0));
+		break;
+	}
+	case AUDIO_FORMAT_FLAC:
+		read_flac(f, read_id3v2(f, tags), tags);
+		break;
+	case AUDIO_FORMAT_OGG:
+	case AUDIO_FORMAT_OPUS:
+		read_ogg(f, file_size, tags);
+		break;
+	case AUDIO_FORMAT_WAV:
+		read_wav(f, tags);
+		break;
+	case AUDIO_FORMAT_M4A:
+		m4a_walk(f, 0, file_size, false, 0, tags);
+		break;
+	case AUDIO_FORMAT_AAC:
+		read_id3v2(f, tags);
+		break;
+	default:
+		break;
+	}
+	fclose(f);
+
+	if (!tags->title[0]) {
+		const char* slash = strrchr(path, '/');
+		Browser_getDisplayName(slash ? slash + 1 : path, tags->title, sizeof(tags->title));
+	}
+	return true;
+}
+
+// ============ INDEX ============
+
+static sqlite3* open_db(void) {
+	mkdir(LIBRARY_DIR, 0755);
+
+	sqlite3* db = NULL;
+	if (sqlite3_open(LIBRARY_DB_PATH, &db) != SQLITE_OK) {
+		LOG_error("Library: %s\n", sqlite3_errmsg(db));
+		sqlite3_close(db);
+		return NULL;
+	}
+	sqlite3_busy_timeout(db, 2000);
+	// WAL so the UI can read while the scanner writes
+	sqlite3_exec(db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;", NULL, NULL, NULL);
+	return db;
+}
+
+static void create_schema(sqlite3* db) {
+	// Loudness results are expensive to redo, they live outside the versioned
+	// tracks table and survive rescans (rows are keyed on mtime/size instead)
+	if (sqlite3_exec(db,
+					 "CREATE TABLE IF NOT EXISTS loudness(path TEXT PRIMARY KEY, mtime INTEGER, size INTEGER, "
+					 "lufs REAL, peak REAL);",
+					 NULL, NULL, NULL) != SQLITE_OK)
+		LOG_error("Library: couldn't create loudness table: %s\n", sqlite3_errmsg(db));
+
+	int version = 0;
+	sqlite3_stmt* stmt = NULL;
+	if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, NULL) == SQLITE_OK &&
+		sqlite3_step(stmt) == SQLITE_ROW)
+		version = sqlite3_column_int(stmt, 0);
+	sqlite3_finalize(stmt);
+
+	if (version == LIBRARY_SCHEMA_VERSION)
+		return;
+
+	char sql[1024];
+	snprintf(sql, sizeof(sql),
+			 "DROP TABLE IF EXISTS tracks;"
+			 "CREATE TABLE tracks(path TEXT PRIMARY KEY, mtime INTEGER, size INTEGER, "
+			 "title TEXT, artist TEXT, album TEXT, album_artist TEXT, genre TEXT, track_no INTEGER, "
+			 "duration_ms INTEGER, format INTEGER, seen INTEGER);"
+			 "CREATE INDEX tracks_artist ON tracks(artist COLLATE NOCASE);"
+			 "CREATE INDEX tracks_album ON tracks(album COLLATE NOCASE, album_artist COLLATE NOCASE);"
+			 "CREATE INDEX tracks_genre ON tracks(genre COLLATE NOCASE);"
+			 "PRAGMA user_version=%d;",
+			 LIBRARY_SCHEMA_VERSION);
+	if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
+		LOG_error("Library: couldn't create index: %s\n", sqlite3_errmsg(db));
+}
+
+// Scanner state, only touched by the scanner thread
+typedef struct {
+	sqlite3* db;
+	sqlite3_stmt* lookup;
+	sqlite3_stmt* touch;
+	sqlite3_stmt* upsert;
+	int generation;
+	int pending; // writes in the open transaction
+	int added;
+} LibraryScan;
+
+static bool scan_should_stop(void) {
+	pthread_mutex_lock(&library.mutex);
+	bool stop = library.stop;
+	pthread_mutex_unlock(&library.mutex);
+	return stop;
+}
+
+static void scan_commit(LibraryScan* scan, bool force) {
+	if (!force && scan->pending < LIBRARY_BATCH_SIZE)
+		return;
+	sqlite3_exec(scan->db, "COMMIT; BEGIN;", NULL, NULL, NULL);
+	scan->pending = 0;
+}
+
+// Only files whose mtime or size changed are opened
+static void scan_file(LibraryScan* scan, const char* path) {
+	struct stat st;
+	if (stat(path, &st) != 0)
+		return;
+
+	sqlite3_bind_text(scan->lookup, 1, path, -1, SQLITE_STATIC);
+	bool unchanged = sqlite3_step(scan->lookup) == SQLITE_ROW &&
+					 sqlite3_column_int64(scan->lookup, 0) == (sqlite3_int64)st.st_mtime &&
+					 sqlite3_column_int64(scan->lookup, 1) == (sqlite3_int64)st.st_size;
+	sqlite3_reset(scan->lookup);
+
+	if (unchanged) {
+		sqlite3_bind_int(scan->touch, 1, scan->generation);
+		sqlite3_bind_text(scan->touch, 2, path, -1, SQLITE_STATIC);
+		sqlite3_step(scan->touch);
+		sqlite3_reset(scan->touch);
+	} else {
+		LibraryTags tags;
+		if (!Library_readTags(path, &tags))
+			return;
+
+		sqlite3_stmt* s = scan->upsert;
+		sqlite3_bind_text(s, 1, path, -1, SQLITE_STATIC);
+		sqlite3_bind_int64(s, 2, st.st_mtime);
+		sqlite3_bind_int64(s, 3, st.st_size);
+		sqlite3_bind_text(s, 4, tags.title, -1, SQLITE_STATIC);
+		sqlite3_bind_text(s, 5, tags.artist[0] ? tags.artist : UNKNOWN_ARTIST, -1, SQLITE_STATIC);
+		sqlite3_bind_text(s, 6, tags.album[0] ? tags.album : UNKNOWN_ALBUM, -1, SQLITE_STATIC);
+		// Albums are told apart by album artist, falling back to the track artist
+		const char* album_artist = tags.album_artist[0] ? tags.album_artist : tags.artist;
+		sqlite3_bind_text(s, 7, album_artist[0] ? album_artist : UNKNOWN_ARTIST, -1, SQLITE_STATIC);
+		sqlite3_bind_text(s, 8, tags.genre[0] ? tags.genre : UNKNOWN_GENRE, -1, SQLITE_STATIC);
+		sqlite3_bind_int(s, 9, tags.track_no);
+		sqlite3_bind_int(s, 10, tags.duration_ms);
+		sqlite3_bind_int(s, 11, tags.format);
+		sqlite3_bind_int(s, 12, scan->generation);
+		if (sqlite3_step(s) != SQLITE_DONE)
+			LOG_error("Library: couldn't index %s: %s\n", path, sqlite3_errmsg(scan->db));
+		sqlite3_reset(s);
+		scan->added++;
+	}
+
+	scan->pending++;
+	scan_commit(scan, false);
+}
+
+static void scan_directory(LibraryScan* scan, const char* path, int depth) {
+	if (depth > LIBRARY_MAX_DEPTH)
+		return;
+
+	DIR* dir = opendir(path);
+	if (!dir)
+		return;
+
+	struct dirent* ent;
+	while ((ent = readdir(dir)) != NULL && !scan_should_stop()) {
+		if (ent->d_name[0] == '.')
+			continue; // Skip hidden files
+
+		char full_path[512];
+		if (snprintf(full_path, sizeof(full_path), "%s/%s", path, ent->d_name) >= (int)sizeof(full_path))
+			continue;
+
+		// Don't follow symlinks, they can loop
+		BrowserEntryKind kind = Browser_classifyEntry(full_path, ent, false);
+		if (kind == BROWSER_ENTRY_DIR)
+			scan_directory(scan, full_path, depth + 1);
+		else if (kind == BROWSER_ENTRY_FILE && Browser_isAudioFile(ent->d_name))
+			scan_file(scan, full_path);
+	}
+	closedir(dir);
+}
+
+static void* scanner_thread(void* arg) {
+	(void)arg;
+
+	// Stay out of the way of playback and the UI
+	setpriority(PRIO_PROCESS, syscall(SYS_gettid), 10);
+
+	uint32_t start = SDL_GetTicks();
+	LibraryScan scan = {0};
+	scan.db = open_db();
+	if (!scan.db)
+		goto done;
+
+	sqlite3_stmt* stmt = NULL;
+	if (sqlite3_prepare_v2(scan.db, "SELECT COALESCE(MAX(seen), 0) + 1 FROM tracks;", -1, &stmt, NULL) == SQLITE_OK &&
+		sqlite3_step(stmt) == SQLITE_ROW)
+		scan.generation = sqlite3_column_int(stmt, 0);
+	sqlite3_finalize(stmt);
+
+	sqlite3_prepare_v2(scan.db, "SELECT mtime, size FROM tracks WHERE path=?;", -1, &scan.lookup, NULL);
+	sqlite3_prepare_v2(scan.db, "UPDATE tracks SET seen=? WHERE path=?;", -1, &scan.touch, NULL);
+	sqlite3_prepare_v2(scan.db,
+					   "INSERT OR REPLACE INTO tracks(path, mtime, size, title, artist, album, album_artist, "
+					   "genre, track_no, duration_ms, format, seen) VALUES(?,?,?,?,?,?,?,?,?,?,?,?);",
+					   -1, &scan.upsert, NULL);
+	if (!scan.lookup || !scan.touch || !scan.upsert) {
+		LOG_error("Library: %s\n", sqlite3_errmsg(scan.db));
+		goto cleanup;
+	}
+
+	sqlite3_exec(scan.db, "BEGIN;", NULL, NULL, NULL);
+	scan_directory(&scan, library.music_root, 0);
+	if (!scan_should_stop()) {
+		// Anything not seen this pass was deleted or moved
+		char sql[128];
+		snprintf(sql, sizeof(sql), "DELETE FROM tracks WHERE seen<>%d;", scan.generation);
+		sqlite3_exec(scan.db, sql, NULL, NULL, NULL);
+	}
+	sqlite3_exec(scan.db, "COMMIT;", NULL, NULL, NULL);
+
+	LOG_info("Library: scan done in %ums, %d new or changed files\n", SDL_GetTicks() - start, scan.added);
+
+cleanup:
+	sqlite3_finalize(scan.lookup);
+	sqlite3_finalize(scan.touch);
+	sqlite3_finalize(scan.upsert);
+	sqlite3_close(scan.db);
+done:
+	pthread_mutex_lock(&library.mutex);
+	library.scanning = false;
+	pthread_mutex_unlock(&library.mutex);
+	return NULL;
+}
+
+void Library_init(const char* music_root) {
+	snprintf(library.music_root, sizeof(library.music_root), "%s", music_root);
+
+	library.db = open_db();
+	if (!library.db)
+		return;
+	create_schema(library.db);
+
+	Library_rescan();
+}
+
+void Library_rescan(void) {
+	if (!library.db)
+		return;
+
+	pthread_mutex_lock(&library.mutex);
+	if (library.scanning) {
+		pthread_mutex_unlock(&library.mutex);
+		return;
+	}
+	library.scanning = true;
+	library.stop = false;
+	pthread_mutex_unlock(&library.mutex);
+
+	// reap the previous, already finished, scan
+	if (library.scanner_joinable) {
+		pthread_join(library.scanner, NULL);
+		library.scanner_joinable = false;
+	}
+
+	if (pthread_create(&library.scanner, NULL, scanner_thread, NULL) != 0) {
+		LOG_error("Library: couldn't start scanner\n");
+		pthread_mutex_lock(&library.mutex);
+		library.scanning = false;
+		pthread_mutex_unlock(&library.mutex);
+		return;
+	}
+	library.scanner_joinable = true;
+}
+
+void Library_quit(void) {
+	pthread_mutex_lock(&library.mutex);
+	library.stop = true;
+	pthread_mutex_unlock(&library.mutex);
+
+	if (library.scanner_joinable) {
+		pthread_join(library.scanner, NULL);
+		library.scanner_joinable = false;
+	}
+
+	if (library.db) {
+		sqlite3_close(library.db);
+		library.db = NULL;
+	}
+}
+
+bool Library_isScanning(void) {
+	pthread_mutex_lock(&library.mutex);
+	bool scanning = library.scanning;
+	pthread_mutex_unlock(&library.mutex);
+	return scanning;
+}
+
+// Player threads use a short lived connection of their own
+bool Library_getLoudness(const char* path, float* lufs, float* peak) {
+	struct stat st;
+	if (!path || stat(path, &st) != 0)
+		return false;
+
+	sqlite3* db = open_db();
+	if (!db)
+		return false;
+
+	bool found = false;
+	sqlite3_stmt* stmt = NULL;
+	if (sqlite3_prepare_v2(db, "SELECT lufs, peak FROM loudness WHERE path=? AND mtime=? AND size=?;",
+						   -1, &stmt, NULL) == SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, path, -1, SQLITE_STATIC);
+		sqlite3_bind_int64(stmt, 2, st.st_mtime);
+		sqlite3_bind_int64(stmt, 3, st.st_size);
+		if (sqlite3_step(stmt) == SQLITE_ROW) {
+			*lufs = (float)sqlite3_column_double(stmt, 0);
+			*peak = (float)sqlite3_column_double(stmt, 1);
+			found = true;
+		}
+	}
+	sqlite3_finalize(stmt);
+	sqlite3_close(db);
+	return found;
+}
+
+void Library_setLoudness(const char* path, float lufs, float peak) {
+	struct stat st;
+	if (!path || stat(path, &st) != 0)
+		return;
+
+	sqlite3* db = open_db();
+	if (!db)
+		return;
+
+	sqlite3_stmt* stmt = NULL;
+	if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO loudness(path, mtime, size, lufs, peak) VALUES(?,?,?,?,?);",
+						   -1, &stmt, NULL) == SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, path, -1, SQLITE_STATIC);
+		sqlite3_bind_int64(stmt, 2, st.st_mtime);
+		sqlite3_bind_int64(stmt, 3, st.st_size);
+		sqlite3_bind_double(stmt, 4, lufs);
+		sqlite3_bind_double(stmt, 5, peak);
+		if (sqlite3_step(stmt) != SQLITE_DONE)
+			LOG_error("Library: couldn't store loudness of %s: %s\n", path, sqlite3_errmsg(db));
+	} else {
+		LOG_error("Library: %s\n", sqlite3_errmsg(db));
+	}
+	sqlite3_finalize(stmt);
+	sqlite3_close(db);
+}
+
+static const char* view_column(LibraryView view) {
+	switch (view) {
+	case LIBRARY_VIEW_ALBUMS:
+		return "album";
+	case LIBRARY_VIEW_GENRES:
+		return "genre";
+	default:
+		return "artist";
+	}
+}
+
+LibraryGroup* Library_listGroups(LibraryView view, int* count) {
+	*count = 0;
+	if (!library.db)
+		return NULL;
+
+	// Same-named albums by different artists stay apart
+	const char* column = view_column(view);
+	const char* artist = view == LIBRARY_VIEW_ALBUMS ? "album_artist" : "''";
+	char sql[512];
+	snprintf(sql, sizeof(sql),
+			 "SELECT %s, %s, COUNT(*) FROM tracks GROUP BY %s COLLATE NOCASE, %s COLLATE NOCASE "
+			 "ORDER BY %s COLLATE NOCASE, %s COLLATE NOCASE;",
+			 column, artist, column, artist, column, artist);
+
+	sqlite3_stmt* stmt = NULL;
+	if (sqlite3_prepare_v2(library.db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+		LOG_error("Library: %s\n", sqlite3_errmsg(library.db));
+		return NULL;
+	}
+
+	int capacity = 64;
+	LibraryGroup* groups = malloc(sizeof(LibraryGroup) * capacity);
+	while (groups && sqlite3_step(stmt) == SQLITE_ROW) {
+		if (*count >= capacity) {
+			capacity *= 2;
+			LibraryGroup* new_groups = realloc(groups, sizeof(LibraryGroup) * capacity);
+			if (!new_groups)
+				break;
+			groups = new_groups;
+		}
+		LibraryGroup* group = &groups[*count];
+		const char* name = (const char*)sqlite3_column_text(stmt, 0);
+		const char* artist_name = (const char*)sqlite3_column_text(stmt, 1);
+		snprintf(group->name, sizeof(group->name), "%s", name ? name : "");
+		snprintf(group->artist, sizeof(group->artist), "%s", artist_name ? artist_name : "");
+		group->track_count = sqlite3_column_int(stmt, 2);
+		(*count)++;
+	}
+	sqlite3_finalize(stmt);
+	return groups;
+}
+
+int Library_listTracks(LibraryView view, const LibraryGroup* group, PlaylistTrack* tracks, int max) {
+	if (!library.db || !group)
+		return 0;
+
+	const char* column = view_column(view);
+	const char* order = (view == LIBRARY_VIEW_ALBUMS)
+							? "track_no, title COLLATE NOCASE"
+							: "album COLLATE NOCASE, album_artist COLLATE NOCASE, track_no, title COLLATE NOCASE";
+	const char* artist = view == LIBRARY_VIEW_ALBUMS ? "album_artist" : "''";
+	char sql[256];
+	snprintf(sql, sizeof(sql),
+			 "SELECT path, title, format FROM tracks WHERE %s=? COLLATE NOCASE AND %s=? COLLATE NOCASE "
+			 "ORDER BY %s LIMIT ?;",
+			 column, artist, order);
+
+	sqlite3_stmt* stmt = NULL;
+	if (sqlite3_prepare_v2(library.db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+		LOG_error("Library: %s\n", sqlite3_errmsg(library.db));
+		return 0;
+	}
+	sqlite3_bind_text(stmt, 1, group->name, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, group->artist, -1, SQLITE_STATIC);
+	sqlite3_bind_int(stmt, 3, max);
+
+	int count = 0;
+	while (count < max && sqlite3_step(stmt) == SQLITE_ROW) {
+		PlaylistTrack* track = &tracks[count];
+		const char* path = (const char*)sqlite3_column_text(stmt, 0);
+		const char* title = (const char*)sqlite3_column_text(stmt, 1);
+		snprintf(track->path, sizeof(track->path), "%s", path ? path : "");
+		snprintf(track->name, sizeof(track->name), "%s", title ? title : "");
+		track->format = (AudioFormat)sqlite3_column_int(stmt, 2);
+		count++;
+	}
+	sqlite3_finalize(stmt);
+	return count;
+}
@@ -0,0 +1,65 @@
+#ifndef __LIBRARY_H__
+#define __LIBRARY_H__
+
+#include <stdbool.h>
+#include "player.h"	  // For AudioFormat
+#include "playlist.h" // For PlaylistTrack
+
+#define LIBRARY_DIR SHARED_USERDATA_PATH "/music-player"
+#define LIBRARY_DB_PATH LIBRARY_DIR "/library.sqlite"
+
+// Tag based views over the music folder
+typedef enum {
+	LIBRARY_VIEW_ARTISTS,
+	LIBRARY_VIEW_ALBUMS,
+	LIBRARY_VIEW_GENRES
+} LibraryView;
+
+// One artist/album/genre entry
+typedef struct {
+	char name[256];
+	char artist[256]; // album artist for albums, "" otherwise
+	int track_count;
+} LibraryGroup;
+
+// Tags read from a single file
+typedef struct {
+	char title[256];
+	char artist[256];
+	char album[256];
+	char album_artist[256];
+	char genre[128];
+	int track_no;
+	int duration_ms;
+	AudioFormat format;
+} LibraryTags;
+
+// Open the index and start an incremental background scan of music_root
+void Library_init(const char* music_root);
+
+// Stop the scanner and close the index
+void Library_quit(void);
+
+// Start another incremental scan (no-op while one is running)
+void Library_rescan(void);
+
+// Check if the background scanner is running
+bool Library_isScanning(void);
+
+// List the artists/albums/genres in the index, sorted by name.
+// Returns a malloc()ed array (caller frees) and sets *count.
+LibraryGroup* Library_listGroups(LibraryView view, int* count);
+
+// Load the tracks of one artist/album/genre, in album and track order.
+// Returns number of tracks loaded.
+int Library_listTracks(LibraryView view, const LibraryGroup* group, PlaylistTrack* tracks, int max);
+
+// Read tags and duration from a file without decoding it
+bool Library_readTags(const char* path, LibraryTags* tags);
+
+// Loudness analysis results (integrated LUFS and linear sample peak) of files
+// without ReplayGain tags. Safe to call from any thread.
+bool Library_getLoudness(const char* path, float* lufs, float* peak);
+void Library_setLoudness(const char* path, float lufs, float peak);
+
+#endif
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+
+#include "loudness.h"
+
+#define LOUDNESS_STEP_MS 100		 // Gating blocks start every 100ms...
+#define LOUDNESS_BLOCK_STEPS 4		 // ...and are 400ms long (75% overlap)
+#define LOUDNESS_ABSOLUTE_GATE -70.0 // LUFS
+#define LOUDNESS_RELATIVE_GATE -10.0 // LU below the absolute-gated loudness
+#define LOUDNESS_MAX_GAIN 60.0f		 // Larger tag values are treated as garbage
+
+// Direct Form II Transposed biquad, double precision: the 38Hz high-pass
+// has its poles right next to the unit circle
+typedef struct {
+	double b0, b1, b2, a1, a2;
+} LoudnessBiquad;
+
+struct LoudnessMeter {
+	int channels;
+	LoudnessBiquad shelf;	 // K-weighting stage 1: head related high shelf
+	LoudnessBiquad highpass; // K-weighting stage 2: RLB high-pass
+	double state[2][4];		 // Per channel: shelf w1, w2, high-pass w1, w2
+
+	size_t step_frames;
+	size_t step_pos;
+	double step_sum;					// Weighted sum of squares of the current step
+	double steps[LOUDNESS_BLOCK_STEPS]; // Last steps, a block is their sum
+	int steps_seen;
+
+	float* blocks; // Mean square of every gating block
+	size_t block_count;
+	size_t block_capacity;
+
+	int peak;
+};
+
+// BS.1770 filters are specified at 48kHz, derive them for any rate from the
+// analog prototypes (same approach as libebur128)
+static void k_weighting_init(LoudnessMeter* meter, int sample_rate) {
+	double f0 = 1681.974450955533;
+	double gain_db = 3.999843853973347;
+	double q = 0.7071752369554196;
+	double k = tan(M_PI * f0 / sample_rate);
+	double vh = pow(10.0, gain_db / 20.0);
+	double vb = pow(vh, 0.4996667741545416);
+	double a0 = 1.0 + k / q + k * k;
+	meter->shelf.b0 = (vh + vb * k / q + k * k) / a0;
+	meter->shelf.b1 = 2.0 * (k * k - vh) / a0;
+	meter->shelf.b2 = (vh - vb * k / q + k * k) / a0;
+	meter->shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+	meter->shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+	f0 = 38.13547087602444;
+	q = 0.5003270373238773;
+	k = tan(M_PI * f0 / sample_rate);
+	a0 = 1.0 + k / q + k * k;
+	meter->highpass.b0 = 1.0;
+	meter->highpass.b1 = -2.0;
+	meter->highpass.b2 = 1.0;
+	meter->highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+	meter->highpass.a2 = (1.0 - k / q + k * k) / a0;
+}
+
+static inline double biquad_run(const LoudnessBiquad* f, double* w, double x) {
+	double y = f->b0 * x + w[0];
+	w[0] = f->b1 * x - f->a1 * y + w[1];
+	w[1] = f->b2 * x - f->a2 * y;
+	return y;
+}
+
+LoudnessMeter* Loudness_create(int sample_rate, int channels) {
+	if (sample_rate <= 0)
+		return NULL;
+
+	LoudnessMeter* meter = calloc(1, sizeof(LoudnessMeter));
+	if (!meter)
+		return NULL;
+	meter->channels = (channels == 1) ? 1 : 2;
+	meter->step_frames = (size_t)sample_rate * LOUDNESS_STEP_MS / 1000;
+	k_weighting_init(meter, sample_rate);
+	return meter;
+}
+
+void Loudness_free(LoudnessMeter* meter) {
+	if (!meter)
+		return;
+	free(meter->blocks);
+	free(meter);
+}
+
+// A 100ms step is complete: close the 400ms block ending with it
+static void finish_step(LoudnessMeter* meter) {
+	memmove(meter->steps, meter->steps + 1, sizeof(double) * (LOUDNESS_BLOCK_STEPS - 1));
+	meter->steps[LOUDNESS_BLOCK_STEPS - 1] = meter->step_sum;
+	meter->step_sum = 0.0;
+	meter->step_pos = 0;
+	if (++meter->steps_seen < LOUDNESS_BLOCK_STEPS)
+		return;
+
+	if (meter->block_count >= meter->block_capacity) {
+		size_t capacity = meter->block_capacity ? meter->block_capacity * 2 : 1024;
+		float* blocks = realloc(meter->blocks, sizeof(float) * capacity);
+		if (!blocks)
+			return; // Measure what fits
+		meter->blocks = blocks;
+		meter->block_capacity = capacity;
+	}
+
+	double sum = 0.0;
+	for (int i = 0; i < LOUDNESS_BLOCK_STEPS; i++)
+		sum += meter->steps[i];
+	meter->blocks[meter->block_count++] = (float)(sum / (meter->step_frames * LOUDNESS_BLOCK_STEPS));
+}
+
+void Loudness_process(LoudnessMeter* meter, const int16_t* samples, size_t frames) {
+	if (!meter)
+		return;
+
+	for (size_t i = 0; i < frames; i++) {
+		const int16_t* frame = samples + i * 2;
+		for (int ch = 0; ch < meter->channels; ch++) {
+			int v = frame[ch];
+			int abs_v = v < 0 ? -v : v;
+			if (abs_v > meter->peak)
+				meter->peak = abs_v;
+
+			double* w = meter->state[ch];
+			double x = v * (1.0 / 32768.0);
+			x = biquad_run(&meter->shelf, &w[0], x);
+			x = biquad_run(&meter->highpass, &w[2], x);
+			meter->step_sum += x * x; // Channel weights are 1.0 for L/R
+		}
+		if (++meter->step_pos >= meter->step_frames)
+			finish_step(meter);
+	}
+}
+
+static double block_lufs(double mean_square) {
+	return -0.691 + 10.0 * log10(mean_square);
+}
+
+bool Loudness_getResult(LoudnessMeter* meter, float* lufs, float* peak) {
+	if (!meter)
+		return false;
+
+	// Absolute gate, then relative gate 10 LU under what passed it
+	double absolute = pow(10.0, (LOUDNESS_ABSOLUTE_GATE + 0.691) / 10.0);
+	double sum = 0.0;
+	size_t count = 0;
+	for (size_t i = 0; i < meter->block_count; i++) {
+		if (meter->blocks[i] > absolute) {
+			sum += meter->blocks[i];
+			count++;
+		}
+	}
+	if (count == 0)
+		return false;
+
+	double relative = pow(10.0, (block_lufs(sum / count) + LOUDNESS_RELATIVE_GATE + 0.691) / 10.0);
+	double threshold = relative > absolute ? relative : absolute;
+	sum = 0.0;
+	count = 0;
+	for (size_t i = 0; i < meter->block_count; i++) {
+		if (meter->blocks[i] > threshold) {
+			sum += meter->blocks[i];
+			count++;
+		}
+	}
+	if (count == 0)
+		return false;
+
+	*lufs = (float)block_lufs(sum / count);
+	*peak = meter->peak / 32768.0f;
+	return true;
+}
+
+// "-6.54 dB" / "+1.20 dB"
+static bool parse_gain(const char* value, float* db) {
+	char* end;
+	float v = strtof(value, &end);
+	if (end == value || !isfinite(v) || fabsf(v) > LOUDNESS_MAX_GAIN)
+		return false;
+	*db = v;
+	return true;
+}
+
+static bool parse_peak(const char* value, float* peak) {
+	char* end;
+	float v = strtof(value, &end);
+	if (end == value || !isfinite(v) || v <= 0.0f)
+		return false;
+	*peak = v;
+	return true;
+}
+
+// Opus R128_*_GAIN: Q7.8 dB relative to -23 LUFS (RFC 7845)
+static bool parse_r128_gain(const char* value, float* db) {
+	char* end;
+	long v = strtol(value, &end, 10);
+	if (end == value || v < -32768 || v > 32767)
+		return false;
+	*db = v / 256.0f + (LOUDNESS_REFERENCE_LUFS - -23.0f);
+	return true;
+}
+
+static bool key_is(const char* key, size_t key_len, const char* name) {
+	return strlen(name) == key_len && strncasecmp(key, name, key_len) == 0;
+}
+
+bool Loudness_parseTag(ReplayGain* rg, const char* key, size_t key_len, const char* value) {
+	if (!rg || !key || !value)
+		return false;
+
+	if (key_is(key, key_len, "REPLAYGAIN_TRACK_GAIN")) {
+		rg->has_track_gain = parse_gain(value, &rg->track_gain) || rg->has_track_gain;
+	} else if (key_is(key, key_len, "REPLAYGAIN_ALBUM_GAIN")) {
+		rg->has_album_gain = parse_gain(value, &rg->album_gain) || rg->has_album_gain;
+	} else if (key_is(key, key_len, "REPLAYGAIN_TRACK_PEAK")) {
+		parse_peak(value, &rg->track_peak);
+	} else if (key_is(key, key_len, "REPLAYGAIN_ALBUM_PEAK")) {
+		parse_peak(value, &rg->album_peak);
+	} else if (key_is(key, key_len, "R128_TRACK_GAIN")) {
+		rg->has_track_gain = parse_r128_gain(value, &rg->track_gain) || rg->has_track_gain;
+	} else if (key_is(key, key_len, "R128_ALBUM_GAIN")) {
+		rg->has_album_gain = parse_r128_gain(value, &rg->album_gain) || rg->has_album_gain;
+	} else {
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,31 @@
+#ifndef __LOUDNESS_H__
+#define __LOUDNESS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "player.h" // For ReplayGain
+
+// ReplayGain 2.0 reference level, gain = reference - integrated loudness
+#define LOUDNESS_REFERENCE_LUFS -18.0f
+
+// EBU R128 / ITU-R BS.1770 integrated loudness meter (K-weighted, gated)
+typedef struct LoudnessMeter LoudnessMeter;
+
+// Samples are fed stereo interleaved. With channels == 1 only the left
+// channel is measured, mono sources are duplicated to both.
+LoudnessMeter* Loudness_create(int sample_rate, int channels);
+void Loudness_free(LoudnessMeter* meter);
+
+// Feed decoded audio
+void Loudness_process(LoudnessMeter* meter, const int16_t* samples, size_t frames);
+
+// Integrated loudness (LUFS) and sample peak (linear) of everything fed so far.
+// Returns false if nothing was above the absolute gate (silence or < 400ms).
+bool Loudness_getResult(LoudnessMeter* meter, float* lufs, float* peak);
+
+// Parse a ReplayGain or Opus R128 tag (REPLAYGAIN_TRACK_GAIN, R128_ALBUM_GAIN, ...)
+// into rg. Returns false if key isn't one of them.
+bool Loudness_parseTag(ReplayGain* rg, const char* key, size_t key_len, const char* value);
+
+#endif
@@ -0,0 +1,168 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "defines.h"
+#include "api.h"
+#include "module_common.h"
+#include "module_browse.h"
+#include "module_player.h"
+#include "library.h"
+#include "playlist.h"
+#include "ui_browse.h"
+#include "ui_list.h"
+
+// Internal states
+typedef enum {
+	BROWSE_INTERNAL_GROUPS,
+	BROWSE_INTERNAL_TRACKS
+} BrowseInternalState;
+
+// Controls help state IDs (for render_controls_help)
+#define BROWSE_GROUPS_HELP_STATE 56
+#define BROWSE_TRACKS_HELP_STATE 57
+
+// Refresh the group list this often while the scanner is still running
+#define BROWSE_SCAN_REFRESH_MS 1000
+
+// Group list state
+static LibraryGroup* groups = NULL;
+static int group_count = 0;
+static int group_selected = 0;
+static int group_scroll = 0;
+
+// Track list state
+static PlaylistTrack tracks[PLAYLIST_MAX_TRACKS];
+static int track_count = 0;
+static int track_selected = 0;
+static int track_scroll = 0;
+
+static const char* view_titles[] = {"Artists", "Albums", "Genres"};
+
+static void refresh_groups(LibraryView view) {
+	free(groups);
+	groups = Library_listGroups(view, &group_count);
+	if (group_selected >= group_count)
+		group_selected = group_count > 0 ? group_count - 1 : 0;
+}
+
+// Up/Down step, Left/Right page, both wrap like the other lists
+static bool navigate(int* selected, int count, int page) {
+	if (count <= 0)
+		return false;
+	if (PAD_justRepeated(BTN_UP)) {
+		*selected = (*selected > 0) ? *selected - 1 : count - 1;
+	} else if (PAD_justRepeated(BTN_DOWN)) {
+		*selected = (*selected < count - 1) ? *selected + 1 : 0;
+	} else if (PAD_justRepeated(BTN_LEFT)) {
+		*selected = (*selected > 0) ? (*selected > page ? *selected - page : 0) : count - 1;
+	} else if (PAD_justRepeated(BTN_RIGHT)) {
+		*selected = (*selected < count - 1) ? (*selected + page < count ? *selected + page : count - 1) : 0;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+ModuleExitReason BrowseModule_run(SDL_Surface* screen, LibraryView view) {
+	const char* view_title = view_titles[view];
+	group_selected = 0;
+	group_scroll = 0;
+	refresh_groups(view);
+
+	BrowseInternalState state = BROWSE_INTERNAL_GROUPS;
+	bool dirty = true;
+	IndicatorType show_setting = INDICATOR_NONE;
+	bool scanning = Library_isScanning();
+	uint32_t last_refresh = SDL_GetTicks();
+	char track_title[300] = "";
+
+	while (1) {
+		GFX_startFrame();
+		PAD_poll();
+
+		// Handle global input
+		int app_state_for_help = (state == BROWSE_INTERNAL_GROUPS) ? BROWSE_GROUPS_HELP_STATE : BROWSE_TRACKS_HELP_STATE;
+		GlobalInputResult global = ModuleCommon_handleGlobalInput(screen, &show_setting, app_state_for_help);
+		if (global.should_quit) {
+			return MODULE_EXIT_QUIT;
+		}
+		if (global.input_consumed) {
+			if (global.dirty)
+				dirty = 1;
+			GFX_sync();
+			continue;
+		}
+
+		int items_per_page = UI_calcListLayout(screen).items_per_page;
+
+		if (state == BROWSE_INTERNAL_GROUPS) {
+			// Pick up what the scanner indexed since we last looked
+			if (scanning && SDL_GetTicks() - last_refresh >= BROWSE_SCAN_REFRESH_MS) {
+				scanning = Library_isScanning();
+				refresh_groups(view);
+				last_refresh = SDL_GetTicks();
+				dirty = 1;
+			}
+
+			if (PAD_justPressed(BTN_B)) {
+				GFX_clearLayers(LAYER_SCROLLTEXT);
+				return MODULE_EXIT_TO_MENU;
+			} else if (navigate(&group_selected, group_count, items_per_page)) {
+				dirty = 1;
+			} else if (PAD_justPressed(BTN_A) && group_selected < group_count) {
+				track_count = Library_listTracks(view, &groups[group_selected], tracks, PLAYLIST_MAX_TRACKS);
+				snprintf(track_title, sizeof(track_title), "%s", groups[group_selected].name);
+				track_selected = 0;
+				track_scroll = 0;
+				state = BROWSE_INTERNAL_TRACKS;
+				GFX_clearLayers(LAYER_SCROLLTEXT);
+				dirty = 1;
+			}
+		} else if (state == BROWSE_INTERNAL_TRACKS) {
+			if (PAD_justPressed(BTN_B)) {
+				GFX_clearLayers(LAYER_SCROLLTEXT);
+				refresh_groups(view); // Refresh counts
+				state = BROWSE_INTERNAL_GROUPS;
+				dirty = 1;
+			} else if (navigate(&track_selected, track_count, items_per_page)) {
+				dirty = 1;
+			} else if (PAD_justPressed(BTN_A) && track_count > 0) {
+				// Play the whole group starting from the selected track
+				GFX_clearLayers(LAYER_SCROLLTEXT);
+				ModuleExitReason reason = PlayerModule_runWithPlaylist(screen, tracks, track_count, track_selected);
+				if (reason == MODULE_EXIT_QUIT)
+					return MODULE_EXIT_QUIT;
+				dirty = 1;
+			}
+		}
+
+		// Animate scroll
+		if (browse_list_needs_scroll_refresh()) {
+			browse_list_animate_scroll();
+		}
+		if (browse_list_scroll_needs_render())
+			dirty = 1;
+
+		// Power management
+		ModuleCommon_PWR_update(&dirty, &show_setting);
+
+		// Render
+		if (dirty) {
+			if (state == BROWSE_INTERNAL_GROUPS) {
+				UI_adjustListScroll(group_selected, &group_scroll, items_per_page);
+				render_browse_groups(screen, show_setting, view_title, groups, group_count,
+									 group_selected, group_scroll, scanning);
+			} else {
+				UI_adjustListScroll(track_selected, &track_scroll, items_per_page);
+				render_browse_tracks(screen, show_setting, track_title, tracks, track_count,
+									 track_selected, track_scroll);
+			}
+
+			GFX_flip(screen);
+			dirty = 0;
+		} else {
+			GFX_sync();
+		}
+	}
+}
@@ -0,0 +1,11 @@
+#ifndef __MODULE_BROWSE_H__
+#define __MODULE_BROWSE_H__
+
+#include <SDL2/SDL.h>
+#include "module_common.h"
+#include "library.h"
+
+// Run the tag based Artists/Albums/Genres browser
+ModuleExitReason BrowseModule_run(SDL_Surface* screen, LibraryView view);
+
+#endif
@@ -8,18 +8,23 @@
 #include "module_player.h"
 #include "module_playlist.h"
 #include "module_downloader.h"
+#include "module_browse.h"
+#include "library.h"
 #include "ui_list.h"
 
 // Library submenu items
 #define LIBRARY_FILES 0
-#define LIBRARY_PLAYLISTS 1
-#define LIBRARY_DOWNLOADER 2
-#define LIBRARY_ITEM_COUNT 3
+#define LIBRARY_ARTISTS 1
+#define LIBRARY_ALBUMS 2
+#define LIBRARY_GENRES 3
+#define LIBRARY_PLAYLISTS 4
+#define LIBRARY_DOWNLOADER 5
+#define LIBRARY_ITEM_COUNT 6
 
 // Help state for controls dialog
 #define LIBRARY_MENU_HELP_STATE 55
 
-static const char* library_items[] = {"Files", "Playlists", "Downloader"};
+static const char* library_items[] = {"Files", "Artists", "Albums", "Genres", "Playlists", "Downloader"};
 
 // Toast state
 static char library_toast_message[128] = "";
@@ -77,12 +82,23 @@ ModuleExitReason LibraryModule_run(SDL_Surface* screen) {
 			switch (menu_selected) {
 			case LIBRARY_FILES:
 				reason = PlayerModule_run(screen);
+				Library_rescan(); // files may have been deleted
+				break;
+			case LIBRARY_ARTISTS:
+				reason = BrowseModule_run(screen, LIBRARY_VIEW_ARTISTS);
+				break;
+			case LIBRARY_ALBUMS:
+				reason = BrowseModule_run(screen, LIBRARY_VIEW_ALBUMS);
+				break;
+			case LIBRARY_GENRES:
+				reason = BrowseModule_run(screen, LIBRARY_VIEW_GENRES);
 				break;
 			case LIBRARY_PLAYLISTS:
 				reason = PlaylistModule_run(screen);
 				break;
 			case LIBRARY_DOWNLOADER:
 				reason = DownloaderModule_run(screen);
+				Library_rescan(); // pick up new downloads
 				break;
 			}
 
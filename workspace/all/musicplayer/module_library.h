@@ -4,7 +4,7 @@
 #include <SDL2/SDL.h>
 #include "module_common.h"
 
-// Run the library submenu (Files, Playlists, Downloader)
+// Run the library submenu (Files, Artists, Albums, Genres, Playlists, Downloader)
 ModuleExitReason LibraryModule_run(SDL_Surface* screen);
 
 // Set toast message (called by sub-modules returning to library with a message)
@@ -57,6 +57,9 @@ static char resume_playlist_path[512] = "";
 // Resume: last save timestamp for periodic updates
 static uint32_t last_resume_save = 0;
 
+// Gapless: playlist index or browser entry queued in the player (-1 if none)
+static int queued_index = -1;
+
 
 // Clear all player GPU overlay layers
 static void clear_gpu_layers(void) {
@@ -81,39 +84,104 @@ static void init_player(void) {
 	initialized = true;
 }
 
-// Try to load and play a track, returns true on success
-static bool try_load_and_play(const char* path) {
-	if (Player_load(path) == 0) {
-		Player_play();
-		const TrackInfo* info = Player_getTrackInfo();
-
-		// Fetch album art (async) and lyrics after playback starts
-		if (info && !Player_getAlbumArt()) {
-			const char* artist = info->artist[0] ? info->artist : "";
-			const char* title = info->title[0] ? info->title : "";
-			if (artist[0] || title[0]) {
-				album_art_fetch(artist, title);
-			}
+// Pick what handle_track_ended would play next, without changing any state.
+// Returns a playlist index or browser entry, -1 if playback would stop.
+static int peek_next_index(void) {
+	if (playlist_active) {
+		int count = Playlist_getCount(&playlist);
+		int current = Playlist_getCurrentIndex(&playlist);
+		if (repeat_enabled)
+			return current;
+		if (shuffle_enabled) {
+			if (count <= 1)
+				return count - 1;
+			int idx;
+			do {
+				idx = rand() % count;
+			} while (idx == current);
+			return idx;
 		}
-		if (Settings_getLyricsEnabled() && info) {
-			Lyrics_fetch(info->artist, info->title, info->duration_ms / 1000);
+		return (current + 1 < count) ? current + 1 : -1;
+	}
+
+	if (repeat_enabled)
+		return browser.selected;
+	if (shuffle_enabled) {
+		int audio_count = Browser_countAudioFiles(&browser);
+		if (audio_count <= 1)
+			return -1;
+		int random_idx = rand() % (audio_count - 1);
+		int count = 0;
+		for (int i = 0; i < browser.entry_count; i++) {
+			if (!browser.entries[i].is_dir && i != browser.selected) {
+				if (count == random_idx)
+					return i;
+				count++;
+			}
 		}
+		return -1;
+	}
+	for (int i = browser.selected + 1; i < browser.entry_count; i++) {
+		if (!browser.entries[i].is_dir)
+			return i;
+	}
+	return -1;
+}
 
-		// Save resume state on every track change
-		const char* name = (info && info->title[0]) ? info->title : NULL;
-		if (!name) {
-			const char* slash = strrchr(path, '/');
-			name = slash ? slash + 1 : path;
+// Queue the upcoming track in the player so it starts without a gap
+static void queue_next_track(void) {
+	int idx = peek_next_index();
+	const char* path = NULL;
+	if (idx >= 0) {
+		if (playlist_active) {
+			const PlaylistTrack* track = Playlist_getTrack(&playlist, idx);
+			path = track ? track->path : NULL;
+		} else if (idx < browser.entry_count) {
+			path = browser.entries[idx].path;
 		}
-		if (resume_playlist_path[0] && playlist_active) {
-			Resume_savePlaylist(resume_playlist_path, path, name,
-								Playlist_getCurrentIndex(&playlist), 0);
-		} else {
-			int idx = playlist_active ? Playlist_getCurrentIndex(&playlist) : browser.selected;
-			Resume_saveFiles(browser.current_path, path, name, idx, 0);
+	}
+	if (Player_setNextTrack(path))
+		queued_index = path ? idx : -1;
+}
+
+// Track started playing: fetch art/lyrics, save resume state and queue the next one
+static void on_track_started(const char* path) {
+	const TrackInfo* info = Player_getTrackInfo();
+
+	// Fetch album art (async) and lyrics after playback starts
+	if (info && !Player_getAlbumArt()) {
+		const char* artist = info->artist[0] ? info->artist : "";
+		const char* title = info->title[0] ? info->title : "";
+		if (artist[0] || title[0]) {
+			album_art_fetch(artist, title);
 		}
-		last_resume_save = SDL_GetTicks();
+	}
+	if (Settings_getLyricsEnabled() && info) {
+		Lyrics_fetch(info->artist, info->title, info->duration_ms / 1000);
+	}
+
+	// Save resume state on every track change
+	const char* name = (info && info->title[0]) ? info->title : NULL;
+	if (!name) {
+		const char* slash = strrchr(path, '/');
+		name = slash ? slash + 1 : path;
+	}
+	if (resume_playlist_path[0] && playlist_active) {
+		Resume_savePlaylist(resume_playlist_path, path, name,
+							Playlist_getCurrentIndex(&playlist), 0);
+	} else {
+		int idx = playlist_active ? Playlist_getCurrentIndex(&playlist) : browser.selected;
+		Resume_saveFiles(browser.current_path, path, name, idx, 0);
+	}
+	last_resume_save = SDL_GetTicks();
+	queue_next_track();
+}
 
+// Try to load and play a track, returns true on success
+static bool try_load_and_play(const char* path) {
+	if (Player_load(path) == 0) {
+		Player_play();
+		on_track_started(path);
 		return true;
 	}
 	return false;
@@ -181,6 +249,22 @@ static bool handle_track_ended(void) {
 	return browser_pick_next();
 }
 
+// Poll the player, following a gapless switch to the queued track
+static bool handle_track_changed(void) {
+	if (!Player_pollTrackChange())
+		return false;
+
+	if (queued_index >= 0) {
+		if (playlist_active)
+			Playlist_setCurrentIndex(&playlist, queued_index);
+		else
+			browser.selected = queued_index;
+		queued_index = -1;
+	}
+	on_track_started(Player_getCurrentFile());
+	return true;
+}
+
 // Start playback of a track (load + play + init spectrum)
 static bool start_playback(const char* path) {
 	// Stop any other background player before starting music playback
@@ -334,7 +418,8 @@ static bool handle_playing_input(SDL_Surface* screen, PlayerInternalState* state
 			GFX_clear(screen);
 			GFX_flip(screen);
 		}
-		Player_update();
+		if (handle_track_changed())
+			*dirty = 1;
 		GFX_sync();
 		return true;
 	}
@@ -351,7 +436,8 @@ static bool handle_playing_input(SDL_Surface* screen, PlayerInternalState* state
 		// Handle USB/Bluetooth media and volume buttons even with screen off
 		handle_hid_events();
 		ModuleCommon_handleHardwareVolume();
-		Player_update();
+		if (handle_track_changed())
+			*dirty = 1;
 
 		if (Player_getState() == PLAYER_STATE_STOPPED) {
 			if (!handle_track_ended() && Player_getState() == PLAYER_STATE_STOPPED) {
@@ -402,9 +488,11 @@ static bool handle_playing_input(SDL_Surface* screen, PlayerInternalState* state
 		*dirty = 1;
 	} else if (PAD_justPressed(BTN_X)) {
 		shuffle_enabled = !shuffle_enabled;
+		queue_next_track();
 		*dirty = 1;
 	} else if (PAD_justPressed(BTN_Y)) {
 		repeat_enabled = !repeat_enabled;
+		queue_next_track();
 		*dirty = 1;
 	} else if (PAD_justPressed(BTN_L3) || PAD_justPressed(BTN_L2)) {
 		Spectrum_cycleNext();
@@ -428,7 +516,8 @@ static bool handle_playing_input(SDL_Surface* screen, PlayerInternalState* state
 	}
 
 	// Check if track ended
-	Player_update();
+	if (handle_track_changed())
+		*dirty = 1;
 	if (Player_getState() == PLAYER_STATE_STOPPED) {
 		if (!handle_track_ended() && Player_getState() == PLAYER_STATE_STOPPED) {
 			Resume_clear(); // All tracks finished naturally
@@ -743,7 +832,8 @@ ModuleExitReason PlayerModule_runWithPlaylist(SDL_Surface* screen,
 				GFX_clear(screen);
 				GFX_flip(screen);
 			}
-			Player_update();
+			if (handle_track_changed())
+				dirty = 1;
 			GFX_sync();
 			continue;
 		}
@@ -758,7 +848,8 @@ ModuleExitReason PlayerModule_runWithPlaylist(SDL_Surface* screen,
 			}
 			handle_hid_events();
 			ModuleCommon_handleHardwareVolume();
-			Player_update();
+			if (handle_track_changed())
+				dirty = 1;
 
 			if (Player_getState() == PLAYER_STATE_STOPPED) {
 				if (!handle_track_ended() && Player_getState() == PLAYER_STATE_STOPPED) {
@@ -807,9 +898,11 @@ ModuleExitReason PlayerModule_runWithPlaylist(SDL_Surface* screen,
 			dirty = 1;
 		} else if (PAD_justPressed(BTN_X)) {
 			shuffle_enabled = !shuffle_enabled;
+			queue_next_track();
 			dirty = 1;
 		} else if (PAD_justPressed(BTN_Y)) {
 			repeat_enabled = !repeat_enabled;
+			queue_next_track();
 			dirty = 1;
 		} else if (PAD_justPressed(BTN_L3) || PAD_justPressed(BTN_L2)) {
 			Spectrum_cycleNext();
@@ -832,7 +925,8 @@ ModuleExitReason PlayerModule_runWithPlaylist(SDL_Surface* screen,
 		}
 
 		// Check if track ended
-		Player_update();
+		if (handle_track_changed())
+			dirty = 1;
 		if (Player_getState() == PLAYER_STATE_STOPPED) {
 			if (!handle_track_ended() && Player_getState() == PLAYER_STATE_STOPPED) {
 				Resume_clear(); // All tracks finished naturally
@@ -1090,7 +1184,7 @@ ModuleExitReason PlayerModule_runResume(SDL_Surface* screen, const ResumeState*
 
 // Background tick: handle track advancement and resume saving while in menu
 void PlayerModule_backgroundTick(void) {
-	Player_update();
+	handle_track_changed();
 
 	// Handle track ended (auto-advance)
 	if (Player_getState() == PLAYER_STATE_STOPPED) {
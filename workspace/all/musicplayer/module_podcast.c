@@ -278,17 +278,7 @@ ModuleExitReason PodcastModule_run(SDL_Surface* screen) {
 						int fi = Podcast_findFeedIndex(cl_entry->feed_url);
 						if (fi >= 0) {
 							PodcastFeed* feed = Podcast_getSubscription(fi);
-							// Find episode index by guid
-							int ep_idx = -1;
-							if (feed) {
-								for (int e = 0; e < feed->episode_count; e++) {
-									PodcastEpisode* ep = Podcast_getEpisode(fi, e);
-									if (ep && strcmp(ep->guid, cl_entry->episode_guid) == 0) {
-										ep_idx = e;
-										break;
-									}
-								}
-							}
+							int ep_idx = Podcast_findEpisodeIndex(fi, cl_entry->episode_guid);
 							if (feed && ep_idx >= 0 && Podcast_episodeFileExists(feed, ep_idx)) {
 								Background_stopAll();
 								podcast_current_feed_index = fi;
@@ -24,10 +24,11 @@ typedef enum {
 #define SETTINGS_ITEM_SCREEN_OFF 0
 #define SETTINGS_ITEM_BASS_FILTER 1
 #define SETTINGS_ITEM_SOFT_LIMITER 2
-#define SETTINGS_ITEM_CLEAR_CACHE 3
-#define SETTINGS_ITEM_CLEAR_LYRICS 4
-#define SETTINGS_ITEM_UPDATE_YTDLP 5
-#define SETTINGS_ITEM_COUNT 6
+#define SETTINGS_ITEM_REPLAY_GAIN 3
+#define SETTINGS_ITEM_CLEAR_CACHE 4
+#define SETTINGS_ITEM_CLEAR_LYRICS 5
+#define SETTINGS_ITEM_UPDATE_YTDLP 6
+#define SETTINGS_ITEM_COUNT 7
 
 // Internal app state constants for controls help
 // These match the pattern used in ui_main.c
@@ -73,6 +74,9 @@ ModuleExitReason SettingsModule_run(SDL_Surface* screen) {
 				} else if (menu_selected == SETTINGS_ITEM_SOFT_LIMITER) {
 					Settings_cycleSoftLimiterPrev();
 					dirty = 1;
+				} else if (menu_selected == SETTINGS_ITEM_REPLAY_GAIN) {
+					Settings_cycleReplayGainPrev();
+					dirty = 1;
 				}
 			} else if (PAD_justPressed(BTN_RIGHT)) {
 				if (menu_selected == SETTINGS_ITEM_SCREEN_OFF) {
@@ -84,6 +88,9 @@ ModuleExitReason SettingsModule_run(SDL_Surface* screen) {
 				} else if (menu_selected == SETTINGS_ITEM_SOFT_LIMITER) {
 					Settings_cycleSoftLimiterNext();
 					dirty = 1;
+				} else if (menu_selected == SETTINGS_ITEM_REPLAY_GAIN) {
+					Settings_cycleReplayGainNext();
+					dirty = 1;
 				}
 			} else if (PAD_justPressed(BTN_A)) {
 				switch (menu_selected) {
@@ -100,6 +107,10 @@ ModuleExitReason SettingsModule_run(SDL_Surface* screen) {
 					Settings_cycleSoftLimiterNext();
 					dirty = 1;
 					break;
+				case SETTINGS_ITEM_REPLAY_GAIN:
+					Settings_cycleReplayGainNext();
+					dirty = 1;
+					break;
 				case SETTINGS_ITEM_CLEAR_CACHE:
 					state = SETTINGS_STATE_CLEAR_CACHE_CONFIRM;
 					dirty = 1;
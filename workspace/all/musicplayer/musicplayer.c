@@ -26,6 +26,7 @@
 #include "module_settings.h"
 #include "settings.h"
 #include "resume.h"
+#include "library.h"
 #include "background.h"
 #include "display_helper.h"
 
@@ -95,6 +96,9 @@ int main(int argc, char* argv[]) {
 	// Initialize resume state
 	Resume_init();
 
+	// Open the tag index and refresh it in the background
+	Library_init(SDCARD_PATH "/Music");
+
 	// Initialize YouTube downloader (loads queue, auto-resumes pending downloads)
 	Downloader_init();
 
@@ -169,6 +173,7 @@ cleanup:
 
 	Background_stopAll();
 	Downloader_cleanup();
+	Library_quit();
 	Settings_quit();
 	ModuleCommon_quit();
 	Player_quit();
@@ -2,6 +2,9 @@
 #include "radio.h"
 #include "album_art.h"
 #include "settings.h"
+#include "library.h"
+#include "loudness.h"
+#include "dsp.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,6 +13,9 @@
 #include <math.h>
 #include <fcntl.h>
 #include <dirent.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <samplerate.h>
 #include <SDL2/SDL_image.h>
 #include "api.h"
@@ -124,73 +130,28 @@ static inline float apply_volume_curve(float linear_vol) {
 	return powf(linear_vol, 0.4f);
 }
 
-// Soft limiter for built-in speaker to prevent amplifier clipping
-// Linear below threshold, asymptotically compressed above
-static inline int16_t speaker_soft_limit(int16_t sample, float threshold) {
-	float headroom = 1.0f - threshold;
+// Largest gain change per audio callback (~1 dB), so a gain that arrives
+// mid-track from the loudness analysis fades in instead of jumping
+#define REPLAY_GAIN_STEP 1.122f
 
-	float x = sample * (1.0f / 32768.0f);
-	float abs_x = fabsf(x);
-	if (abs_x <= threshold)
-		return sample;
-
-	float sign = (x >= 0.0f) ? 1.0f : -1.0f;
-	float over = abs_x - threshold;
-	// Asymptotic curve: smoothly approaches 1.0 but never reaches it
-	float compressed = threshold + headroom * over / (over + headroom);
-
-	return (int16_t)(sign * compressed * 32767.0f);
-}
-
-// High-pass biquad filter for built-in speaker to remove sub-bass
-// that the tiny speaker can't reproduce (just wastes amp headroom)
-typedef struct {
-	float w1, w2; // Direct Form II Transposed state
-} BiquadState;
-
-static struct {
-	float b0, b1, b2, a1, a2;
-} speaker_hpf_coeffs;
-static BiquadState speaker_hpf_state[AUDIO_CHANNELS];
-static int speaker_hpf_last_hz = 0; // tracks setting changes for coefficient recalc
-
-static void speaker_hpf_init(int sample_rate, float cutoff_hz) {
-	// 2nd-order Butterworth high-pass
-	const float fc = cutoff_hz;
-	const float Q = 0.7071f; // Butterworth
-	float omega = 2.0f * M_PI * fc / (float)sample_rate;
-	float sin_w = sinf(omega);
-	float cos_w = cosf(omega);
-	float alpha = sin_w / (2.0f * Q);
-
-	float a0 = 1.0f + alpha;
-	speaker_hpf_coeffs.b0 = ((1.0f + cos_w) / 2.0f) / a0;
-	speaker_hpf_coeffs.b1 = (-(1.0f + cos_w)) / a0;
-	speaker_hpf_coeffs.b2 = ((1.0f + cos_w) / 2.0f) / a0;
-	speaker_hpf_coeffs.a1 = (-2.0f * cos_w) / a0;
-	speaker_hpf_coeffs.a2 = (1.0f - alpha) / a0;
-
-	for (int i = 0; i < AUDIO_CHANNELS; i++) {
-		speaker_hpf_state[i].w1 = 0.0f;
-		speaker_hpf_state[i].w2 = 0.0f;
-	}
-}
-
-static inline int16_t speaker_hpf_process(int16_t sample, int channel) {
-	BiquadState* s = &speaker_hpf_state[channel];
-	float x = (float)sample;
-
-	// Direct Form II Transposed
-	float y = speaker_hpf_coeffs.b0 * x + s->w1;
-	s->w1 = speaker_hpf_coeffs.b1 * x - speaker_hpf_coeffs.a1 * y + s->w2;
-	s->w2 = speaker_hpf_coeffs.b2 * x - speaker_hpf_coeffs.a2 * y;
+// Linear ReplayGain of a track for the current setting (1.0 if off or unknown).
+// Album mode falls back to the track gain and vice versa.
+static float replay_gain_linear(const ReplayGain* rg) {
+	int mode = Settings_getReplayGain();
+	if (mode == 0 || (!rg->has_track_gain && !rg->has_album_gain))
+		return 1.0f;
 
-	if (y > 32767.0f)
-		y = 32767.0f;
-	if (y < -32768.0f)
-		y = -32768.0f;
+	bool use_album = rg->has_album_gain && (mode == 2 || !rg->has_track_gain);
+	float db = use_album ? rg->album_gain : rg->track_gain;
+	float peak = use_album ? rg->album_peak : rg->track_peak;
+	float gain = powf(10.0f, db / 20.0f);
 
-	return (int16_t)y;
+	// Never boost the loudest sample past full scale
+	if (peak > 0.0f && gain * peak > 1.0f)
+		gain = 1.0f / peak;
+	if (gain > DSP_GAIN_MAX)
+		gain = DSP_GAIN_MAX;
+	return gain;
 }
 
 // Global player context
@@ -200,6 +161,7 @@ static WaveformData waveform = {0};					  // Waveform overview for progress disp
 static int current_sample_rate = SAMPLE_RATE_DEFAULT; // Track current SDL audio device rate
 static bool bluetooth_audio_active = false;			  // Track if Bluetooth audio is active
 static bool usbdac_audio_active = false;			  // Track if USB DAC is active
+static DSPChain output_dsp;							  // Output post-processing (audio callback only)
 
 // Get target sample rate based on current audio sink
 static int get_target_sample_rate(void) {
@@ -224,6 +186,11 @@ static void audio_device_change_callback(int device_type, int event);
 // Forward declaration for FLAC metadata callback
 static void flac_metadata_callback(void* pUserData, drflac_metadata* pMetadata);
 
+// Forward declarations for tag parsers (also used for the gapless next track)
+static void parse_mp3_metadata(const char* filepath, TrackInfo* info, SDL_Surface** art);
+static void parse_m4a_metadata(StreamDecoder* sd, TrackInfo* info, SDL_Surface** art);
+static void parse_vorbis_comment(TrackInfo* info, const char* comment);
+
 // ============ STREAMING PLAYBACK SYSTEM ============
 
 // Decode chunk size (~0.5 seconds at 48kHz)
@@ -339,8 +306,28 @@ static size_t circular_buffer_read(CircularBuffer* cb, int16_t* data, size_t fra
 
 // ============ STREAMING DECODER INTERFACE ============
 
+// M4A gapless info: iTunSMPB is " 00000000 DELAY PADDING LENGTH ..." in hex.
+// Files flagged pgap without it get the standard iTunes priming.
+#define M4A_DEFAULT_PRIMING 2112
+static void m4a_read_gapless_info(StreamDecoder* sd, M4ADecoder* m4a) {
+	unsigned int delay = 0, padding = 0;
+	unsigned long long length = 0;
+	if (m4a->mp4.tag.smpb &&
+		sscanf((const char*)m4a->mp4.tag.smpb, "%*x %x %x %llx", &delay, &padding, &length) == 3 &&
+		length > 0) {
+		sd->encoder_delay = delay;
+		sd->total_frames = (int64_t)length;
+		sd->exact_length = true;
+	} else if (m4a->mp4.tag.gapless && sd->total_frames > M4A_DEFAULT_PRIMING) {
+		sd->encoder_delay = M4A_DEFAULT_PRIMING;
+		sd->total_frames -= M4A_DEFAULT_PRIMING;
+	}
+	sd->skip_frames = sd->encoder_delay;
+}
+
 // Open decoder and read metadata (doesn't decode audio yet)
-static int stream_decoder_open(StreamDecoder* sd, const char* filepath) {
+// FLAC Vorbis comments are parsed into info while opening
+static int stream_decoder_open(StreamDecoder* sd, const char* filepath, TrackInfo* info) {
 	memset(sd, 0, sizeof(StreamDecoder));
 
 	sd->format = Player_detectFormat(filepath);
@@ -377,7 +364,7 @@ static int stream_decoder_open(StreamDecoder* sd, const char* filepath) {
 		break;
 	}
 	case AUDIO_FORMAT_FLAC: {
-		drflac* flac = drflac_open_file_with_metadata(filepath, flac_metadata_callback, NULL, NULL);
+		drflac* flac = drflac_open_file_with_metadata(filepath, flac_metadata_callback, info, NULL);
 		if (!flac) {
 			LOG_error("Stream: Failed to open FLAC: %s\n", filepath);
 			return -1;
@@ -518,6 +505,7 @@ static int stream_decoder_open(StreamDecoder* sd, const char* filepath) {
 		sd->decoder = m4a;
 		sd->source_sample_rate = m4a->sample_rate;
 		sd->source_channels = m4a->channels;
+		m4a_read_gapless_info(sd, m4a);
 		break;
 	}
 	case AUDIO_FORMAT_AAC: {
@@ -623,8 +611,8 @@ static int stream_decoder_open(StreamDecoder* sd, const char* filepath) {
 	return 0;
 }
 
-// Read chunk of audio from decoder (returns frames read, outputs stereo)
-static size_t stream_decoder_read(StreamDecoder* sd, int16_t* buffer, size_t frames) {
+// Read chunk of audio from the underlying decoder (returns frames read, outputs stereo)
+static size_t stream_decoder_read_raw(StreamDecoder* sd, int16_t* buffer, size_t frames) {
 	if (!sd->decoder)
 		return 0;
 
@@ -954,6 +942,28 @@ static size_t stream_decoder_read(StreamDecoder* sd, int16_t* buffer, size_t fra
 		break;
 	}
 
+	return frames_read;
+}
+
+// Read chunk of audio with encoder delay/padding trimmed (returns frames read, outputs stereo)
+static size_t stream_decoder_read(StreamDecoder* sd, int16_t* buffer, size_t frames) {
+	while (sd->skip_frames > 0) {
+		size_t to_skip = (sd->skip_frames < (int64_t)frames) ? (size_t)sd->skip_frames : frames;
+		size_t skipped = stream_decoder_read_raw(sd, buffer, to_skip);
+		if (skipped == 0)
+			return 0;
+		sd->skip_frames -= skipped;
+	}
+
+	if (sd->exact_length) {
+		int64_t remaining = sd->total_frames - sd->current_frame;
+		if (remaining <= 0)
+			return 0;
+		if ((int64_t)frames > remaining)
+			frames = (size_t)remaining;
+	}
+
+	size_t frames_read = stream_decoder_read_raw(sd, buffer, frames);
 	sd->current_frame += frames_read;
 	return frames_read;
 }
@@ -989,11 +999,16 @@ static int stream_decoder_seek(StreamDecoder* sd, int64_t frame) {
 		M4ADecoder* m4a = (M4ADecoder*)sd->decoder;
 		// Convert PCM frame to AAC sample index
 		// Each AAC frame typically produces 1024 PCM samples
-		unsigned target_sample = (unsigned)(frame / 1024);
+		int64_t stream_frame = frame + sd->encoder_delay;
+		unsigned target_sample = (unsigned)(stream_frame / 1024);
 		if (target_sample >= m4a->sample_count) {
 			target_sample = m4a->sample_count > 0 ? m4a->sample_count - 1 : 0;
 		}
 		m4a->current_sample = target_sample;
+		// Drop the part of the AAC frame before the target
+		sd->skip_frames = stream_frame - (int64_t)target_sample * 1024;
+		if (sd->skip_frames < 0)
+			sd->skip_frames = 0;
 		// Flush FDK-AAC decoder state for clean seek
 		// Use AACDEC_INTR to signal discontinuity, then decode a dummy frame to flush
 		aacDecoder_SetParam(m4a->aac_decoder, AAC_TPDEC_CLEAR_BUFFER, 1);
@@ -1213,6 +1228,145 @@ static size_t resample_chunk(int16_t* input, size_t input_frames,
 
 // ============ STREAMING DECODE THREAD ============
 
+// Open the queued track this far (in source frames) before the current one ends
+#define NEXT_TRACK_OPEN_AHEAD_FRAMES (DECODE_CHUNK_FRAMES * 2)
+
+// Fill in title from the file name (tags override it later)
+static void init_track_info(TrackInfo* info, const char* filepath) {
+	memset(info, 0, sizeof(TrackInfo));
+
+	const char* filename = strrchr(filepath, '/');
+	if (filename)
+		filename++;
+	else
+		filename = filepath;
+	strncpy(info->title, filename, sizeof(info->title) - 1);
+
+	// Remove extension from title
+	char* ext = strrchr(info->title, '.');
+	if (ext)
+		*ext = '\0';
+}
+
+// Read tags that need the opened decoder or the file (FLAC is done while opening)
+static void parse_track_metadata(const char* filepath, StreamDecoder* sd, TrackInfo* info, SDL_Surface** art) {
+	if (sd->format == AUDIO_FORMAT_MP3) {
+		parse_mp3_metadata(filepath, info, art);
+	} else if (sd->format == AUDIO_FORMAT_M4A) {
+		parse_m4a_metadata(sd, info, art);
+	} else if (sd->format == AUDIO_FORMAT_OGG) {
+		stb_vorbis_comment comments = stb_vorbis_get_comment((stb_vorbis*)sd->decoder);
+		for (int i = 0; i < comments.comment_list_length; i++)
+			parse_vorbis_comment(info, comments.comment_list[i]);
+	} else if (sd->format == AUDIO_FORMAT_OPUS) {
+		// Opus uses Vorbis comment tags
+		const OpusTags* tags = op_tags((OggOpusFile*)sd->decoder, -1);
+		if (tags) {
+			for (int i = 0; i < tags->comments; i++)
+				parse_vorbis_comment(info, tags->user_comments[i]);
+		}
+	}
+
+	// Untagged files use an earlier loudness analysis if there is one
+	float lufs, peak;
+	if (!info->replay_gain.has_track_gain && Library_getLoudness(filepath, &lufs, &peak)) {
+		info->replay_gain.track_gain = LOUDNESS_REFERENCE_LUFS - lufs;
+		info->replay_gain.track_peak = peak;
+		info->replay_gain.has_track_gain = true;
+	}
+}
+
+// Fill in output format and duration of an opened decoder
+static void set_stream_track_info(TrackInfo* info, StreamDecoder* sd, int dst_rate) {
+	info->sample_rate = dst_rate; // Output rate
+	info->channels = AUDIO_CHANNELS;
+	info->duration_ms = (int)((sd->total_frames * 1000) / sd->source_sample_rate);
+}
+
+// Close the pre-opened next track (decode thread only)
+static void close_next_track(void) {
+	stream_decoder_close(&player.next_decoder);
+	if (player.next_album_art) {
+		SDL_FreeSurface(player.next_album_art);
+		player.next_album_art = NULL;
+	}
+	player.next_opened[0] = '\0';
+}
+
+// Open the queued track if it isn't already (decode thread only)
+static bool open_next_track(void) {
+	char path[512];
+	pthread_mutex_lock(&player.mutex);
+	strcpy(path, player.next_file);
+	bool blocked = player.track_change_pending; // next_info not consumed yet
+	pthread_mutex_unlock(&player.mutex);
+
+	if (blocked)
+		return false;
+	if (strcmp(path, player.next_opened) != 0)
+		close_next_track(); // Queue changed since it was opened
+	if (player.next_opened[0])
+		return player.next_decoder.decoder != NULL; // Already opened (or failed to)
+	if (!path[0])
+		return false;
+
+	init_track_info(&player.next_info, path);
+	if (stream_decoder_open(&player.next_decoder, path, &player.next_info) != 0) {
+		// Don't retry, the track end falls back to a normal load
+		strcpy(player.next_opened, path);
+		return false;
+	}
+	parse_track_metadata(path, &player.next_decoder, &player.next_info, &player.next_album_art);
+	set_stream_track_info(&player.next_info, &player.next_decoder, get_target_sample_rate());
+	strcpy(player.next_opened, path);
+	return true;
+}
+
+// Current track finished decoding: continue filling the buffer from the next one
+static bool start_next_track(void) {
+	if (!open_next_track() || !player.next_decoder.decoder)
+		return false;
+
+	// Flush the resampler and start it over for the new stream
+	if (player.resampler) {
+		src_reset((SRC_STATE*)player.resampler);
+		player.resample_leftover_count = 0;
+	}
+	if (player.next_decoder.source_sample_rate != get_target_sample_rate() && !player.resampler) {
+		int error;
+		player.resampler = src_new(SRC_SINC_FASTEST, AUDIO_CHANNELS, &error);
+		if (!player.resampler) {
+			LOG_error("Stream: Failed to create resampler: %s\n", src_strerror(error));
+			return false;
+		}
+	}
+
+	// Everything buffered so far belongs to the current track
+	pthread_mutex_lock(&player.mutex);
+	player.next_replay_gain = replay_gain_linear(&player.next_info.replay_gain);
+	player.next_boundary = circular_buffer_available(&player.stream_buffer);
+	player.decoding_next = true;
+	player.stream_eof = false;
+	pthread_mutex_unlock(&player.mutex);
+	return true;
+}
+
+// Audio callback played past the boundary: next track becomes the current one
+static void finish_track_switch(void) {
+	StreamDecoder old = player.stream_decoder;
+
+	pthread_mutex_lock(&player.mutex);
+	player.stream_decoder = player.next_decoder;
+	memset(&player.next_decoder, 0, sizeof(StreamDecoder));
+	player.decoding_next = false;
+	player.track_switched = false;
+	player.track_change_pending = true; // next_opened/next_info are handed to Player_update
+	player.next_file[0] = '\0';
+	pthread_mutex_unlock(&player.mutex);
+
+	stream_decoder_close(&old);
+}
+
 static void* stream_thread_func(void* arg) {
 	(void)arg;
 
@@ -1230,10 +1384,23 @@ static void* stream_thread_func(void* arg) {
 	}
 
 	while (player.stream_running) {
+		if (player.track_switched) {
+			finish_track_switch();
+		}
+
 		// Check if seeking requested
 		if (player.stream_seeking) {
-			stream_decoder_seek(&player.stream_decoder, player.seek_target_frame);
+			// Seeking inside the current track drops the buffered start of the next one
+			pthread_mutex_lock(&player.mutex);
+			bool rewind_next = player.decoding_next;
+			player.decoding_next = false;
+			player.next_boundary = -1;
 			circular_buffer_clear(&player.stream_buffer);
+			pthread_mutex_unlock(&player.mutex);
+			if (rewind_next) {
+				stream_decoder_seek(&player.next_decoder, 0);
+			}
+			stream_decoder_seek(&player.stream_decoder, player.seek_target_frame);
 			if (player.resampler) {
 				src_reset((SRC_STATE*)player.resampler);
 			}
@@ -1243,20 +1410,30 @@ static void* stream_thread_func(void* arg) {
 			player.stream_seeking = false;
 		}
 
+		StreamDecoder* sd = player.decoding_next ? &player.next_decoder : &player.stream_decoder;
+
+		// Open the queued track ahead of time so the switch doesn't wait on file I/O
+		if (!player.decoding_next && player.next_file[0] &&
+			sd->total_frames - sd->current_frame < NEXT_TRACK_OPEN_AHEAD_FRAMES) {
+			open_next_track();
+		}
+
 		// Check if buffer needs more data (< 50% full)
 		size_t available = circular_buffer_available(&player.stream_buffer);
 		if (available < STREAM_BUFFER_FRAMES / 2) {
 			// Decode a chunk
-			size_t decoded = stream_decoder_read(&player.stream_decoder,
-												 decode_buffer, DECODE_CHUNK_FRAMES);
+			size_t decoded = stream_decoder_read(sd, decode_buffer, DECODE_CHUNK_FRAMES);
 			if (decoded == 0) {
-				// Decoder has reached end of file
-				player.stream_eof = true;
+				// Decoder has reached end of file, go on with the queued track if there is one
+				if (player.decoding_next || !start_next_track()) {
+					player.stream_eof = true;
+					usleep(5000); // 5ms
+				}
 			} else {
 				// Resample chunk to target rate if needed
-				int src_rate = player.stream_decoder.source_sample_rate;
+				int src_rate = sd->source_sample_rate;
 				int dst_rate = get_target_sample_rate();
-				bool is_last = (player.stream_decoder.current_frame >= player.stream_decoder.total_frames);
+				bool is_last = (sd->current_frame >= sd->total_frames);
 
 				size_t output_frames;
 				if (src_rate == dst_rate) {
@@ -1285,6 +1462,310 @@ static void* stream_thread_func(void* arg) {
 
 // ============ END STREAMING PLAYBACK SYSTEM ============
 
+// ============ WAVEFORM OVERVIEW ============
+//
+// A low priority thread runs its own decoder over the file and reduces it to
+// WAVEFORM_BARS min/max/RMS peaks, publishing each bar as soon as it is done.
+// Peaks are cached per track so a replay fills the waveform immediately.
+// Stale jobs are dropped through a generation counter (like lyrics fetches).
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define WAVEFORM_CACHE_DIR SDCARD_PATH "/.cache/waveform"
+#define WAVEFORM_CACHE_PARENT_DIR SDCARD_PATH "/.cache"
+#define WAVEFORM_CACHE_MAGIC 0x31465657 // "WVF1"
+#define WAVEFORM_CHUNK_FRAMES 4096
+
+// Peaks of one bar as stored in the cache file
+typedef struct {
+	int16_t min;
+	int16_t max;
+	uint16_t rms;
+	uint16_t reserved;
+} WaveformPeak;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t bar_count;
+	WaveformPeak peaks[WAVEFORM_BARS];
+} WaveformCache;
+
+static pthread_mutex_t waveform_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile int waveform_generation = 0;
+
+// Min/max/sum of squares over interleaved samples
+static void waveform_scan(const int16_t* samples, size_t count,
+						  int16_t* min_out, int16_t* max_out, uint64_t* sum_sq_out) {
+	int16_t lo = *min_out, hi = *max_out;
+	uint64_t sum_sq = 0;
+	size_t i = 0;
+#if defined(__ARM_NEON) || defined(__aarch64__)
+	int16x8_t vlo = vdupq_n_s16(lo), vhi = vdupq_n_s16(hi);
+	uint64x2_t vsum = vdupq_n_u64(0);
+	for (; i + 8 <= count; i += 8) {
+		int16x8_t v = vld1q_s16(samples + i);
+		vlo = vminq_s16(vlo, v);
+		vhi = vmaxq_s16(vhi, v);
+		// Squares fit in 31 bits, pairwise-add them into 64-bit lanes
+		uint32x4_t sq_lo = vreinterpretq_u32_s32(vmull_s16(vget_low_s16(v), vget_low_s16(v)));
+		uint32x4_t sq_hi = vreinterpretq_u32_s32(vmull_s16(vget_high_s16(v), vget_high_s16(v)));
+		vsum = vpadalq_u32(vsum, sq_lo);
+		vsum = vpadalq_u32(vsum, sq_hi);
+	}
+	int16_t lanes[8];
+	vst1q_s16(lanes, vlo);
+	for (int j = 0; j < 8; j++)
+		if (lanes[j] < lo)
+			lo = lanes[j];
+	vst1q_s16(lanes, vhi);
+	for (int j = 0; j < 8; j++)
+		if (lanes[j] > hi)
+			hi = lanes[j];
+	sum_sq = vgetq_lane_u64(vsum, 0) + vgetq_lane_u64(vsum, 1);
+#endif
+	for (; i < count; i++) {
+		int16_t v = samples[i];
+		if (v < lo)
+			lo = v;
+		if (v > hi)
+			hi = v;
+		sum_sq += (uint32_t)((int32_t)v * v);
+	}
+	*min_out = lo;
+	*max_out = hi;
+	*sum_sq_out += sum_sq;
+}
+
+// Cache file name from path, size and mtime, so edited files are rescanned
+static bool waveform_cache_path(const char* filepath, char* out, size_t out_size) {
+	struct stat st;
+	if (stat(filepath, &st) != 0)
+		return false;
+
+	char key[768];
+	snprintf(key, sizeof(key), "%s|%lld|%lld", filepath, (long long)st.st_size, (long long)st.st_mtime);
+	unsigned int hash = 5381;
+	for (const char* c = key; *c; c++)
+		hash = ((hash << 5) + hash) + (unsigned char)*c;
+
+	snprintf(out, out_size, "%s/%08x.peaks", WAVEFORM_CACHE_DIR, hash);
+	return true;
+}
+
+// Publish one bar if the job is still current
+static bool waveform_publish(int generation, int bar, const WaveformPeak* peak) {
+	pthread_mutex_lock(&waveform_mutex);
+	bool current = (waveform_generation == generation);
+	if (current) {
+		int peak_abs = abs(peak->min) > abs(peak->max) ? abs(peak->min) : abs(peak->max);
+		waveform.bars[bar] = peak_abs / 32768.0f;
+		waveform.rms[bar] = peak->rms / 32768.0f;
+		if (bar + 1 > waveform.bar_count)
+			waveform.bar_count = bar + 1;
+		waveform.valid = (waveform.bar_count == WAVEFORM_BARS);
+	}
+	pthread_mutex_unlock(&waveform_mutex);
+	return current;
+}
+
+typedef struct {
+	char filepath[512];
+	int generation;
+	bool analyze_loudness; // Track has no ReplayGain, measure it in the same pass
+} WaveformJob;
+
+// Loudness analysis finished: keep it in the library and level the track if it's still playing
+static void loudness_publish(const WaveformJob* job, float lufs, float peak) {
+	Library_setLoudness(job->filepath, lufs, peak);
+
+	pthread_mutex_lock(&player.mutex);
+	// Past a gapless boundary the job's track isn't the one playing anymore
+	if (waveform_generation == job->generation && !player.track_switched && !player.track_change_pending) {
+		ReplayGain* rg = &player.track_info.replay_gain;
+		rg->track_gain = LOUDNESS_REFERENCE_LUFS - lufs;
+		rg->track_peak = peak;
+		rg->has_track_gain = true;
+		player.replay_gain = replay_gain_linear(rg);
+	}
+	pthread_mutex_unlock(&player.mutex);
+}
+
+static void* waveform_thread_func(void* arg) {
+	WaveformJob* job = (WaveformJob*)arg;
+
+	// Stay out of the way of the playback decode thread
+	setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+
+	char cache_path[512];
+	bool have_cache_path = waveform_cache_path(job->filepath, cache_path, sizeof(cache_path));
+
+	WaveformCache cache;
+	bool cached = false;
+	if (have_cache_path) {
+		FILE* f = fopen(cache_path, "rb");
+		if (f) {
+			cached = fread(&cache, sizeof(cache), 1, f) == 1 &&
+					 cache.magic == WAVEFORM_CACHE_MAGIC && cache.bar_count == WAVEFORM_BARS;
+			fclose(f);
+			if (cached) {
+				for (int i = 0; i < WAVEFORM_BARS; i++)
+					waveform_publish(job->generation, i, &cache.peaks[i]);
+			}
+		}
+	}
+	if (cached && !job->analyze_loudness) {
+		free(job);
+		return NULL;
+	}
+
+	StreamDecoder sd;
+	TrackInfo scratch_info; // FLAC tags land here, playback already has them
+	memset(&scratch_info, 0, sizeof(scratch_info));
+	int16_t* buffer = malloc(WAVEFORM_CHUNK_FRAMES * sizeof(int16_t) * AUDIO_CHANNELS);
+	if (!buffer || stream_decoder_open(&sd, job->filepath, &scratch_info) != 0) {
+		free(buffer);
+		free(job);
+		return NULL;
+	}
+
+	LoudnessMeter* meter = NULL;
+	if (job->analyze_loudness)
+		meter = Loudness_create(sd.source_sample_rate, sd.source_channels);
+
+	if (!cached) {
+		memset(&cache, 0, sizeof(cache));
+		cache.magic = WAVEFORM_CACHE_MAGIC;
+		cache.bar_count = WAVEFORM_BARS;
+	}
+
+	int64_t total = sd.total_frames > 0 ? sd.total_frames : 1;
+	int bar = cached ? WAVEFORM_BARS : 0; // Bars from the cache only need the loudness pass
+	int64_t bar_end = total / WAVEFORM_BARS;
+	int16_t lo = 0, hi = 0;
+	uint64_t sum_sq = 0;
+	int64_t bar_samples = 0;
+	int64_t frame = 0;
+	bool cancelled = false;
+
+	while (bar < WAVEFORM_BARS || meter) {
+		if (waveform_generation != job->generation) {
+			cancelled = true;
+			break;
+		}
+		size_t got = stream_decoder_read(&sd, buffer, WAVEFORM_CHUNK_FRAMES);
+		Loudness_process(meter, buffer, got);
+		size_t pos = 0;
+		while (bar < WAVEFORM_BARS && (pos < got || got == 0)) {
+			// Frames of this chunk that fall into the current bar (the last bar takes any overrun)
+			size_t take = got - pos;
+			if (bar < WAVEFORM_BARS - 1 && frame + (int64_t)take > bar_end)
+				take = (size_t)(bar_end - frame);
+			if (take > 0) {
+				waveform_scan(buffer + pos * AUDIO_CHANNELS, take * AUDIO_CHANNELS, &lo, &hi, &sum_sq);
+				bar_samples += take * AUDIO_CHANNELS;
+				frame += take;
+				pos += take;
+			}
+
+			// Bar complete (or decoder ran out early: close the remaining bars)
+			if (got == 0 || (bar < WAVEFORM_BARS - 1 && frame >= bar_end)) {
+				WaveformPeak* peak = &cache.peaks[bar];
+				peak->min = lo;
+				peak->max = hi;
+				peak->rms = bar_samples ? (uint16_t)sqrt((double)sum_sq / bar_samples) : 0;
+				if (!waveform_publish(job->generation, bar, peak)) {
+					cancelled = true;
+					break;
+				}
+				bar++;
+				bar_end = total * (bar + 1) / WAVEFORM_BARS;
+				lo = hi = 0;
+				sum_sq = 0;
+				bar_samples = 0;
+			}
+		}
+		if (cancelled || got == 0)
+			break;
+	}
+
+	stream_decoder_close(&sd);
+	free(buffer);
+
+	float lufs, peak;
+	if (!cancelled && meter && Loudness_getResult(meter, &lufs, &peak))
+		loudness_publish(job, lufs, peak);
+	Loudness_free(meter);
+
+	// Only cache complete scans
+	if (!cancelled && !cached && bar == WAVEFORM_BARS && have_cache_path) {
+		mkdir(WAVEFORM_CACHE_PARENT_DIR, 0755);
+		mkdir(WAVEFORM_CACHE_DIR, 0755);
+		char tmp_path[520];
+		snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache_path);
+		FILE* f = fopen(tmp_path, "wb");
+		if (f) {
+			bool ok = fwrite(&cache, sizeof(cache), 1, f) == 1;
+			ok = (fclose(f) == 0) && ok;
+			if (ok)
+				rename(tmp_path, cache_path);
+			else
+				unlink(tmp_path);
+		}
+	}
+
+	free(job);
+	return NULL;
+}
+
+// Drop the current waveform and any job still filling it
+static void waveform_reset(void) {
+	pthread_mutex_lock(&waveform_mutex);
+	waveform_generation++;
+	memset(&waveform, 0, sizeof(waveform));
+	pthread_mutex_unlock(&waveform_mutex);
+}
+
+// Start filling the waveform for filepath in the background, measuring
+// its loudness along the way if it has no ReplayGain yet
+static void waveform_start(const char* filepath, bool analyze_loudness) {
+	waveform_reset();
+
+	WaveformJob* job = malloc(sizeof(WaveformJob));
+	if (!job)
+		return;
+	snprintf(job->filepath, sizeof(job->filepath), "%s", filepath);
+	job->generation = waveform_generation;
+	job->analyze_loudness = analyze_loudness;
+
+	pthread_t thread;
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	if (pthread_create(&thread, &attr, waveform_thread_func, job) != 0) {
+		free(job);
+	}
+	pthread_attr_destroy(&attr);
+}
+
+// Volume and ReplayGain as one fixed point gain, then the speaker high-pass
+// filter and soft limiter (speaker only, BT/USB DAC get the gain alone)
+static void process_output(int16_t* samples, size_t frames, float gain) {
+	bool speaker = !bluetooth_audio_active && !usbdac_audio_active;
+	DSP_setGain(&output_dsp, gain);
+	DSP_setHighPass(&output_dsp, current_sample_rate, speaker ? Settings_getBassFilterHz() : 0);
+	DSP_setLimiter(&output_dsp, speaker ? Settings_getSoftLimiterThreshold() : 0.0f);
+	DSP_process(&output_dsp, samples, frames);
+}
+
+// Volume with logarithmic curve for natural perceived loudness
+static float output_volume(PlayerContext* ctx) {
+	if (ctx->volume < 0.99f || ctx->volume > 1.01f)
+		return apply_volume_curve(ctx->volume);
+	return 1.0f;
+}
+
 // Audio callback - SDL pulls audio data from here
 static void audio_callback(void* userdata, Uint8* stream, int len) {
 	PlayerContext* ctx = (PlayerContext*)userdata;
@@ -1305,30 +1786,8 @@ static void audio_callback(void* userdata, Uint8* stream, int len) {
 				memset(&out[samples_got], 0, (samples_needed * AUDIO_CHANNELS - samples_got) * sizeof(int16_t));
 			}
 
-			// Apply volume with logarithmic curve for natural perceived loudness
-			if (ctx->volume < 0.99f || ctx->volume > 1.01f) {
-				float curved_vol = apply_volume_curve(ctx->volume);
-				for (int i = 0; i < samples_needed * AUDIO_CHANNELS; i++) {
-					out[i] = (int16_t)(out[i] * curved_vol);
-				}
-			}
-
-			// Speaker processing: high-pass filter + soft limiter
-			if (!bluetooth_audio_active && !usbdac_audio_active) {
-				int bass_hz = Settings_getBassFilterHz();
-				float limiter_thresh = Settings_getSoftLimiterThreshold();
-				if (bass_hz != speaker_hpf_last_hz) {
-					if (bass_hz > 0)
-						speaker_hpf_init(current_sample_rate, (float)bass_hz);
-					speaker_hpf_last_hz = bass_hz;
-				}
-				for (int i = 0; i < samples_needed * AUDIO_CHANNELS; i++) {
-					if (bass_hz > 0)
-						out[i] = speaker_hpf_process(out[i], i % AUDIO_CHANNELS);
-					if (limiter_thresh > 0.0f)
-						out[i] = speaker_soft_limit(out[i], limiter_thresh);
-				}
-			}
+			// Volume + speaker high-pass filter and soft limiter (no ReplayGain for streams)
+			process_output(out, samples_needed, output_volume(ctx));
 		} else {
 			// CONNECTING or other states - output silence
 			memset(stream, 0, len);
@@ -1354,36 +1813,44 @@ static void audio_callback(void* userdata, Uint8* stream, int len) {
 		// Read from circular buffer
 		size_t samples_read = circular_buffer_read(&ctx->stream_buffer, out, samples_needed);
 
+		// Gapless: frames past the boundary already belong to the next track
+		int64_t next_track_frames = -1;
+		if (ctx->next_boundary >= 0) {
+			if ((int64_t)samples_read >= ctx->next_boundary) {
+				next_track_frames = samples_read - ctx->next_boundary;
+				ctx->next_boundary = -1;
+				ctx->track_switched = true;
+			} else {
+				ctx->next_boundary -= samples_read;
+			}
+		}
+
 		// If not enough data, fill rest with silence
 		if (samples_read < (size_t)samples_needed) {
 			memset(&out[samples_read * AUDIO_CHANNELS], 0,
 				   (samples_needed - samples_read) * sizeof(int16_t) * AUDIO_CHANNELS);
 		}
 
-		// Apply volume with logarithmic curve for natural perceived loudness
-		if (ctx->volume < 0.99f || ctx->volume > 1.01f) {
-			float curved_vol = apply_volume_curve(ctx->volume);
-			for (size_t i = 0; i < samples_read * AUDIO_CHANNELS; i++) {
-				out[i] = (int16_t)(out[i] * curved_vol);
-			}
-		}
+		// Ease towards the track's ReplayGain (it can arrive late from the analysis)
+		float applied = ctx->replay_gain_applied;
+		if (ctx->replay_gain > applied * REPLAY_GAIN_STEP)
+			applied *= REPLAY_GAIN_STEP;
+		else if (ctx->replay_gain < applied / REPLAY_GAIN_STEP)
+			applied /= REPLAY_GAIN_STEP;
+		else
+			applied = ctx->replay_gain;
 
-		// Speaker processing: high-pass filter + soft limiter
-		if (!bluetooth_audio_active && !usbdac_audio_active) {
-			int bass_hz = Settings_getBassFilterHz();
-			float limiter_thresh = Settings_getSoftLimiterThreshold();
-			if (bass_hz != speaker_hpf_last_hz) {
-				if (bass_hz > 0)
-					speaker_hpf_init(current_sample_rate, (float)bass_hz);
-				speaker_hpf_last_hz = bass_hz;
-			}
-			for (size_t i = 0; i < samples_read * AUDIO_CHANNELS; i++) {
-				if (bass_hz > 0)
-					out[i] = speaker_hpf_process(out[i], i % AUDIO_CHANNELS);
-				if (limiter_thresh > 0.0f)
-					out[i] = speaker_soft_limit(out[i], limiter_thresh);
-			}
+		// Volume + ReplayGain + speaker high-pass filter and soft limiter.
+		// Frames past a gapless boundary take the next track's gain right away.
+		float volume = output_volume(ctx);
+		size_t current_frames = next_track_frames >= 0 ? samples_read - next_track_frames : samples_read;
+		process_output(out, current_frames, volume * applied);
+		if (next_track_frames >= 0) {
+			ctx->replay_gain = ctx->next_replay_gain;
+			applied = ctx->replay_gain;
+			process_output(out + current_frames * AUDIO_CHANNELS, next_track_frames, volume * applied);
 		}
+		ctx->replay_gain_applied = applied;
 
 		// Copy to visualization buffer (non-blocking)
 		if (samples_read > 0 && pthread_mutex_trylock(&ctx->vis_mutex) == 0) {
@@ -1396,11 +1863,15 @@ static void audio_callback(void* userdata, Uint8* stream, int len) {
 		}
 
 		// Update position
-		audio_position_samples += samples_read;
+		if (next_track_frames >= 0)
+			audio_position_samples = next_track_frames;
+		else
+			audio_position_samples += samples_read;
 		ctx->position_ms = (audio_position_samples * 1000) / current_sample_rate;
 
 		// Check if track ended (decoder reached EOF or frame count)
 		if ((ctx->stream_decoder.current_frame >= ctx->stream_decoder.total_frames || ctx->stream_eof) &&
+			!ctx->decoding_next && !ctx->track_switched &&
 			circular_buffer_available(&ctx->stream_buffer) == 0) {
 			if (ctx->repeat) {
 				// Seek back to beginning
@@ -1432,6 +1903,11 @@ int Player_init(void) {
 
 	player.volume = 1.0f;
 	player.state = PLAYER_STATE_STOPPED;
+	player.next_boundary = -1;
+	player.replay_gain = 1.0f;
+	player.replay_gain_applied = 1.0f;
+	player.next_replay_gain = 1.0f;
+	DSP_init(&output_dsp);
 
 	// Initialize SDL audio
 	if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
@@ -1537,11 +2013,7 @@ int Player_init(void) {
 
 	player.audio_initialized = true;
 	current_sample_rate = have.freq;
-	{
-		int bass_hz = Settings_getBassFilterHz();
-		if (bass_hz > 0)
-			speaker_hpf_init(current_sample_rate, (float)bass_hz);
-	}
+	DSP_reset(&output_dsp); // Filter state belongs to the old device
 
 	// Register for audio device changes (Bluetooth, USB DAC, etc.)
 	PLAT_audioDeviceWatchRegister(audio_device_change_callback);
@@ -1585,11 +2057,7 @@ static int reconfigure_audio_device(int new_sample_rate) {
 	}
 
 	current_sample_rate = have.freq;
-	{
-		int bass_hz = Settings_getBassFilterHz();
-		if (bass_hz > 0)
-			speaker_hpf_init(current_sample_rate, (float)bass_hz);
-	}
+	DSP_reset(&output_dsp); // Filter state belongs to the old device
 	return 0;
 }
 
@@ -1625,11 +2093,7 @@ static void reopen_audio_device(void) {
 	}
 
 	current_sample_rate = have.freq;
-	{
-		int bass_hz = Settings_getBassFilterHz();
-		if (bass_hz > 0)
-			speaker_hpf_init(current_sample_rate, (float)bass_hz);
-	}
+	DSP_reset(&output_dsp); // Filter state belongs to the old device
 
 	// Resume playback if it was playing
 	if (prev_state == PLAYER_STATE_PLAYING) {
@@ -1798,7 +2262,7 @@ static void utf16be_to_ascii(char* dest, const uint8_t* src, size_t src_len, siz
 }
 
 // Parse ID3v1 tag (at end of file, 128 bytes)
-static void parse_id3v1(const char* filepath) {
+static void parse_id3v1(const char* filepath, TrackInfo* info) {
 	FILE* f = fopen(filepath, "rb");
 	if (!f)
 		return;
@@ -1825,29 +2289,76 @@ static void parse_id3v1(const char* filepath) {
 	char buf[31];
 
 	// Title (bytes 3-32)
-	if (player.track_info.title[0] == '\0' || strstr(player.track_info.title, ".") != NULL) {
+	if (info->title[0] == '\0' || strstr(info->title, ".") != NULL) {
 		memcpy(buf, &tag[3], 30);
 		buf[30] = '\0';
-		copy_metadata_string(player.track_info.title, buf, sizeof(player.track_info.title));
+		copy_metadata_string(info->title, buf, sizeof(info->title));
 	}
 
 	// Artist (bytes 33-62)
-	if (player.track_info.artist[0] == '\0') {
+	if (info->artist[0] == '\0') {
 		memcpy(buf, &tag[33], 30);
 		buf[30] = '\0';
-		copy_metadata_string(player.track_info.artist, buf, sizeof(player.track_info.artist));
+		copy_metadata_string(info->artist, buf, sizeof(info->artist));
 	}
 
 	// Album (bytes 63-92)
-	if (player.track_info.album[0] == '\0') {
+	if (info->album[0] == '\0') {
 		memcpy(buf, &tag[63], 30);
 		buf[30] = '\0';
-		copy_metadata_string(player.track_info.album, buf, sizeof(player.track_info.album));
+		copy_metadata_string(info->album, buf, sizeof(info->album));
 	}
 }
 
+// Helper: decode one null-terminated ID3v2 UTF-16 string (encoding 1 has a BOM),
+// returns the bytes it took including the terminator
+static size_t id3_utf16_string(char* dest, size_t max_len, const uint8_t* src, size_t src_len, uint8_t encoding) {
+	size_t len = 0;
+	while (len + 1 < src_len && (src[len] || src[len + 1]))
+		len += 2;
+	size_t used = (len + 2 <= src_len) ? len + 2 : src_len;
+
+	bool big_endian = (encoding == 2);
+	if (encoding == 1 && len >= 2 && ((src[0] == 0xFF && src[1] == 0xFE) || (src[0] == 0xFE && src[1] == 0xFF))) {
+		big_endian = (src[0] == 0xFE);
+		src += 2;
+		len -= 2;
+	}
+	if (big_endian)
+		utf16be_to_ascii(dest, src, len, max_len);
+	else
+		utf16le_to_ascii(dest, src, len, max_len);
+	return used;
+}
+
+// Parse a TXXX (user defined text) frame, only ReplayGain values are used
+static void parse_id3_txxx(TrackInfo* info, const uint8_t* frame_data, size_t frame_size) {
+	uint8_t encoding = frame_data[0];
+	const uint8_t* text = &frame_data[1];
+	size_t text_len = frame_size - 1;
+	char desc[64];
+	char value[64];
+
+	if (encoding == 0 || encoding == 3) {
+		// ISO-8859-1 or UTF-8: description and value separated by a single null
+		size_t desc_len = strnlen((const char*)text, text_len);
+		if (desc_len >= text_len)
+			return;
+		snprintf(desc, sizeof(desc), "%.*s", (int)desc_len, text);
+		snprintf(value, sizeof(value), "%.*s", (int)(text_len - desc_len - 1), text + desc_len + 1);
+	} else if (encoding == 1 || encoding == 2) {
+		size_t used = id3_utf16_string(desc, sizeof(desc), text, text_len, encoding);
+		if (used >= text_len)
+			return;
+		id3_utf16_string(value, sizeof(value), text + used, text_len - used, encoding);
+	} else {
+		return;
+	}
+	Loudness_parseTag(&info->replay_gain, desc, strlen(desc), value);
+}
+
 // Parse ID3v2 tag (at beginning of file)
-static void parse_id3v2(const char* filepath) {
+static void parse_id3v2(const char* filepath, TrackInfo* info, SDL_Surface** art) {
 	FILE* f = fopen(filepath, "rb");
 	if (!f)
 		return;
@@ -1909,8 +2420,12 @@ static void parse_id3v2(const char* filepath) {
 		if (frame_size == 0 || pos + frame_size > tag_size)
 			break;
 
+		// User defined text frames carry ReplayGain
+		if (strcmp(frame_id, "TXXX") == 0 && frame_size > 1) {
+			parse_id3_txxx(info, &tag_data[pos], frame_size);
+		}
 		// Process text frames (TIT2, TPE1, TALB, etc.)
-		if (frame_id[0] == 'T' && frame_size > 1) {
+		else if (frame_id[0] == 'T' && frame_size > 1) {
 			const uint8_t* frame_data = &tag_data[pos];
 			uint8_t encoding = frame_data[0];
 			const uint8_t* text_data = &frame_data[1];
@@ -1949,15 +2464,15 @@ static void parse_id3v2(const char* filepath) {
 
 			// Assign to appropriate field
 			if (strcmp(frame_id, "TIT2") == 0 && temp[0]) { // Title
-				copy_metadata_string(player.track_info.title, temp, sizeof(player.track_info.title));
+				copy_metadata_string(info->title, temp, sizeof(info->title));
 			} else if (strcmp(frame_id, "TPE1") == 0 && temp[0]) { // Artist
-				copy_metadata_string(player.track_info.artist, temp, sizeof(player.track_info.artist));
+				copy_metadata_string(info->artist, temp, sizeof(info->artist));
 			} else if (strcmp(frame_id, "TALB") == 0 && temp[0]) { // Album
-				copy_metadata_string(player.track_info.album, temp, sizeof(player.track_info.album));
+				copy_metadata_string(info->album, temp, sizeof(info->album));
 			}
 		}
 		// Process APIC frame (album art) - only if we don't already have art
-		else if (strcmp(frame_id, "APIC") == 0 && frame_size > 10 && player.album_art == NULL) {
+		else if (strcmp(frame_id, "APIC") == 0 && frame_size > 10 && *art == NULL) {
 			const uint8_t* frame_data = &tag_data[pos];
 			uint8_t encoding = frame_data[0];
 			size_t offset = 1;
@@ -1994,16 +2509,16 @@ static void parse_id3v2(const char* filepath) {
 					const uint8_t* image_data = &frame_data[offset];
 
 					// Prefer front cover (type 3), but accept any if we have none
-					if (pic_type == 3 || player.album_art == NULL) {
+					if (pic_type == 3 || *art == NULL) {
 						SDL_RWops* rw = SDL_RWFromConstMem(image_data, image_size);
 						if (rw) {
-							SDL_Surface* art = IMG_Load_RW(rw, 1); // 1 = auto-close RWops
-							if (art) {
+							SDL_Surface* image = IMG_Load_RW(rw, 1); // 1 = auto-close RWops
+							if (image) {
 								// Free previous art if we're replacing with front cover
-								if (player.album_art) {
-									SDL_FreeSurface(player.album_art);
+								if (*art) {
+									SDL_FreeSurface(*art);
 								}
-								player.album_art = art;
+								*art = image;
 							}
 						}
 					}
@@ -2018,54 +2533,64 @@ static void parse_id3v2(const char* filepath) {
 }
 
 // Parse MP3 metadata (ID3v2 first, then ID3v1 as fallback)
-static void parse_mp3_metadata(const char* filepath) {
+static void parse_mp3_metadata(const char* filepath, TrackInfo* info, SDL_Surface** art) {
 	// Try ID3v2 first (more modern, more info)
-	parse_id3v2(filepath);
+	parse_id3v2(filepath, info, art);
 
 	// Fall back to ID3v1 for any missing fields
-	if (player.track_info.artist[0] == '\0' || player.track_info.album[0] == '\0') {
-		parse_id3v1(filepath);
+	if (info->artist[0] == '\0' || info->album[0] == '\0') {
+		parse_id3v1(filepath, info);
 	}
 }
 
 // Parse M4A metadata from the already-opened decoder
-static void parse_m4a_metadata(void) {
-	if (player.stream_decoder.format != AUDIO_FORMAT_M4A || !player.stream_decoder.decoder) {
+static void parse_m4a_metadata(StreamDecoder* sd, TrackInfo* info, SDL_Surface** art) {
+	if (sd->format != AUDIO_FORMAT_M4A || !sd->decoder) {
 		return;
 	}
 
-	M4ADecoder* m4a = (M4ADecoder*)player.stream_decoder.decoder;
+	M4ADecoder* m4a = (M4ADecoder*)sd->decoder;
 
 	// Copy metadata from minimp4's parsed tags
 	if (m4a->mp4.tag.title && m4a->mp4.tag.title[0]) {
-		copy_metadata_string(player.track_info.title, (const char*)m4a->mp4.tag.title,
-							 sizeof(player.track_info.title));
+		copy_metadata_string(info->title, (const char*)m4a->mp4.tag.title,
+							 sizeof(info->title));
 	}
 
 	if (m4a->mp4.tag.artist && m4a->mp4.tag.artist[0]) {
-		copy_metadata_string(player.track_info.artist, (const char*)m4a->mp4.tag.artist,
-							 sizeof(player.track_info.artist));
+		copy_metadata_string(info->artist, (const char*)m4a->mp4.tag.artist,
+							 sizeof(info->artist));
 	}
 
 	if (m4a->mp4.tag.album && m4a->mp4.tag.album[0]) {
-		copy_metadata_string(player.track_info.album, (const char*)m4a->mp4.tag.album,
-							 sizeof(player.track_info.album));
+		copy_metadata_string(info->album, (const char*)m4a->mp4.tag.album,
+							 sizeof(info->album));
 	}
 
+	// ReplayGain freeform tags
+	if (m4a->mp4.tag.replaygain_track_gain)
+		Loudness_parseTag(&info->replay_gain, "REPLAYGAIN_TRACK_GAIN", 21, (const char*)m4a->mp4.tag.replaygain_track_gain);
+	if (m4a->mp4.tag.replaygain_album_gain)
+		Loudness_parseTag(&info->replay_gain, "REPLAYGAIN_ALBUM_GAIN", 21, (const char*)m4a->mp4.tag.replaygain_album_gain);
+	if (m4a->mp4.tag.replaygain_track_peak)
+		Loudness_parseTag(&info->replay_gain, "REPLAYGAIN_TRACK_PEAK", 21, (const char*)m4a->mp4.tag.replaygain_track_peak);
+	if (m4a->mp4.tag.replaygain_album_peak)
+		Loudness_parseTag(&info->replay_gain, "REPLAYGAIN_ALBUM_PEAK", 21, (const char*)m4a->mp4.tag.replaygain_album_peak);
+
 	// Load cover art if present
-	if (m4a->mp4.tag.cover && m4a->mp4.tag.cover_size > 0 && player.album_art == NULL) {
+	if (m4a->mp4.tag.cover && m4a->mp4.tag.cover_size > 0 && *art == NULL) {
 		SDL_RWops* rw = SDL_RWFromConstMem(m4a->mp4.tag.cover, m4a->mp4.tag.cover_size);
 		if (rw) {
-			SDL_Surface* art = IMG_Load_RW(rw, 1); // 1 = auto-close RWops
-			if (art) {
-				player.album_art = art;
+			SDL_Surface* image = IMG_Load_RW(rw, 1); // 1 = auto-close RWops
+			if (image) {
+				*art = image;
 			}
 		}
 	}
 }
 
-// Parse Vorbis comments (for OGG and FLAC)
-static void parse_vorbis_comment(const char* comment) {
+// Parse Vorbis comments (for OGG, Opus and FLAC)
+static void parse_vorbis_comment(TrackInfo* info, const char* comment) {
 	if (!comment)
 		return;
 
@@ -2078,17 +2603,19 @@ static void parse_vorbis_comment(const char* comment) {
 	const char* value = eq + 1;
 
 	if (strncasecmp(comment, "TITLE", key_len) == 0 && key_len == 5) {
-		copy_metadata_string(player.track_info.title, value, sizeof(player.track_info.title));
+		copy_metadata_string(info->title, value, sizeof(info->title));
 	} else if (strncasecmp(comment, "ARTIST", key_len) == 0 && key_len == 6) {
-		copy_metadata_string(player.track_info.artist, value, sizeof(player.track_info.artist));
+		copy_metadata_string(info->artist, value, sizeof(info->artist));
 	} else if (strncasecmp(comment, "ALBUM", key_len) == 0 && key_len == 5) {
-		copy_metadata_string(player.track_info.album, value, sizeof(player.track_info.album));
+		copy_metadata_string(info->album, value, sizeof(info->album));
+	} else {
+		Loudness_parseTag(&info->replay_gain, comment, key_len, value);
 	}
 }
 
 // FLAC metadata callback
 static void flac_metadata_callback(void* pUserData, drflac_metadata* pMetadata) {
-	(void)pUserData;
+	TrackInfo* info = (TrackInfo*)pUserData;
 
 	if (pMetadata->type == DRFLAC_METADATA_BLOCK_TYPE_VORBIS_COMMENT) {
 		// Parse Vorbis comments
@@ -2109,7 +2636,7 @@ static void flac_metadata_callback(void* pUserData, drflac_metadata* pMetadata)
 				if (comment) {
 					memcpy(comment, pComments, commentLength);
 					comment[commentLength] = '\0';
-					parse_vorbis_comment(comment);
+					parse_vorbis_comment(info, comment);
 					free(comment);
 				}
 
@@ -2165,7 +2692,7 @@ void Player_setSampleRate(int sample_rate) {
 // Load file using streaming playback (decode on-the-fly)
 static int load_streaming(const char* filepath) {
 	// Open decoder
-	if (stream_decoder_open(&player.stream_decoder, filepath) != 0) {
+	if (stream_decoder_open(&player.stream_decoder, filepath, &player.track_info) != 0) {
 		return -1;
 	}
 
@@ -2191,10 +2718,7 @@ static int load_streaming(const char* filepath) {
 	}
 
 	// Set track info
-	player.track_info.sample_rate = dst_rate; // Output rate
-	player.track_info.channels = AUDIO_CHANNELS;
-	player.track_info.duration_ms = (int)((player.stream_decoder.total_frames * 1000) /
-										  player.stream_decoder.source_sample_rate);
+	set_stream_track_info(&player.track_info, &player.stream_decoder, dst_rate);
 
 	// Configure audio device at target rate (no reconfiguration needed later!)
 	reconfigure_audio_device(dst_rate);
@@ -2203,6 +2727,7 @@ static int load_streaming(const char* filepath) {
 	player.stream_running = true;
 	player.stream_seeking = false;
 	player.stream_eof = false;
+	player.next_boundary = -1;
 	pthread_create(&player.stream_thread, NULL, stream_thread_func, NULL);
 
 	// Pre-buffer some audio before returning (~0.5 seconds)
@@ -2233,22 +2758,8 @@ int Player_load(const char* filepath) {
 	// Store filename
 	strncpy(player.current_file, filepath, sizeof(player.current_file) - 1);
 
-	// Extract title from filename
-	const char* filename = strrchr(filepath, '/');
-	if (filename)
-		filename++;
-	else
-		filename = filepath;
-	strncpy(player.track_info.title, filename, sizeof(player.track_info.title) - 1);
-
-	// Remove extension from title
-	char* ext = strrchr(player.track_info.title, '.');
-	if (ext)
-		*ext = '\0';
-
-	// Clear artist/album
-	player.track_info.artist[0] = '\0';
-	player.track_info.album[0] = '\0';
+	// Title from filename until tags are read
+	init_track_info(&player.track_info, filepath);
 
 	pthread_mutex_unlock(&player.mutex);
 
@@ -2260,22 +2771,9 @@ int Player_load(const char* filepath) {
 		format == AUDIO_FORMAT_OPUS) {
 		result = load_streaming(filepath);
 
-		// Parse metadata for MP3
-		if (result == 0 && format == AUDIO_FORMAT_MP3) {
-			parse_mp3_metadata(filepath);
-		}
-		// Parse metadata for M4A
-		if (result == 0 && format == AUDIO_FORMAT_M4A) {
-			parse_m4a_metadata();
-		}
-		// Parse metadata for Opus (uses Vorbis comment tags)
-		if (result == 0 && format == AUDIO_FORMAT_OPUS) {
-			OggOpusFile* of = (OggOpusFile*)player.stream_decoder.decoder;
-			const OpusTags* tags = op_tags(of, -1);
-			if (tags) {
-				for (int i = 0; i < tags->comments; i++)
-					parse_vorbis_comment(tags->user_comments[i]);
-			}
+		// Parse metadata for MP3, M4A and Opus
+		if (result == 0) {
+			parse_track_metadata(filepath, &player.stream_decoder, &player.track_info, &player.album_art);
 		}
 
 		// Album art fetch moved to module_player.c (after Player_play)
@@ -2290,15 +2788,44 @@ int Player_load(const char* filepath) {
 		player.position_ms = 0;
 		audio_position_samples = 0;
 		player.state = PLAYER_STATE_STOPPED;
+		player.replay_gain_mode = Settings_getReplayGain();
+		player.replay_gain = replay_gain_linear(&player.track_info.replay_gain);
+		player.replay_gain_applied = player.replay_gain; // New track, no fade
+		bool analyze_loudness = !player.track_info.replay_gain.has_track_gain;
 		pthread_mutex_unlock(&player.mutex);
 
-		// Note: Waveform generation disabled for streaming mode
-		// (would require reading entire file which defeats the purpose)
+		// Waveform (and loudness of untagged files) come from a separate low priority decoder pass
+		waveform_start(filepath, analyze_loudness);
 	}
 
 	return result;
 }
 
+bool Player_setNextTrack(const char* filepath) {
+	bool queued = false;
+	pthread_mutex_lock(&player.mutex);
+	// Once the next track is in the buffer it can't be swapped out anymore
+	if (!player.decoding_next && !player.track_switched) {
+		if (filepath)
+			snprintf(player.next_file, sizeof(player.next_file), "%s", filepath);
+		else
+			player.next_file[0] = '\0';
+		queued = true;
+	}
+	pthread_mutex_unlock(&player.mutex);
+	return queued;
+}
+
+bool Player_pollTrackChange(void) {
+	Player_update();
+
+	pthread_mutex_lock(&player.mutex);
+	bool changed = player.track_changed;
+	player.track_changed = false;
+	pthread_mutex_unlock(&player.mutex);
+	return changed;
+}
+
 int Player_play(void) {
 	// Check if we have audio loaded
 	if (!player.use_streaming || !player.stream_decoder.decoder)
@@ -2339,6 +2866,7 @@ void Player_stop(void) {
 	// Clean up streaming resources
 	if (player.use_streaming) {
 		stream_decoder_close(&player.stream_decoder);
+		close_next_track();
 		circular_buffer_free(&player.stream_buffer);
 		if (player.resampler) {
 			src_delete((SRC_STATE*)player.resampler);
@@ -2357,8 +2885,16 @@ void Player_stop(void) {
 	memset(&player.track_info, 0, sizeof(TrackInfo));
 	player.current_file[0] = '\0';
 
+	// Drop the gapless queue
+	player.next_file[0] = '\0';
+	player.decoding_next = false;
+	player.next_boundary = -1;
+	player.track_switched = false;
+	player.track_change_pending = false;
+	player.track_changed = false;
+
 	// Clear waveform
-	memset(&waveform, 0, sizeof(waveform));
+	waveform_reset();
 
 	// Free album art
 	if (player.album_art) {
@@ -2459,8 +2995,12 @@ int Player_getVisBuffer(int16_t* buffer, int max_samples) {
 	return samples_to_copy;
 }
 
-const WaveformData* Player_getWaveform(void) {
-	return &waveform;
+bool Player_getWaveform(WaveformData* out) {
+	// The background job writes bars while we copy
+	pthread_mutex_lock(&waveform_mutex);
+	*out = waveform;
+	pthread_mutex_unlock(&waveform_mutex);
+	return out->bar_count > 0;
 }
 
 SDL_Surface* Player_getAlbumArt(void) {
@@ -2473,8 +3013,42 @@ SDL_Surface* Player_getAlbumArt(void) {
 }
 
 void Player_update(void) {
-	// End-of-track detection is handled in the audio callback for streaming mode
-	// This function is kept for any future polling needs
+	// End-of-track detection is handled in the audio callback for streaming mode.
+	// After a gapless switch the decode thread has swapped decoders, take over the
+	// next track's metadata here so album art is only freed on the main thread.
+	pthread_mutex_lock(&player.mutex);
+
+	// ReplayGain setting changed: recompute the gains (the callback eases into them)
+	int mode = Settings_getReplayGain();
+	if (mode != player.replay_gain_mode && !player.track_switched && !player.track_change_pending) {
+		player.replay_gain_mode = mode;
+		player.replay_gain = replay_gain_linear(&player.track_info.replay_gain);
+		if (player.decoding_next)
+			player.next_replay_gain = replay_gain_linear(&player.next_info.replay_gain);
+	}
+
+	if (!player.track_change_pending) {
+		pthread_mutex_unlock(&player.mutex);
+		return;
+	}
+
+	SDL_Surface* old_art = player.album_art;
+	strcpy(player.current_file, player.next_opened);
+	player.next_opened[0] = '\0';
+	player.track_info = player.next_info;
+	player.album_art = player.next_album_art;
+	player.next_album_art = NULL;
+	player.format = player.stream_decoder.format;
+	player.track_change_pending = false;
+	player.track_changed = true;
+	bool analyze_loudness = !player.track_info.replay_gain.has_track_gain;
+	waveform_reset(); // The old track's analysis mustn't land on this one
+	pthread_mutex_unlock(&player.mutex);
+
+	if (old_art)
+		SDL_FreeSurface(old_art);
+	album_art_clear();
+	waveform_start(player.current_file, analyze_loudness);
 }
 
 void Player_resumeAudio(void) {
@@ -26,6 +26,16 @@ typedef enum {
 	PLAYER_STATE_PAUSED
 } PlayerState;
 
+// ReplayGain of a track, from tags or loudness analysis
+typedef struct {
+	float track_gain; // dB relative to the -18 LUFS reference
+	float album_gain;
+	float track_peak; // Linear sample peak (0 if unknown)
+	float album_peak;
+	bool has_track_gain;
+	bool has_album_gain;
+} ReplayGain;
+
 // Track metadata
 typedef struct {
 	char title[256];
@@ -35,14 +45,16 @@ typedef struct {
 	int sample_rate;
 	int channels;
 	int bitrate;
+	ReplayGain replay_gain;
 } TrackInfo;
 
 // Waveform overview data
 #define WAVEFORM_BARS 128 // Number of bars in waveform display
 typedef struct {
-	float bars[WAVEFORM_BARS]; // Amplitude values 0.0-1.0 for each bar
-	int bar_count;
-	bool valid;
+	float bars[WAVEFORM_BARS]; // Peak amplitude 0.0-1.0 for each bar
+	float rms[WAVEFORM_BARS];  // RMS level 0.0-1.0 for each bar
+	int bar_count;			   // Bars filled in so far (fills in progressively)
+	bool valid;				   // All bars are filled in
 } WaveformData;
 
 // Streaming decoder state (holds any decoder type)
@@ -53,6 +65,9 @@ typedef struct {
 	int source_channels;
 	int64_t total_frames;
 	int64_t current_frame;
+	int64_t skip_frames; // Decoded frames to drop before output (encoder delay, seek remainder)
+	int encoder_delay;	 // Priming frames at the start of the stream (M4A iTunSMPB/pgap)
+	bool exact_length;	 // total_frames excludes encoder padding, stop output there
 } StreamDecoder;
 
 // Circular buffer for streaming playback
@@ -104,6 +119,25 @@ typedef struct {
 	bool use_streaming;		   // True if using streaming mode
 	bool stream_eof;		   // True when decoder has reached end of file
 
+	// Gapless playback: the queued track is opened near EOF and decoded
+	// into stream_buffer right behind the current one
+	char next_file[512];		 // Queued track ("" if none), set by Player_setNextTrack
+	char next_opened[512];		 // Track next_decoder was opened for
+	StreamDecoder next_decoder;	 // Owned by the decode thread
+	TrackInfo next_info;		 // Metadata of next_decoder's track
+	SDL_Surface* next_album_art; // Album art of next_decoder's track
+	bool decoding_next;			 // Current track fully decoded, buffer is being filled from next_decoder
+	int64_t next_boundary;		 // Buffered frames left of the current track (-1 if no boundary buffered)
+	bool track_switched;		 // Audio callback crossed the boundary, decode thread swaps decoders
+	bool track_change_pending;	 // Decoders swapped, Player_update swaps track info
+	bool track_changed;			 // Reported once by Player_pollTrackChange
+
+	// Loudness normalization (linear gain, 1.0 when off or unknown)
+	float replay_gain;		   // Target gain of the playing track
+	float replay_gain_applied; // Gain the audio callback is at, eases towards replay_gain
+	float next_replay_gain;	   // Gain of next_decoder's track, taken over at the boundary
+	int replay_gain_mode;	   // Settings value the gains were computed for
+
 	// Resampler leftover buffer (for unconsumed input frames)
 	int16_t* resample_leftover;
 	size_t resample_leftover_count;
@@ -122,6 +156,13 @@ void Player_quit(void);
 // Load a file (does not start playing)
 int Player_load(const char* filepath);
 
+// Queue the track to play gaplessly after the current one (NULL clears it).
+// Returns false if the current queue is already being decoded into the buffer.
+bool Player_setNextTrack(const char* filepath);
+
+// Check if playback moved on to the queued track since the last call
+bool Player_pollTrackChange(void);
+
 // Start/resume playback
 int Player_play(void);
 
@@ -165,8 +206,9 @@ const char* Player_getCurrentFile(void);
 // Returns number of samples copied
 int Player_getVisBuffer(int16_t* buffer, int max_samples);
 
-// Get waveform overview data (for static waveform progress display)
-const WaveformData* Player_getWaveform(void);
+// Copy the waveform overview (for the waveform progress display).
+// Returns false while no bar is filled in yet.
+bool Player_getWaveform(WaveformData* out);
 
 // Get album art surface (NULL if no album art available)
 SDL_Surface* Player_getAlbumArt(void);
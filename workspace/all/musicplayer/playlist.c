@@ -6,6 +6,7 @@
 #include "api.h"
 #include "playlist.h"
 #include "player.h"
+#include "browser.h"
 
 // Forward declarations for internal helpers
 static int scan_directory_recursive(PlaylistContext* ctx, const char* path, int depth);
@@ -111,15 +112,10 @@ static int scan_directory_recursive(PlaylistContext* ctx, const char* path, int
 		char full_path[512];
 		snprintf(full_path, sizeof(full_path), "%s/%s", path, ent->d_name);
 
-		struct stat st;
-		if (lstat(full_path, &st) != 0)
-			continue; // Use lstat to detect symlinks
-
 		// Skip symlinks to prevent infinite loops
-		if (S_ISLNK(st.st_mode))
-			continue;
+		BrowserEntryKind kind = Browser_classifyEntry(full_path, ent, false);
 
-		if (S_ISDIR(st.st_mode)) {
+		if (kind == BROWSER_ENTRY_DIR) {
 			// Add directory name
 			if (dir_count >= dirs_capacity) {
 				dirs_capacity *= 2;
@@ -131,7 +127,7 @@ static int scan_directory_recursive(PlaylistContext* ctx, const char* path, int
 			dirs[dir_count] = strdup(ent->d_name);
 			if (dirs[dir_count])
 				dir_count++;
-		} else if (is_audio_file(ent->d_name)) {
+		} else if (kind == BROWSER_ENTRY_FILE && is_audio_file(ent->d_name)) {
 			// Add audio file name
 			if (file_count >= files_capacity) {
 				files_capacity *= 2;
@@ -234,15 +230,10 @@ int Playlist_buildFromDirectory(PlaylistContext* ctx, const char* path, const ch
 		char full_path[512];
 		snprintf(full_path, sizeof(full_path), "%s/%s", path, ent->d_name);
 
-		struct stat st;
-		if (lstat(full_path, &st) != 0)
-			continue;
-
 		// Skip symlinks
-		if (S_ISLNK(st.st_mode))
-			continue;
+		BrowserEntryKind kind = Browser_classifyEntry(full_path, ent, false);
 
-		if (S_ISDIR(st.st_mode)) {
+		if (kind == BROWSER_ENTRY_DIR) {
 			if (dir_count >= dirs_capacity) {
 				dirs_capacity *= 2;
 				char** new_dirs = realloc(dirs, sizeof(char*) * dirs_capacity);
@@ -253,7 +244,7 @@ int Playlist_buildFromDirectory(PlaylistContext* ctx, const char* path, const ch
 			dirs[dir_count] = strdup(ent->d_name);
 			if (dirs[dir_count])
 				dir_count++;
-		} else if (is_audio_file(ent->d_name)) {
+		} else if (kind == BROWSER_ENTRY_FILE && is_audio_file(ent->d_name)) {
 			if (file_count >= files_capacity) {
 				files_capacity *= 2;
 				char** new_files = realloc(files, sizeof(char*) * files_capacity);
@@ -1,5 +1,6 @@
 #define _GNU_SOURCE
 #include "podcast.h"
+#include "podcast_store.h"
 #include "wget_fetch.h"
 #include "player.h"
 #include <stdio.h>
@@ -220,6 +221,9 @@ static int episode_cache_offset = 0;
 static int episode_cache_count = 0;
 static pthread_mutex_t episode_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// Serializes store rewrites (refresh) against in-place record updates
+static pthread_mutex_t episode_store_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 // Continue Listening
 static ContinueListeningEntry continue_listening[PODCAST_MAX_CONTINUE_LISTENING];
 static int continue_listening_count = 0;
@@ -230,6 +234,10 @@ static volatile bool refresh_running = false;
 static int refresh_feed_index = -1; // -1 = all feeds, >=0 = specific feed
 static volatile bool refresh_completed = false;
 #define REFRESH_COOLDOWN_SEC 900 // 15 minutes
+#define REFRESH_MAX_WORKERS 4	 // Feeds fetched in parallel by a refresh-all
+static pthread_mutex_t refresh_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int refresh_next_index = 0;
+static int refresh_end_index = 0;
 
 // Base data directory for podcast data
 static char podcast_data_dir[512] = "";
@@ -246,6 +254,7 @@ static void save_continue_listening(void);
 static void load_continue_listening(void);
 static void validate_continue_listening(void);
 static void sanitize_for_filename(char* str);
+static int get_cached_progress(const char* feed_url, const char* episode_guid);
 
 
 // ============================================================================
@@ -298,13 +307,20 @@ static int get_feed_index(PodcastFeed* feed) {
 	return -1;
 }
 
-// Get path to feed's episodes JSON file
+// Get path to feed's legacy episodes JSON file (migrated to the episode store)
 static void get_episodes_file_path(const char* feed_id, char* path, int path_size) {
 	if (!feed_id || !path || path_size <= 0)
 		return;
 	snprintf(path, path_size, "%s/%s/episodes.json", podcast_data_dir, feed_id);
 }
 
+// Get path to feed's episode store
+static void get_episode_store_path(const char* feed_id, char* path, int path_size) {
+	if (!feed_id || !path || path_size <= 0)
+		return;
+	snprintf(path, path_size, "%s/%s/episodes.bin", podcast_data_dir, feed_id);
+}
+
 // Create directory recursively
 static void mkdir_recursive(const char* path) {
 	char tmp[512];
@@ -327,105 +343,36 @@ static void mkdir_recursive(const char* path) {
 }
 
 // ============================================================================
-// Episode Storage (JSON on disk)
+// Episode Storage (indexed store on disk)
 // ============================================================================
 
-// Save episodes to JSON file for a feed
-int Podcast_saveEpisodes(int feed_index, PodcastEpisode* episodes, int count) {
-	if (feed_index < 0 || feed_index >= subscription_count || !episodes || count < 0) {
+// Parse the legacy episodes.json into a malloc'd array. Returns count, -1 if unreadable.
+static int load_episodes_json(const char* path, PodcastEpisode** out) {
+	*out = NULL;
+	JSON_Value* root = json_parse_file(path);
+	if (!root)
 		return -1;
-	}
-
-	PodcastFeed* feed = &subscriptions[feed_index];
-
-	set_feed_id(feed);
-
-	// Create feed directory
-	char feed_dir[512];
-	Podcast_getFeedDataPath(feed->feed_id, feed_dir, sizeof(feed_dir));
-	mkdir_recursive(feed_dir);
-
-	// Build episodes JSON
-	JSON_Value* root = json_value_init_array();
-	JSON_Array* arr = json_value_get_array(root);
-
-	for (int i = 0; i < count; i++) {
-		PodcastEpisode* ep = &episodes[i];
-		JSON_Value* ep_val = json_value_init_object();
-		JSON_Object* ep_obj = json_value_get_object(ep_val);
-
-		json_object_set_string(ep_obj, "guid", ep->guid);
-		json_object_set_string(ep_obj, "title", ep->title);
-		json_object_set_string(ep_obj, "url", ep->url);
-		json_object_set_string(ep_obj, "description", ep->description);
-		json_object_set_number(ep_obj, "duration", ep->duration_sec);
-		json_object_set_number(ep_obj, "pub_date", ep->pub_date);
-		json_object_set_number(ep_obj, "progress", ep->progress_sec);
-		json_object_set_boolean(ep_obj, "downloaded", ep->downloaded);
-		if (ep->local_path[0]) {
-			json_object_set_string(ep_obj, "local_path", ep->local_path);
-		}
-		json_object_set_boolean(ep_obj, "is_new", ep->is_new);
-
-		json_array_append_value(arr, ep_val);
-	}
-
-	// Save to file
-	char episodes_path[512];
-	get_episodes_file_path(feed->feed_id, episodes_path, sizeof(episodes_path));
-	int result = json_serialize_to_file_pretty(root, episodes_path);
-	json_value_free(root);
-
-	if (result == JSONSuccess) {
-		feed->episode_count = count;
-		return 0;
-	}
-
-	LOG_error("[Podcast] Failed to save episodes to %s\n", episodes_path);
-	return -1;
-}
-
-// Load a page of episodes from JSON file into cache
-int Podcast_loadEpisodePage(int feed_index, int offset) {
-	if (feed_index < 0 || feed_index >= subscription_count || offset < 0) {
-		return 0;
-	}
-
-	PodcastFeed* feed = &subscriptions[feed_index];
-
-	set_feed_id(feed);
-
-	char episodes_path[512];
-	get_episodes_file_path(feed->feed_id, episodes_path, sizeof(episodes_path));
-
-	JSON_Value* root = json_parse_file(episodes_path);
-	if (!root) {
-		LOG_error("[Podcast] Failed to load episodes from %s\n", episodes_path);
-		return 0;
-	}
 
 	JSON_Array* arr = json_value_get_array(root);
 	if (!arr) {
 		json_value_free(root);
-		return 0;
+		return -1;
 	}
 
 	int total = json_array_get_count(arr);
-	feed->episode_count = total; // Update total count
-
-	pthread_mutex_lock(&episode_cache_mutex);
-
-	episode_cache_feed_index = feed_index;
-	episode_cache_offset = offset;
-	episode_cache_count = 0;
+	PodcastEpisode* episodes = (PodcastEpisode*)calloc(total > 0 ? total : 1, sizeof(PodcastEpisode));
+	if (!episodes) {
+		json_value_free(root);
+		return -1;
+	}
 
-	for (int i = offset; i < total && episode_cache_count < PODCAST_EPISODE_PAGE_SIZE; i++) {
+	int count = 0;
+	for (int i = 0; i < total; i++) {
 		JSON_Object* ep_obj = json_array_get_object(arr, i);
 		if (!ep_obj)
 			continue;
 
-		PodcastEpisode* ep = &episode_cache[episode_cache_count];
-		memset(ep, 0, sizeof(PodcastEpisode));
+		PodcastEpisode* ep = &episodes[count++];
 
 		const char* str;
 		str = json_object_get_string(ep_obj, "guid");
@@ -449,22 +396,130 @@ int Podcast_loadEpisodePage(int feed_index, int offset) {
 		ep->progress_sec = (int)json_object_get_number(ep_obj, "progress");
 		ep->downloaded = json_object_get_boolean(ep_obj, "downloaded");
 		ep->is_new = (json_object_get_boolean(ep_obj, "is_new") == 1);
+	}
+
+	json_value_free(root);
+	*out = episodes;
+	return count;
+}
 
-		// Cross-reference with progress.json (more recent than episodes.json)
-		int cached_progress = Podcast_getProgress(feed->feed_url, ep->guid);
+// Open a feed's episode store, converting episodes.json on first use
+static PodcastStore* open_episode_store(PodcastFeed* feed) {
+	set_feed_id(feed);
+
+	char store_path[512];
+	get_episode_store_path(feed->feed_id, store_path, sizeof(store_path));
+	PodcastStore* store = PodcastStore_open(store_path);
+	if (store)
+		return store;
+
+	char episodes_path[512];
+	get_episodes_file_path(feed->feed_id, episodes_path, sizeof(episodes_path));
+	if (access(episodes_path, F_OK) != 0)
+		return NULL;
+
+	PodcastEpisode* episodes = NULL;
+	int count = load_episodes_json(episodes_path, &episodes);
+	if (count < 0) {
+		LOG_error("[Podcast] Failed to load episodes from %s\n", episodes_path);
+		return NULL;
+	}
+
+	// progress.json used to be overlaid on every page load, fold it in once
+	for (int i = 0; i < count; i++) {
+		int cached_progress = get_cached_progress(feed->feed_url, episodes[i].guid);
 		if (cached_progress != 0) {
-			ep->progress_sec = cached_progress;
+			episodes[i].progress_sec = cached_progress;
 		}
+	}
+
+	int result = PodcastStore_write(store_path, episodes, count);
+	free(episodes);
+	if (result != 0)
+		return NULL;
+
+	unlink(episodes_path);
+	LOG_info("[Podcast] Migrated %d episodes of %s to the episode store\n", count, feed->feed_id);
+	return PodcastStore_open(store_path);
+}
+
+// Save episodes to the feed's episode store
+int Podcast_saveEpisodes(int feed_index, PodcastEpisode* episodes, int count) {
+	if (feed_index < 0 || feed_index >= subscription_count || !episodes || count < 0) {
+		return -1;
+	}
+
+	PodcastFeed* feed = &subscriptions[feed_index];
+
+	set_feed_id(feed);
+
+	// Create feed directory
+	char feed_dir[512];
+	Podcast_getFeedDataPath(feed->feed_id, feed_dir, sizeof(feed_dir));
+	mkdir_recursive(feed_dir);
+
+	char store_path[512];
+	get_episode_store_path(feed->feed_id, store_path, sizeof(store_path));
+
+	pthread_mutex_lock(&episode_store_mutex);
+	int result = PodcastStore_write(store_path, episodes, count);
+	pthread_mutex_unlock(&episode_store_mutex);
 
-		episode_cache_count++;
+	if (result == 0) {
+		feed->episode_count = count;
+		return 0;
 	}
 
+	LOG_error("[Podcast] Failed to save episodes to %s\n", store_path);
+	return -1;
+}
+
+// Load a page of episodes from the episode store into cache
+int Podcast_loadEpisodePage(int feed_index, int offset) {
+	if (feed_index < 0 || feed_index >= subscription_count || offset < 0) {
+		return 0;
+	}
+
+	PodcastFeed* feed = &subscriptions[feed_index];
+
+	pthread_mutex_lock(&episode_store_mutex);
+	PodcastStore* store = open_episode_store(feed);
+	if (!store) {
+		pthread_mutex_unlock(&episode_store_mutex);
+		LOG_error("[Podcast] Failed to load episodes for %s\n", feed->feed_id);
+		return 0;
+	}
+
+	feed->episode_count = PodcastStore_getCount(store); // Update total count
+
+	pthread_mutex_lock(&episode_cache_mutex);
+
+	episode_cache_feed_index = feed_index;
+	episode_cache_offset = offset;
+	episode_cache_count = PodcastStore_readPage(store, offset, episode_cache, PODCAST_EPISODE_PAGE_SIZE);
+
 	pthread_mutex_unlock(&episode_cache_mutex);
-	json_value_free(root);
+
+	PodcastStore_close(store);
+	pthread_mutex_unlock(&episode_store_mutex);
 
 	return episode_cache_count;
 }
 
+// Find an episode's index by GUID through the store's hash index
+int Podcast_findEpisodeIndex(int feed_index, const char* guid) {
+	if (feed_index < 0 || feed_index >= subscription_count || !guid)
+		return -1;
+
+	PodcastFeed* feed = &subscriptions[feed_index];
+	pthread_mutex_lock(&episode_store_mutex);
+	PodcastStore* store = open_episode_store(feed);
+	int index = PodcastStore_find(store, guid);
+	PodcastStore_close(store);
+	pthread_mutex_unlock(&episode_store_mutex);
+	return index;
+}
+
 // Get episode by index (loads from cache, auto-loads page if needed)
 PodcastEpisode* Podcast_getEpisode(int feed_index, int episode_index) {
 	if (feed_index < 0 || feed_index >= subscription_count || episode_index < 0) {
@@ -664,16 +719,7 @@ int Podcast_init(void) {
 		strcpy(charts_country_code, "us");
 	}
 
-	// Load saved data
-	Podcast_loadSubscriptions();
-	Podcast_loadDownloadQueue();
-
-	// Auto-resume pending downloads if WiFi is already connected
-	if (download_queue_count > 0 && Wifi_isConnected()) {
-		Podcast_startDownloads();
-	}
-
-	// Load progress entries
+	// Load progress entries (before subscriptions, episode store migration folds them in)
 	JSON_Value* root = json_parse_file(progress_file);
 	if (root) {
 		JSON_Array* arr = json_value_get_array(root);
@@ -697,6 +743,15 @@ int Podcast_init(void) {
 		json_value_free(root);
 	}
 
+	// Load saved data
+	Podcast_loadSubscriptions();
+	Podcast_loadDownloadQueue();
+
+	// Auto-resume pending downloads if WiFi is already connected
+	if (download_queue_count > 0 && Wifi_isConnected()) {
+		Podcast_startDownloads();
+	}
+
 	// Load and validate continue listening entries
 	load_continue_listening();
 	validate_continue_listening();
@@ -767,61 +822,126 @@ PodcastFeed* Podcast_getSubscription(int index) {
 	return &subscriptions[index];
 }
 
-int Podcast_subscribe(const char* feed_url) {
-	if (!feed_url || subscription_count >= PODCAST_MAX_SUBSCRIPTIONS) {
-		return -1;
-	}
+// ============================================================================
+// Feed Fetching (streamed straight into the RSS parser)
+// ============================================================================
 
-	// Check if already subscribed
-	if (Podcast_isSubscribed(feed_url)) {
-		return 0; // Already subscribed, not an error
+#define FEED_MAX_EPISODES 2000 // Most podcasts have far fewer
+
+typedef struct {
+	PodcastRSSParser* parser;
+	PodcastStore* known;	  // Stop at the first episode stored here (NULL = parse everything)
+	bool reached_known;
+	bool out_of_memory;
+	PodcastEpisode* episodes; // Parsed episodes, grown as they arrive
+	int count;
+	int capacity;
+} FeedFetch;
+
+static bool fetch_feed_episode(const PodcastEpisode* episode, void* userdata) {
+	FeedFetch* ff = (FeedFetch*)userdata;
+	if (ff->known && PodcastStore_find(ff->known, episode->guid) >= 0) {
+		ff->reached_known = true;
+		return false; // Everything after it is already stored
+	}
+	if (ff->count >= FEED_MAX_EPISODES)
+		return true;
+
+	if (ff->count == ff->capacity) {
+		int capacity = ff->capacity ? ff->capacity * 2 : 16;
+		if (capacity > FEED_MAX_EPISODES)
+			capacity = FEED_MAX_EPISODES;
+		PodcastEpisode* grown = (PodcastEpisode*)realloc(ff->episodes, capacity * sizeof(PodcastEpisode));
+		if (!grown) {
+			ff->out_of_memory = true; // Not a deliberate stop, the list is incomplete
+			return false;
+		}
+		ff->episodes = grown;
+		ff->capacity = capacity;
 	}
+	memcpy(&ff->episodes[ff->count++], episode, sizeof(PodcastEpisode));
+	return true;
+}
+
+static bool fetch_feed_chunk(const uint8_t* data, int len, void* userdata) {
+	FeedFetch* ff = (FeedFetch*)userdata;
+	return podcast_rss_parser_feed(ff->parser, (const char*)data, len);
+}
 
-	// Fetch the feed
-	uint8_t* buffer = (uint8_t*)malloc(5 * 1024 * 1024); // 5MB buffer for large RSS feeds
-	if (!buffer) {
-		snprintf(error_message, sizeof(error_message), "Out of memory");
+// Fetch a feed, parsing it while it downloads. Channel metadata goes to meta,
+// episodes to ff->episodes. Returns bytes received (0 = not modified),
+// -1 if the fetch failed or was cut off, -2 if it isn't a valid (complete)
+// feed. Callers must not touch the store or validators unless it's > 0.
+static int fetch_feed(const char* url, PodcastFeed* meta, FeedFetch* ff,
+					  const char* etag, const char* last_modified, WgetFetchInfo* info) {
+	ff->parser = podcast_rss_parser_create(meta, fetch_feed_episode, ff);
+	if (!ff->parser)
 		return -1;
-	}
 
-	int bytes = wget_fetch(feed_url, buffer, 5 * 1024 * 1024);
-	if (bytes <= 0) {
-		LOG_error("[Podcast] Failed to fetch feed: %s\n", feed_url);
-		free(buffer);
-		snprintf(error_message, sizeof(error_message), "Failed to fetch feed");
+	int bytes = wget_fetch_stream(url, etag, last_modified, fetch_feed_chunk, ff, info);
+	int valid = podcast_rss_parser_finish(ff->parser);
+	ff->parser = NULL;
+
+	if (bytes <= 0)
+		return bytes;
+	if (ff->out_of_memory)
 		return -1;
-	}
+	return valid == 0 ? bytes : -2;
+}
+
+// Feeds normally list newest first. Only then does the first known GUID
+// mean everything after it is stored already.
+static bool store_is_newest_first(PodcastStore* store) {
+	int count = PodcastStore_getCount(store);
+	if (count < 2)
+		return false;
 
-	// Allocate temporary episodes array (parse all episodes from feed)
-	// Using 2000 as a reasonable max - most podcasts have far fewer
-	int max_episodes = 2000;
-	PodcastEpisode* temp_episodes = (PodcastEpisode*)malloc(max_episodes * sizeof(PodcastEpisode));
-	if (!temp_episodes) {
-		free(buffer);
-		snprintf(error_message, sizeof(error_message), "Out of memory");
+	PodcastEpisode first, last;
+	if (PodcastStore_readPage(store, 0, &first, 1) != 1 ||
+		PodcastStore_readPage(store, count - 1, &last, 1) != 1)
+		return false;
+	return first.pub_date != 0 && first.pub_date >= last.pub_date;
+}
+
+int Podcast_subscribe(const char* feed_url) {
+	if (!feed_url || subscription_count >= PODCAST_MAX_SUBSCRIPTIONS) {
 		return -1;
 	}
 
-	// Parse RSS into feed and episodes array
+	// Check if already subscribed
+	if (Podcast_isSubscribed(feed_url)) {
+		return 0; // Already subscribed, not an error
+	}
+
+	// Fetch and parse the feed into feed metadata and episodes
 	PodcastFeed temp_feed;
 	memset(&temp_feed, 0, sizeof(PodcastFeed));
 	strncpy(temp_feed.feed_url, feed_url, PODCAST_MAX_URL - 1);
 
-	int episode_count = 0;
-	int result = podcast_rss_parse_with_episodes((const char*)buffer, bytes, &temp_feed,
-												 temp_episodes, max_episodes, &episode_count);
-	free(buffer);
-
-	if (result != 0) {
+	FeedFetch ff = {0};
+	WgetFetchInfo info;
+	int result = fetch_feed(feed_url, &temp_feed, &ff, NULL, NULL, &info);
+	if (result == -2) {
 		LOG_error("[Podcast] Failed to parse feed: %s\n", feed_url);
-		free(temp_episodes);
+		free(ff.episodes);
 		snprintf(error_message, sizeof(error_message), "Invalid RSS feed");
 		return -1;
 	}
+	if (result <= 0) {
+		LOG_error("[Podcast] Failed to fetch feed: %s\n", feed_url);
+		free(ff.episodes);
+		snprintf(error_message, sizeof(error_message), "Failed to fetch feed");
+		return -1;
+	}
+
+	PodcastEpisode* temp_episodes = ff.episodes;
+	int episode_count = ff.count;
 
 	set_feed_id(&temp_feed);
 	temp_feed.last_updated = (uint32_t)time(NULL);
 	temp_feed.episode_count = episode_count;
+	strncpy(temp_feed.etag, info.etag, sizeof(temp_feed.etag) - 1);
+	strncpy(temp_feed.last_modified, info.last_modified, sizeof(temp_feed.last_modified) - 1);
 
 	// Add to subscriptions
 	pthread_mutex_lock(&subscriptions_mutex);
@@ -1000,99 +1120,121 @@ int Podcast_refreshFeed(int index) {
 
 	PodcastFeed* feed = &subscriptions[index];
 
-	uint8_t* buffer = (uint8_t*)malloc(5 * 1024 * 1024); // 5MB buffer for large RSS feeds
-	if (!buffer)
-		return -1;
+	// Snapshot what the fetch needs, other refresh workers share the array
+	char feed_url[PODCAST_MAX_URL];
+	char etag[sizeof(feed->etag)];
+	char last_modified[sizeof(feed->last_modified)];
+	pthread_mutex_lock(&subscriptions_mutex);
+	set_feed_id(feed);
+	strcpy(feed_url, feed->feed_url);
+	strcpy(etag, feed->etag);
+	strcpy(last_modified, feed->last_modified);
+	pthread_mutex_unlock(&subscriptions_mutex);
+
+	pthread_mutex_lock(&episode_store_mutex);
+	PodcastStore* known = open_episode_store(feed);
+	pthread_mutex_unlock(&episode_store_mutex);
 
-	int bytes = wget_fetch(feed->feed_url, buffer, 5 * 1024 * 1024);
-	if (bytes <= 0) {
-		free(buffer);
+	// Parse into temporary feed. Newest-first feeds stop at the first known
+	// episode, the rest of the body isn't even downloaded.
+	PodcastFeed temp_feed;
+	memset(&temp_feed, 0, sizeof(temp_feed));
+	strncpy(temp_feed.feed_url, feed_url, PODCAST_MAX_URL - 1);
+
+	FeedFetch ff = {0};
+	if (known && store_is_newest_first(known))
+		ff.known = known;
+
+	// Validators are only worth sending if there's a store to fall back on
+	WgetFetchInfo info;
+	int bytes = fetch_feed(feed_url, &temp_feed, &ff, known ? etag : NULL, known ? last_modified : NULL, &info);
+	PodcastStore_close(known);
+
+	if (bytes < 0) {
+		free(ff.episodes);
 		return -1;
 	}
 
-	// Allocate temporary episodes array
-	int max_episodes = 2000;
-	PodcastEpisode* new_episodes = (PodcastEpisode*)malloc(max_episodes * sizeof(PodcastEpisode));
-	if (!new_episodes) {
-		free(buffer);
-		return -1;
+	if (bytes == 0) {
+		// 304 Not Modified
+		pthread_mutex_lock(&subscriptions_mutex);
+		if (info.etag[0])
+			strcpy(feed->etag, info.etag);
+		if (info.last_modified[0])
+			strcpy(feed->last_modified, info.last_modified);
+		feed->last_updated = (uint32_t)time(NULL);
+		pthread_mutex_unlock(&subscriptions_mutex);
+		return 0;
 	}
 
-	// Parse into temporary feed
-	PodcastFeed temp_feed;
-	memset(&temp_feed, 0, sizeof(temp_feed));
-	strncpy(temp_feed.feed_url, feed->feed_url, PODCAST_MAX_URL - 1);
+	char store_path[512];
+	get_episode_store_path(feed->feed_id, store_path, sizeof(store_path));
 
-	int new_episode_count = 0;
-	if (podcast_rss_parse_with_episodes((const char*)buffer, bytes, &temp_feed,
-										new_episodes, max_episodes, &new_episode_count) == 0) {
-		// Load existing episodes to preserve progress/downloaded status
-		char episodes_path[512];
-		set_feed_id(feed);
-		get_episodes_file_path(feed->feed_id, episodes_path, sizeof(episodes_path));
-
-		JSON_Value* old_root = json_parse_file(episodes_path);
-		if (old_root) {
-			JSON_Array* old_arr = json_value_get_array(old_root);
-			if (old_arr) {
-				int old_count = json_array_get_count(old_arr);
-				// Preserve progress for matching episodes, detect new ones
-				for (int i = 0; i < new_episode_count; i++) {
-					bool found_in_old = false;
-					for (int j = 0; j < old_count; j++) {
-						JSON_Object* old_ep = json_array_get_object(old_arr, j);
-						const char* old_guid = json_object_get_string(old_ep, "guid");
-						if (old_guid && strcmp(new_episodes[i].guid, old_guid) == 0) {
-							new_episodes[i].progress_sec = (int)json_object_get_number(old_ep, "progress");
-							new_episodes[i].downloaded = json_object_get_boolean(old_ep, "downloaded");
-							const char* local = json_object_get_string(old_ep, "local_path");
-							if (local)
-								strncpy(new_episodes[i].local_path, local, PODCAST_MAX_URL - 1);
-							new_episodes[i].is_new = (json_object_get_boolean(old_ep, "is_new") == 1);
-							found_in_old = true;
-							break;
-						}
-					}
-					if (!found_in_old) {
-						new_episodes[i].is_new = true; // Brand new episode
-					}
+	// Hold the store until the new one is written so in-place progress
+	// updates made meanwhile aren't lost with the old file
+	pthread_mutex_lock(&episode_store_mutex);
+
+	int result;
+	if (ff.reached_known) {
+		// Only the new items were parsed, they go in front of the stored ones
+		for (int i = 0; i < ff.count; i++) {
+			ff.episodes[i].is_new = true;
+		}
+		result = PodcastStore_prepend(store_path, ff.episodes, ff.count);
+	} else {
+		// Preserve progress/downloaded status of known episodes, detect new ones
+		PodcastStore* old_store = open_episode_store(feed);
+		if (old_store) {
+			PodcastEpisode old_ep;
+			for (int i = 0; i < ff.count; i++) {
+				int j = PodcastStore_find(old_store, ff.episodes[i].guid);
+				if (j >= 0 && PodcastStore_readPage(old_store, j, &old_ep, 1) == 1) {
+					ff.episodes[i].progress_sec = old_ep.progress_sec;
+					ff.episodes[i].downloaded = old_ep.downloaded;
+					memcpy(ff.episodes[i].local_path, old_ep.local_path, PODCAST_MAX_URL);
+					ff.episodes[i].is_new = old_ep.is_new;
+				} else {
+					ff.episodes[i].is_new = true; // Brand new episode
 				}
 			}
-			json_value_free(old_root);
+			PodcastStore_close(old_store);
 		}
+		result = PodcastStore_write(store_path, ff.episodes, ff.count);
+	}
 
-		// Update feed metadata
-		pthread_mutex_lock(&subscriptions_mutex);
-		strncpy(feed->title, temp_feed.title, PODCAST_MAX_TITLE - 1);
-		strncpy(feed->author, temp_feed.author, PODCAST_MAX_AUTHOR - 1);
-		strncpy(feed->description, temp_feed.description, PODCAST_MAX_DESCRIPTION - 1);
-		// Only update artwork if we didn't have it from iTunes
-		if (!feed->artwork_url[0] && temp_feed.artwork_url[0]) {
-			strncpy(feed->artwork_url, temp_feed.artwork_url, PODCAST_MAX_URL - 1);
-		}
-		feed->episode_count = new_episode_count;
-		feed->last_updated = (uint32_t)time(NULL);
-		pthread_mutex_unlock(&subscriptions_mutex);
+	PodcastStore* store = (result == 0) ? PodcastStore_open(store_path) : NULL;
+	int episode_count = PodcastStore_getCount(store);
+	int new_count = PodcastStore_getNewCount(store);
+	PodcastStore_close(store);
+	pthread_mutex_unlock(&episode_store_mutex);
+	free(ff.episodes);
 
-		// Save new episodes to disk
-		Podcast_saveEpisodes(index, new_episodes, new_episode_count);
+	if (result != 0) {
+		LOG_error("[Podcast] Failed to save episodes to %s\n", store_path);
+		return -1;
+	}
 
-		// Recount new_episode_count from the episodes we just saved
-		int nc = 0;
-		for (int i = 0; i < new_episode_count; i++) {
-			if (new_episodes[i].is_new)
-				nc++;
-		}
-		feed->new_episode_count = nc;
+	// Update feed metadata
+	pthread_mutex_lock(&subscriptions_mutex);
+	strncpy(feed->title, temp_feed.title, PODCAST_MAX_TITLE - 1);
+	strncpy(feed->author, temp_feed.author, PODCAST_MAX_AUTHOR - 1);
+	strncpy(feed->description, temp_feed.description, PODCAST_MAX_DESCRIPTION - 1);
+	// Only update artwork if we didn't have it from iTunes
+	if (!feed->artwork_url[0] && temp_feed.artwork_url[0]) {
+		strncpy(feed->artwork_url, temp_feed.artwork_url, PODCAST_MAX_URL - 1);
+	}
+	strcpy(feed->etag, info.etag);
+	strcpy(feed->last_modified, info.last_modified);
+	feed->episode_count = episode_count;
+	feed->new_episode_count = new_count;
+	feed->last_updated = (uint32_t)time(NULL);
+	pthread_mutex_unlock(&subscriptions_mutex);
 
-		// Invalidate cache if this feed was cached
-		if (episode_cache_feed_index == index) {
-			Podcast_invalidateEpisodeCache();
-		}
+	// Invalidate cache if this feed was cached
+	if (episode_cache_feed_index == index) {
+		Podcast_invalidateEpisodeCache();
 	}
 
-	free(new_episodes);
-	free(buffer);
 	return 0;
 }
 
@@ -1119,8 +1261,10 @@ void Podcast_saveSubscriptions(void) {
 		json_object_set_string(feed_obj, "artwork_url", feed->artwork_url);
 		json_object_set_number(feed_obj, "last_updated", feed->last_updated);
 		json_object_set_number(feed_obj, "episode_count", feed->episode_count);
-		// Note: episodes are stored separately in <feed_id>/episodes.json
-		// new_episode_count is computed dynamically from episodes.json
+		json_object_set_string(feed_obj, "etag", feed->etag);
+		json_object_set_string(feed_obj, "last_modified", feed->last_modified);
+		// Note: episodes are stored separately in <feed_id>/episodes.bin
+		// new_episode_count is read from the episode store header
 
 		json_array_append_value(arr, feed_val);
 	}
@@ -1175,6 +1319,12 @@ void Podcast_loadSubscriptions(void) {
 		str = json_object_get_string(feed_obj, "artwork_url");
 		if (str)
 			strncpy(feed->artwork_url, str, PODCAST_MAX_URL - 1);
+		str = json_object_get_string(feed_obj, "etag");
+		if (str)
+			strncpy(feed->etag, str, sizeof(feed->etag) - 1);
+		str = json_object_get_string(feed_obj, "last_modified");
+		if (str)
+			strncpy(feed->last_modified, str, sizeof(feed->last_modified) - 1);
 
 		feed->last_updated = (uint32_t)json_object_get_number(feed_obj, "last_updated");
 		feed->episode_count = (int)json_object_get_number(feed_obj, "episode_count");
@@ -1188,27 +1338,17 @@ void Podcast_loadSubscriptions(void) {
 	}
 	pthread_mutex_unlock(&subscriptions_mutex);
 
-	// Compute new_episode_count dynamically from each feed's episodes.json
+	// new_episode_count comes from each feed's episode store header (no scan)
+	pthread_mutex_lock(&episode_store_mutex);
 	for (int i = 0; i < subscription_count; i++) {
 		PodcastFeed* feed = &subscriptions[i];
-		feed->new_episode_count = 0;
-		char episodes_path[512];
-		get_episodes_file_path(feed->feed_id, episodes_path, sizeof(episodes_path));
-		JSON_Value* ep_root = json_parse_file(episodes_path);
-		if (ep_root) {
-			JSON_Array* ep_arr = json_value_get_array(ep_root);
-			if (ep_arr) {
-				int ep_count = json_array_get_count(ep_arr);
-				for (int j = 0; j < ep_count; j++) {
-					JSON_Object* ep_obj = json_array_get_object(ep_arr, j);
-					if (ep_obj && json_object_get_boolean(ep_obj, "is_new") == 1) {
-						feed->new_episode_count++;
-					}
-				}
-			}
-			json_value_free(ep_root);
-		}
+		PodcastStore* store = open_episode_store(feed);
+		feed->new_episode_count = PodcastStore_getNewCount(store);
+		if (store)
+			feed->episode_count = PodcastStore_getCount(store);
+		PodcastStore_close(store);
 	}
+	pthread_mutex_unlock(&episode_store_mutex);
 
 	json_value_free(root);
 }
@@ -1608,11 +1748,36 @@ bool Podcast_isDownloading(void) {
 // Progress Tracking
 // ============================================================================
 
+// Write progress straight into the feed's episode store. Returns false if the
+// episode isn't in a subscribed feed's store.
+static bool store_progress(const char* feed_url, const char* episode_guid, int* position_sec, bool write) {
+	int feed_idx = Podcast_findFeedIndex(feed_url);
+	if (feed_idx < 0)
+		return false;
+
+	pthread_mutex_lock(&episode_store_mutex);
+	PodcastStore* store = open_episode_store(&subscriptions[feed_idx]);
+	int index = PodcastStore_find(store, episode_guid);
+	bool found = index >= 0;
+	if (found) {
+		if (write) {
+			found = PodcastStore_setProgress(store, index, *position_sec) == 0;
+		} else {
+			*position_sec = PodcastStore_getProgress(store, index);
+		}
+	}
+	PodcastStore_close(store);
+	pthread_mutex_unlock(&episode_store_mutex);
+	return found;
+}
+
 void Podcast_saveProgress(const char* feed_url, const char* episode_guid, int position_sec) {
 	if (!feed_url || !episode_guid)
 		return;
 
-	// Find existing entry or add new one
+	bool stored = store_progress(feed_url, episode_guid, &position_sec, true);
+
+	// Keep any older entry in step, the store takes precedence when reading
 	for (int i = 0; i < progress_entry_count; i++) {
 		if (strcmp(progress_entries[i].feed_url, feed_url) == 0 &&
 			strcmp(progress_entries[i].episode_guid, episode_guid) == 0) {
@@ -1620,6 +1785,8 @@ void Podcast_saveProgress(const char* feed_url, const char* episode_guid, int po
 			return;
 		}
 	}
+	if (stored)
+		return;
 
 	// Add new entry
 	if (progress_entry_count < MAX_PROGRESS_ENTRIES) {
@@ -1634,6 +1801,14 @@ int Podcast_getProgress(const char* feed_url, const char* episode_guid) {
 	if (!feed_url || !episode_guid)
 		return 0;
 
+	int position_sec = 0;
+	if (store_progress(feed_url, episode_guid, &position_sec, false))
+		return position_sec;
+	return get_cached_progress(feed_url, episode_guid);
+}
+
+// Progress kept outside the episode stores (progress.json)
+static int get_cached_progress(const char* feed_url, const char* episode_guid) {
 	for (int i = 0; i < progress_entry_count; i++) {
 		if (strcmp(progress_entries[i].feed_url, feed_url) == 0 &&
 			strcmp(progress_entries[i].episode_guid, episode_guid) == 0) {
@@ -2164,6 +2339,22 @@ int Podcast_getDownloadedEpisodeIndex(int feed_index, int episode_index) {
 // Background Feed Refresh
 // ============================================================================
 
+// Takes feeds off the shared queue until it's empty
+static void* refresh_worker_func(void* arg) {
+	(void)arg;
+	PWR_pinToCores(CPU_CORE_EFFICIENCY);
+
+	while (refresh_running) {
+		pthread_mutex_lock(&refresh_queue_mutex);
+		int i = refresh_next_index++;
+		pthread_mutex_unlock(&refresh_queue_mutex);
+		if (i >= refresh_end_index || i >= subscription_count)
+			break;
+		Podcast_refreshFeed(i);
+	}
+	return NULL;
+}
+
 static void* refresh_thread_func(void* arg) {
 	(void)arg;
 	PWR_pinToCores(CPU_CORE_EFFICIENCY);
@@ -2172,14 +2363,23 @@ static void* refresh_thread_func(void* arg) {
 		// Refresh single feed
 		Podcast_refreshFeed(refresh_feed_index);
 	} else {
-		// Refresh all feeds - snapshot count to avoid race with unsubscribe
+		// Refresh all feeds - snapshot count to avoid race with unsubscribe.
+		// A refresh mostly waits on the network, so run a few at once.
 		pthread_mutex_lock(&subscriptions_mutex);
 		int count = subscription_count;
 		pthread_mutex_unlock(&subscriptions_mutex);
-		for (int i = 0; i < count && i < subscription_count; i++) {
-			if (!refresh_running)
-				break;
-			Podcast_refreshFeed(i);
+
+		refresh_next_index = 0;
+		refresh_end_index = count;
+		pthread_t workers[REFRESH_MAX_WORKERS - 1];
+		int started = 0;
+		for (int w = 1; w < REFRESH_MAX_WORKERS && w < count; w++) {
+			if (pthread_create(&workers[started], NULL, refresh_worker_func, NULL) == 0)
+				started++;
+		}
+		refresh_worker_func(NULL); // This thread works the queue too
+		for (int w = 0; w < started; w++) {
+			pthread_join(workers[w], NULL);
 		}
 	}
 
@@ -2271,28 +2471,15 @@ void Podcast_clearNewFlag(int feed_index, int episode_index) {
 		feed->new_episode_count--;
 	}
 
-	// Update the on-disk episodes.json
-	set_feed_id(feed);
-	char episodes_path[512];
-	get_episodes_file_path(feed->feed_id, episodes_path, sizeof(episodes_path));
-
-	JSON_Value* root = json_parse_file(episodes_path);
-	if (root) {
-		JSON_Array* arr = json_value_get_array(root);
-		if (arr) {
-			int total = json_array_get_count(arr);
-			for (int i = 0; i < total; i++) {
-				JSON_Object* obj = json_array_get_object(arr, i);
-				const char* guid = json_object_get_string(obj, "guid");
-				if (guid && strcmp(guid, guid_copy) == 0) {
-					json_object_set_boolean(obj, "is_new", false);
-					break;
-				}
-			}
-			json_serialize_to_file_pretty(root, episodes_path);
-		}
-		json_value_free(root);
+	// Update the record in place
+	pthread_mutex_lock(&episode_store_mutex);
+	PodcastStore* store = open_episode_store(feed);
+	int index = PodcastStore_find(store, guid_copy);
+	if (index >= 0) {
+		PodcastStore_setNew(store, index, false);
 	}
+	PodcastStore_close(store);
+	pthread_mutex_unlock(&episode_store_mutex);
 }
 
 // ============================================================================
@@ -2480,16 +2667,8 @@ static void validate_continue_listening(void) {
 
 		// Check audio file exists
 		PodcastFeed* feed = &subscriptions[feed_idx];
-		bool file_found = false;
-		for (int ei = 0; ei < feed->episode_count; ei++) {
-			PodcastEpisode* ep = Podcast_getEpisode(feed_idx, ei);
-			if (ep && strcmp(ep->guid, e->episode_guid) == 0) {
-				if (Podcast_episodeFileExists(feed, ei)) {
-					file_found = true;
-				}
-				break;
-			}
-		}
+		int ei = Podcast_findEpisodeIndex(feed_idx, e->episode_guid);
+		bool file_found = ei >= 0 && Podcast_episodeFileExists(feed, ei);
 		if (!file_found) {
 			for (int j = i; j < continue_listening_count - 1; j++) {
 				memcpy(&continue_listening[j], &continue_listening[j + 1], sizeof(ContinueListeningEntry));
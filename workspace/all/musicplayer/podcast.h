@@ -63,6 +63,8 @@ typedef struct {
 	int episode_count;	   // Total episodes (stored on disk)
 	uint32_t last_updated; // Unix timestamp
 	int new_episode_count; // Count of episodes with is_new == true
+	char etag[128];		   // Validators of the last fetch, for conditional refresh
+	char last_modified[64];
 } PodcastFeed;
 
 // iTunes search result
@@ -327,12 +329,15 @@ int Podcast_loadEpisodePage(int feed_index, int offset);
 // Invalidate episode cache (call when switching feeds)
 void Podcast_invalidateEpisodeCache(void);
 
-// Save episodes to disk (called after RSS parse)
+// Save episodes to the feed's episode store (called after RSS parse)
 int Podcast_saveEpisodes(int feed_index, PodcastEpisode* episodes, int count);
 
 // Get total episode count for a feed (from metadata, no disk read)
 int Podcast_getEpisodeCount(int feed_index);
 
+// Find an episode's index by GUID, -1 if the feed doesn't have it
+int Podcast_findEpisodeIndex(int feed_index, const char* guid);
+
 // Get path to feed's data directory
 void Podcast_getFeedDataPath(const char* feed_id, char* path, int path_size);
 
@@ -360,4 +365,15 @@ int podcast_rss_parse_with_episodes(const char* xml_data, int xml_len, PodcastFe
 									PodcastEpisode* episodes_out, int max_episodes,
 									int* episode_count_out);
 
+// Incremental parser for feeds streamed in chunks. on_episode is called for
+// every complete item, returning false stops parsing.
+typedef struct PodcastRSSParser PodcastRSSParser;
+typedef bool (*PodcastRSSEpisodeCallback)(const PodcastEpisode* episode, void* userdata);
+PodcastRSSParser* podcast_rss_parser_create(PodcastFeed* feed, PodcastRSSEpisodeCallback on_episode, void* userdata);
+// Returns false once parsing was stopped
+bool podcast_rss_parser_feed(PodcastRSSParser* parser, const char* data, int len);
+// Frees the parser. Returns 0 if a valid feed (with a title) was read to the end
+// of its document or stopped by on_episode, -1 otherwise (e.g. truncated).
+int podcast_rss_parser_finish(PodcastRSSParser* parser);
+
 #endif // __PODCAST_H__
@@ -0,0 +1,560 @@
+#define _GNU_SOURCE
+#include "podcast_store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "defines.h"
+#include "api.h"
+
+#define STORE_MAGIC 0x50454E58 // "XNEP"
+#define STORE_VERSION 1
+#define STORE_MIN_SLOTS 16
+
+#define STORE_FLAG_DOWNLOADED 0x01
+#define STORE_FLAG_NEW 0x02
+
+// Strings of a record, stored back to back (NUL terminated) in the heap
+enum {
+	FIELD_GUID,
+	FIELD_TITLE,
+	FIELD_URL,
+	FIELD_DESCRIPTION,
+	FIELD_LOCAL_PATH,
+	FIELD_COUNT
+};
+
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t record_size;
+	uint32_t count;
+	uint32_t new_count;
+	uint32_t index_slots; // Power of two, slot = record index + 1 (0 = empty)
+	uint32_t heap_size;
+} StoreHeader;
+
+typedef struct {
+	uint32_t guid_hash;
+	uint32_t heap_offset; // Relative to the start of the heap
+	uint16_t len[FIELD_COUNT];
+	uint16_t flags;
+	int32_t duration_sec;
+	uint32_t pub_date;
+	int32_t progress_sec;
+} StoreRecord;
+
+struct PodcastStore {
+	int fd;
+	StoreHeader header;
+	off_t records_offset;
+	off_t index_offset;
+	off_t heap_offset;
+	uint32_t* index; // Loaded on first lookup
+};
+
+static uint32_t guid_hash(const char* guid) {
+	// FNV-1a
+	uint32_t h = 2166136261u;
+	for (const unsigned char* p = (const unsigned char*)guid; *p; p++) {
+		h ^= *p;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static uint32_t record_span(const StoreRecord* rec) {
+	uint32_t span = 0;
+	for (int f = 0; f < FIELD_COUNT; f++)
+		span += rec->len[f] + 1;
+	return span;
+}
+
+static void set_offsets(PodcastStore* store) {
+	store->records_offset = sizeof(StoreHeader);
+	store->index_offset = store->records_offset + (off_t)store->header.count * sizeof(StoreRecord);
+	store->heap_offset = store->index_offset + (off_t)store->header.index_slots * sizeof(uint32_t);
+}
+
+static bool read_full(int fd, void* buf, size_t size, off_t offset) {
+	return pread(fd, buf, size, offset) == (ssize_t)size;
+}
+
+static bool write_full(int fd, const void* buf, size_t size, off_t offset) {
+	return pwrite(fd, buf, size, offset) == (ssize_t)size;
+}
+
+// ============================================================================
+// Writing
+// ============================================================================
+
+static size_t field_len(const char* str, size_t size) {
+	size_t len = strnlen(str, size - 1);
+	return len > UINT16_MAX ? UINT16_MAX : len;
+}
+
+// Records and string heap for a run of episodes
+typedef struct {
+	StoreRecord* records;
+	char* heap;
+	size_t heap_size;
+	uint32_t new_count;
+} EncodedEpisodes;
+
+static void encoded_free(EncodedEpisodes* enc) {
+	free(enc->records);
+	free(enc->heap);
+}
+
+static int encode_episodes(const PodcastEpisode* episodes, int count, EncodedEpisodes* enc) {
+	memset(enc, 0, sizeof(*enc));
+	size_t heap_capacity = 64 * 1024;
+	enc->records = calloc(count > 0 ? count : 1, sizeof(StoreRecord));
+	enc->heap = malloc(heap_capacity);
+	if (!enc->records || !enc->heap) {
+		encoded_free(enc);
+		return -1;
+	}
+
+	for (int i = 0; i < count; i++) {
+		const PodcastEpisode* ep = &episodes[i];
+		StoreRecord* rec = &enc->records[i];
+		const char* fields[FIELD_COUNT] = {ep->guid, ep->title, ep->url, ep->description, ep->local_path};
+		const size_t sizes[FIELD_COUNT] = {sizeof(ep->guid), sizeof(ep->title), sizeof(ep->url),
+										   sizeof(ep->description), sizeof(ep->local_path)};
+
+		size_t span = 0;
+		for (int f = 0; f < FIELD_COUNT; f++) {
+			rec->len[f] = (uint16_t)field_len(fields[f], sizes[f]);
+			span += rec->len[f] + 1;
+		}
+		if (enc->heap_size + span > heap_capacity) {
+			while (enc->heap_size + span > heap_capacity)
+				heap_capacity *= 2;
+			char* grown = realloc(enc->heap, heap_capacity);
+			if (!grown) {
+				encoded_free(enc);
+				return -1;
+			}
+			enc->heap = grown;
+		}
+
+		rec->heap_offset = (uint32_t)enc->heap_size;
+		for (int f = 0; f < FIELD_COUNT; f++) {
+			memcpy(enc->heap + enc->heap_size, fields[f], rec->len[f]);
+			enc->heap_size += rec->len[f];
+			enc->heap[enc->heap_size++] = '\0';
+		}
+
+		rec->guid_hash = guid_hash(enc->heap + rec->heap_offset);
+		rec->flags = (ep->downloaded ? STORE_FLAG_DOWNLOADED : 0) | (ep->is_new ? STORE_FLAG_NEW : 0);
+		rec->duration_sec = ep->duration_sec;
+		rec->pub_date = ep->pub_date;
+		rec->progress_sec = ep->progress_sec;
+		if (ep->is_new)
+			enc->new_count++;
+	}
+	return 0;
+}
+
+static uint32_t index_slots_for(int count) {
+	uint32_t slots = STORE_MIN_SLOTS;
+	while (slots < (uint32_t)count * 2) // Load factor <= 0.5
+		slots <<= 1;
+	return slots;
+}
+
+// Returns the NUL terminated GUID of rec, buf has PODCAST_MAX_GUID bytes
+typedef const char* (*GuidLookup)(void* ctx, const StoreRecord* rec, char* buf);
+
+static void build_index(const StoreRecord* records, int count, uint32_t* index, uint32_t slots,
+						GuidLookup guid_at, void* ctx) {
+	uint32_t mask = slots - 1;
+	char a[PODCAST_MAX_GUID];
+	char b[PODCAST_MAX_GUID];
+	for (int i = 0; i < count; i++) {
+		const StoreRecord* rec = &records[i];
+		if (rec->len[FIELD_GUID] == 0)
+			continue;
+
+		// Duplicate GUIDs keep their first record, like the old linear search
+		for (uint32_t s = rec->guid_hash & mask;; s = (s + 1) & mask) {
+			if (!index[s]) {
+				index[s] = (uint32_t)i + 1;
+				break;
+			}
+			const StoreRecord* other = &records[index[s] - 1];
+			if (other->guid_hash == rec->guid_hash && other->len[FIELD_GUID] == rec->len[FIELD_GUID]) {
+				const char* ga = guid_at(ctx, other, a);
+				const char* gb = guid_at(ctx, rec, b);
+				if (ga && gb && strcmp(ga, gb) == 0)
+					break;
+			}
+		}
+	}
+}
+
+static const char* heap_guid(void* ctx, const StoreRecord* rec, char* buf) {
+	(void)buf;
+	return (const char*)ctx + rec->heap_offset;
+}
+
+// Write a store to a temp file and move it into place. The heap is heap
+// followed by old_heap_size bytes copied from old_fd (prepend).
+static int write_store_file(const char* path, const StoreHeader* header, const StoreRecord* records,
+							const uint32_t* index, const char* heap, size_t heap_size,
+							int old_fd, off_t old_heap_offset, size_t old_heap_size) {
+	char tmp_path[512];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	FILE* f = fopen(tmp_path, "wb");
+	if (!f) {
+		LOG_error("[PodcastStore] Failed to write %s\n", path);
+		return -1;
+	}
+
+	bool ok = fwrite(header, sizeof(*header), 1, f) == 1 &&
+			  (header->count == 0 || fwrite(records, sizeof(StoreRecord), header->count, f) == header->count) &&
+			  fwrite(index, sizeof(uint32_t), header->index_slots, f) == header->index_slots &&
+			  (heap_size == 0 || fwrite(heap, 1, heap_size, f) == heap_size);
+
+	char chunk[64 * 1024];
+	for (size_t done = 0; ok && done < old_heap_size;) {
+		size_t n = old_heap_size - done < sizeof(chunk) ? old_heap_size - done : sizeof(chunk);
+		ok = read_full(old_fd, chunk, n, old_heap_offset + (off_t)done) && fwrite(chunk, 1, n, f) == n;
+		done += n;
+	}
+
+	ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+	ok = (fclose(f) == 0) && ok;
+	if (ok && rename(tmp_path, path) == 0)
+		return 0;
+
+	unlink(tmp_path);
+	LOG_error("[PodcastStore] Failed to write %s\n", path);
+	return -1;
+}
+
+int PodcastStore_write(const char* path, const PodcastEpisode* episodes, int count) {
+	if (!path || (count > 0 && !episodes) || count < 0)
+		return -1;
+
+	EncodedEpisodes enc;
+	if (encode_episodes(episodes, count, &enc) != 0)
+		return -1;
+
+	uint32_t slots = index_slots_for(count);
+	uint32_t* index = calloc(slots, sizeof(uint32_t));
+	if (!index) {
+		encoded_free(&enc);
+		return -1;
+	}
+	build_index(enc.records, count, index, slots, heap_guid, enc.heap);
+
+	StoreHeader header = {
+		.magic = STORE_MAGIC,
+		.version = STORE_VERSION,
+		.record_size = sizeof(StoreRecord),
+		.count = (uint32_t)count,
+		.new_count = enc.new_count,
+		.index_slots = slots,
+		.heap_size = (uint32_t)enc.heap_size,
+	};
+	int result = write_store_file(path, &header, enc.records, index, enc.heap, enc.heap_size, -1, 0, 0);
+
+	free(index);
+	encoded_free(&enc);
+	return result;
+}
+
+typedef struct {
+	const char* heap; // Heap of the prepended episodes
+	size_t heap_size;
+	PodcastStore* old;
+} PrependGuids;
+
+static const char* prepend_guid(void* ctx, const StoreRecord* rec, char* buf) {
+	PrependGuids* p = (PrependGuids*)ctx;
+	if (rec->heap_offset < p->heap_size)
+		return p->heap + rec->heap_offset;
+
+	uint16_t len = rec->len[FIELD_GUID];
+	if (len >= PODCAST_MAX_GUID ||
+		!read_full(p->old->fd, buf, len, p->old->heap_offset + (rec->heap_offset - p->heap_size)))
+		return NULL;
+	buf[len] = '\0';
+	return buf;
+}
+
+int PodcastStore_prepend(const char* path, const PodcastEpisode* episodes, int count) {
+	if (!path || (count > 0 && !episodes) || count < 0)
+		return -1;
+
+	PodcastStore* old = PodcastStore_open(path);
+	if (!old)
+		return PodcastStore_write(path, episodes, count);
+	if (count == 0) {
+		PodcastStore_close(old);
+		return 0;
+	}
+
+	EncodedEpisodes enc;
+	if (encode_episodes(episodes, count, &enc) != 0) {
+		PodcastStore_close(old);
+		return -1;
+	}
+
+	int result = -1;
+	int old_count = (int)old->header.count;
+	int total = count + old_count;
+	uint64_t total_heap = (uint64_t)enc.heap_size + old->header.heap_size;
+	uint32_t slots = index_slots_for(total);
+	StoreRecord* records = malloc(total * sizeof(StoreRecord));
+	uint32_t* index = calloc(slots, sizeof(uint32_t));
+	if (!records || !index || total_heap > UINT32_MAX)
+		goto done;
+
+	// Existing records follow the new ones, their strings after the new heap
+	memcpy(records, enc.records, count * sizeof(StoreRecord));
+	if (old_count > 0 &&
+		!read_full(old->fd, records + count, old_count * sizeof(StoreRecord), old->records_offset))
+		goto done;
+	for (int i = count; i < total; i++)
+		records[i].heap_offset += (uint32_t)enc.heap_size;
+
+	PrependGuids ctx = {enc.heap, enc.heap_size, old};
+	build_index(records, total, index, slots, prepend_guid, &ctx);
+
+	StoreHeader header = {
+		.magic = STORE_MAGIC,
+		.version = STORE_VERSION,
+		.record_size = sizeof(StoreRecord),
+		.count = (uint32_t)total,
+		.new_count = enc.new_count + old->header.new_count,
+		.index_slots = slots,
+		.heap_size = (uint32_t)total_heap,
+	};
+	result = write_store_file(path, &header, records, index, enc.heap, enc.heap_size,
+							  old->fd, old->heap_offset, old->header.heap_size);
+
+done:
+	free(records);
+	free(index);
+	encoded_free(&enc);
+	PodcastStore_close(old);
+	return result;
+}
+
+// ============================================================================
+// Reading
+// ============================================================================
+
+PodcastStore* PodcastStore_open(const char* path) {
+	if (!path)
+		return NULL;
+
+	int fd = open(path, O_RDWR);
+	if (fd < 0)
+		return NULL;
+
+	PodcastStore* store = calloc(1, sizeof(PodcastStore));
+	if (!store) {
+		close(fd);
+		return NULL;
+	}
+	store->fd = fd;
+
+	struct stat st;
+	StoreHeader* h = &store->header;
+	if (!read_full(fd, h, sizeof(*h), 0) || h->magic != STORE_MAGIC || h->version != STORE_VERSION ||
+		h->record_size != sizeof(StoreRecord) || h->index_slots == 0 ||
+		(h->index_slots & (h->index_slots - 1)) != 0 || fstat(fd, &st) != 0) {
+		LOG_error("[PodcastStore] Not a valid episode store: %s\n", path);
+		PodcastStore_close(store);
+		return NULL;
+	}
+
+	set_offsets(store);
+	if (st.st_size < store->heap_offset + (off_t)h->heap_size) {
+		LOG_error("[PodcastStore] Truncated episode store: %s\n", path);
+		PodcastStore_close(store);
+		return NULL;
+	}
+	return store;
+}
+
+void PodcastStore_close(PodcastStore* store) {
+	if (!store)
+		return;
+	if (store->fd >= 0)
+		close(store->fd);
+	free(store->index);
+	free(store);
+}
+
+int PodcastStore_getCount(PodcastStore* store) {
+	return store ? (int)store->header.count : 0;
+}
+
+int PodcastStore_getNewCount(PodcastStore* store) {
+	return store ? (int)store->header.new_count : 0;
+}
+
+static bool read_record(PodcastStore* store, int index, StoreRecord* rec) {
+	if (index < 0 || (uint32_t)index >= store->header.count)
+		return false;
+	return read_full(store->fd, rec, sizeof(*rec), store->records_offset + (off_t)index * sizeof(StoreRecord));
+}
+
+static void copy_field(char* dst, size_t dst_size, const char* src, uint16_t len) {
+	size_t n = len < dst_size - 1 ? len : dst_size - 1;
+	memcpy(dst, src, n);
+	dst[n] = '\0';
+}
+
+int PodcastStore_readPage(PodcastStore* store, int offset, PodcastEpisode* out, int max) {
+	if (!store || !out || offset < 0 || max <= 0 || (uint32_t)offset >= store->header.count)
+		return 0;
+
+	int n = (int)store->header.count - offset;
+	if (n > max)
+		n = max;
+
+	StoreRecord* records = malloc(n * sizeof(StoreRecord));
+	if (!records)
+		return 0;
+	if (!read_full(store->fd, records, n * sizeof(StoreRecord), store->records_offset + (off_t)offset * sizeof(StoreRecord))) {
+		free(records);
+		return 0;
+	}
+
+	// Records are written in order, so their strings are one contiguous range
+	uint32_t heap_start = records[0].heap_offset;
+	uint32_t heap_end = records[n - 1].heap_offset + record_span(&records[n - 1]);
+	if (heap_end < heap_start || heap_end > store->header.heap_size) {
+		free(records);
+		return 0;
+	}
+	char* heap = malloc(heap_end - heap_start + 1);
+	if (!heap || !read_full(store->fd, heap, heap_end - heap_start, store->heap_offset + heap_start)) {
+		free(heap);
+		free(records);
+		return 0;
+	}
+
+	int loaded = 0;
+	for (int i = 0; i < n; i++) {
+		const StoreRecord* rec = &records[i];
+		if (rec->heap_offset < heap_start || rec->heap_offset + record_span(rec) > heap_end)
+			break; // Corrupt, keep what was valid
+
+		PodcastEpisode* ep = &out[loaded++];
+		memset(ep, 0, sizeof(PodcastEpisode));
+
+		char* dsts[FIELD_COUNT] = {ep->guid, ep->title, ep->url, ep->description, ep->local_path};
+		const size_t sizes[FIELD_COUNT] = {sizeof(ep->guid), sizeof(ep->title), sizeof(ep->url),
+										   sizeof(ep->description), sizeof(ep->local_path)};
+		const char* src = heap + (rec->heap_offset - heap_start);
+		for (int f = 0; f < FIELD_COUNT; f++) {
+			copy_field(dsts[f], sizes[f], src, rec->len[f]);
+			src += rec->len[f] + 1;
+		}
+
+		ep->duration_sec = rec->duration_sec;
+		ep->pub_date = rec->pub_date;
+		ep->progress_sec = rec->progress_sec;
+		ep->downloaded = (rec->flags & STORE_FLAG_DOWNLOADED) != 0;
+		ep->is_new = (rec->flags & STORE_FLAG_NEW) != 0;
+	}
+
+	free(heap);
+	free(records);
+	return loaded;
+}
+
+int PodcastStore_find(PodcastStore* store, const char* guid) {
+	if (!store || !guid || !guid[0] || store->header.count == 0)
+		return -1;
+
+	uint32_t slots = store->header.index_slots;
+	if (!store->index) {
+		store->index = malloc(slots * sizeof(uint32_t));
+		if (!store->index)
+			return -1;
+		if (!read_full(store->fd, store->index, slots * sizeof(uint32_t), store->index_offset)) {
+			free(store->index);
+			store->index = NULL;
+			return -1;
+		}
+	}
+
+	size_t guid_len = strlen(guid);
+	uint32_t hash = guid_hash(guid);
+	uint32_t mask = slots - 1;
+	for (uint32_t s = hash & mask, probes = 0; probes < slots; s = (s + 1) & mask, probes++) {
+		uint32_t slot = store->index[s];
+		if (!slot)
+			return -1;
+
+		StoreRecord rec;
+		if (!read_record(store, (int)slot - 1, &rec))
+			return -1;
+		if (rec.guid_hash != hash || rec.len[FIELD_GUID] != guid_len)
+			continue;
+
+		char stored[PODCAST_MAX_GUID];
+		if (guid_len >= sizeof(stored) ||
+			rec.heap_offset + guid_len > store->header.heap_size ||
+			!read_full(store->fd, stored, guid_len, store->heap_offset + rec.heap_offset))
+			continue;
+		if (memcmp(stored, guid, guid_len) == 0)
+			return (int)slot - 1;
+	}
+	return -1;
+}
+
+// ============================================================================
+// In-place updates
+// ============================================================================
+
+int PodcastStore_getProgress(PodcastStore* store, int index) {
+	StoreRecord rec;
+	if (!store || !read_record(store, index, &rec))
+		return 0;
+	return rec.progress_sec;
+}
+
+int PodcastStore_setProgress(PodcastStore* store, int index, int progress_sec) {
+	if (!store || index < 0 || (uint32_t)index >= store->header.count)
+		return -1;
+	int32_t value = progress_sec;
+	off_t offset = store->records_offset + (off_t)index * sizeof(StoreRecord) + offsetof(StoreRecord, progress_sec);
+	return write_full(store->fd, &value, sizeof(value), offset) ? 0 : -1;
+}
+
+int PodcastStore_setNew(PodcastStore* store, int index, bool is_new) {
+	StoreRecord rec;
+	if (!store || !read_record(store, index, &rec))
+		return -1;
+	if (((rec.flags & STORE_FLAG_NEW) != 0) == is_new)
+		return 0;
+
+	uint16_t flags = is_new ? (rec.flags | STORE_FLAG_NEW) : (rec.flags & ~STORE_FLAG_NEW);
+	off_t offset = store->records_offset + (off_t)index * sizeof(StoreRecord) + offsetof(StoreRecord, flags);
+	if (!write_full(store->fd, &flags, sizeof(flags), offset))
+		return -1;
+
+	// Keep the header total in step so feeds can show it without a scan
+	if (is_new)
+		store->header.new_count++;
+	else if (store->header.new_count > 0)
+		store->header.new_count--;
+	if (!write_full(store->fd, &store->header.new_count, sizeof(store->header.new_count),
+					offsetof(StoreHeader, new_count)))
+		return -1;
+	return 0;
+}
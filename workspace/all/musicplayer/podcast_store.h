@@ -0,0 +1,40 @@
+#ifndef __PODCAST_STORE_H__
+#define __PODCAST_STORE_H__
+
+#include <stdbool.h>
+#include "podcast.h" // For PodcastEpisode
+
+// Per-feed episode store (<feed_id>/episodes.bin):
+//   header | fixed-size records | GUID hash index | string heap
+// Records keep feed order, so episode N is record N and a page of episodes
+// is two reads (its records, then the contiguous heap range they point to).
+// Progress and flags live in the records and are rewritten in place.
+
+typedef struct PodcastStore PodcastStore;
+
+// Write a complete store (temp file + rename). Returns 0 on success.
+int PodcastStore_write(const char* path, const PodcastEpisode* episodes, int count);
+
+// Put episodes in front of an existing store's records (new items of a
+// refresh) without loading the existing ones. Writes a new store if missing.
+int PodcastStore_prepend(const char* path, const PodcastEpisode* episodes, int count);
+
+// Open an existing store, NULL if missing or not a valid store
+PodcastStore* PodcastStore_open(const char* path);
+void PodcastStore_close(PodcastStore* store);
+
+int PodcastStore_getCount(PodcastStore* store);
+int PodcastStore_getNewCount(PodcastStore* store);
+
+// Read up to max episodes starting at offset. Returns number read.
+int PodcastStore_readPage(PodcastStore* store, int offset, PodcastEpisode* out, int max);
+
+// Record index of guid, -1 if not in the store
+int PodcastStore_find(PodcastStore* store, const char* guid);
+
+// In-place updates of a single record
+int PodcastStore_getProgress(PodcastStore* store, int index);
+int PodcastStore_setProgress(PodcastStore* store, int index, int progress_sec);
+int PodcastStore_setNew(PodcastStore* store, int index, bool is_new);
+
+#endif
@@ -24,12 +24,17 @@ static const float soft_limiter_thresholds[] = {0.0f, 0.7f, 0.6f, 0.5f};
 #define SOFT_LIMITER_VALUE_COUNT 4
 #define DEFAULT_SOFT_LIMITER_INDEX 2 // Medium (0.6)
 
+// ReplayGain (0=off, 1=track, 2=album)
+#define REPLAY_GAIN_VALUE_COUNT 3
+#define DEFAULT_REPLAY_GAIN 1 // Track
+
 // Current settings
 static struct {
 	int screen_off_timeout; // seconds, 0 = off
 	bool lyrics_enabled;	// true = show lyrics
 	int bass_filter_hz;		// 0=off, 80, 100, 120, 150, 200
 	int soft_limiter_index; // 0=off, 1=mild, 2=medium, 3=strong
+	int replay_gain;		// 0=off, 1=track, 2=album
 } current_settings;
 
 // Find index of current screen off value in the values array
@@ -58,6 +63,7 @@ void Settings_init(void) {
 	current_settings.lyrics_enabled = true;
 	current_settings.bass_filter_hz = bass_filter_values[DEFAULT_BASS_FILTER_INDEX];
 	current_settings.soft_limiter_index = DEFAULT_SOFT_LIMITER_INDEX;
+	current_settings.replay_gain = DEFAULT_REPLAY_GAIN;
 
 	// Try to load from file
 	FILE* f = fopen(SETTINGS_FILE, "r");
@@ -92,6 +98,11 @@ void Settings_init(void) {
 				current_settings.soft_limiter_index = value;
 			}
 		}
+		if (sscanf(line, "replay_gain=%d", &value) == 1) {
+			if (value >= 0 && value < REPLAY_GAIN_VALUE_COUNT) {
+				current_settings.replay_gain = value;
+			}
+		}
 	}
 	fclose(f);
 }
@@ -159,6 +170,7 @@ void Settings_save(void) {
 	fprintf(f, "lyrics_enabled=%d\n", current_settings.lyrics_enabled ? 1 : 0);
 	fprintf(f, "bass_filter_hz=%d\n", current_settings.bass_filter_hz);
 	fprintf(f, "soft_limiter=%d\n", current_settings.soft_limiter_index);
+	fprintf(f, "replay_gain=%d\n", current_settings.replay_gain);
 	fclose(f);
 }
 
@@ -239,3 +251,31 @@ const char* Settings_getSoftLimiterDisplayStr(void) {
 		return "Medium";
 	}
 }
+
+// ReplayGain getters/cyclers
+int Settings_getReplayGain(void) {
+	return current_settings.replay_gain;
+}
+
+void Settings_cycleReplayGainNext(void) {
+	current_settings.replay_gain = (current_settings.replay_gain + 1) % REPLAY_GAIN_VALUE_COUNT;
+	Settings_save();
+}
+
+void Settings_cycleReplayGainPrev(void) {
+	current_settings.replay_gain = (current_settings.replay_gain - 1 + REPLAY_GAIN_VALUE_COUNT) % REPLAY_GAIN_VALUE_COUNT;
+	Settings_save();
+}
+
+const char* Settings_getReplayGainDisplayStr(void) {
+	switch (current_settings.replay_gain) {
+	case 0:
+		return "Off";
+	case 1:
+		return "Track";
+	case 2:
+		return "Album";
+	default:
+		return "Track";
+	}
+}
@@ -43,6 +43,12 @@ void Settings_cycleSoftLimiterNext(void);
 void Settings_cycleSoftLimiterPrev(void);
 const char* Settings_getSoftLimiterDisplayStr(void);
 
+// ReplayGain loudness normalization (0 = off, 1 = track, 2 = album)
+int Settings_getReplayGain(void);
+void Settings_cycleReplayGainNext(void);
+void Settings_cycleReplayGainPrev(void);
+const char* Settings_getReplayGainDisplayStr(void);
+
 // Save settings to file (auto-called on change)
 void Settings_save(void);
 
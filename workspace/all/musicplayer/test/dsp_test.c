@@ -0,0 +1,278 @@
+// Checks DSP_process (NEON/SSE2) and DSP_processScalar bit for bit against
+// the output processing player.c did before it moved to dsp.c, and times
+// them. Host build: make -C test, device build: make -C test device
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#include "dsp.h"
+
+#define TEST_FRAMES 4096
+#define TEST_CALLS 8 // per config, filter state carries across calls
+#define BENCH_FRAMES 1024
+#define BENCH_BUFFERS (48000 * 10 / BENCH_FRAMES) // buffers in 10 s of 48 kHz audio
+
+static uint32_t rng_state = 0x12345678;
+static uint32_t rng(void) {
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+// Full scale noise mixed with quiet passages and runs pinned at the rails
+static void fill(int16_t* samples, size_t count) {
+	int mode = rng() % 3;
+	for (size_t i = 0; i < count; i++) {
+		if (i % 512 == 0)
+			mode = rng() % 3;
+		switch (mode) {
+		case 0:
+			samples[i] = (int16_t)rng();
+			break;
+		case 1:
+			samples[i] = (int16_t)(rng() % 512) - 256;
+			break;
+		default:
+			samples[i] = rng() & 1 ? INT16_MAX : INT16_MIN;
+			break;
+		}
+	}
+}
+
+///////////////////////////////
+// Reference: player.c's speaker_soft_limit(), speaker_hpf_*() and
+// process_output() as they were before dsp.c, settings passed in
+
+#define AUDIO_CHANNELS 2
+#define OUTPUT_GAIN_SHIFT 14
+
+// Soft limiter for built-in speaker to prevent amplifier clipping
+// Linear below threshold, asymptotically compressed above
+static inline int16_t speaker_soft_limit(int16_t sample, float threshold) {
+	float headroom = 1.0f - threshold;
+
+	float x = sample * (1.0f / 32768.0f);
+	float abs_x = fabsf(x);
+	if (abs_x <= threshold)
+		return sample;
+
+	float sign = (x >= 0.0f) ? 1.0f : -1.0f;
+	float over = abs_x - threshold;
+	// Asymptotic curve: smoothly approaches 1.0 but never reaches it
+	float compressed = threshold + headroom * over / (over + headroom);
+
+	return (int16_t)(sign * compressed * 32767.0f);
+}
+
+typedef struct {
+	float w1, w2; // Direct Form II Transposed state
+} BiquadState;
+
+static struct {
+	float b0, b1, b2, a1, a2;
+} speaker_hpf_coeffs;
+static BiquadState speaker_hpf_state[AUDIO_CHANNELS];
+
+static void speaker_hpf_init(int sample_rate, float cutoff_hz) {
+	// 2nd-order Butterworth high-pass
+	const float fc = cutoff_hz;
+	const float Q = 0.7071f; // Butterworth
+	float omega = 2.0f * M_PI * fc / (float)sample_rate;
+	float sin_w = sinf(omega);
+	float cos_w = cosf(omega);
+	float alpha = sin_w / (2.0f * Q);
+
+	float a0 = 1.0f + alpha;
+	speaker_hpf_coeffs.b0 = ((1.0f + cos_w) / 2.0f) / a0;
+	speaker_hpf_coeffs.b1 = (-(1.0f + cos_w)) / a0;
+	speaker_hpf_coeffs.b2 = ((1.0f + cos_w) / 2.0f) / a0;
+	speaker_hpf_coeffs.a1 = (-2.0f * cos_w) / a0;
+	speaker_hpf_coeffs.a2 = (1.0f - alpha) / a0;
+
+	for (int i = 0; i < AUDIO_CHANNELS; i++) {
+		speaker_hpf_state[i].w1 = 0.0f;
+		speaker_hpf_state[i].w2 = 0.0f;
+	}
+}
+
+static inline int16_t speaker_hpf_process(int16_t sample, int channel) {
+	BiquadState* s = &speaker_hpf_state[channel];
+	float x = (float)sample;
+
+	// Direct Form II Transposed
+	float y = speaker_hpf_coeffs.b0 * x + s->w1;
+	s->w1 = speaker_hpf_coeffs.b1 * x - speaker_hpf_coeffs.a1 * y + s->w2;
+	s->w2 = speaker_hpf_coeffs.b2 * x - speaker_hpf_coeffs.a2 * y;
+
+	if (y > 32767.0f)
+		y = 32767.0f;
+	if (y < -32768.0f)
+		y = -32768.0f;
+
+	return (int16_t)y;
+}
+
+static void process_output(int16_t* samples, size_t frames, float gain, int bass_hz, float limiter_thresh) {
+	int32_t gain_q = (int32_t)(gain * (1 << OUTPUT_GAIN_SHIFT) + 0.5f);
+	bool scale = (gain_q != (1 << OUTPUT_GAIN_SHIFT));
+	if (!scale && bass_hz == 0 && limiter_thresh <= 0.0f)
+		return;
+
+	for (size_t i = 0; i < frames; i++) {
+		int16_t* frame = &samples[i * AUDIO_CHANNELS];
+		for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+			int16_t sample = frame[ch];
+			if (scale) {
+				int32_t v = (sample * gain_q + (1 << (OUTPUT_GAIN_SHIFT - 1))) >> OUTPUT_GAIN_SHIFT;
+				if (v > 32767)
+					v = 32767;
+				if (v < -32768)
+					v = -32768;
+				sample = (int16_t)v;
+			}
+			if (bass_hz > 0)
+				sample = speaker_hpf_process(sample, ch);
+			if (limiter_thresh > 0.0f)
+				sample = speaker_soft_limit(sample, limiter_thresh);
+			frame[ch] = sample;
+		}
+	}
+}
+
+///////////////////////////////
+
+static void configure(DSPChain* dsp, float gain, int rate, int hz, float threshold) {
+	DSP_init(dsp);
+	DSP_setGain(dsp, gain);
+	DSP_setHighPass(dsp, rate, hz);
+	DSP_setLimiter(dsp, threshold);
+}
+
+typedef struct {
+	float gain;
+	int rate;
+	int hz;
+	float threshold;
+} TestConfig;
+
+static const TestConfig configs[] = {
+	{1.0f, 48000, 0, 0.0f}, // everything off
+	{0.5f, 48000, 0, 0.0f},
+	{DSP_GAIN_MAX, 48000, 0, 0.0f},
+	{1.0f, 44100, 80, 0.0f},
+	{1.0f, 48000, 200, 0.0f},
+	{1.0f, 48000, 0, 0.7f},
+	{1.0f, 48000, 0, 0.95f},
+	{2.0f, 44100, 120, 0.8f},
+	{DSP_GAIN_MAX, 48000, 300, 0.5f},
+	{0.0f, 48000, 80, 0.9f},
+};
+#define CONFIG_COUNT (int)(sizeof(configs) / sizeof(configs[0]))
+
+static int check(const TestConfig* config, int index) {
+	DSPChain simd, scalar;
+	configure(&simd, config->gain, config->rate, config->hz, config->threshold);
+	configure(&scalar, config->gain, config->rate, config->hz, config->threshold);
+	if (config->hz > 0)
+		speaker_hpf_init(config->rate, (float)config->hz);
+
+	int16_t* in = malloc(TEST_FRAMES * DSP_CHANNELS * sizeof(int16_t));
+	int16_t* a = malloc(TEST_FRAMES * DSP_CHANNELS * sizeof(int16_t));
+	int16_t* b = malloc(TEST_FRAMES * DSP_CHANNELS * sizeof(int16_t));
+	int16_t* ref = malloc(TEST_FRAMES * DSP_CHANNELS * sizeof(int16_t));
+	int failed = 0;
+
+	for (int call = 0; call < TEST_CALLS && !failed; call++) {
+		// Odd lengths leave tails after the vector loops and the 256 frame blocks
+		size_t frames = call == 0 ? TEST_FRAMES : 1 + rng() % TEST_FRAMES;
+		fill(in, frames * DSP_CHANNELS);
+		memcpy(a, in, frames * DSP_CHANNELS * sizeof(int16_t));
+		memcpy(b, in, frames * DSP_CHANNELS * sizeof(int16_t));
+		memcpy(ref, in, frames * DSP_CHANNELS * sizeof(int16_t));
+		DSP_process(&simd, a, frames);
+		DSP_processScalar(&scalar, b, frames);
+		process_output(ref, frames, config->gain, config->hz, config->threshold);
+
+		for (size_t i = 0; i < frames * DSP_CHANNELS; i++) {
+			if (a[i] != ref[i] || b[i] != ref[i]) {
+				printf("FAIL config %d call %d sample %zu: in %d simd %d scalar %d reference %d\n",
+					   index, call, i, in[i], a[i], b[i], ref[i]);
+				failed = 1;
+				break;
+			}
+		}
+		for (int ch = 0; ch < DSP_CHANNELS && !failed && config->hz > 0; ch++) {
+			BiquadState* state = &speaker_hpf_state[ch];
+			if (memcmp(&simd.w1[ch], &state->w1, sizeof(float)) != 0 || memcmp(&simd.w2[ch], &state->w2, sizeof(float)) != 0 ||
+				memcmp(&scalar.w1[ch], &state->w1, sizeof(float)) != 0 || memcmp(&scalar.w2[ch], &state->w2, sizeof(float)) != 0) {
+				printf("FAIL config %d call %d: filter state differs\n", index, call);
+				failed = 1;
+			}
+		}
+	}
+
+	free(in);
+	free(a);
+	free(b);
+	free(ref);
+	return failed;
+}
+
+static double now_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+typedef void (*ProcessFunc)(DSPChain* dsp, int16_t* samples, size_t frames);
+
+static double bench(ProcessFunc process, const int16_t* in) {
+	DSPChain dsp;
+	configure(&dsp, 2.0f, 48000, 120, 0.8f);
+	int16_t buffer[BENCH_FRAMES * DSP_CHANNELS];
+
+	double start = now_ms();
+	for (int i = 0; i < BENCH_BUFFERS; i++) {
+		memcpy(buffer, in, sizeof(buffer));
+		process(&dsp, buffer, BENCH_FRAMES);
+	}
+	return now_ms() - start;
+}
+
+static double benchReference(const int16_t* in) {
+	speaker_hpf_init(48000, 120.0f);
+	int16_t buffer[BENCH_FRAMES * DSP_CHANNELS];
+
+	double start = now_ms();
+	for (int i = 0; i < BENCH_BUFFERS; i++) {
+		memcpy(buffer, in, sizeof(buffer));
+		process_output(buffer, BENCH_FRAMES, 2.0f, 120, 0.8f);
+	}
+	return now_ms() - start;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc > 1)
+		rng_state = (uint32_t)strtoul(argv[1], NULL, 0) | 1;
+
+	int failed = 0;
+	for (int i = 0; i < CONFIG_COUNT; i++)
+		failed += check(&configs[i], i);
+	printf("%d/%d configs match the reference\n", CONFIG_COUNT - failed, CONFIG_COUNT);
+
+	int16_t in[BENCH_FRAMES * DSP_CHANNELS];
+	fill(in, BENCH_FRAMES * DSP_CHANNELS);
+	double reference_ms = benchReference(in);
+	double scalar_ms = bench(DSP_processScalar, in);
+	double simd_ms = bench(DSP_process, in);
+	printf("10 s of 48 kHz stereo, full chain: reference %.2f ms, scalar %.2f ms, DSP_process %.2f ms\n",
+		   reference_ms, scalar_ms, simd_ms);
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
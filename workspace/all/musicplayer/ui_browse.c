@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "defines.h"
+#include "api.h"
+#include "ui_components.h"
+#include "ui_browse.h"
+#include "ui_icons.h"
+#include "ui_list.h"
+
+// Scroll text state for selected item in browse lists
+static ScrollTextState browse_scroll = {0};
+
+void render_browse_groups(SDL_Surface* screen, IndicatorType show_setting,
+						  const char* title, LibraryGroup* groups, int count,
+						  int selected, int scroll, bool scanning) {
+	GFX_clear(screen);
+
+	char truncated[256];
+
+	UI_renderMenuBar(screen, title);
+
+	// Empty state - nothing indexed (yet)
+	if (count == 0) {
+		if (scanning)
+			UI_renderEmptyState(screen, "Scanning music library...", "Tracks appear as they are found", NULL);
+		else
+			UI_renderEmptyState(screen, "No music found", "Add music to the Music folder", NULL);
+		return;
+	}
+
+	ListLayout layout = UI_calcListLayout(screen);
+
+	for (int i = 0; i < layout.items_per_page && (scroll + i) < count; i++) {
+		int idx = scroll + i;
+		bool is_selected = (idx == selected);
+		int y = layout.list_y + i * layout.item_h;
+
+		char display[600];
+		if (groups[idx].artist[0])
+			snprintf(display, sizeof(display), "%s - %s (%d)", groups[idx].name, groups[idx].artist, groups[idx].track_count);
+		else
+			snprintf(display, sizeof(display), "%s (%d)", groups[idx].name, groups[idx].track_count);
+
+		ListItemPos pos = UI_renderListItemPill(screen, &layout, font.medium, display, truncated, y, is_selected, 0);
+		int available_width = pos.pill_width - SCALE1(BUTTON_PADDING * 2);
+		UI_renderListItemText(screen, &browse_scroll, display, font.medium,
+							  pos.text_x, pos.text_y, available_width, is_selected);
+	}
+
+	UI_renderScrollIndicators(screen, scroll, layout.items_per_page, count);
+
+	UI_renderButtonHintBar(screen, (char*[]){"START", "CONTROLS", "B", "BACK", "A", "OPEN", NULL});
+}
+
+void render_browse_tracks(SDL_Surface* screen, IndicatorType show_setting,
+						  const char* title, PlaylistTrack* tracks, int count,
+						  int selected, int scroll) {
+	GFX_clear(screen);
+
+	char truncated[256];
+
+	UI_renderMenuBar(screen, title);
+
+	// Empty state (group vanished in a rescan)
+	if (count == 0) {
+		UI_renderEmptyState(screen, "No tracks found", NULL, NULL);
+		return;
+	}
+
+	ListLayout layout = UI_calcListLayout(screen);
+
+	// Icon size and spacing (same as browser)
+	int icon_size = Icons_isLoaded() ? SCALE1(24) : 0;
+	int icon_spacing = Icons_isLoaded() ? SCALE1(6) : 0;
+	int icon_offset = icon_size + icon_spacing;
+
+	for (int i = 0; i < layout.items_per_page && (scroll + i) < count; i++) {
+		int idx = scroll + i;
+		bool is_selected = (idx == selected);
+		int y = layout.list_y + i * layout.item_h;
+
+		const char* display = tracks[idx].name;
+
+		ListItemPos pos = UI_renderListItemPill(screen, &layout, font.medium, display, truncated, y, is_selected, icon_offset);
+
+		// Render icon
+		if (Icons_isLoaded()) {
+			SDL_Surface* icon = Icons_getForFormat(tracks[idx].format, is_selected);
+			if (icon) {
+				int icon_y = y + (layout.item_h - icon_size) / 2;
+				SDL_Rect src_rect = {0, 0, icon->w, icon->h};
+				SDL_Rect dst_rect = {pos.text_x, icon_y, icon_size, icon_size};
+				SDL_BlitScaled(icon, &src_rect, screen, &dst_rect);
+			}
+		}
+
+		int text_x = pos.text_x + icon_offset;
+		int available_width = pos.pill_width - SCALE1(BUTTON_PADDING * 2) - icon_offset;
+		UI_renderListItemText(screen, &browse_scroll, display, font.medium,
+							  text_x, pos.text_y, available_width, is_selected);
+	}
+
+	UI_renderScrollIndicators(screen, scroll, layout.items_per_page, count);
+
+	UI_renderButtonHintBar(screen, (char*[]){"START", "CONTROLS", "B", "BACK", "A", "PLAY", NULL});
+}
+
+bool browse_list_needs_scroll_refresh(void) {
+	return ScrollText_isScrolling(&browse_scroll);
+}
+
+bool browse_list_scroll_needs_render(void) {
+	return ScrollText_needsRender(&browse_scroll);
+}
+
+void browse_list_animate_scroll(void) {
+	ScrollText_animateOnly(&browse_scroll);
+}
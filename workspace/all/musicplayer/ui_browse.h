@@ -0,0 +1,28 @@
+#ifndef __UI_BROWSE_H__
+#define __UI_BROWSE_H__
+
+#include <SDL2/SDL.h>
+#include "api.h"
+#include "library.h"
+#include "playlist.h"
+
+// Render the artist/album/genre list
+void render_browse_groups(SDL_Surface* screen, IndicatorType show_setting,
+						  const char* title, LibraryGroup* groups, int count,
+						  int selected, int scroll, bool scanning);
+
+// Render the tracks of one artist/album/genre
+void render_browse_tracks(SDL_Surface* screen, IndicatorType show_setting,
+						  const char* title, PlaylistTrack* tracks, int count,
+						  int selected, int scroll);
+
+// Check if browse list has active scrolling
+bool browse_list_needs_scroll_refresh(void);
+
+// Check if browse list scroll needs render (delay phase)
+bool browse_list_scroll_needs_render(void);
+
+// Animate browse list scroll (GPU mode)
+void browse_list_animate_scroll(void);
+
+#endif
@@ -295,6 +295,13 @@ static const ControlHelp playlist_detail_controls[] = {
 	{"Start (hold)", "Exit App"},
 	{NULL, NULL}};
 
+// Artist/album/genre browse controls (A/B shown in footer)
+static const ControlHelp browse_controls[] = {
+	{"Up/Down", "Navigate"},
+	{"Left/Right", "Page"},
+	{"Start (hold)", "Exit App"},
+	{NULL, NULL}};
+
 // About page controls (A/B shown in footer)
 static const ControlHelp about_controls[] = {
 	{"Start (hold)", "Exit App"},
@@ -410,6 +417,14 @@ void render_controls_help(SDL_Surface* screen, int app_state) {
 		controls = main_menu_controls;
 		page_title = "Library";
 		break;
+	case 56: // BROWSE_GROUPS_HELP_STATE
+		controls = browse_controls;
+		page_title = "Browse Library";
+		break;
+	case 57: // BROWSE_TRACKS_HELP_STATE
+		controls = browse_controls;
+		page_title = "Tracks";
+		break;
 	case 41: // SETTINGS_INTERNAL_ABOUT
 		controls = about_controls;
 		page_title = "About";
@@ -24,6 +24,11 @@ static int last_rendered_position = -1;
 static int last_rendered_duration = -1;
 static bool playtime_position_set = false;
 
+// Waveform progress strip, drawn on the playtime layer
+static int waveform_x = 0, waveform_y = 0, waveform_w = 0, waveform_h = 0;
+static bool waveform_position_set = false;
+static int last_waveform_bars = -1;
+
 // Lyrics GPU state
 static int lyrics_gpu_x = 0, lyrics_gpu_y = 0, lyrics_gpu_max_w = 0;
 static bool lyrics_gpu_position_set = false;
@@ -178,13 +183,9 @@ void render_playing(SDL_Surface* screen, IndicatorType show_setting, BrowserCont
 	int total_tracks = (playlist_total > 0) ? playlist_total : Browser_countAudioFiles(browser);
 	char track_str[32];
 	snprintf(track_str, sizeof(track_str), "%02d - %02d", track_num, total_tracks);
-	SDL_Surface* track_surf = TTF_RenderUTF8_Blended(font.tiny, track_str, COLOR_GRAY);
-	if (track_surf) {
-		int track_x = badge_x + badge_w + SCALE1(8);
-		int track_y = top_y + (badge_h - track_surf->h) / 2;
-		SDL_BlitSurface(track_surf, NULL, screen, &(SDL_Rect){track_x, track_y});
-		SDL_FreeSurface(track_surf);
-	}
+	int track_x = badge_x + badge_w + SCALE1(8);
+	int track_y = top_y + (badge_h - TTF_FontHeight(font.tiny)) / 2;
+	GFX_blitGlyphs(font.tiny, track_str, COLOR_GRAY, screen, track_x, track_y, 0);
 
 	// Hardware status (clock, battery) on right
 	GFX_blitHardwareGroup(screen, show_setting);
@@ -199,14 +200,8 @@ void render_playing(SDL_Surface* screen, IndicatorType show_setting, BrowserCont
 	// Artist name (Medium font, gray)
 	const char* artist = info->artist[0] ? info->artist : "Unknown Artist";
 	GFX_truncateText(font.medium, artist, truncated, max_w_text, 0);
-	SDL_Surface* artist_surf = TTF_RenderUTF8_Blended(font.medium, truncated, COLOR_GRAY);
-	if (artist_surf) {
-		SDL_BlitSurface(artist_surf, NULL, screen, &(SDL_Rect){SCALE1(PADDING), info_y});
-		info_y += artist_surf->h + SCALE1(2);
-		SDL_FreeSurface(artist_surf);
-	} else {
-		info_y += SCALE1(18);
-	}
+	GFX_blitGlyphs(font.medium, truncated, COLOR_GRAY, screen, SCALE1(PADDING), info_y, 0);
+	info_y += TTF_FontHeight(font.medium) + SCALE1(2);
 
 	// Song title (Regular font extra large, white) - with GPU scrolling animation (no background)
 	const char* title = info->title[0] ? info->title : "Unknown Title";
@@ -226,11 +221,7 @@ void render_playing(SDL_Surface* screen, IndicatorType show_setting, BrowserCont
 	} else {
 		// Static text - render to screen surface
 		PLAT_clearLayers(LAYER_SCROLLTEXT);
-		SDL_Surface* title_surf = TTF_RenderUTF8_Blended(font.title, title, COLOR_WHITE);
-		if (title_surf) {
-			SDL_BlitSurface(title_surf, NULL, screen, &(SDL_Rect){SCALE1(PADDING), title_y, 0, 0});
-			SDL_FreeSurface(title_surf);
-		}
+		GFX_blitGlyphs(font.title, title, COLOR_WHITE, screen, SCALE1(PADDING), title_y, 0);
 	}
 	info_y += TTF_FontHeight(font.title) + SCALE1(2);
 
@@ -243,11 +234,7 @@ void render_playing(SDL_Surface* screen, IndicatorType show_setting, BrowserCont
 		const char* album = info->album[0] ? info->album : "";
 		if (album[0]) {
 			GFX_truncateText(font.small, album, truncated, max_w_text, 0);
-			SDL_Surface* album_surf = TTF_RenderUTF8_Blended(font.small, truncated, COLOR_GRAY);
-			if (album_surf) {
-				SDL_BlitSurface(album_surf, NULL, screen, &(SDL_Rect){SCALE1(PADDING), info_y});
-				SDL_FreeSurface(album_surf);
-			}
+			GFX_blitGlyphs(font.small, truncated, COLOR_GRAY, screen, SCALE1(PADDING), info_y, 0);
 		}
 	}
 
@@ -307,13 +294,15 @@ void render_playing(SDL_Surface* screen, IndicatorType show_setting, BrowserCont
 	if (!Settings_getLyricsEnabled()) {
 		label_x -= SCALE1(12);
 		const char* lyric_text = "LYRIC OFF";
-		SDL_Surface* lyric_surf = TTF_RenderUTF8_Blended(font.tiny, lyric_text, COLOR_GRAY);
-		if (lyric_surf) {
-			label_x -= lyric_surf->w;
-			SDL_BlitSurface(lyric_surf, NULL, screen, &(SDL_Rect){label_x, bottom_y});
-			SDL_FreeSurface(lyric_surf);
-		}
+		label_x -= GFX_sizeGlyphs(font.tiny, lyric_text);
+		GFX_blitGlyphs(font.tiny, lyric_text, COLOR_GRAY, screen, label_x, bottom_y, 0);
 	}
+
+	// Waveform progress between the time and the labels
+	int time_w = GFX_sizeGlyphs(font.small, "00:00") + SCALE1(6) + GFX_sizeGlyphs(font.tiny, "00:00");
+	int wave_x = time_x + time_w + SCALE1(12);
+	int wave_w = label_x - SCALE1(12) - wave_x;
+	PlayTime_setWaveformPosition(wave_x, bottom_y, wave_w, TTF_FontHeight(font.small));
 }
 
 // Check if browser list has active scrolling (for refresh optimization)
@@ -362,13 +351,31 @@ void PlayTime_setPosition(int x, int y, int duration_x) {
 	playtime_position_set = true;
 }
 
+void PlayTime_setWaveformPosition(int x, int y, int w, int h) {
+	waveform_x = x;
+	waveform_y = y;
+	waveform_w = w;
+	waveform_h = h;
+	waveform_position_set = (w > 0 && h > 0);
+}
+
 void PlayTime_clear(void) {
 	playtime_position_set = false;
+	waveform_position_set = false;
 	last_rendered_position = -1;
 	last_rendered_duration = -1;
+	last_waveform_bars = -1;
 	// Note: Caller should clear LAYER_PLAYTIME and call PLAT_GPU_Flip() if needed
 }
 
+static bool waveform_needs_refresh(int duration) {
+	if (!waveform_position_set || duration <= 0)
+		return false;
+	WaveformData waveform;
+	Player_getWaveform(&waveform);
+	return waveform.bar_count != last_waveform_bars;
+}
+
 bool PlayTime_needsRefresh(void) {
 	if (!playtime_position_set)
 		return false;
@@ -380,7 +387,54 @@ bool PlayTime_needsRefresh(void) {
 	int duration = Player_getDuration();
 
 	// Only refresh if position changed (updates once per second)
-	return (position != last_rendered_position || duration != last_rendered_duration);
+	if (position != last_rendered_position || duration != last_rendered_duration)
+		return true;
+
+	// ...or the waveform filled in some more
+	return waveform_needs_refresh(duration);
+}
+
+// Peak and RMS per column, played part white, the rest gray.
+// Without waveform data yet it's a plain progress line.
+static void render_waveform(int position, int duration) {
+	WaveformData waveform;
+	Player_getWaveform(&waveform);
+	int played = (int)((int64_t)waveform_w * position / duration);
+	if (played > waveform_w)
+		played = waveform_w;
+
+	last_waveform_bars = waveform.bar_count;
+
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, waveform_w, waveform_h, 32, SDL_PIXELFORMAT_ARGB8888);
+	if (!surface)
+		return;
+	SDL_FillRect(surface, NULL, 0); // Transparent background
+
+	Uint32 peak_played = SDL_MapRGBA(surface->format, 0xff, 0xff, 0xff, 0x99);
+	Uint32 rms_played = SDL_MapRGBA(surface->format, 0xff, 0xff, 0xff, 0xff);
+	Uint32 peak_rest = SDL_MapRGBA(surface->format, 0x80, 0x80, 0x80, 0x66);
+	Uint32 rms_rest = SDL_MapRGBA(surface->format, 0x80, 0x80, 0x80, 0xcc);
+	int mid = waveform_h / 2;
+
+	for (int x = 0; x < waveform_w; x++) {
+		bool is_played = x < played;
+		int bar = x * WAVEFORM_BARS / waveform_w;
+		int peak_h = 1;
+		int rms_h = 1;
+		if (bar < waveform.bar_count) {
+			peak_h = (int)(waveform.bars[bar] * waveform_h + 0.5f);
+			rms_h = (int)(waveform.rms[bar] * waveform_h + 0.5f);
+			if (peak_h < 1)
+				peak_h = 1;
+			if (rms_h < 1)
+				rms_h = 1;
+		}
+		SDL_FillRect(surface, &(SDL_Rect){x, mid - peak_h / 2, 1, peak_h}, is_played ? peak_played : peak_rest);
+		SDL_FillRect(surface, &(SDL_Rect){x, mid - rms_h / 2, 1, rms_h}, is_played ? rms_played : rms_rest);
+	}
+
+	PLAT_drawOnLayer(surface, waveform_x, waveform_y, waveform_w, waveform_h, 1.0f, false, LAYER_PLAYTIME);
+	SDL_FreeSurface(surface);
 }
 
 void PlayTime_renderGPU(void) {
@@ -391,7 +445,7 @@ void PlayTime_renderGPU(void) {
 	int duration = Player_getDuration();
 
 	// Skip if nothing changed
-	if (position == last_rendered_position && duration == last_rendered_duration)
+	if (position == last_rendered_position && duration == last_rendered_duration && !waveform_needs_refresh(duration))
 		return;
 
 	last_rendered_position = position;
@@ -432,6 +486,9 @@ void PlayTime_renderGPU(void) {
 		PLAT_drawOnLayer(combined, playtime_x, playtime_y, total_w, total_h, 1.0f, false, LAYER_PLAYTIME);
 		SDL_FreeSurface(combined);
 
+		if (waveform_position_set && duration > 0)
+			render_waveform(position, duration);
+
 		PLAT_GPU_Flip();
 	}
 
@@ -39,6 +39,7 @@ void player_animate_scroll(void);
 
 // Playtime GPU rendering functions
 void PlayTime_setPosition(int x, int y, int duration_x);
+void PlayTime_setWaveformPosition(int x, int y, int w, int h);
 void PlayTime_renderGPU(void);
 bool PlayTime_needsRefresh(void);
 void PlayTime_clear(void);
@@ -590,11 +590,7 @@ static void format_date(char* buf, uint32_t timestamp) {
 
 // --- Section header helper ---
 static void render_section_header(SDL_Surface* screen, const char* text, int y) {
-	SDL_Surface* surf = TTF_RenderUTF8_Blended(font.small, text, COLOR_GRAY);
-	if (surf) {
-		SDL_BlitSurface(surf, NULL, screen, &(SDL_Rect){SCALE1(PADDING + BUTTON_PADDING), y});
-		SDL_FreeSurface(surf);
-	}
+	GFX_blitGlyphs(font.small, text, COLOR_GRAY, screen, SCALE1(PADDING + BUTTON_PADDING), y, 0);
 }
 
 // --- Rich list item renderer (artwork + title + subtitle using rich pill) ---
@@ -626,12 +622,7 @@ static ListItemRichPos render_rich_list_item(SDL_Surface* screen, ListLayout* la
 
 	// Subtitle (row 2)
 	if (subtitle && subtitle[0]) {
-		SDL_Surface* s = TTF_RenderUTF8_Blended(font.small, subtitle, COLOR_GRAY);
-		if (s) {
-			SDL_Rect src = {0, 0, s->w > pos.text_max_width ? pos.text_max_width : s->w, s->h};
-			SDL_BlitSurface(s, &src, screen, &(SDL_Rect){pos.subtitle_x, pos.subtitle_y});
-			SDL_FreeSurface(s);
-		}
+		GFX_blitGlyphs(font.small, subtitle, COLOR_GRAY, screen, pos.subtitle_x, pos.subtitle_y, pos.text_max_width);
 	}
 
 	return pos;
@@ -922,11 +913,8 @@ void render_podcast_top_shows(SDL_Surface* screen, IndicatorType show_setting,
 	if (status->loading) {
 		int center_y = screen->h / 2;
 		const char* msg = "Loading...";
-		SDL_Surface* text = TTF_RenderUTF8_Blended(font.medium, msg, COLOR_WHITE);
-		if (text) {
-			SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){(hw - text->w) / 2, center_y});
-			SDL_FreeSurface(text);
-		}
+		int text_w = GFX_sizeGlyphs(font.medium, msg);
+		GFX_blitGlyphs(font.medium, msg, COLOR_WHITE, screen, (hw - text_w) / 2, center_y, 0);
 		return;
 	}
 
@@ -937,11 +925,8 @@ void render_podcast_top_shows(SDL_Surface* screen, IndicatorType show_setting,
 	if (count == 0) {
 		int center_y = screen->h / 2 - SCALE1(15);
 		const char* msg = status->error_message[0] ? status->error_message : "No shows available";
-		SDL_Surface* text = TTF_RenderUTF8_Blended(font.medium, msg, COLOR_WHITE);
-		if (text) {
-			SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){(hw - text->w) / 2, center_y});
-			SDL_FreeSurface(text);
-		}
+		int text_w = GFX_sizeGlyphs(font.medium, msg);
+		GFX_blitGlyphs(font.medium, msg, COLOR_WHITE, screen, (hw - text_w) / 2, center_y, 0);
 		UI_renderButtonHintBar(screen, (char*[]){"B", "BACK", NULL});
 		return;
 	}
@@ -1001,11 +986,8 @@ void render_podcast_search_results(SDL_Surface* screen, IndicatorType show_setti
 	if (status->searching) {
 		int center_y = screen->h / 2;
 		const char* msg = "Searching...";
-		SDL_Surface* text = TTF_RenderUTF8_Blended(font.medium, msg, COLOR_WHITE);
-		if (text) {
-			SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){(hw - text->w) / 2, center_y});
-			SDL_FreeSurface(text);
-		}
+		int text_w = GFX_sizeGlyphs(font.medium, msg);
+		GFX_blitGlyphs(font.medium, msg, COLOR_WHITE, screen, (hw - text_w) / 2, center_y, 0);
 		return;
 	}
 
@@ -1016,11 +998,8 @@ void render_podcast_search_results(SDL_Surface* screen, IndicatorType show_setti
 	if (count == 0) {
 		int center_y = screen->h / 2 - SCALE1(15);
 		const char* msg = status->error_message[0] ? status->error_message : "No results found";
-		SDL_Surface* text = TTF_RenderUTF8_Blended(font.medium, msg, COLOR_WHITE);
-		if (text) {
-			SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){(hw - text->w) / 2, center_y});
-			SDL_FreeSurface(text);
-		}
+		int text_w = GFX_sizeGlyphs(font.medium, msg);
+		GFX_blitGlyphs(font.medium, msg, COLOR_WHITE, screen, (hw - text_w) / 2, center_y, 0);
 		UI_renderButtonHintBar(screen, (char*[]){"B", "BACK", NULL});
 		return;
 	}
@@ -1119,19 +1098,12 @@ void render_podcast_episodes(SDL_Surface* screen, IndicatorType show_setting,
 		}
 		if (feed->author[0]) {
 			GFX_truncateText(font.small, feed->author, truncated, text_max_w, 0);
-			SDL_Surface* a = TTF_RenderUTF8_Blended(font.small, truncated, COLOR_GRAY);
-			if (a) {
-				SDL_BlitSurface(a, NULL, screen, &(SDL_Rect){text_x, ty});
-				SDL_FreeSurface(a);
-			}
+			GFX_blitGlyphs(font.small, truncated, COLOR_GRAY, screen, text_x, ty, 0);
 		}
 		int center_y = base_y + info_area_h + (viewport_h - info_area_h) / 2;
 		const char* msg = "No episodes available";
-		SDL_Surface* text = TTF_RenderUTF8_Blended(font.medium, msg, COLOR_WHITE);
-		if (text) {
-			SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){(hw - text->w) / 2, center_y});
-			SDL_FreeSurface(text);
-		}
+		int text_w = GFX_sizeGlyphs(font.medium, msg);
+		GFX_blitGlyphs(font.medium, msg, COLOR_WHITE, screen, (hw - text_w) / 2, center_y, 0);
 		UI_renderButtonHintBar(screen, (char*[]){"B", "BACK", NULL});
 		return;
 	}
@@ -1524,11 +1496,8 @@ void render_podcast_download_queue(SDL_Surface* screen, IndicatorType show_setti
 	if (queue_count == 0) {
 		int center_y = screen->h / 2;
 		const char* msg = "No downloads";
-		SDL_Surface* text = TTF_RenderUTF8_Blended(font.medium, msg, COLOR_WHITE);
-		if (text) {
-			SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){(hw - text->w) / 2, center_y - text->h / 2});
-			SDL_FreeSurface(text);
-		}
+		int text_w = GFX_sizeGlyphs(font.medium, msg);
+		GFX_blitGlyphs(font.medium, msg, COLOR_WHITE, screen, (hw - text_w) / 2, center_y - TTF_FontHeight(font.medium) / 2, 0);
 		UI_renderButtonHintBar(screen, (char*[]){"B", "BACK", NULL});
 		UI_renderToast(screen, toast_message, toast_time);
 		return;
@@ -1607,11 +1576,7 @@ void render_podcast_download_queue(SDL_Surface* screen, IndicatorType show_setti
 			}
 		} else if (item->status == PODCAST_DOWNLOAD_PENDING) {
 			const char* label = "Queued";
-			SDL_Surface* s = TTF_RenderUTF8_Blended(font.small, label, COLOR_GRAY);
-			if (s) {
-				SDL_BlitSurface(s, NULL, screen, &(SDL_Rect){pos.subtitle_x, pos.subtitle_y});
-				SDL_FreeSurface(s);
-			}
+			GFX_blitGlyphs(font.small, label, COLOR_GRAY, screen, pos.subtitle_x, pos.subtitle_y, 0);
 		} else if (item->status == PODCAST_DOWNLOAD_FAILED) {
 			const char* label = "[Failed]";
 			if (item->retry_count > 0) {
@@ -1625,19 +1590,11 @@ void render_podcast_download_queue(SDL_Surface* screen, IndicatorType show_setti
 					SDL_FreeSurface(s);
 				}
 			} else {
-				SDL_Surface* s = TTF_RenderUTF8_Blended(font.small, label, (SDL_Color){200, 80, 80, 255});
-				if (s) {
-					SDL_BlitSurface(s, NULL, screen, &(SDL_Rect){pos.subtitle_x, pos.subtitle_y});
-					SDL_FreeSurface(s);
-				}
+				GFX_blitGlyphs(font.small, label, (SDL_Color){200, 80, 80, 255}, screen, pos.subtitle_x, pos.subtitle_y, 0);
 			}
 		} else if (item->status == PODCAST_DOWNLOAD_COMPLETE) {
 			const char* label = "Complete";
-			SDL_Surface* s = TTF_RenderUTF8_Blended(font.small, label, (SDL_Color){80, 200, 80, 255});
-			if (s) {
-				SDL_BlitSurface(s, NULL, screen, &(SDL_Rect){pos.subtitle_x, pos.subtitle_y});
-				SDL_FreeSurface(s);
-			}
+			GFX_blitGlyphs(font.small, label, (SDL_Color){80, 200, 80, 255}, screen, pos.subtitle_x, pos.subtitle_y, 0);
 		}
 
 		// Feed title as secondary info (tiny font, below subtitle)
@@ -1769,11 +1726,7 @@ void render_podcast_playing(SDL_Surface* screen, IndicatorType show_setting,
 	} else {
 		// Static text - render to screen surface
 		PLAT_clearLayers(LAYER_SCROLLTEXT);
-		SDL_Surface* title_surf = TTF_RenderUTF8_Blended(font.title, title, COLOR_WHITE);
-		if (title_surf) {
-			SDL_BlitSurface(title_surf, NULL, screen, &(SDL_Rect){SCALE1(PADDING), title_y, 0, 0});
-			SDL_FreeSurface(title_surf);
-		}
+		GFX_blitGlyphs(font.title, title, COLOR_WHITE, screen, SCALE1(PADDING), title_y, 0);
 	}
 	info_y += TTF_FontHeight(font.title) + SCALE1(2);
 
@@ -1912,11 +1865,8 @@ void render_podcast_loading(SDL_Surface* screen, const char* message) {
 	int hh = screen->h;
 
 	const char* msg = message ? message : "Loading...";
-	SDL_Surface* text = TTF_RenderUTF8_Blended(font.medium, msg, COLOR_WHITE);
-	if (text) {
-		SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){(hw - text->w) / 2, hh / 2});
-		SDL_FreeSurface(text);
-	}
+	int text_w = GFX_sizeGlyphs(font.medium, msg);
+	GFX_blitGlyphs(font.medium, msg, COLOR_WHITE, screen, (hw - text_w) / 2, hh / 2, 0);
 }
 
 // Check if podcast title is currently scrolling (list or playing screen)
@@ -2049,17 +1999,10 @@ void PodcastProgress_renderGPU(void) {
 	format_duration(time_cur, position_sec);
 	format_duration(time_dur, duration_ms / 1000);
 
-	SDL_Surface* cur_surf = TTF_RenderUTF8_Blended(font.tiny, time_cur, COLOR_GRAY);
-	if (cur_surf) {
-		SDL_BlitSurface(cur_surf, NULL, combined, &(SDL_Rect){bar_margin, progress_bar_h + time_gap});
-		SDL_FreeSurface(cur_surf);
-	}
+	GFX_blitGlyphs(font.tiny, time_cur, COLOR_GRAY, combined, bar_margin, progress_bar_h + time_gap, 0);
 
-	SDL_Surface* dur_surf = TTF_RenderUTF8_Blended(font.tiny, time_dur, COLOR_GRAY);
-	if (dur_surf) {
-		SDL_BlitSurface(dur_surf, NULL, combined, &(SDL_Rect){progress_screen_w - bar_margin - dur_surf->w, progress_bar_h + time_gap});
-		SDL_FreeSurface(dur_surf);
-	}
+	int dur_w = GFX_sizeGlyphs(font.tiny, time_dur);
+	GFX_blitGlyphs(font.tiny, time_dur, COLOR_GRAY, combined, progress_screen_w - bar_margin - dur_w, progress_bar_h + time_gap, 0);
 
 	// Clear previous and draw new
 	PLAT_clearLayers(LAYER_PODCAST_PROGRESS);
@@ -55,11 +55,8 @@ void render_radio_list(SDL_Surface* screen, IndicatorType show_setting,
 		// Genre (if available)
 		if (station->genre[0]) {
 			SDL_Color genre_color = selected ? COLOR_GRAY : COLOR_DARK_TEXT;
-			SDL_Surface* genre_text = TTF_RenderUTF8_Blended(font.tiny, station->genre, genre_color);
-			if (genre_text) {
-				SDL_BlitSurface(genre_text, NULL, screen, &(SDL_Rect){hw - genre_text->w - SCALE1(PADDING * 2), y + (layout.item_h - genre_text->h) / 2});
-				SDL_FreeSurface(genre_text);
-			}
+			int genre_text_w = GFX_sizeGlyphs(font.tiny, station->genre);
+			GFX_blitGlyphs(font.tiny, station->genre, genre_color, screen, hw - genre_text_w - SCALE1(PADDING * 2), y + (layout.item_h - TTF_FontHeight(font.tiny)) / 2, 0);
 		}
 	}
 
@@ -70,18 +67,12 @@ void render_radio_list(SDL_Surface* screen, IndicatorType show_setting,
 		int note_y = hh - SCALE1(BUTTON_SIZE + BUTTON_MARGIN + PADDING + 55);
 
 		const char* note1 = "These are default stations";
-		SDL_Surface* note1_surf = TTF_RenderUTF8_Blended(font.tiny, note1, COLOR_GRAY);
-		if (note1_surf) {
-			SDL_BlitSurface(note1_surf, NULL, screen, &(SDL_Rect){(hw - note1_surf->w) / 2, note_y});
-			SDL_FreeSurface(note1_surf);
-		}
+		int note1_w = GFX_sizeGlyphs(font.tiny, note1);
+		GFX_blitGlyphs(font.tiny, note1, COLOR_GRAY, screen, (hw - note1_w) / 2, note_y, 0);
 
 		const char* note2 = "Press Y to manage stations";
-		SDL_Surface* note2_surf = TTF_RenderUTF8_Blended(font.tiny, note2, COLOR_GRAY);
-		if (note2_surf) {
-			SDL_BlitSurface(note2_surf, NULL, screen, &(SDL_Rect){(hw - note2_surf->w) / 2, note_y + SCALE1(14)});
-			SDL_FreeSurface(note2_surf);
-		}
+		int note2_w = GFX_sizeGlyphs(font.tiny, note2);
+		GFX_blitGlyphs(font.tiny, note2, COLOR_GRAY, screen, (hw - note2_w) / 2, note_y + SCALE1(14), 0);
 	}
 
 	// Toast notification
@@ -297,11 +288,7 @@ void render_radio_playing(SDL_Surface* screen, IndicatorType show_setting, int r
 
 	// Error message (displayed prominently if in error state)
 	if (state == RADIO_STATE_ERROR) {
-		SDL_Surface* err_text = TTF_RenderUTF8_Blended(font.small, Radio_getError(), (SDL_Color){255, 100, 100, 255});
-		if (err_text) {
-			SDL_BlitSurface(err_text, NULL, screen, &(SDL_Rect){SCALE1(PADDING), vis_y - SCALE1(20)});
-			SDL_FreeSurface(err_text);
-		}
+		GFX_blitGlyphs(font.small, Radio_getError(), (SDL_Color){255, 100, 100, 255}, screen, SCALE1(PADDING), vis_y - SCALE1(20), 0);
 	}
 }
 
@@ -342,11 +329,8 @@ void render_radio_add(SDL_Surface* screen, IndicatorType show_setting,
 		char count_str[32];
 		snprintf(count_str, sizeof(count_str), "%d stations", curated_station_count);
 		SDL_Color count_color = selected ? COLOR_GRAY : COLOR_DARK_TEXT;
-		SDL_Surface* count_text = TTF_RenderUTF8_Blended(font.tiny, count_str, count_color);
-		if (count_text) {
-			SDL_BlitSurface(count_text, NULL, screen, &(SDL_Rect){hw - count_text->w - SCALE1(PADDING * 2), y + (layout.item_h - count_text->h) / 2});
-			SDL_FreeSurface(count_text);
-		}
+		int count_text_w = GFX_sizeGlyphs(font.tiny, count_str);
+		GFX_blitGlyphs(font.tiny, count_str, count_color, screen, hw - count_text_w - SCALE1(PADDING * 2), y + (layout.item_h - TTF_FontHeight(font.tiny)) / 2, 0);
 	}
 
 	UI_renderScrollIndicators(screen, *add_country_scroll, layout.items_per_page, country_count);
@@ -429,11 +413,7 @@ void render_radio_add_stations(SDL_Surface* screen, IndicatorType show_setting,
 		// Added indicator prefix
 		if (added) {
 			SDL_Color prefix_color = Fonts_getListTextColor(selected);
-			SDL_Surface* prefix_text = TTF_RenderUTF8_Blended(font.small, "[+]", prefix_color);
-			if (prefix_text) {
-				SDL_BlitSurface(prefix_text, NULL, screen, &(SDL_Rect){text_x, y + (layout.item_h - prefix_text->h) / 2});
-				SDL_FreeSurface(prefix_text);
-			}
+			GFX_blitGlyphs(font.small, "[+]", prefix_color, screen, text_x, y + (layout.item_h - TTF_FontHeight(font.small)) / 2, 0);
 		}
 
 		// Station name
@@ -443,11 +423,8 @@ void render_radio_add_stations(SDL_Surface* screen, IndicatorType show_setting,
 		// Genre on right
 		if (station->genre[0]) {
 			SDL_Color genre_color = selected ? COLOR_GRAY : COLOR_DARK_TEXT;
-			SDL_Surface* genre_text = TTF_RenderUTF8_Blended(font.tiny, station->genre, genre_color);
-			if (genre_text) {
-				SDL_BlitSurface(genre_text, NULL, screen, &(SDL_Rect){hw - genre_text->w - SCALE1(PADDING * 2), y + (layout.item_h - genre_text->h) / 2});
-				SDL_FreeSurface(genre_text);
-			}
+			int genre_text_w = GFX_sizeGlyphs(font.tiny, station->genre);
+			GFX_blitGlyphs(font.tiny, station->genre, genre_color, screen, hw - genre_text_w - SCALE1(PADDING * 2), y + (layout.item_h - TTF_FontHeight(font.tiny)) / 2, 0);
 		}
 	}
 
@@ -553,11 +530,7 @@ void render_radio_help(SDL_Surface* screen, IndicatorType show_setting, int* hel
 			use_font = font.tiny;
 		}
 
-		SDL_Surface* line_text = TTF_RenderUTF8_Blended(use_font, lines[i], color);
-		if (line_text) {
-			SDL_BlitSurface(line_text, NULL, screen, &(SDL_Rect){left_padding, text_y});
-			SDL_FreeSurface(line_text);
-		}
+		GFX_blitGlyphs(use_font, lines[i], color, screen, left_padding, text_y, 0);
 		text_y += line_h;
 	}
 
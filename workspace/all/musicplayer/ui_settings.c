@@ -13,10 +13,11 @@
 #define SETTINGS_ITEM_SCREEN_OFF 0
 #define SETTINGS_ITEM_BASS_FILTER 1
 #define SETTINGS_ITEM_SOFT_LIMITER 2
-#define SETTINGS_ITEM_CLEAR_CACHE 3
-#define SETTINGS_ITEM_CLEAR_LYRICS 4
-#define SETTINGS_ITEM_UPDATE_YTDLP 5
-#define SETTINGS_ITEM_COUNT 6
+#define SETTINGS_ITEM_REPLAY_GAIN 3
+#define SETTINGS_ITEM_CLEAR_CACHE 4
+#define SETTINGS_ITEM_CLEAR_LYRICS 5
+#define SETTINGS_ITEM_UPDATE_YTDLP 6
+#define SETTINGS_ITEM_COUNT 7
 
 // Format cache size as human-readable string
 static void format_cache_size(long bytes, char* buf, int buf_size) {
@@ -52,6 +53,7 @@ void render_settings_menu(SDL_Surface* screen, IndicatorType show_setting, int m
 		{.label = "Auto Screen Off", .value = Settings_getScreenOffDisplayStr(), .swatch = -1, .cycleable = 1, .desc = "Turn off screen while music is playing"},
 		{.label = "Bass Filter", .value = Settings_getBassFilterDisplayStr(), .swatch = -1, .cycleable = 1, .desc = "High-pass filter to reduce speaker distortion"},
 		{.label = "Soft Limiter", .value = Settings_getSoftLimiterDisplayStr(), .swatch = -1, .cycleable = 1, .desc = "Limit volume peaks to prevent clipping"},
+		{.label = "ReplayGain", .value = Settings_getReplayGainDisplayStr(), .swatch = -1, .cycleable = 1, .desc = "Play all tracks at the same loudness"},
 		{.label = cache_label, .swatch = -1, .desc = "Delete cached album art images"},
 		{.label = lyrics_label, .swatch = -1, .desc = "Delete cached lyrics files"},
 		{.label = "Update yt-dlp", .swatch = -1, .desc = "Download the latest version of yt-dlp"},
@@ -63,7 +65,8 @@ void render_settings_menu(SDL_Surface* screen, IndicatorType show_setting, int m
 
 	bool is_cyclable = (menu_selected == SETTINGS_ITEM_SCREEN_OFF ||
 						menu_selected == SETTINGS_ITEM_BASS_FILTER ||
-						menu_selected == SETTINGS_ITEM_SOFT_LIMITER);
+						menu_selected == SETTINGS_ITEM_SOFT_LIMITER ||
+						menu_selected == SETTINGS_ITEM_REPLAY_GAIN);
 
 	UI_renderButtonHintBar(screen, (char*[]){
 									   "START", "CONTROLS",
@@ -1,6 +1,10 @@
 #include <dirent.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <stdint.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "content.h"
 #include "shortcuts.h"
 #include "api.h"
@@ -8,7 +12,7 @@
 
 static bool _simple_mode = false;
 
-// EMULIST_CACHE_PATH and ROMINDEX_CACHE_PATH defined in defines.h
+// ROMINDEX_CACHE_PATH defined in defines.h
 
 void Content_setSimpleMode(bool mode) {
 	_simple_mode = mode;
@@ -334,251 +338,1209 @@ int isConsoleDir(char* path) {
 }
 
 ///////////////////////////////////////
-// Content retrieval
+// ROM index
+//
+// A binary snapshot of every dir under ROMS_PATH and the roms inside the
+// ones that show up as consoles. The file is mmap'd read-only and laid out as
+// the header, dirs[], consoles[], roms[] (sorted by name) and finally a string
+// pool that every record points into. Each dir remembers its mtime so a
+// rescan only re-reads the dirs that actually changed.
+//
+// Copies made on a PC can keep old mtimes (FAT doesn't even update a dir's
+// mtime when files are added), so the first launch after a boot also lists
+// every dir and compares the entry count and a hash of the names. Later
+// launches trust mtimes, changes made on the device itself do update them.
+
+#define ROMINDEX_MAGIC 0x58444952 // "RIDX"
+#define ROMINDEX_VERSION 2
+
+typedef struct RomIndexHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size; // total file size, catches truncated writes
+	uint32_t dir_count;
+	uint32_t console_count;
+	uint32_t rom_count;
+	uint32_t strings_size;
+	uint32_t alpha_count;
+	uint32_t alphas[INT_ARRAY_MAX]; // first rom for each index char, same as Directory->alphas
+	int64_t roms_mtime;				// ROMS_PATH, catches added/removed console dirs
+	int64_t map_mtime;				// ROMS_PATH/map.txt
+	int64_t paks_mtime;				// system Emus dir, catches installed/removed emu paks
+	int64_t emus_mtime;				// user Emus dir
+	int64_t map_size;
+	uint32_t top_names; // names in ROMS_PATH and both Emus dirs, see RomIndex_listDir()
+	uint32_t reserved;
+} RomIndexHeader;
+
+typedef struct RomIndexDir {
+	int64_t mtime;
+	uint32_t name;		// dir name relative to ROMS_PATH
+	uint32_t has_files; // any non-hidden entry, see hasRoms()
+	uint32_t entries;	// non-hidden entries
+	uint32_t names;		// see RomIndex_listDir()
+} RomIndexDir;
+
+typedef struct RomIndexConsole {
+	uint32_t path;
+	uint32_t name;
+} RomIndexConsole;
+
+typedef struct RomIndexRom {
+	uint32_t path;
+	uint32_t name; // "display name (console name)"
+	uint32_t dir;
+	uint32_t alpha;
+} RomIndexRom;
+
+static struct {
+	void* data;
+	size_t size;
+	int mapped; // data is an mmap of ROMINDEX_CACHE_PATH, otherwise malloc'd
+	int checked; // already compared against the filesystem this launch
+	const RomIndexHeader* header;
+	const RomIndexDir* dirs;
+	const RomIndexConsole* consoles;
+	const RomIndexRom* roms;
+	const char* strings;
+} romindex;
+static uint32_t romindex_generation = 0; // bumped whenever a different index is attached
+
+static const char* RomIndex_string(uint32_t offset) {
+	return romindex.strings + offset;
+}
 
-static void writeRomsCache(Array* entries) {
-	FILE* file = fopen(EMULIST_CACHE_PATH, "w");
-	if (!file)
-		return;
-	for (int i = 0; i < entries->count; i++) {
-		Entry* entry = entries->items[i];
-		fputs(entry->path, file);
-		fputc('\t', file);
-		fputs(entry->name, file);
-		fputc('\n', file);
+static int64_t getMtime(const char* path) {
+	struct stat st;
+	if (stat(path, &st) != 0)
+		return 0;
+	return (int64_t)st.st_mtime;
+}
+
+// Lists the non-hidden entries of a dir, pushing file names to files if
+// given. names is an order independent hash of every entry's name.
+static int RomIndex_listDir(const char* path, uint32_t* entries, uint32_t* names, Array* files) {
+	*entries = 0;
+	*names = 0;
+	DIR* dh = opendir(path);
+	if (!dh)
+		return 0;
+	struct dirent* dp;
+	while ((dp = readdir(dh)) != NULL) {
+		if (hide(dp->d_name))
+			continue;
+		uint32_t hash = 2166136261u; // FNV-1a
+		for (const char* c = dp->d_name; *c; c++) {
+			hash ^= (unsigned char)*c;
+			hash *= 16777619u;
+		}
+		*entries += 1;
+		*names += hash;
+		if (files && dp->d_type != DT_DIR)
+			Array_push(files, strdup(dp->d_name));
 	}
-	fclose(file);
+	closedir(dh);
+	return 1;
 }
 
-static Array* readRomsCache(void) {
-	FILE* file = fopen(EMULIST_CACHE_PATH, "r");
+static void RomIndex_stamp(RomIndexHeader* header, int list) {
+	char path[MAX_PATH];
+	char paks_path[MAX_PATH];
+	char emus_path[MAX_PATH];
+	struct stat st;
+	header->roms_mtime = getMtime(ROMS_PATH);
+	snprintf(path, sizeof(path), "%s/map.txt", ROMS_PATH);
+	header->map_mtime = 0;
+	header->map_size = 0;
+	if (stat(path, &st) == 0) {
+		header->map_mtime = (int64_t)st.st_mtime;
+		header->map_size = (int64_t)st.st_size;
+	}
+	snprintf(paks_path, sizeof(paks_path), "%s/Emus", PAKS_PATH);
+	header->paks_mtime = getMtime(paks_path);
+	snprintf(emus_path, sizeof(emus_path), "%s/Emus/%s", SDCARD_PATH, PLATFORM);
+	header->emus_mtime = getMtime(emus_path);
+
+	header->top_names = 0;
+	if (list) {
+		const char* paths[] = {ROMS_PATH, paks_path, emus_path};
+		for (int i = 0; i < 3; i++) {
+			uint32_t entries, names;
+			RomIndex_listDir(paths[i], &entries, &names, NULL);
+			header->top_names += names * (i + 1) + entries;
+		}
+	}
+}
+
+static void RomIndex_close(void) {
+	if (romindex.data) {
+		if (romindex.mapped)
+			munmap(romindex.data, romindex.size);
+		else
+			free(romindex.data);
+	}
+	memset(&romindex, 0, sizeof(romindex));
+}
+
+static int RomIndex_attach(void* data, size_t size, int mapped) {
+	const RomIndexHeader* header = data;
+	if (size < sizeof(RomIndexHeader) || header->magic != ROMINDEX_MAGIC ||
+		header->version != ROMINDEX_VERSION || header->size != size)
+		return 0;
+
+	uint64_t expected = sizeof(RomIndexHeader) +
+						(uint64_t)header->dir_count * sizeof(RomIndexDir) +
+						(uint64_t)header->console_count * sizeof(RomIndexConsole) +
+						(uint64_t)header->rom_count * sizeof(RomIndexRom) +
+						header->strings_size;
+	if (expected != size || header->strings_size == 0 || header->alpha_count > INT_ARRAY_MAX)
+		return 0;
+
+	const RomIndexDir* dirs = (const RomIndexDir*)((const char*)data + sizeof(RomIndexHeader));
+	const RomIndexConsole* consoles = (const RomIndexConsole*)(dirs + header->dir_count);
+	const RomIndexRom* roms = (const RomIndexRom*)(consoles + header->console_count);
+	const char* strings = (const char*)(roms + header->rom_count);
+
+	// the pool ends in a NUL so any in-range offset is a valid string
+	uint32_t limit = header->strings_size;
+	if (strings[limit - 1] != '\0')
+		return 0;
+	for (uint32_t i = 0; i < header->dir_count; i++) {
+		if (dirs[i].name >= limit)
+			return 0;
+	}
+	for (uint32_t i = 0; i < header->console_count; i++) {
+		if (consoles[i].path >= limit || consoles[i].name >= limit)
+			return 0;
+	}
+	for (uint32_t i = 0; i < header->rom_count; i++) {
+		if (roms[i].path >= limit || roms[i].name >= limit || roms[i].dir >= header->dir_count)
+			return 0;
+	}
+
+	RomIndex_close();
+	romindex.data = data;
+	romindex.size = size;
+	romindex.mapped = mapped;
+	romindex.header = header;
+	romindex.dirs = dirs;
+	romindex.consoles = consoles;
+	romindex.roms = roms;
+	romindex.strings = strings;
+	romindex_generation++;
+	return 1;
+}
+
+static int RomIndex_map(void) {
+	int fd = open(ROMINDEX_CACHE_PATH, O_RDONLY);
+	if (fd < 0)
+		return 0;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(RomIndexHeader)) {
+		close(fd);
+		return 0;
+	}
+
+	void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return 0;
+
+	if (!RomIndex_attach(data, st.st_size, 1)) {
+		LOG_warn("ignoring stale or corrupt rom index\n");
+		munmap(data, st.st_size);
+		return 0;
+	}
+	return 1;
+}
+
+static int RomIndex_write(const void* data, size_t size) {
+	char tmp_path[MAX_PATH];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", ROMINDEX_CACHE_PATH);
+
+	FILE* file = fopen(tmp_path, "wb");
 	if (!file)
+		return 0;
+	int ok = fwrite(data, 1, size, file) == size;
+	ok = fflush(file) == 0 && ok;
+	if (ok)
+		fsync(fileno(file));
+	ok = fclose(file) == 0 && ok;
+
+	// rename() keeps readers on either the old or the new index, never half of one
+	if (!ok || rename(tmp_path, ROMINDEX_CACHE_PATH) != 0) {
+		unlink(tmp_path);
+		return 0;
+	}
+	return 1;
+}
+
+// With list, dirs whose listing no longer matches are flagged in stale
+static int RomIndex_isFresh(int list, uint8_t* stale) {
+	const RomIndexHeader* header = romindex.header;
+	RomIndexHeader stamp;
+	RomIndex_stamp(&stamp, list);
+	int fresh = stamp.roms_mtime == header->roms_mtime && stamp.map_mtime == header->map_mtime &&
+				stamp.map_size == header->map_size &&
+				stamp.paks_mtime == header->paks_mtime && stamp.emus_mtime == header->emus_mtime &&
+				(!list || stamp.top_names == header->top_names);
+
+	// a listing keeps going, RomIndex_build() only rescans by mtime otherwise
+	char path[MAX_PATH];
+	for (uint32_t i = 0; i < header->dir_count && (fresh || list); i++) {
+		const RomIndexDir* dir = &romindex.dirs[i];
+		snprintf(path, sizeof(path), "%s/%s", ROMS_PATH, RomIndex_string(dir->name));
+		if (getMtime(path) != dir->mtime) {
+			fresh = 0;
+			continue;
+		}
+		if (list) {
+			uint32_t entries, names;
+			RomIndex_listDir(path, &entries, &names, NULL);
+			if (entries != dir->entries || names != dir->names) {
+				stale[i] = 1;
+				fresh = 0;
+			}
+		}
+	}
+	return fresh;
+}
+
+static int RomIndex_findDir(const char* name) {
+	if (!romindex.header)
+		return -1;
+	for (uint32_t i = 0; i < romindex.header->dir_count; i++) {
+		if (exactMatch((char*)RomIndex_string(romindex.dirs[i].name), (char*)name))
+			return i;
+	}
+	return -1;
+}
+
+typedef struct RomIndexScan {
+	char* name;
+	int64_t mtime;
+	int has_files;
+	uint32_t entries;
+	uint32_t names;
+	int old_dir; // matching dir in the previous index whose roms are still valid, or -1
+	Array* files;
+} RomIndexScan;
+
+// indexed: per dir of the previous index, whether it was indexed as a console
+// with roms. Other dirs are always rescanned, an emu pak installed since then
+// may have turned them into a console.
+static RomIndexScan* RomIndexScan_new(const char* name, const uint8_t* indexed) {
+	char path[MAX_PATH];
+	snprintf(path, sizeof(path), "%s/%s", ROMS_PATH, name);
+
+	struct stat st;
+	if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode))
 		return NULL;
 
-	Array* entries = Array_new();
+	RomIndexScan* self = malloc(sizeof(RomIndexScan));
+	self->name = strdup(name);
+	self->mtime = (int64_t)st.st_mtime;
+	self->has_files = 0;
+	self->old_dir = -1;
+	self->files = Array_new();
+
+	int old_dir = RomIndex_findDir(name);
+	if (old_dir >= 0 && indexed && indexed[old_dir] && romindex.dirs[old_dir].mtime == self->mtime) {
+		self->old_dir = old_dir;
+		self->has_files = romindex.dirs[old_dir].has_files;
+		self->entries = romindex.dirs[old_dir].entries;
+		self->names = romindex.dirs[old_dir].names;
+		return self;
+	}
+
+	RomIndex_listDir(path, &self->entries, &self->names, self->files);
+	self->has_files = self->entries > 0;
+	return self;
+}
+
+static void RomIndexScan_free(RomIndexScan* self) {
+	free(self->name);
+	StringArray_free(self->files);
+	free(self);
+}
+
+typedef struct RomIndexPool {
+	char* data;
+	uint32_t size;
+	uint32_t capacity;
+	int failed;
+} RomIndexPool;
+
+static uint32_t RomIndexPool_add(RomIndexPool* self, const char* str) {
+	size_t len = strlen(str) + 1;
+	if (self->size + len > self->capacity) {
+		size_t capacity = self->capacity ? self->capacity : 64 * 1024;
+		while (self->size + len > capacity)
+			capacity *= 2;
+		char* tmp = capacity <= UINT32_MAX ? realloc(self->data, capacity) : NULL;
+		if (!tmp) {
+			self->failed = 1;
+			return 0;
+		}
+		self->data = tmp;
+		self->capacity = capacity;
+	}
+	uint32_t offset = self->size;
+	memcpy(self->data + offset, str, len);
+	self->size += len;
+	return offset;
+}
+
+static const char* romindex_sort_strings = NULL;
+static int RomIndex_sortRom(const void* a, const void* b) {
+	const RomIndexRom* rom1 = a;
+	const RomIndexRom* rom2 = b;
+	return strcasecmp(romindex_sort_strings + rom1->name, romindex_sort_strings + rom2->name);
+}
+
+static void applyRomsMap(Array* entries) {
+	char map_path[MAX_PATH];
+	snprintf(map_path, sizeof(map_path), "%s/map.txt", ROMS_PATH);
+	if (entries->count == 0 || !exists(map_path))
+		return;
+
+	FILE* file = fopen(map_path, "r");
+	if (!file)
+		return;
+
+	Hash* map = Hash_new();
 	char line[MAX_PATH];
-	while (fgets(line, sizeof(line), file) != NULL) {
+	while (fgets(line, sizeof(line), file)) {
 		normalizeNewline(line);
 		trimTrailingNewlines(line);
 		if (strlen(line) == 0)
 			continue;
 
-		char* tab = strchr(line, '\t');
-		if (!tab) {
-			EntryArray_free(entries);
-			fclose(file);
-			return NULL; // malformed cache, force rescan
+		char* tmp = strchr(line, '\t');
+		if (tmp) {
+			*tmp = '\0';
+			char* key = line;
+			char* value = tmp + 1;
+			Hash_set(map, key, value);
 		}
-		*tab = '\0';
-		char* path = line;
-		char* name = tab + 1;
-		Array_push(entries, Entry_newNamed(path, ENTRY_DIR, name));
 	}
 	fclose(file);
-	return entries;
-}
 
-static void writeRomIndexCache(Array* entries) {
-	FILE* file = fopen(ROMINDEX_CACHE_PATH, "w");
-	if (!file)
-		return;
+	bool resort = false;
 	for (int i = 0; i < entries->count; i++) {
 		Entry* entry = entries->items[i];
-		fputs(entry->path, file);
-		fputc('\t', file);
-		fputs(entry->name, file);
-		fputc('\n', file);
+		char* slash = strrchr(entry->path, '/');
+		if (!slash)
+			continue;
+		char* filename = slash + 1;
+		char* alias = Hash_get(map, filename);
+		if (alias) {
+			free(entry->name);
+			entry->name = strdup(alias);
+			resort = true;
+		}
 	}
-	fclose(file);
+	if (resort)
+		EntryArray_sort(entries);
+	Hash_free(map);
 }
 
-static Array* readRomIndexCache(void) {
-	FILE* file = fopen(ROMINDEX_CACHE_PATH, "r");
-	if (!file)
-		return NULL;
-
+static Array* scanConsoles(Array* scans) {
 	Array* entries = Array_new();
-	char line[MAX_PATH * 2];
-	while (fgets(line, sizeof(line), file) != NULL) {
-		normalizeNewline(line);
-		trimTrailingNewlines(line);
-		if (strlen(line) == 0)
+	Array* emus = Array_new();
+	char emu_name[MAX_PATH];
+	char full_path[MAX_PATH];
+	for (int i = 0; i < scans->count; i++) {
+		RomIndexScan* scan = scans->items[i];
+		if (!scan->has_files)
 			continue;
+		getEmuName(scan->name, emu_name);
+		if (!hasEmu(emu_name))
+			continue;
+		snprintf(full_path, sizeof(full_path), "%s/%s", ROMS_PATH, scan->name);
+		Array_push(emus, Entry_new(full_path, ENTRY_DIR));
+	}
 
-		char* tab = strchr(line, '\t');
-		if (!tab) {
-			EntryArray_free(entries);
-			fclose(file);
-			return NULL;
+	EntryArray_sort(emus);
+	Entry* prev_entry = NULL;
+	for (int i = 0; i < emus->count; i++) {
+		Entry* entry = emus->items[i];
+		if (prev_entry && exactMatch(prev_entry->name, entry->name)) {
+			Entry_free(entry);
+			continue;
 		}
-		*tab = '\0';
-		char* path = line;
-		char* name = tab + 1;
-		Array_push(entries, Entry_newNamed(path, ENTRY_ROM, name));
+		Array_push(entries, entry);
+		prev_entry = entry;
 	}
-	fclose(file);
+	Array_free(emus);
+
+	applyRomsMap(entries);
 	return entries;
 }
 
-void Content_invalidateEmulist(void) {
-	unlink(EMULIST_CACHE_PATH);
-	unlink(ROMINDEX_CACHE_PATH);
+// stale: dirs of the previous index to rescan even if their mtime matches
+static int RomIndex_build(const uint8_t* stale) {
+	RomIndexHeader header = {0};
+	header.magic = ROMINDEX_MAGIC;
+	header.version = ROMINDEX_VERSION;
+	RomIndex_stamp(&header, 1);
+
+	// the previous index is only trusted per dir, and only the dir list
+	// itself when ROMS_PATH hasn't changed since it was written
+	uint8_t* indexed = NULL;
+	if (romindex.header) {
+		indexed = calloc(romindex.header->dir_count + 1, 1);
+		for (uint32_t i = 0; indexed && i < romindex.header->rom_count; i++)
+			indexed[romindex.roms[i].dir] = !(stale && stale[romindex.roms[i].dir]);
+	}
+
+	Array* scans = Array_new();
+	if (romindex.header && romindex.header->roms_mtime == header.roms_mtime &&
+		romindex.header->top_names == header.top_names) {
+		for (uint32_t i = 0; i < romindex.header->dir_count; i++) {
+			RomIndexScan* scan = RomIndexScan_new(RomIndex_string(romindex.dirs[i].name), indexed);
+			if (scan)
+				Array_push(scans, scan);
+		}
+	} else {
+		DIR* dh = opendir(ROMS_PATH);
+		if (dh) {
+			struct dirent* dp;
+			while ((dp = readdir(dh)) != NULL) {
+				if (hide(dp->d_name))
+					continue;
+				RomIndexScan* scan = RomIndexScan_new(dp->d_name, indexed);
+				if (scan)
+					Array_push(scans, scan);
+			}
+			closedir(dh);
+		}
+	}
+	free(indexed);
+
+	// carry over the roms of unchanged dirs in a single pass over the old index
+	if (romindex.header) {
+		RomIndexScan** reused = calloc(romindex.header->dir_count + 1, sizeof(RomIndexScan*));
+		if (!reused) {
+			for (int i = 0; i < scans->count; i++)
+				RomIndexScan_free(scans->items[i]);
+			Array_free(scans);
+			return 0;
+		}
+		for (int i = 0; i < scans->count; i++) {
+			RomIndexScan* scan = scans->items[i];
+			if (scan->old_dir >= 0)
+				reused[scan->old_dir] = scan;
+		}
+		for (uint32_t i = 0; i < romindex.header->rom_count; i++) {
+			const RomIndexRom* rom = &romindex.roms[i];
+			RomIndexScan* scan = reused[rom->dir];
+			if (!scan)
+				continue;
+			char* slash = strrchr(RomIndex_string(rom->path), '/');
+			if (slash)
+				Array_push(scan->files, strdup(slash + 1));
+		}
+		free(reused);
+	}
+	RomIndex_close();
+
+	Array* consoles = scanConsoles(scans);
+
+	RomIndexPool pool = {0};
+	RomIndexPool_add(&pool, ""); // keeps offset 0 harmless
+
+	header.dir_count = scans->count;
+	header.console_count = consoles->count;
+	RomIndexDir* dirs = calloc(scans->count + 1, sizeof(RomIndexDir));
+	RomIndexConsole* consoles_out = calloc(consoles->count + 1, sizeof(RomIndexConsole));
+	int* console_dirs = calloc(consoles->count + 1, sizeof(int));
+
+	for (int i = 0; dirs && i < scans->count; i++) {
+		RomIndexScan* scan = scans->items[i];
+		dirs[i].mtime = scan->mtime;
+		dirs[i].name = RomIndexPool_add(&pool, scan->name);
+		dirs[i].has_files = scan->has_files;
+		dirs[i].entries = scan->entries;
+		dirs[i].names = scan->names;
+	}
+
+	size_t rom_count = 0;
+	for (int i = 0; consoles_out && console_dirs && i < consoles->count; i++) {
+		Entry* console_entry = consoles->items[i];
+		consoles_out[i].path = RomIndexPool_add(&pool, console_entry->path);
+		consoles_out[i].name = RomIndexPool_add(&pool, console_entry->name);
+
+		char* slash = strrchr(console_entry->path, '/');
+		console_dirs[i] = -1;
+		for (int j = 0; slash && j < scans->count; j++) {
+			RomIndexScan* scan = scans->items[j];
+			if (exactMatch(scan->name, slash + 1)) {
+				console_dirs[i] = j;
+				rom_count += scan->files->count;
+				break;
+			}
+		}
+	}
+
+	RomIndexRom* roms = calloc(rom_count + 1, sizeof(RomIndexRom));
+	header.rom_count = 0;
+	if (roms && consoles_out && console_dirs) {
+		char rom_path[MAX_PATH];
+		char display_name[MAX_PATH];
+		char full_display[MAX_PATH];
+		for (int i = 0; i < consoles->count; i++) {
+			if (console_dirs[i] < 0)
+				continue;
+			Entry* console_entry = consoles->items[i];
+			RomIndexScan* scan = scans->items[console_dirs[i]];
+			for (int j = 0; j < scan->files->count; j++) {
+				snprintf(rom_path, sizeof(rom_path), "%s/%s", console_entry->path, (char*)scan->files->items[j]);
+				getDisplayName(rom_path, display_name);
+				snprintf(full_display, sizeof(full_display), "%s (%s)", display_name, console_entry->name);
+
+				RomIndexRom* rom = &roms[header.rom_count++];
+				rom->path = RomIndexPool_add(&pool, rom_path);
+				rom->name = RomIndexPool_add(&pool, full_display);
+				rom->dir = console_dirs[i];
+			}
+		}
+	}
+
+	char* image = NULL;
+	size_t size = 0;
+	if (dirs && consoles_out && console_dirs && roms && !pool.failed) {
+		romindex_sort_strings = pool.data;
+		qsort(roms, header.rom_count, sizeof(RomIndexRom), RomIndex_sortRom);
+		romindex_sort_strings = NULL;
+
+		int alpha = -1;
+		for (uint32_t i = 0; i < header.rom_count; i++) {
+			int a = getIndexChar(pool.data + roms[i].name);
+			if (a != alpha) {
+				if (header.alpha_count < INT_ARRAY_MAX)
+					header.alphas[header.alpha_count++] = i;
+				alpha = a;
+			}
+			roms[i].alpha = header.alpha_count - 1;
+		}
+
+		size_t dirs_size = header.dir_count * sizeof(RomIndexDir);
+		size_t consoles_size = header.console_count * sizeof(RomIndexConsole);
+		size_t roms_size = header.rom_count * sizeof(RomIndexRom);
+		size = sizeof(RomIndexHeader) + dirs_size + consoles_size + roms_size + pool.size;
+		header.strings_size = pool.size;
+		header.size = size;
+
+		image = size <= UINT32_MAX ? malloc(size) : NULL;
+		if (image) {
+			char* out = image;
+			memcpy(out, &header, sizeof(RomIndexHeader));
+			out += sizeof(RomIndexHeader);
+			memcpy(out, dirs, dirs_size);
+			out += dirs_size;
+			memcpy(out, consoles_out, consoles_size);
+			out += consoles_size;
+			memcpy(out, roms, roms_size);
+			out += roms_size;
+			memcpy(out, pool.data, pool.size);
+		}
+	}
+
+	free(dirs);
+	free(consoles_out);
+	free(console_dirs);
+	free(roms);
+	free(pool.data);
+	EntryArray_free(consoles);
+	for (int i = 0; i < scans->count; i++)
+		RomIndexScan_free(scans->items[i]);
+	Array_free(scans);
+
+	if (!image) {
+		LOG_error("unable to build rom index\n");
+		return 0;
+	}
+
+	// prefer the mapping of the file just written so the heap copy can go,
+	// but keep serving from memory if the card is read-only or full
+	if (RomIndex_write(image, size) && RomIndex_map()) {
+		free(image);
+		return 1;
+	}
+	return RomIndex_attach(image, size, 0);
 }
 
-Array* Content_searchRoms(const char* query) {
-	Array* all_roms = readRomIndexCache();
-	if (!all_roms) {
-		// Force a build by calling getRoms() (which populates both caches)
-		Array* consoles = getRoms();
-		EntryArray_free(consoles);
-		all_roms = readRomIndexCache();
-		if (!all_roms)
-			return Array_new();
+static int RomIndex_open(void) {
+	if (romindex.header && romindex.checked)
+		return 1;
+	if (!romindex.header)
+		RomIndex_map();
+
+	// list every dir once per boot, see the top of this section
+	int list = !exists(ROMINDEX_CHECKED_PATH);
+	uint8_t* stale = NULL;
+	if (romindex.header && list) {
+		stale = calloc(romindex.header->dir_count + 1, 1);
+		list = stale != NULL;
 	}
+	int ok = 1;
+	if (!romindex.header || !RomIndex_isFresh(list, stale))
+		ok = RomIndex_build(stale);
+	free(stale);
+	if (!ok)
+		return 0;
+	if (list)
+		touch(ROMINDEX_CHECKED_PATH);
+	romindex.checked = 1;
+	return 1;
+}
 
-	if (!query || strlen(query) == 0)
-		return all_roms;
+///////////////////////////////////////
+// ROM search
+//
+// Built once per session over the ROM index: every name is folded (case,
+// accents, punctuation) into one pool, and a trigram index over the folded
+// names narrows each query down before the actual substring checks. Tokens
+// starting with '@' filter by console tag or name. When nothing matches
+// exactly, tokens of 4+ chars are retried allowing one typo (two for 8+).
+// A query that extends the previous one only re-checks the previous matches.
+
+#define SEARCH_SYMBOLS 38 // space, a-z, 0-9, anything else
+#define SEARCH_TRIGRAMS (SEARCH_SYMBOLS * SEARCH_SYMBOLS * SEARCH_SYMBOLS)
+#define SEARCH_MAX_TOKENS 8
+#define SEARCH_MAX_TOKEN 64
+
+// Latin-1 Supplement and Latin Extended-A folded to their base letter,
+// indexed by codepoint - 0xC0, a space splits words like punctuation does
+static const char search_fold_latin[] =
+	"aaaaaaaceeeeiiii"	// U+00C0
+	"dnooooo ouuuuyts"	// U+00D0
+	"aaaaaaaceeeeiiii"	// U+00E0
+	"dnooooo ouuuuyty"	// U+00F0
+	"aaaaaaccccccccdd"	// U+0100
+	"ddeeeeeeeeeegggg"	// U+0110
+	"gggghhhhiiiiiiii"	// U+0120
+	"iiiijjkkklllllll"	// U+0130
+	"lllnnnnnnnnnoooo"	// U+0140
+	"oooorrrrrrssssss"	// U+0150
+	"ssttttttuuuuuuuu"	// U+0160
+	"uuuuwwyyyzzzzzzs"; // U+0170
+
+typedef struct SearchToken {
+	char text[SEARCH_MAX_TOKEN];
+	int len;
+	int filter; // '@' token, matches the console instead of the name
+	uint64_t mask;
+} SearchToken;
+
+static struct {
+	uint32_t generation; // romindex_generation this was built from
+	uint32_t count;
+	char* folded;
+	uint32_t* folded_offsets;
+	uint32_t* trigram_starts; // SEARCH_TRIGRAMS + 1 offsets into postings
+	uint32_t* postings;		  // rom ids, ascending per trigram
+	uint64_t* masks;		  // which symbols appear in each folded name
+	char** dir_tags;		  // folded emu tag per romindex dir, eg. "gba"
+	char** dir_names;		  // folded console name per romindex dir
+	uint32_t dir_count;
+	// scratch, sized to count
+	uint32_t* ids;
+	uint32_t* scores;
+	uint16_t* hits;
+	// previous query, for refining
+	char last_query[MAX_PATH];
+	uint32_t* last_ids;
+	uint32_t last_count;
+	int last_valid;
+} search;
+
+// Lowercases, folds accents and collapses everything that isn't a letter or
+// digit into single spaces so "Pokémon: Red" and "pokemon red" compare equal.
+// Other non-ASCII text (eg. Japanese titles) is kept as is.
+static int foldSearchText(const char* in, char* out, int out_size) {
+	const unsigned char* s = (const unsigned char*)in;
+	int len = 0;
+	int space = 1; // drop leading spaces
+	while (*s && len < out_size - 4) {
+		unsigned char c = *s;
+		char f;
+		if (c < 0x80) {
+			s++;
+			if (c == '\'')
+				continue; // "Link's" searches as "links"
+			f = isalnum(c) ? tolower(c) : ' ';
+		} else if ((c & 0xE0) == 0xC0 && (s[1] & 0xC0) == 0x80) {
+			unsigned cp = ((c & 0x1F) << 6) | (s[1] & 0x3F);
+			if (cp < 0xC0 || cp >= 0x180) {
+				out[len++] = s[0];
+				out[len++] = s[1];
+				s += 2;
+				space = 0;
+				continue;
+			}
+			s += 2;
+			f = search_fold_latin[cp - 0xC0];
+		} else if (c == 0xE2 && s[1] == 0x80 && s[2] == 0x99) {
+			s += 3; // right single quotation mark, same as '
+			continue;
+		} else {
+			out[len++] = *s++;
+			while ((*s & 0xC0) == 0x80 && len < out_size - 1)
+				out[len++] = *s++;
+			space = 0;
+			continue;
+		}
 
-	Array* results = Array_new();
-	for (int i = 0; i < all_roms->count; i++) {
-		Entry* entry = all_roms->items[i];
-		if (containsString(entry->name, (char*)query)) {
-			Array_push(results, entry);
+		if (f == ' ') {
+			if (space)
+				continue;
+			space = 1;
 		} else {
-			Entry_free(entry);
+			space = 0;
 		}
+		out[len++] = f;
 	}
-	Array_free(all_roms);
-	return results;
+	if (len > 0 && out[len - 1] == ' ')
+		len--;
+	out[len] = '\0';
+	return len;
 }
 
-Array* getRoms(void) {
-	// Try loading from cache first
-	Array* entries = readRomsCache();
-	if (entries)
-		return entries;
+static inline int searchSymbol(unsigned char c) {
+	if (c == ' ')
+		return 0;
+	if (c >= 'a' && c <= 'z')
+		return 1 + c - 'a';
+	if (c >= '0' && c <= '9')
+		return 27 + c - '0';
+	return 37;
+}
 
-	// Cache miss: full filesystem scan
-	entries = Array_new();
-	DIR* dh = opendir(ROMS_PATH);
-	if (dh) {
-		struct dirent* dp;
-		char full_path[MAX_PATH];
-		snprintf(full_path, sizeof(full_path), "%s/", ROMS_PATH);
-		char* tmp = full_path + strlen(full_path);
+static inline uint32_t searchTrigram(const char* s) {
+	return (searchSymbol(s[0]) * SEARCH_SYMBOLS + searchSymbol(s[1])) * SEARCH_SYMBOLS + searchSymbol(s[2]);
+}
 
-		Array* emus = Array_new();
-		size_t remaining = sizeof(full_path) - (tmp - full_path);
-		while ((dp = readdir(dh)) != NULL) {
-			if (hide(dp->d_name))
+static uint64_t Search_mask(const char* text) {
+	uint64_t mask = 0;
+	for (const char* c = text; *c; c++)
+		mask |= 1ULL << searchSymbol(*c);
+	return mask;
+}
+
+void Content_freeSearch(void) {
+	free(search.folded);
+	free(search.folded_offsets);
+	free(search.trigram_starts);
+	free(search.postings);
+	free(search.masks);
+	for (uint32_t i = 0; i < search.dir_count; i++) {
+		free(search.dir_tags[i]);
+		free(search.dir_names[i]);
+	}
+	free(search.dir_tags);
+	free(search.dir_names);
+	free(search.ids);
+	free(search.scores);
+	free(search.hits);
+	free(search.last_ids);
+	memset(&search, 0, sizeof(search));
+}
+
+static int Search_build(void) {
+	Content_freeSearch();
+
+	uint32_t count = romindex.header->rom_count;
+	search.generation = romindex_generation;
+	search.count = count;
+	search.folded_offsets = malloc((count + 1) * sizeof(uint32_t));
+	search.trigram_starts = calloc(SEARCH_TRIGRAMS + 1, sizeof(uint32_t));
+	search.ids = malloc((count + 1) * sizeof(uint32_t));
+	search.scores = malloc((count + 1) * sizeof(uint32_t));
+	search.hits = malloc((count + 1) * sizeof(uint16_t));
+	search.last_ids = malloc((count + 1) * sizeof(uint32_t));
+	search.masks = malloc((count + 1) * sizeof(uint64_t));
+	uint32_t* last_seen = calloc(SEARCH_TRIGRAMS, sizeof(uint32_t));
+	if (!search.folded_offsets || !search.trigram_starts || !search.ids || !search.scores ||
+		!search.hits || !search.last_ids || !search.masks || !last_seen)
+		goto fail;
+
+	// folded names, the pool can't grow past the raw names
+	search.folded = malloc(romindex.header->strings_size);
+	if (!search.folded)
+		goto fail;
+	uint32_t size = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		search.folded_offsets[i] = size;
+		char* name = search.folded + size;
+		size += foldSearchText(RomIndex_string(romindex.roms[i].name), name, MAX_PATH) + 1;
+		search.masks[i] = Search_mask(name);
+	}
+	search.folded_offsets[count] = size;
+
+	// count each distinct trigram once per name, then lay the postings out
+	for (uint32_t i = 0; i < count; i++) {
+		const char* name = search.folded + search.folded_offsets[i];
+		for (int j = 0; name[j] && name[j + 1] && name[j + 2]; j++) {
+			uint32_t key = searchTrigram(name + j);
+			if (last_seen[key] == i + 1)
 				continue;
-			if (hasRoms(dp->d_name)) {
-				strncpy(tmp, dp->d_name, remaining - 1);
-				full_path[MAX_PATH - 1] = '\0';
-				Array_push(emus, Entry_new(full_path, ENTRY_DIR));
+			last_seen[key] = i + 1;
+			search.trigram_starts[key + 1]++;
+		}
+	}
+	for (uint32_t key = 0; key < SEARCH_TRIGRAMS; key++)
+		search.trigram_starts[key + 1] += search.trigram_starts[key];
+
+	search.postings = malloc((search.trigram_starts[SEARCH_TRIGRAMS] + 1) * sizeof(uint32_t));
+	if (!search.postings)
+		goto fail;
+	uint32_t* fill = malloc(SEARCH_TRIGRAMS * sizeof(uint32_t)); // per-trigram write cursors
+	if (!fill)
+		goto fail;
+	memset(last_seen, 0, SEARCH_TRIGRAMS * sizeof(uint32_t));
+	memcpy(fill, search.trigram_starts, SEARCH_TRIGRAMS * sizeof(uint32_t));
+	for (uint32_t i = 0; i < count; i++) {
+		const char* name = search.folded + search.folded_offsets[i];
+		for (int j = 0; name[j] && name[j + 1] && name[j + 2]; j++) {
+			uint32_t key = searchTrigram(name + j);
+			if (last_seen[key] == i + 1)
+				continue;
+			last_seen[key] = i + 1;
+			search.postings[fill[key]++] = i;
+		}
+	}
+	free(fill);
+	free(last_seen);
+	last_seen = NULL;
+
+	// console tags and names for '@' filters
+	uint32_t dir_count = romindex.header->dir_count;
+	search.dir_tags = calloc(dir_count + 1, sizeof(char*));
+	search.dir_names = calloc(dir_count + 1, sizeof(char*));
+	if (!search.dir_tags || !search.dir_names)
+		goto fail;
+	search.dir_count = dir_count;
+	char folded[MAX_PATH];
+	char emu_name[MAX_PATH];
+	for (uint32_t i = 0; i < dir_count; i++) {
+		const char* dir_name = RomIndex_string(romindex.dirs[i].name);
+		getEmuName(dir_name, emu_name);
+		foldSearchText(emu_name, folded, sizeof(folded));
+		search.dir_tags[i] = strdup(folded);
+		folded[0] = '\0';
+		for (uint32_t j = 0; j < romindex.header->console_count; j++) {
+			const char* path = RomIndex_string(romindex.consoles[j].path);
+			const char* slash = strrchr(path, '/');
+			if (slash && exactMatch((char*)slash + 1, (char*)dir_name)) {
+				foldSearchText(RomIndex_string(romindex.consoles[j].name), folded, sizeof(folded));
+				break;
 			}
 		}
-		closedir(dh);
+		search.dir_names[i] = strdup(folded);
+	}
+	return 1;
 
-		EntryArray_sort(emus);
-		Entry* prev_entry = NULL;
-		for (int i = 0; i < emus->count; i++) {
-			Entry* entry = emus->items[i];
-			if (prev_entry && exactMatch(prev_entry->name, entry->name)) {
-				Entry_free(entry);
+fail:
+	free(last_seen);
+	Content_freeSearch();
+	LOG_error("unable to build rom search index\n");
+	return 0;
+}
+
+// Splits an already folded query into tokens, '@' survives folding only as
+// the first char of a raw token so filters are tagged before folding
+static int Search_tokenize(const char* query, SearchToken* tokens, char* normalized, int normalized_size) {
+	char raw[MAX_PATH];
+	strncpy(raw, query, sizeof(raw) - 1);
+	raw[sizeof(raw) - 1] = '\0';
+
+	int count = 0;
+	normalized[0] = '\0';
+	char* save = NULL;
+	for (char* word = strtok_r(raw, " \t", &save); word; word = strtok_r(NULL, " \t", &save)) {
+		int filter = word[0] == '@';
+		char folded[MAX_PATH];
+		foldSearchText(word + filter, folded, sizeof(folded));
+
+		char* save_part = NULL;
+		for (char* part = strtok_r(folded, " ", &save_part); part; part = strtok_r(NULL, " ", &save_part)) {
+			if (count >= SEARCH_MAX_TOKENS)
+				break;
+			SearchToken* token = &tokens[count++];
+			strncpy(token->text, part, SEARCH_MAX_TOKEN - 1);
+			token->text[SEARCH_MAX_TOKEN - 1] = '\0';
+			token->len = strlen(token->text);
+			token->filter = filter;
+			token->mask = Search_mask(token->text);
+
+			int used = strlen(normalized);
+			snprintf(normalized + used, normalized_size - used, "%s%s%s", used ? " " : "", filter ? "@" : "", token->text);
+		}
+	}
+	return count;
+}
+
+static int Search_matchFilter(const SearchToken* token, uint32_t id) {
+	uint32_t dir = romindex.roms[id].dir;
+	return prefixMatch((char*)token->text, search.dir_tags[dir]) || strstr(search.dir_names[dir], token->text) != NULL;
+}
+
+// Cheapest edit distance between token and any substring of text, counting
+// swapped neighbours as one edit (Sellers with Damerau transpositions)
+static int Search_distance(const char* token, int len, const char* text, int limit) {
+	int columns[3][SEARCH_MAX_TOKEN + 1];
+	int* older = columns[0]; // two text chars back
+	int* prev = columns[1];
+	int* col = columns[2];
+	for (int i = 0; i <= len; i++)
+		older[i] = prev[i] = i;
+	int best = len;
+	for (const char* c = text; *c && best > 0; c++) {
+		col[0] = 0; // a match may start anywhere
+		for (int i = 1; i <= len; i++) {
+			int v = MIN(MIN(prev[i] + 1, col[i - 1] + 1), prev[i - 1] + (token[i - 1] != *c));
+			if (i > 1 && c > text && token[i - 1] == c[-1] && token[i - 2] == *c)
+				v = MIN(v, older[i - 2] + 1);
+			col[i] = v;
+		}
+		best = MIN(best, col[len]);
+		int* tmp = older;
+		older = prev;
+		prev = col;
+		col = tmp;
+	}
+	return best <= limit ? best : -1;
+}
+
+static int Search_typos(const SearchToken* token) {
+	return token->len >= 8 ? 2 : 1;
+}
+
+// Narrows ids to the roms containing every trigram of the given tokens
+static uint32_t Search_intersect(const SearchToken* tokens, int token_count, uint32_t* ids) {
+	uint32_t count = UINT32_MAX;
+	for (int t = 0; t < token_count; t++) {
+		const SearchToken* token = &tokens[t];
+		if (token->filter || token->len < 3)
+			continue;
+		for (int j = 0; j + 2 < token->len; j++) {
+			uint32_t key = searchTrigram(token->text + j);
+			const uint32_t* list = search.postings + search.trigram_starts[key];
+			uint32_t list_count = search.trigram_starts[key + 1] - search.trigram_starts[key];
+			if (count == UINT32_MAX) {
+				memcpy(ids, list, list_count * sizeof(uint32_t));
+				count = list_count;
 				continue;
 			}
-			Array_push(entries, entry);
-			prev_entry = entry;
+			uint32_t kept = 0;
+			uint32_t k = 0;
+			for (uint32_t i = 0; i < count && k < list_count; i++) {
+				while (k < list_count && list[k] < ids[i])
+					k++;
+				if (k < list_count && list[k] == ids[i])
+					ids[kept++] = ids[i];
+			}
+			count = kept;
 		}
-		Array_free(emus);
 	}
+	if (count == UINT32_MAX) {
+		for (uint32_t i = 0; i < search.count; i++)
+			ids[i] = i;
+		count = search.count;
+	}
+	return count;
+}
 
-	// Handle mapping logic
-	char map_path[MAX_PATH];
-	snprintf(map_path, sizeof(map_path), "%s/map.txt", ROMS_PATH);
-	if (entries->count > 0 && exists(map_path)) {
-		FILE* file = fopen(map_path, "r");
-		if (file) {
-			Hash* map = Hash_new();
-			char line[MAX_PATH];
+// Returns the rank of an exact match, lower is better, or -1
+static int Search_scoreExact(const SearchToken* tokens, int token_count, uint32_t id) {
+	const char* name = search.folded + search.folded_offsets[id];
+	int score = 0;
+	for (int t = 0; t < token_count; t++) {
+		const SearchToken* token = &tokens[t];
+		if (token->filter) {
+			if (!Search_matchFilter(token, id))
+				return -1;
+			continue;
+		}
+		const char* hit = strstr(name, token->text);
+		if (!hit)
+			return -1;
+		if (hit != name) {
+			// prefer any occurrence at the start of a word
+			const char* word = hit;
+			while (word && word != name && word[-1] != ' ')
+				word = strstr(word + 1, token->text);
+			score += word ? 1 : 3;
+		}
+	}
+	return score;
+}
 
-			while (fgets(line, sizeof(line), file)) {
-				normalizeNewline(line);
-				trimTrailingNewlines(line);
-				if (strlen(line) == 0)
-					continue;
+// Same but each token of 4+ chars may be misspelled, the cheap checks for
+// every token run before any edit distance is computed
+static int Search_scoreFuzzy(const SearchToken* tokens, int token_count, uint32_t id) {
+	const char* name = search.folded + search.folded_offsets[id];
+	int score = 0;
+	int misspelled = 0; // bit per token that needs Search_distance()
+	for (int t = 0; t < token_count; t++) {
+		const SearchToken* token = &tokens[t];
+		if (token->filter) {
+			if (!Search_matchFilter(token, id))
+				return -1;
+			continue;
+		}
+		if (strstr(name, token->text)) {
+			score += 1;
+			continue;
+		}
+		if (token->len < 4)
+			return -1;
+		// every token char missing from the name costs at least one edit
+		if (__builtin_popcountll(token->mask & ~search.masks[id]) > Search_typos(token))
+			return -1;
+		misspelled |= 1 << t;
+	}
+	for (int t = 0; t < token_count; t++) {
+		if (!(misspelled & (1 << t)))
+			continue;
+		const SearchToken* token = &tokens[t];
+		int distance = Search_distance(token->text, token->len, name, Search_typos(token));
+		if (distance < 0)
+			return -1;
+		score += 4 + distance * 2;
+	}
+	return score;
+}
 
-				char* tmp = strchr(line, '\t');
-				if (tmp) {
-					*tmp = '\0';
-					char* key = line;
-					char* value = tmp + 1;
-					Hash_set(map, key, value);
-				}
-			}
-			fclose(file);
+// Candidates sharing enough trigrams with each long token to be within reach
+static uint32_t Search_fuzzyCandidates(const SearchToken* tokens, int token_count, uint32_t* ids) {
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < search.count; i++)
+		ids[count++] = i;
 
-			bool resort = false;
-			for (int i = 0; i < entries->count; i++) {
-				Entry* entry = entries->items[i];
-				char* slash = strrchr(entry->path, '/');
-				if (!slash)
-					continue;
-				char* filename = slash + 1;
-				char* alias = Hash_get(map, filename);
-				if (alias) {
-					free(entry->name);
-					entry->name = strdup(alias);
-					resort = true;
-				}
+	for (int t = 0; t < token_count; t++) {
+		const SearchToken* token = &tokens[t];
+		if (token->filter || token->len < 4)
+			continue;
+		// each typo breaks up to 3 trigrams, short tokens are left to Search_distance()
+		int trigrams = token->len - 2;
+		int needed = trigrams - 3 * Search_typos(token);
+		if (needed <= 0)
+			continue;
+		memset(search.hits, 0, search.count * sizeof(uint16_t));
+		for (int j = 0; j < trigrams; j++) {
+			uint32_t key = searchTrigram(token->text + j);
+			int seen = 0;
+			for (int k = 0; k < j && !seen; k++)
+				seen = searchTrigram(token->text + k) == key;
+			if (seen)
+				continue;
+			for (uint32_t p = search.trigram_starts[key]; p < search.trigram_starts[key + 1]; p++) {
+				uint32_t id = search.postings[p];
+				if (search.hits[id] < UINT16_MAX)
+					search.hits[id]++;
 			}
-			if (resort)
-				EntryArray_sort(entries);
-			Hash_free(map);
 		}
+		uint32_t kept = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			if (search.hits[ids[i]] >= needed)
+				ids[kept++] = ids[i];
+		}
+		count = kept;
 	}
+	return count;
+}
 
-	// Build ROM index: scan all console dirs for individual ROMs
-	{
-		Array* rom_index = Array_new();
-		for (int i = 0; i < entries->count; i++) {
-			Entry* console_entry = entries->items[i];
-			char* console_name = console_entry->name;
+static int Search_sortRanked(const void* a, const void* b) {
+	uint32_t id1 = *(const uint32_t*)a;
+	uint32_t id2 = *(const uint32_t*)b;
+	if (search.scores[id1] != search.scores[id2])
+		return search.scores[id1] < search.scores[id2] ? -1 : 1;
+	return id1 < id2 ? -1 : id1 > id2; // then by name
+}
 
-			DIR* rom_dh = opendir(console_entry->path);
-			if (!rom_dh)
-				continue;
+Array* Content_searchRoms(const char* query) {
+	Array* results = Array_new();
+	if (!RomIndex_open())
+		return results;
+	if (!search.folded || search.generation != romindex_generation) {
+		if (!Search_build())
+			return results;
+	}
 
-			struct dirent* rom_dp;
-			char rom_path[MAX_PATH];
-			while ((rom_dp = readdir(rom_dh)) != NULL) {
-				if (hide(rom_dp->d_name))
-					continue;
-				if (rom_dp->d_type == DT_DIR)
-					continue;
+	SearchToken tokens[SEARCH_MAX_TOKENS];
+	char normalized[MAX_PATH];
+	int token_count = Search_tokenize(query ? query : "", tokens, normalized, sizeof(normalized));
 
-				snprintf(rom_path, sizeof(rom_path), "%s/%s",
-						 console_entry->path, rom_dp->d_name);
+	// refining a query can only shrink the previous exact matches
+	uint32_t count;
+	if (search.last_valid && search.last_query[0] && prefixMatch(search.last_query, normalized)) {
+		memcpy(search.ids, search.last_ids, search.last_count * sizeof(uint32_t));
+		count = search.last_count;
+	} else {
+		count = Search_intersect(tokens, token_count, search.ids);
+	}
 
-				char display_name[MAX_PATH];
-				getDisplayName(rom_path, display_name);
-				char full_display[MAX_PATH];
-				snprintf(full_display, sizeof(full_display), "%s (%s)",
-						 display_name, console_name);
+	uint32_t matched = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t id = search.ids[i];
+		int score = Search_scoreExact(tokens, token_count, id);
+		if (score < 0)
+			continue;
+		search.scores[id] = score;
+		search.ids[matched++] = id;
+	}
 
-				Array_push(rom_index, Entry_newNamed(rom_path, ENTRY_ROM, full_display));
-			}
-			closedir(rom_dh);
+	memcpy(search.last_ids, search.ids, matched * sizeof(uint32_t));
+	search.last_count = matched;
+	strncpy(search.last_query, normalized, sizeof(search.last_query) - 1);
+	search.last_query[sizeof(search.last_query) - 1] = '\0';
+	search.last_valid = 1;
+
+	if (matched == 0 && token_count > 0) {
+		count = Search_fuzzyCandidates(tokens, token_count, search.ids);
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t id = search.ids[i];
+			int score = Search_scoreFuzzy(tokens, token_count, id);
+			if (score < 0)
+				continue;
+			search.scores[id] = score;
+			search.ids[matched++] = id;
 		}
-		EntryArray_sort(rom_index);
-		writeRomIndexCache(rom_index);
-		EntryArray_free(rom_index);
 	}
 
-	// Write cache for next launch
-	writeRomsCache(entries);
+	qsort(search.ids, matched, sizeof(uint32_t), Search_sortRanked);
+
+	// only matches are turned into Entries, the rest stay in the mapping
+	for (uint32_t i = 0; i < matched; i++) {
+		const RomIndexRom* rom = &romindex.roms[search.ids[i]];
+		Entry* entry = Entry_newNamed(RomIndex_string(rom->path), ENTRY_ROM, RomIndex_string(rom->name));
+		entry->alpha = rom->alpha;
+		Array_push(results, entry);
+	}
+	return results;
+}
+
+///////////////////////////////////////
+// Content retrieval
+
+void Content_invalidateEmulist(void) {
+	RomIndex_close();
+	unlink(ROMINDEX_CACHE_PATH);
+}
 
+Array* getRoms(void) {
+	Array* entries = Array_new();
+	if (!RomIndex_open())
+		return entries;
+
+	for (uint32_t i = 0; i < romindex.header->console_count; i++) {
+		const RomIndexConsole* console = &romindex.consoles[i];
+		Array_push(entries, Entry_newNamed(RomIndex_string(console->path), ENTRY_DIR, RomIndex_string(console->name)));
+	}
 	return entries;
 }
 
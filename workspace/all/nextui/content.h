@@ -41,5 +41,6 @@ Array* getQuickToggles(int simple_mode);
 
 // Search
 Array* Content_searchRoms(const char* query);
+void Content_freeSearch(void);
 
 #endif // CONTENT_H
@@ -3,6 +3,13 @@
 #include <string.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <zlib.h>
 #include "defines.h"
 #include "api.h"
 #include "utils.h"
@@ -42,7 +49,7 @@ SDL_mutex* bgqueueMutex = NULL;
 SDL_mutex* thumbqueueMutex = NULL;
 
 static SDL_Thread* bgLoadThread = NULL;
-static SDL_Thread* thumbLoadThread = NULL;
+static SDL_Thread* thumbLoadThreads[THUMB_WORKERS] = {NULL};
 
 static SDL_atomic_t workerThreadsShutdown; // Flag to signal threads to exit (atomic for thread safety)
 
@@ -56,21 +63,49 @@ static int cachedScreenH = 0;
 
 ///////////////////////////////////////
 // Thumbnail cache
+//
+// Decoded thumbs are kept pre-scaled in screen format, looked up by path
+// hash and evicted least recently used first once over THUMB_CACHE_BYTES.
+// Paths without art are cached too (surface NULL) so they don't get
+// decoded again every time they're selected. Fresh decodes keep the disk
+// cache key around until they're shown and written out.
 
-#define THUMB_CACHE_SIZE 8
+#define THUMB_CACHE_BYTES (24 * 1024 * 1024)
+#define THUMB_CACHE_BUCKETS 256
 
-typedef struct {
+typedef struct ThumbCacheEntry {
 	char path[MAX_PATH];
+	uint32_t hash;
 	SDL_Surface* surface;
-	int lru_counter;
-	bool occupied;
+	size_t bytes;
+	struct ThumbDiskHeader* unsaved; // not in the disk cache yet
+	struct ThumbCacheEntry* bucket_next;
+	struct ThumbCacheEntry* lru_prev; // towards most recently used
+	struct ThumbCacheEntry* lru_next;
 } ThumbCacheEntry;
 
-static ThumbCacheEntry thumb_cache[THUMB_CACHE_SIZE];
-static int thumb_lru_counter = 0;
+static ThumbCacheEntry* thumb_buckets[THUMB_CACHE_BUCKETS];
+static ThumbCacheEntry* thumb_lru_head = NULL;
+static ThumbCacheEntry* thumb_lru_tail = NULL;
+static size_t thumb_cache_bytes = 0;
 static char desiredThumbPath[MAX_PATH] = {0};
 static SDL_atomic_t thumbAsyncLoaded;
 
+///////////////////////////////////////
+// Thumbnail jobs (protected by thumbQueue.mutex)
+//
+// The on-screen thumb always goes first, then the prefetch list in the order
+// it was given. Both are replaced wholesale by newer requests, which is how
+// stale jobs get cancelled; decodes already in flight still land in the cache.
+
+static struct {
+	char current[MAX_PATH]; // "" when nothing is pending
+	char save[MAX_PATH];	// on screen from memory, still to be written to disk
+	char prefetch[THUMB_PREFETCH_MAX][MAX_PATH];
+	int prefetch_count;
+	char busy[THUMB_WORKERS][MAX_PATH]; // being decoded right now
+} thumbJobs;
+
 ///////////////////////////////////////
 // Shared state (non-static, externed in imgloader.h)
 
@@ -186,140 +221,490 @@ int loadWorker(void* arg) {
 ///////////////////////////////////////
 // Thumbnail cache helpers (must be called under thumbMutex)
 
-static void thumbCacheInsert(const char* path, SDL_Surface* surface) {
-	int target = -1;
-	int min_lru = INT_MAX;
+static uint32_t thumbHash(const char* path) {
+	uint32_t hash = 2166136261u; // FNV-1a
+	while (*path) {
+		hash ^= (unsigned char)*path++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static ThumbCacheEntry* thumbCacheFind(const char* path) {
+	uint32_t hash = thumbHash(path);
+	ThumbCacheEntry* entry = thumb_buckets[hash % THUMB_CACHE_BUCKETS];
+	while (entry && (entry->hash != hash || strcmp(entry->path, path) != 0))
+		entry = entry->bucket_next;
+	return entry;
+}
+
+static void thumbCacheUnlink(ThumbCacheEntry* entry) {
+	if (entry->lru_prev)
+		entry->lru_prev->lru_next = entry->lru_next;
+	else
+		thumb_lru_head = entry->lru_next;
+	if (entry->lru_next)
+		entry->lru_next->lru_prev = entry->lru_prev;
+	else
+		thumb_lru_tail = entry->lru_prev;
+	entry->lru_prev = entry->lru_next = NULL;
+}
+
+static void thumbCacheTouch(ThumbCacheEntry* entry) {
+	if (thumb_lru_head == entry)
+		return;
+	if (entry->lru_prev || entry->lru_next || thumb_lru_tail == entry)
+		thumbCacheUnlink(entry);
+	entry->lru_next = thumb_lru_head;
+	if (thumb_lru_head)
+		thumb_lru_head->lru_prev = entry;
+	thumb_lru_head = entry;
+	if (!thumb_lru_tail)
+		thumb_lru_tail = entry;
+}
 
-	// Check if already cached (update in place)
-	for (int i = 0; i < THUMB_CACHE_SIZE; i++) {
-		if (thumb_cache[i].occupied && strcmp(thumb_cache[i].path, path) == 0) {
-			SDL_FreeSurface(thumb_cache[i].surface);
-			thumb_cache[i].surface = surface;
-			thumb_cache[i].lru_counter = ++thumb_lru_counter;
+static void thumbCacheEvict(ThumbCacheEntry* entry) {
+	ThumbCacheEntry** link = &thumb_buckets[entry->hash % THUMB_CACHE_BUCKETS];
+	while (*link != entry)
+		link = &(*link)->bucket_next;
+	*link = entry->bucket_next;
+	thumbCacheUnlink(entry);
+
+	thumb_cache_bytes -= entry->bytes;
+	if (entry->surface)
+		SDL_FreeSurface(entry->surface);
+	free(entry->unsaved);
+	free(entry);
+}
+
+// Takes ownership of surface and unsaved
+static void thumbCacheInsert(const char* path, SDL_Surface* surface, struct ThumbDiskHeader* unsaved) {
+	ThumbCacheEntry* entry = thumbCacheFind(path);
+	if (entry) {
+		// Already cached (update in place)
+		thumb_cache_bytes -= entry->bytes;
+		if (entry->surface)
+			SDL_FreeSurface(entry->surface);
+		free(entry->unsaved);
+	} else {
+		entry = calloc(1, sizeof(ThumbCacheEntry));
+		if (!entry) {
+			if (surface)
+				SDL_FreeSurface(surface);
+			free(unsaved);
 			return;
 		}
+		strncpy(entry->path, path, sizeof(entry->path) - 1);
+		entry->hash = thumbHash(path);
+		ThumbCacheEntry** bucket = &thumb_buckets[entry->hash % THUMB_CACHE_BUCKETS];
+		entry->bucket_next = *bucket;
+		*bucket = entry;
 	}
 
-	// Find empty slot
-	for (int i = 0; i < THUMB_CACHE_SIZE; i++) {
-		if (!thumb_cache[i].occupied) {
-			target = i;
-			break;
+	entry->surface = surface;
+	entry->unsaved = unsaved;
+	entry->bytes = sizeof(ThumbCacheEntry) + (surface ? (size_t)surface->pitch * surface->h : 0);
+	thumb_cache_bytes += entry->bytes;
+	thumbCacheTouch(entry);
+
+	while (thumb_cache_bytes > THUMB_CACHE_BYTES && thumb_lru_tail && thumb_lru_tail != entry)
+		thumbCacheEvict(thumb_lru_tail);
+}
+
+///////////////////////////////////////
+// Thumbnail job helpers (must be called under thumbQueue.mutex)
+
+static bool thumbJobBusy(const char* path) {
+	for (int i = 0; i < THUMB_WORKERS; i++) {
+		if (strcmp(thumbJobs.busy[i], path) == 0)
+			return true;
+	}
+	return false;
+}
+
+enum {
+	THUMB_JOB_NONE,
+	THUMB_JOB_DECODE,
+	THUMB_JOB_SAVE,
+};
+
+static int thumbJobTake(char* path) {
+	if (thumbJobs.current[0] && !thumbJobBusy(thumbJobs.current)) {
+		strcpy(path, thumbJobs.current);
+		thumbJobs.current[0] = '\0';
+		return THUMB_JOB_DECODE;
+	}
+	if (thumbJobs.save[0]) {
+		strcpy(path, thumbJobs.save);
+		thumbJobs.save[0] = '\0';
+		return THUMB_JOB_SAVE;
+	}
+	while (thumbJobs.prefetch_count > 0) {
+		strcpy(path, thumbJobs.prefetch[0]);
+		thumbJobs.prefetch_count--;
+		memmove(thumbJobs.prefetch[0], thumbJobs.prefetch[1], thumbJobs.prefetch_count * sizeof(thumbJobs.prefetch[0]));
+		if (!thumbJobBusy(path))
+			return THUMB_JOB_DECODE;
+	}
+	return THUMB_JOB_NONE;
+}
+
+///////////////////////////////////////
+// Thumbnail disk cache
+//
+// Scaled thumbs are written to THUMB_CACHE_PATH as a header followed by the
+// deflated screen-format pixels, one file per source path. The header carries
+// the source mtime/size and everything the scaling depends on, so a changed
+// png or game art setting simply misses and the file gets rewritten. Only
+// thumbs that were actually on screen are written, prefetches stay in memory
+// until they're shown.
+//
+// The cache file's own mtime is its last use. Once the directory grows past
+// THUMB_DISK_BYTES the least recently used files are deleted, which also
+// takes care of files whose art is gone since they never get used again.
+
+#define THUMB_DISK_MAGIC 0x424d4854 // "THMB"
+#define THUMB_DISK_VERSION 2
+#define THUMB_DISK_BYTES (64 * 1024 * 1024) // trimmed down to 3/4 of this
+#define THUMB_DISK_TOUCH_SEC (24 * 60 * 60) // a hit refreshes the use time at most this often
+
+static SDL_atomic_t thumbDiskBytes;	   // approximate size of THUMB_CACHE_PATH, -1 until counted
+static SDL_atomic_t thumbDiskTrimming; // a trim pass is running
+
+typedef struct ThumbDiskHeader {
+	uint32_t magic;
+	uint32_t version;
+	int64_t src_mtime;
+	int64_t src_size;
+	int32_t max_w;
+	int32_t max_h;
+	int32_t radius;
+	uint32_t format;
+	int32_t w;
+	int32_t h;
+	int32_t pitch;
+	int32_t packed;			 // deflated pixel bytes that follow
+	char src_path[MAX_PATH]; // guards against hash collisions
+} ThumbDiskHeader;
+
+static void thumbDiskPath(const char* src_path, char* disk_path) {
+	uint64_t hash = 14695981039346656037ull; // FNV-1a 64
+	for (const char* c = src_path; *c; c++) {
+		hash ^= (unsigned char)*c;
+		hash *= 1099511628211ull;
+	}
+	snprintf(disk_path, MAX_PATH, "%s/%016llx.thm", THUMB_CACHE_PATH, (unsigned long long)hash);
+}
+
+static SDL_Surface* thumbDiskLoad(const ThumbDiskHeader* key) {
+	char disk_path[MAX_PATH];
+	thumbDiskPath(key->src_path, disk_path);
+	int fd = open(disk_path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	ThumbDiskHeader header;
+	SDL_Surface* surface = NULL;
+	if (read(fd, &header, sizeof(header)) != sizeof(header) ||
+		header.magic != key->magic || header.version != key->version ||
+		header.src_mtime != key->src_mtime || header.src_size != key->src_size ||
+		header.max_w != key->max_w || header.max_h != key->max_h ||
+		header.radius != key->radius || header.format != key->format ||
+		strcmp(header.src_path, key->src_path) != 0 ||
+		header.w <= 0 || header.h <= 0 || header.w > key->max_w || header.h > cachedScreenH ||
+		header.packed <= 0)
+		goto done;
+
+	surface = SDL_CreateRGBSurfaceWithFormat(0, header.w, header.h,
+											 cachedScreenBitsPerPixel, header.format);
+	if (!surface)
+		goto done;
+	if (surface->pitch != header.pitch) {
+		SDL_FreeSurface(surface);
+		surface = NULL;
+		goto done;
+	}
+
+	uLongf size = (uLongf)header.pitch * header.h;
+	Bytef* packed = malloc(header.packed);
+	bool ok = packed && read(fd, packed, header.packed) == header.packed &&
+			  uncompress(surface->pixels, &size, packed, header.packed) == Z_OK &&
+			  size == (uLongf)header.pitch * header.h;
+	free(packed);
+	if (!ok) {
+		SDL_FreeSurface(surface);
+		surface = NULL;
+		goto done;
+	}
+
+	// mark as recently used, not on every hit to spare the sd card
+	struct stat st;
+	if (fstat(fd, &st) == 0 && time(NULL) - st.st_mtime > THUMB_DISK_TOUCH_SEC)
+		futimens(fd, NULL);
+
+done:
+	close(fd);
+	return surface;
+}
+
+typedef struct ThumbDiskFile {
+	char name[32]; // "<hash>.thm"
+	int64_t used;
+	int64_t bytes;
+} ThumbDiskFile;
+
+static int thumbDiskCompareUsed(const void* a, const void* b) {
+	int64_t diff = ((const ThumbDiskFile*)a)->used - ((const ThumbDiskFile*)b)->used;
+	return diff < 0 ? -1 : diff > 0;
+}
+
+// Recount THUMB_CACHE_PATH and delete the least recently used files while
+// it's over THUMB_DISK_BYTES. Anything that isn't a cache file (interrupted
+// saves, older versions) is deleted as well.
+static void thumbDiskTrim(void) {
+	if (!SDL_AtomicCAS(&thumbDiskTrimming, 0, 1))
+		return;
+
+	DIR* dh = opendir(THUMB_CACHE_PATH);
+	if (!dh) {
+		SDL_AtomicSet(&thumbDiskTrimming, 0);
+		return;
+	}
+
+	ThumbDiskFile* files = NULL;
+	int count = 0;
+	int capacity = 0;
+	int64_t total = 0;
+	time_t now = time(NULL);
+	struct dirent* dp;
+	while ((dp = readdir(dh)) != NULL && !SDL_AtomicGet(&workerThreadsShutdown)) {
+		const char* name = dp->d_name;
+		if (name[0] == '.')
+			continue;
+		struct stat st;
+		if (fstatat(dirfd(dh), name, &st, 0) != 0 || !S_ISREG(st.st_mode))
+			continue;
+
+		if (!suffixMatch(".thm", name)) {
+			if (now - st.st_mtime > 60)
+				unlinkat(dirfd(dh), name, 0);
+			continue;
+		}
+		if (count == capacity) {
+			int grown = capacity ? capacity * 2 : 256;
+			ThumbDiskFile* tmp = realloc(files, grown * sizeof(ThumbDiskFile));
+			if (!tmp)
+				break;
+			files = tmp;
+			capacity = grown;
 		}
+		ThumbDiskFile* file = &files[count++];
+		snprintf(file->name, sizeof(file->name), "%s", name);
+		file->used = (int64_t)st.st_mtime;
+		file->bytes = (int64_t)st.st_size;
+		total += file->bytes;
 	}
 
-	// No empty slot - evict LRU
-	if (target < 0) {
-		for (int i = 0; i < THUMB_CACHE_SIZE; i++) {
-			if (thumb_cache[i].lru_counter < min_lru) {
-				min_lru = thumb_cache[i].lru_counter;
-				target = i;
-			}
+	if (total > THUMB_DISK_BYTES && files) {
+		qsort(files, count, sizeof(ThumbDiskFile), thumbDiskCompareUsed);
+		for (int i = 0; i < count && total > THUMB_DISK_BYTES / 4 * 3; i++) {
+			if (unlinkat(dirfd(dh), files[i].name, 0) == 0)
+				total -= files[i].bytes;
 		}
-		if (thumb_cache[target].surface)
-			SDL_FreeSurface(thumb_cache[target].surface);
 	}
 
-	strncpy(thumb_cache[target].path, path, sizeof(thumb_cache[target].path) - 1);
-	thumb_cache[target].path[sizeof(thumb_cache[target].path) - 1] = '\0';
-	thumb_cache[target].surface = surface;
-	thumb_cache[target].lru_counter = ++thumb_lru_counter;
-	thumb_cache[target].occupied = true;
+	closedir(dh);
+	free(files);
+	SDL_AtomicSet(&thumbDiskBytes, (int)total);
+	SDL_AtomicSet(&thumbDiskTrimming, 0);
+}
+
+static void thumbDiskSave(ThumbDiskHeader* key, SDL_Surface* surface) {
+	char disk_path[MAX_PATH];
+	char tmp_path[MAX_PATH + 4];
+	thumbDiskPath(key->src_path, disk_path);
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", disk_path);
+
+	key->w = surface->w;
+	key->h = surface->h;
+	key->pitch = surface->pitch;
+
+	// the fastest level already gets box art down to about a fifth
+	uLong size = (uLong)surface->pitch * surface->h;
+	uLongf packed_size = compressBound(size);
+	Bytef* packed = malloc(packed_size);
+	if (!packed || compress2(packed, &packed_size, surface->pixels, size, Z_BEST_SPEED) != Z_OK) {
+		free(packed);
+		return;
+	}
+	key->packed = (int32_t)packed_size;
+
+	int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		free(packed);
+		return;
+	}
+	bool ok = write(fd, key, sizeof(*key)) == sizeof(*key) &&
+			  write(fd, packed, packed_size) == (ssize_t)packed_size;
+	ok = close(fd) == 0 && ok;
+	free(packed);
+
+	// readers only ever see a complete file or none at all
+	if (!ok || rename(tmp_path, disk_path) != 0) {
+		unlink(tmp_path);
+		return;
+	}
+
+	// the first save of a session counts what's already there
+	int bytes = (int)(sizeof(*key) + packed_size);
+	int before = SDL_AtomicAdd(&thumbDiskBytes, bytes);
+	if (before < 0 || before + bytes > THUMB_DISK_BYTES)
+		thumbDiskTrim();
 }
 
 ///////////////////////////////////////
-// Dedicated thumbnail worker thread
+// Dedicated thumbnail worker threads
+
+// A fresh decode also hands back the key to write it to the disk cache with
+static SDL_Surface* thumbDecode(const char* path, ThumbDiskHeader** unsaved) {
+	*unsaved = NULL;
+
+	// no art at all, don't bother the decoder
+	struct stat st;
+	if (stat(path, &st) != 0)
+		return NULL;
+
+	ThumbDiskHeader key = {0};
+	key.magic = THUMB_DISK_MAGIC;
+	key.version = THUMB_DISK_VERSION;
+	key.src_mtime = (int64_t)st.st_mtime;
+	key.src_size = (int64_t)st.st_size;
+	key.max_w = (int)(cachedScreenW * CFG_getGameArtWidth());
+	key.max_h = (int)(cachedScreenH * 0.6);
+	key.radius = SCALE1(CFG_getThumbnailRadius());
+	key.format = cachedScreenFormat;
+	strncpy(key.src_path, path, sizeof(key.src_path) - 1);
+
+	SDL_Surface* cached = thumbDiskLoad(&key);
+	if (cached)
+		return cached;
+
+	SDL_Surface* image = IMG_Load(path);
+	if (!image)
+		return NULL;
+
+	SDL_Surface* imageRGBA =
+		SDL_ConvertSurfaceFormat(image, cachedScreenFormat, 0);
+	SDL_FreeSurface(image);
+	if (!imageRGBA)
+		return NULL;
+
+	// Downscale to display dimensions before processing
+	int img_w = imageRGBA->w;
+	int img_h = imageRGBA->h;
+	double aspect_ratio = (double)img_h / img_w;
+	int max_w = key.max_w;
+	int max_h = key.max_h;
+	int new_w = max_w;
+	int new_h = (int)(new_w * aspect_ratio);
+	if (new_h > max_h) {
+		new_h = max_h;
+		new_w = (int)(new_h / aspect_ratio);
+	}
+
+	if (new_w > 0 && new_h > 0 &&
+		(new_w < img_w || new_h < img_h)) {
+		SDL_Surface* downscaled = SDL_CreateRGBSurfaceWithFormat(
+			0, new_w, new_h,
+			imageRGBA->format->BitsPerPixel,
+			imageRGBA->format->format);
+		if (downscaled) {
+			SDL_BlitScaled(imageRGBA, NULL, downscaled, NULL);
+			SDL_FreeSurface(imageRGBA);
+			imageRGBA = downscaled;
+		}
+	}
+
+	// Apply rounded corners at display resolution (much faster)
+	GFX_ApplyRoundedCorners_8888(
+		imageRGBA,
+		&(SDL_Rect){0, 0, imageRGBA->w, imageRGBA->h},
+		key.radius);
+
+	*unsaved = malloc(sizeof(key));
+	if (*unsaved)
+		**unsaved = key;
+	return imageRGBA;
+}
+
+// Writes a thumb that's on screen to the disk cache, frees both
+static void thumbSaveShown(ThumbDiskHeader* key, SDL_Surface* copy) {
+	if (key && copy)
+		thumbDiskSave(key, copy);
+	if (copy)
+		SDL_FreeSurface(copy);
+	free(key);
+}
 
 static int thumbLoadWorker(void* arg) {
-	TaskQueue* q = (TaskQueue*)arg;
+	int worker = (int)(intptr_t)arg;
+	TaskQueue* q = &thumbQueue;
+	char path[MAX_PATH];
+
 	while (!SDL_AtomicGet(&workerThreadsShutdown)) {
 		SDL_LockMutex(q->mutex);
-		while (!q->head && !SDL_AtomicGet(&workerThreadsShutdown)) {
+		int job = THUMB_JOB_NONE;
+		while (!SDL_AtomicGet(&workerThreadsShutdown) && !(job = thumbJobTake(path))) {
 			SDL_CondWait(q->cond, q->mutex);
 		}
-		if (SDL_AtomicGet(&workerThreadsShutdown)) {
+		if (!job) {
 			SDL_UnlockMutex(q->mutex);
 			break;
 		}
-		TaskNode* node = q->head;
-		q->head = node->next;
-		if (!q->head)
-			q->tail = NULL;
-		q->size--;
+		strcpy(thumbJobs.busy[worker], path);
 		SDL_UnlockMutex(q->mutex);
 
-		LoadBackgroundTask* task = node->task;
-		free(node);
-
-		SDL_Surface* result = NULL;
-		SDL_Surface* image = IMG_Load(task->imagePath);
-		if (image) {
-			SDL_Surface* imageRGBA =
-				SDL_ConvertSurfaceFormat(image, cachedScreenFormat, 0);
-			SDL_FreeSurface(image);
-
-			if (imageRGBA) {
-				// Downscale to display dimensions before processing
-				int img_w = imageRGBA->w;
-				int img_h = imageRGBA->h;
-				double aspect_ratio = (double)img_h / img_w;
-				int max_w = (int)(cachedScreenW * CFG_getGameArtWidth());
-				int max_h = (int)(cachedScreenH * 0.6);
-				int new_w = max_w;
-				int new_h = (int)(new_w * aspect_ratio);
-				if (new_h > max_h) {
-					new_h = max_h;
-					new_w = (int)(new_h / aspect_ratio);
-				}
-
-				if (new_w > 0 && new_h > 0 &&
-					(new_w < img_w || new_h < img_h)) {
-					SDL_Surface* downscaled = SDL_CreateRGBSurfaceWithFormat(
-						0, new_w, new_h,
-						imageRGBA->format->BitsPerPixel,
-						imageRGBA->format->format);
-					if (downscaled) {
-						SDL_BlitScaled(imageRGBA, NULL, downscaled, NULL);
-						SDL_FreeSurface(imageRGBA);
-						imageRGBA = downscaled;
-					}
-				}
-
-				// Apply rounded corners at display resolution (much faster)
-				GFX_ApplyRoundedCorners_8888(
-					imageRGBA,
-					&(SDL_Rect){0, 0, imageRGBA->w, imageRGBA->h},
-					SCALE1(CFG_getThumbnailRadius()));
-
-				result = imageRGBA;
+		if (job == THUMB_JOB_SAVE) {
+			// shown straight from a prefetch, write it out now
+			ThumbDiskHeader* unsaved = NULL;
+			SDL_Surface* copy = NULL;
+			SDL_LockMutex(thumbMutex);
+			ThumbCacheEntry* entry = thumbCacheFind(path);
+			if (entry && entry->unsaved && entry->surface) {
+				copy = SDL_ConvertSurface(entry->surface, entry->surface->format, 0);
+				unsaved = entry->unsaved;
+				entry->unsaved = NULL;
 			}
+			SDL_UnlockMutex(thumbMutex);
+			thumbSaveShown(unsaved, copy);
+
+			SDL_LockMutex(q->mutex);
+			thumbJobs.busy[worker][0] = '\0';
+			SDL_UnlockMutex(q->mutex);
+			continue;
 		}
 
+		ThumbDiskHeader* unsaved = NULL;
+		SDL_Surface* result = thumbDecode(path, &unsaved);
+		SDL_Surface* copy = NULL;
+
 		// Cache result and conditionally update thumbbmp
 		SDL_LockMutex(thumbMutex);
-		bool is_current = (strcmp(task->imagePath, desiredThumbPath) == 0);
+		bool is_current = (strcmp(path, desiredThumbPath) == 0);
 		bool had_any = (thumbbmp != NULL);
 
-		if (result) {
-			if (is_current) {
-				// Duplicate for thumbbmp before cache takes ownership
-				SDL_Surface* thumb_copy =
-					SDL_ConvertSurface(result, result->format, 0);
-				thumbCacheInsert(task->imagePath, result);
-				if (thumbbmp)
-					SDL_FreeSurface(thumbbmp);
-				thumbbmp = thumb_copy;
-			} else {
-				thumbCacheInsert(task->imagePath, result);
-			}
+		if (is_current) {
+			if (thumbbmp)
+				SDL_FreeSurface(thumbbmp);
+			// Duplicate for thumbbmp before cache takes ownership
+			thumbbmp = result ? SDL_ConvertSurface(result, result->format, 0) : NULL;
+			// and one to write out once the lock is released
+			if (unsaved && result)
+				copy = SDL_ConvertSurface(result, result->format, 0);
 		}
+		thumbCacheInsert(path, result, copy ? NULL : unsaved);
 
 		if (is_current) {
-			if (!result) {
-				if (thumbbmp)
-					SDL_FreeSurface(thumbbmp);
-				thumbbmp = NULL;
-			}
 			thumbchanged = 1;
 			setNeedDraw(1);
 			// Signal layout recalculation only if thumb presence changed
@@ -328,7 +713,12 @@ static int thumbLoadWorker(void* arg) {
 		}
 
 		SDL_UnlockMutex(thumbMutex);
-		free(task);
+		if (copy)
+			thumbSaveShown(unsaved, copy);
+
+		SDL_LockMutex(q->mutex);
+		thumbJobs.busy[worker][0] = '\0';
+		SDL_UnlockMutex(q->mutex);
 	}
 	return 0;
 }
@@ -378,21 +768,29 @@ bool startLoadThumb(const char* thumbpath) {
 	desiredThumbPath[sizeof(desiredThumbPath) - 1] = '\0';
 
 	// Check cache - swap immediately if found
-	for (int i = 0; i < THUMB_CACHE_SIZE; i++) {
-		if (thumb_cache[i].occupied &&
-			strcmp(thumb_cache[i].path, thumbpath) == 0) {
-			thumb_cache[i].lru_counter = ++thumb_lru_counter;
-			if (thumbbmp)
-				SDL_FreeSurface(thumbbmp);
-			thumbbmp = SDL_ConvertSurface(thumb_cache[i].surface,
-										  thumb_cache[i].surface->format, 0);
-			if (thumbbmp) {
-				thumbchanged = 1;
-				setNeedDraw(1);
-			}
-			SDL_UnlockMutex(thumbMutex);
-			return thumbbmp != NULL;
+	ThumbCacheEntry* cached = thumbCacheFind(thumbpath);
+	if (cached) {
+		thumbCacheTouch(cached);
+		bool unsaved = cached->unsaved != NULL;
+		bool had_any = (thumbbmp != NULL);
+		if (thumbbmp)
+			SDL_FreeSurface(thumbbmp);
+		thumbbmp = cached->surface ? SDL_ConvertSurface(cached->surface, cached->surface->format, 0) : NULL;
+		if (thumbbmp || had_any) {
+			thumbchanged = 1;
+			setNeedDraw(1);
+		}
+		bool has_thumb = thumbbmp != NULL;
+		SDL_UnlockMutex(thumbMutex);
+
+		// Prefetched and now on screen, so worth keeping on disk
+		if (unsaved) {
+			SDL_LockMutex(thumbQueue.mutex);
+			snprintf(thumbJobs.save, sizeof(thumbJobs.save), "%s", thumbpath);
+			SDL_CondSignal(thumbQueue.cond);
+			SDL_UnlockMutex(thumbQueue.mutex);
 		}
+		return has_thumb;
 	}
 
 	// Cache miss - keep old thumb visible while loading
@@ -401,28 +799,50 @@ bool startLoadThumb(const char* thumbpath) {
 		thumbchanged = 1; // redraw old thumb for this frame
 	SDL_UnlockMutex(thumbMutex);
 
-	// Enqueue for async loading
-	LoadBackgroundTask* task = malloc(sizeof(LoadBackgroundTask));
-	if (!task)
-		return has_thumb;
-	snprintf(task->imagePath, sizeof(task->imagePath), "%s", thumbpath);
-	task->callback = NULL;
-	enqueueTask(&thumbQueue, task);
+	// Replaces any on-screen request that hasn't started yet
+	SDL_LockMutex(thumbQueue.mutex);
+	snprintf(thumbJobs.current, sizeof(thumbJobs.current), "%s", thumbpath);
+	SDL_CondSignal(thumbQueue.cond);
+	SDL_UnlockMutex(thumbQueue.mutex);
 	return has_thumb;
 }
 
+void startPrefetchThumbs(const char** paths, int count) {
+	if (count > THUMB_PREFETCH_MAX)
+		count = THUMB_PREFETCH_MAX;
+
+	// Only queue what isn't cached yet
+	bool wanted[THUMB_PREFETCH_MAX] = {false};
+	SDL_LockMutex(thumbMutex);
+	for (int i = 0; i < count; i++)
+		wanted[i] = paths[i] && paths[i][0] && !thumbCacheFind(paths[i]);
+	SDL_UnlockMutex(thumbMutex);
+
+	// Drop whatever is left of the previous prefetch, it's for a stale selection
+	SDL_LockMutex(thumbQueue.mutex);
+	thumbJobs.prefetch_count = 0;
+	for (int i = 0; i < count; i++) {
+		if (!wanted[i])
+			continue;
+		char* job = thumbJobs.prefetch[thumbJobs.prefetch_count++];
+		snprintf(job, MAX_PATH, "%s", paths[i]);
+	}
+	if (thumbJobs.prefetch_count > 0)
+		SDL_CondBroadcast(thumbQueue.cond);
+	SDL_UnlockMutex(thumbQueue.mutex);
+}
+
 int thumbCheckAsyncLoaded(void) {
 	return SDL_AtomicCAS(&thumbAsyncLoaded, 1, 0);
 }
 
 static void thumbCacheClear(void) {
-	for (int i = 0; i < THUMB_CACHE_SIZE; i++) {
-		if (thumb_cache[i].surface)
-			SDL_FreeSurface(thumb_cache[i].surface);
-		thumb_cache[i] = (ThumbCacheEntry){0};
-	}
-	thumb_lru_counter = 0;
+	while (thumb_lru_head)
+		thumbCacheEvict(thumb_lru_head);
+	memset(thumb_buckets, 0, sizeof(thumb_buckets));
+	thumb_cache_bytes = 0;
 	desiredThumbPath[0] = '\0';
+	memset(&thumbJobs, 0, sizeof(thumbJobs));
 }
 
 ///////////////////////////////////////
@@ -459,11 +879,16 @@ void initImageLoaderPool(void) {
 	}
 
 	SDL_AtomicSet(&thumbAsyncLoaded, 0);
+	SDL_AtomicSet(&thumbDiskBytes, -1);
+	mkdir(THUMB_CACHE_PATH, 0755);
 
 	bgLoadThread = SDL_CreateThread(loadWorker, "BGLoadWorker", &bgQueue);
-	thumbLoadThread = SDL_CreateThread(thumbLoadWorker, "ThumbLoadWorker", &thumbQueue);
-	if (!bgLoadThread || !thumbLoadThread) {
+	if (!bgLoadThread)
 		fprintf(stderr, "imgloader: failed to create worker threads\n");
+	for (int i = 0; i < THUMB_WORKERS; i++) {
+		thumbLoadThreads[i] = SDL_CreateThread(thumbLoadWorker, "ThumbLoadWorker", (void*)(intptr_t)i);
+		if (!thumbLoadThreads[i])
+			fprintf(stderr, "imgloader: failed to create worker threads\n");
 	}
 }
 
@@ -479,7 +904,7 @@ void cleanupImageLoaderPool(void) {
 	}
 	if (thumbQueue.mutex && thumbQueue.cond) {
 		SDL_LockMutex(thumbQueue.mutex);
-		SDL_CondSignal(thumbQueue.cond);
+		SDL_CondBroadcast(thumbQueue.cond);
 		SDL_UnlockMutex(thumbQueue.mutex);
 	}
 
@@ -488,9 +913,11 @@ void cleanupImageLoaderPool(void) {
 		SDL_WaitThread(bgLoadThread, NULL);
 		bgLoadThread = NULL;
 	}
-	if (thumbLoadThread) {
-		SDL_WaitThread(thumbLoadThread, NULL);
-		thumbLoadThread = NULL;
+	for (int i = 0; i < THUMB_WORKERS; i++) {
+		if (thumbLoadThreads[i]) {
+			SDL_WaitThread(thumbLoadThreads[i], NULL);
+			thumbLoadThreads[i] = NULL;
+		}
 	}
 
 	// Drain any residual tasks left in queues
@@ -50,7 +50,11 @@ void startLoadFolderBackground(const char* imagePath, BackgroundLoadedCallback c
 void onBackgroundLoaded(SDL_Surface* surface);
 
 // Thumbnail loading
+#define THUMB_WORKERS 2
+#define THUMB_PREFETCH_MAX 8
 bool startLoadThumb(const char* thumbpath);
+// Decodes paths into the cache in the given order, replacing any earlier prefetch
+void startPrefetchThumbs(const char** paths, int count);
 int thumbCheckAsyncLoaded(void);
 
 #endif // IMGLOADER_H
@@ -91,6 +91,46 @@ static void updateBackgroundLayer(void) {
 	SDL_UnlockMutex(bgMutex);
 }
 
+// Boxart lives next to the rom as .media/<name without extension>.png
+static void getThumbPath(Entry* entry, char* thumb_path, size_t size) {
+	char path_copy[MAX_PATH];
+	strncpy(path_copy, entry->path, sizeof(path_copy) - 1);
+	path_copy[sizeof(path_copy) - 1] = '\0';
+
+	char* res_name = strrchr(path_copy, '/');
+	if (!res_name) {
+		thumb_path[0] = '\0';
+		return;
+	}
+	*res_name++ = '\0';
+	char* dot = strrchr(res_name, '.');
+	if (dot)
+		*dot = '\0';
+	snprintf(thumb_path, size, "%s/.media/%s.png", path_copy, res_name);
+}
+
+#define THUMB_PREFETCH_RADIUS 3
+
+// Queue the thumbs around the selection, the ones in scroll direction first
+static void prefetchThumbs(int direction) {
+	static char thumb_paths[THUMB_PREFETCH_RADIUS * 2][MAX_PATH];
+	const char* paths[THUMB_PREFETCH_RADIUS * 2];
+	int count = 0;
+	int ahead = direction < 0 ? -1 : 1;
+	for (int pass = 0; pass < 2; pass++) {
+		int step = pass == 0 ? ahead : -ahead;
+		for (int d = 1; d <= THUMB_PREFETCH_RADIUS; d++) {
+			int i = top->selected + step * d;
+			if (i < 0 || i >= top->entries->count)
+				break;
+			getThumbPath(top->entries->items[i], thumb_paths[count], MAX_PATH);
+			paths[count] = thumb_paths[count];
+			count++;
+		}
+	}
+	startPrefetchThumbs(paths, count);
+}
+
 static void renderThumbnail(int reset_changed) {
 	SDL_LockMutex(thumbMutex);
 	if (confirm_shortcut_action != SHORTCUT_NONE) {
@@ -584,30 +624,12 @@ int main(int argc, char* argv[]) {
 			} else {
 				Entry* entry = top->entries->items[top->selected];
 				assert(entry);
-				char tmp_path[MAX_PATH];
-				strncpy(tmp_path, entry->path, sizeof(tmp_path) - 1);
-				tmp_path[sizeof(tmp_path) - 1] = '\0';
-
-				char* res_name = strrchr(tmp_path, '/');
-				if (res_name)
-					res_name++;
-				else
-					res_name = tmp_path;
-
 				char path_copy[1024];
 				strncpy(path_copy, entry->path, sizeof(path_copy) - 1);
 				path_copy[sizeof(path_copy) - 1] = '\0';
 
 				char* rompath = dirname(path_copy);
 
-				char res_copy[1024];
-				strncpy(res_copy, res_name, sizeof(res_copy) - 1);
-				res_copy[sizeof(res_copy) - 1] = '\0';
-
-				char* dot = strrchr(res_copy, '.');
-				if (dot)
-					*dot = '\0';
-
 				// this is only a choice on the root folder
 				list_show_entry_names =
 					stack->count > 1 || CFG_getShowFolderNamesAtRoot();
@@ -620,10 +642,17 @@ int main(int argc, char* argv[]) {
 				// load game thumbnails
 				if (total > 0) {
 					if (CFG_getShowGameArt()) {
-						char thumbpath[1024];
-						snprintf(thumbpath, sizeof(thumbpath), "%s/.media/%s.png", rompath,
-								 res_copy);
+						char thumbpath[MAX_PATH];
+						getThumbPath(entry, thumbpath, sizeof(thumbpath));
 						had_thumb = startLoadThumb(thumbpath);
+
+						static Directory* thumb_dir = NULL;
+						static int thumb_selected = -1;
+						if (thumb_dir != top || thumb_selected != top->selected) {
+							prefetchThumbs(thumb_dir == top ? top->selected - thumb_selected : 0);
+							thumb_dir = top;
+							thumb_selected = top->selected;
+						}
 						int max_w = (int)(screen->w - (screen->w * CFG_getGameArtWidth()));
 						if (had_thumb)
 							ox = (int)(max_w)-SCALE1(BUTTON_MARGIN * 5);
@@ -16,12 +16,14 @@
 #include <string.h>
 
 static Array* search_results = NULL;
+static char search_query[512] = "";
 static int search_selected = 0;
 static int search_scroll = 0;
 static ScrollTextState search_list_scroll = {0};
 
 void Search_init(void) {
 	search_results = NULL;
+	search_query[0] = '\0';
 	search_selected = 0;
 	search_scroll = 0;
 }
@@ -31,34 +33,46 @@ void Search_quit(void) {
 		EntryArray_free(search_results);
 		search_results = NULL;
 	}
+	Content_freeSearch();
 }
 
-bool Search_open(void) {
+static char* Search_prompt(void) {
 	DisplayHelper_prepareForExternal();
 	char* query = UIKeyboard_open("Search");
 	PAD_poll();
 	PAD_reset();
 	DisplayHelper_recoverDisplay();
 
-	if (!query || strlen(query) == 0) {
-		if (query)
-			free(query);
-		return false;
+	if (query && strlen(query) == 0) {
+		free(query);
+		query = NULL;
 	}
+	return query;
+}
 
+static void Search_run(const char* query) {
 	// Free previous results
 	if (search_results) {
 		EntryArray_free(search_results);
 		search_results = NULL;
 	}
 
-	search_results = Content_searchRoms(query);
-	free(query);
+	strncpy(search_query, query, sizeof(search_query) - 1);
+	search_query[sizeof(search_query) - 1] = '\0';
+	search_results = Content_searchRoms(search_query);
 
 	search_selected = 0;
 	search_scroll = 0;
 	memset(&search_list_scroll, 0, sizeof(search_list_scroll));
+}
+
+bool Search_open(void) {
+	char* query = Search_prompt();
+	if (!query)
+		return false;
 
+	Search_run(query);
+	free(query);
 	return true;
 }
 
@@ -84,6 +98,20 @@ SearchResult Search_handleInput(unsigned long now) {
 		return result;
 	}
 
+	// X appends to the current query, which only re-checks the current results
+	if (PAD_justPressed(BTN_X)) {
+		char* refine = Search_prompt();
+		if (refine) {
+			char query[sizeof(search_query)];
+			snprintf(query, sizeof(query), "%s %s", search_query, refine);
+			free(refine);
+			Search_run(query);
+		}
+		GFX_clearLayers(LAYER_SCROLLTEXT);
+		result.dirty = true;
+		return result;
+	}
+
 	if (total == 0)
 		return result;
 
@@ -134,10 +162,12 @@ void Search_render(SDL_Surface* screen, SDL_Surface* blackBG, int lastScreen) {
 
 	// Button hints
 	{
-		char* hints[5] = {NULL};
+		char* hints[7] = {NULL};
 		int hi = 0;
 		hints[hi++] = "B";
 		hints[hi++] = "BACK";
+		hints[hi++] = "X";
+		hints[hi++] = "REFINE";
 		if (total > 0) {
 			hints[hi++] = "A";
 			hints[hi++] = "OPEN";
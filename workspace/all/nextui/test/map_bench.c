@@ -0,0 +1,230 @@
+// Times what Directory_index does with a large map.txt: every line goes
+// through Hash_set, then every ROM in the folder through Hash_get. Before is
+// the Hash types.c had until it became a hash table (parallel key and value
+// Arrays, searched with StringArray_indexOf), after is the current one.
+// Both must return the same alias for every file: last line wins for a
+// repeated key, files missing from map.txt get NULL.
+// Usage: map_bench [map.txt]
+//   Without a map.txt one with MAP_ENTRIES lines is written to build/.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "types.h"
+
+#define MAP_ENTRIES 10000
+#define DUPLICATE_EVERY 50 // line i renames ROM i/2 instead of ROM i
+#define MISSING_EVERY 20   // ROMs in the folder with no alias
+
+static int failures = 0;
+
+static void expect(int ok, const char* what) {
+	printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok)
+		failures += 1;
+}
+
+///////////////////////////////
+// What types.c needs from common/utils.c, which can't build without a
+// platform
+
+int exactMatch(const char* str1, const char* str2) {
+	if (!str1 || !str2)
+		return 0; // NULL isn't safe here
+	size_t len1 = strlen(str1);
+	if (len1 != strlen(str2))
+		return 0;
+	return (strncmp(str1, str2, len1) == 0);
+}
+void getDisplayName(const char* in_name, char* out_name) {
+	strcpy(out_name, in_name);
+}
+void normalizeNewline(char* line) {
+	int len = strlen(line);
+	if (len > 1 && line[len - 1] == '\n' && line[len - 2] == '\r') { // windows!
+		line[len - 2] = '\n';
+		line[len - 1] = '\0';
+	}
+}
+void trimTrailingNewlines(char* line) {
+	int len = strlen(line);
+	while (len > 0 && line[len - 1] == '\n') {
+		line[len - 1] = '\0'; // trim newline
+		len -= 1;
+	}
+}
+
+///////////////////////////////
+// Before
+
+typedef struct {
+	Array* keys;
+	Array* values;
+} OldHash;
+
+static OldHash* OldHash_new(void) {
+	OldHash* self = malloc(sizeof(OldHash));
+	self->keys = Array_new();
+	self->values = Array_new();
+	return self;
+}
+static void OldHash_free(OldHash* self) {
+	StringArray_free(self->keys);
+	StringArray_free(self->values);
+	free(self);
+}
+static void OldHash_set(OldHash* self, const char* key, const char* value) {
+	int i = StringArray_indexOf(self->keys, key);
+	if (i >= 0) {
+		free(self->values->items[i]);
+		self->values->items[i] = strdup(value);
+		return;
+	}
+	Array_push(self->keys, strdup(key));
+	Array_push(self->values, strdup(value));
+}
+static char* OldHash_get(OldHash* self, const char* key) {
+	int i = StringArray_indexOf(self->keys, key);
+	if (i == -1)
+		return NULL;
+	return self->values->items[i];
+}
+
+///////////////////////////////
+
+static double now_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void romName(char* out, size_t size, int i) {
+	// long shared prefixes, like a no-intro set, so comparisons don't stop
+	// at the first character
+	snprintf(out, size, "Super Adventure Quest %05d (USA) (Rev 1).zip", i);
+}
+
+static int writeMap(const char* path, Array* roms) {
+	FILE* file = fopen(path, "w");
+	if (!file)
+		return 0;
+	char name[MAX_PATH];
+	for (int i = 0; i < MAP_ENTRIES; i++) {
+		int rom = i % DUPLICATE_EVERY == DUPLICATE_EVERY - 1 ? i / 2 : i;
+		romName(name, sizeof(name), rom);
+		fprintf(file, "%s\tAdventure %05d%s\n", name, i, i % 3 ? "" : "\r"); // some windows lines
+	}
+	fclose(file);
+
+	// the folder: every ROM listed plus some that aren't
+	for (int i = 0; i < MAP_ENTRIES + MAP_ENTRIES / MISSING_EVERY; i++) {
+		romName(name, sizeof(name), i);
+		Array_push(roms, strdup(name));
+	}
+	return 1;
+}
+
+// The same reading loop as Directory_index
+static double loadMap(const char* path, Hash* map, OldHash* old_map) {
+	FILE* file = fopen(path, "r");
+	if (!file)
+		return -1.0;
+	double elapsed = 0.0;
+	char line[MAX_PATH];
+	while (fgets(line, sizeof(line), file) != NULL) {
+		normalizeNewline(line);
+		trimTrailingNewlines(line);
+		if (strlen(line) == 0)
+			continue; // skip empty lines
+
+		char* tmp = strchr(line, '\t');
+		if (tmp) {
+			tmp[0] = '\0';
+			char* key = line;
+			char* value = tmp + 1;
+			double start = now_ms();
+			if (map)
+				Hash_set(map, key, value);
+			else
+				OldHash_set(old_map, key, value);
+			elapsed += now_ms() - start;
+		}
+	}
+	fclose(file);
+	return elapsed;
+}
+
+int main(int argc, char* argv[]) {
+	const char* path = argc > 1 ? argv[1] : "build/map.txt";
+	Array* roms = Array_new();
+	if (argc > 1) {
+		// the keys of the given map.txt stand in for the folder
+		FILE* file = fopen(path, "r");
+		char line[MAX_PATH];
+		while (file && fgets(line, sizeof(line), file) != NULL) {
+			char* tmp = strchr(line, '\t');
+			if (tmp) {
+				tmp[0] = '\0';
+				Array_push(roms, strdup(line));
+			}
+		}
+		if (file)
+			fclose(file);
+	} else if (!writeMap(path, roms)) {
+		printf("can't write %s\nFAILED\n", path);
+		return EXIT_FAILURE;
+	}
+
+	OldHash* old_map = OldHash_new();
+	Hash* map = Hash_new();
+	double before_set = loadMap(path, NULL, old_map);
+	double after_set = loadMap(path, map, NULL);
+	if (before_set < 0.0 || after_set < 0.0) {
+		printf("can't read %s\nFAILED\n", path);
+		return EXIT_FAILURE;
+	}
+
+	char** before_aliases = malloc(sizeof(char*) * roms->count);
+	char** after_aliases = malloc(sizeof(char*) * roms->count);
+	double start = now_ms();
+	for (int i = 0; i < roms->count; i++)
+		before_aliases[i] = OldHash_get(old_map, roms->items[i]);
+	double before_get = now_ms() - start;
+	start = now_ms();
+	for (int i = 0; i < roms->count; i++)
+		after_aliases[i] = Hash_get(map, roms->items[i]);
+	double after_get = now_ms() - start;
+
+	int same = map->count == old_map->keys->count;
+	int found = 0;
+	for (int i = 0; i < roms->count; i++) {
+		if (!before_aliases[i] || !after_aliases[i])
+			same = same && before_aliases[i] == after_aliases[i];
+		else
+			same = same && strcmp(before_aliases[i], after_aliases[i]) == 0;
+		found += after_aliases[i] != NULL;
+	}
+
+	printf("%d keys, %d lookups (%d found): before %.2f ms set + %.2f ms get, after %.2f ms set + %.2f ms get\n",
+		   map->count, roms->count, found, before_set, before_get, after_set, after_get);
+	expect(same, "same alias for every file as before");
+	if (argc == 1) {
+		char name[MAX_PATH];
+		romName(name, sizeof(name), (DUPLICATE_EVERY - 1) / 2); // on line 24 and 49
+		char* alias = Hash_get(map, name);
+		expect(alias && strcmp(alias, "Adventure 00049") == 0, "last line wins for a repeated key");
+		romName(name, sizeof(name), MAP_ENTRIES);
+		expect(Hash_get(map, name) == NULL, "file missing from map.txt has no alias");
+		expect(found == map->count, "every listed file found");
+	}
+
+	free(before_aliases);
+	free(after_aliases);
+	OldHash_free(old_map);
+	Hash_free(map);
+	StringArray_free(roms);
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -92,32 +92,143 @@ void StringArray_free(Array* self) {
 ///////////////////////////////////////
 // Hash
 
+#define HASH_MIN_CAPACITY 16
+#define HASH_ARENA_SIZE 16384
+
+// keys and values are never freed one at a time, so they're bump allocated
+// from a chain of blocks instead of strdup'd into the heap one by one
+struct HashArena {
+	HashArena* next;
+	size_t used;
+	size_t size;
+	char data[];
+};
+
+static char* HashArena_strdup(Hash* self, const char* str) {
+	size_t len = strlen(str) + 1;
+	HashArena* arena = self->arena;
+	if (!arena || arena->size - arena->used < len) {
+		size_t size = len > HASH_ARENA_SIZE ? len : HASH_ARENA_SIZE;
+		arena = malloc(sizeof(HashArena) + size);
+		if (!arena)
+			return NULL;
+		arena->next = self->arena;
+		arena->used = 0;
+		arena->size = size;
+		self->arena = arena;
+	}
+	char* copy = arena->data + arena->used;
+	memcpy(copy, str, len);
+	arena->used += len;
+	return copy;
+}
+
+static uint32_t Hash_hash(const char* key) {
+	uint32_t hash = 2166136261u; // FNV-1a
+	while (*key) {
+		hash ^= (unsigned char)*key++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// slot holding key or the empty slot it belongs in
+static int Hash_slot(Hash* self, const char* key, uint32_t hash) {
+	int mask = self->capacity - 1;
+	int i = hash & mask;
+	while (self->keys[i]) {
+		if (self->hashes[i] == hash && strcmp(self->keys[i], key) == 0)
+			break;
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+static int Hash_resize(Hash* self, int capacity) {
+	uint32_t* hashes = malloc(sizeof(uint32_t) * capacity);
+	char** keys = calloc(capacity, sizeof(char*));
+	char** values = malloc(sizeof(char*) * capacity);
+	if (!hashes || !keys || !values) {
+		free(hashes);
+		free(keys);
+		free(values);
+		return 0;
+	}
+
+	uint32_t* old_hashes = self->hashes;
+	char** old_keys = self->keys;
+	char** old_values = self->values;
+	int old_capacity = self->capacity;
+
+	self->hashes = hashes;
+	self->keys = keys;
+	self->values = values;
+	self->capacity = capacity;
+	for (int i = 0; i < old_capacity; i++) {
+		if (!old_keys[i])
+			continue;
+		int slot = Hash_slot(self, old_keys[i], old_hashes[i]);
+		hashes[slot] = old_hashes[i];
+		keys[slot] = old_keys[i];
+		values[slot] = old_values[i];
+	}
+
+	free(old_hashes);
+	free(old_keys);
+	free(old_values);
+	return 1;
+}
+
 Hash* Hash_new(void) {
-	Hash* self = malloc(sizeof(Hash));
-	self->keys = Array_new();
-	self->values = Array_new();
+	Hash* self = calloc(1, sizeof(Hash));
+	if (!self)
+		return NULL;
+	if (!Hash_resize(self, HASH_MIN_CAPACITY)) {
+		free(self);
+		return NULL;
+	}
 	return self;
 }
 void Hash_free(Hash* self) {
-	StringArray_free(self->keys);
-	StringArray_free(self->values);
+	HashArena* arena = self->arena;
+	while (arena) {
+		HashArena* next = arena->next;
+		free(arena);
+		arena = next;
+	}
+	free(self->hashes);
+	free(self->keys);
+	free(self->values);
 	free(self);
 }
 void Hash_set(Hash* self, const char* key, const char* value) {
-	int i = StringArray_indexOf(self->keys, key);
-	if (i >= 0) {
-		free(self->values->items[i]);
-		self->values->items[i] = strdup(value);
+	// keep the load under 1/2 so probes stay short
+	if ((self->count + 1) * 2 > self->capacity && !Hash_resize(self, self->capacity * 2))
+		return;
+
+	uint32_t hash = Hash_hash(key);
+	int slot = Hash_slot(self, key, hash);
+	char* copy = HashArena_strdup(self, value);
+	if (!copy)
+		return;
+	if (self->keys[slot]) {
+		self->values[slot] = copy; // the old value stays in the arena until Hash_free()
 		return;
 	}
-	Array_push(self->keys, strdup(key));
-	Array_push(self->values, strdup(value));
+
+	char* interned = HashArena_strdup(self, key);
+	if (!interned)
+		return;
+	self->hashes[slot] = hash;
+	self->keys[slot] = interned;
+	self->values[slot] = copy;
+	self->count++;
 }
 char* Hash_get(Hash* self, const char* key) {
-	int i = StringArray_indexOf(self->keys, key);
-	if (i == -1)
+	int slot = Hash_slot(self, key, Hash_hash(key));
+	if (!self->keys[slot])
 		return NULL;
-	return self->values->items[i];
+	return self->values[slot];
 }
 
 ///////////////////////////////////////
@@ -1,6 +1,7 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -31,10 +32,16 @@ void StringArray_free(Array* self);
 ///////////////////////////////////////
 // Hash
 
+typedef struct HashArena HashArena;
+
 typedef struct Hash {
-	Array* keys;
-	Array* values;
-} Hash; // not really a hash
+	int count;
+	int capacity; // always a power of two
+	uint32_t* hashes;
+	char** keys;   // NULL marks an empty slot
+	char** values; // keys and values both live in arena
+	HashArena* arena;
+} Hash; // open addressing with linear probing
 
 Hash* Hash_new(void);
 void Hash_free(Hash* self);
@@ -11,10 +11,12 @@
 #include <sys/mman.h>
 #include <sys/wait.h>
 
+#include "fb_mirror.h"
+
 #define PID_FILE "/tmp/screenrecorder.pid"
-#define SHM_PATH "/tmp/fb_mirror.raw"
 #define FFMPEG_PATH "/usr/bin/ffmpeg"
-#define POLL_INTERVAL_US 33333 // ~30fps
+#define RECORD_FPS 30
+#define WAIT_TIMEOUT_MS 100 // wake up this often to notice SIGTERM or a recreated mirror
 
 static volatile int quit = 0;
 
@@ -47,6 +49,42 @@ static void ensure_output_dir(const char* filepath) {
 	}
 }
 
+// Maps the renderer's frame mirror once its header is complete, NULL if not (yet) available
+static FBMirrorHeader* open_mirror(int* fd_out, struct stat* st_out) {
+	int fd = open(FB_MIRROR_PATH, O_RDWR); // waiters count lives in the mapping
+	if (fd < 0)
+		return NULL;
+
+	FBMirrorHeader* header = mmap(NULL, FB_MIRROR_HEADER_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+	if (header == MAP_FAILED) {
+		close(fd);
+		return NULL;
+	}
+	int ready = __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == FB_MIRROR_MAGIC && header->version == FB_MIRROR_VERSION;
+	uint32_t frame_size = header->frame_size;
+	munmap(header, FB_MIRROR_HEADER_SIZE);
+
+	struct stat st;
+	if (!ready || fstat(fd, &st) != 0 || (size_t)st.st_size < FBMirror_mapSize(frame_size)) {
+		close(fd);
+		return NULL;
+	}
+
+	FBMirrorHeader* mirror = mmap(NULL, FBMirror_mapSize(frame_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (mirror == MAP_FAILED) {
+		close(fd);
+		return NULL;
+	}
+	*fd_out = fd;
+	*st_out = st;
+	return mirror;
+}
+
+static void close_mirror(FBMirrorHeader* mirror, int fd) {
+	munmap(mirror, FBMirror_mapSize(mirror->frame_size));
+	close(fd);
+}
+
 int main(int argc, char* argv[]) {
 	if (argc < 4) {
 		fprintf(stderr, "Usage: screenrecorder <output_path> <width> <height>\n");
@@ -69,6 +107,8 @@ int main(int argc, char* argv[]) {
 	sa.sa_handler = on_term;
 	sigaction(SIGTERM, &sa, NULL);
 	sigaction(SIGINT, &sa, NULL);
+	sa.sa_handler = SIG_IGN; // a dead ffmpeg shows up as a failed write()
+	sigaction(SIGPIPE, &sa, NULL);
 
 	// Write PID file
 	FILE* pf = fopen(PID_FILE, "w");
@@ -79,34 +119,30 @@ int main(int argc, char* argv[]) {
 
 	ensure_output_dir(output_path);
 
-	// Wait for shm file to appear (capture system creates it)
+	// Wait for the frame mirror to appear (capture system creates it)
 	int shm_fd = -1;
-	for (int i = 0; i < 300 && !quit; i++) { // up to ~10s
-		shm_fd = open(SHM_PATH, O_RDONLY);
-		if (shm_fd >= 0)
-			break;
-		usleep(33333);
-	}
-	if (shm_fd < 0 || quit) {
-		fprintf(stderr, "Timed out waiting for %s\n", SHM_PATH);
+	FBMirrorHeader* mirror = NULL;
+	struct stat shm_stat;
+	for (int i = 0; i < 100 && !quit && !mirror; i++) { // up to ~10s
+		mirror = open_mirror(&shm_fd, &shm_stat);
+		if (!mirror)
+			usleep(100000);
+	}
+	if (!mirror || quit) {
+		fprintf(stderr, "Timed out waiting for %s\n", FB_MIRROR_PATH);
 		remove(PID_FILE);
 		return 1;
 	}
-
-	// Verify file size matches expected frame size
-	off_t file_size = lseek(shm_fd, 0, SEEK_END);
-	if ((size_t)file_size < frame_size) {
-		fprintf(stderr, "SHM file too small: %ld < %zu\n", (long)file_size, frame_size);
-		close(shm_fd);
+	if (mirror->width != (uint32_t)width || mirror->height != (uint32_t)height) {
+		fprintf(stderr, "Mirror is %ux%u, expected %dx%d\n", mirror->width, mirror->height, width, height);
+		close_mirror(mirror, shm_fd);
 		remove(PID_FILE);
 		return 1;
 	}
 
-	// mmap the shm file read-only
-	uint8_t* shm_ptr = mmap(NULL, frame_size, PROT_READ, MAP_SHARED, shm_fd, 0);
-	if (shm_ptr == MAP_FAILED) {
-		perror("mmap");
-		close(shm_fd);
+	uint8_t* frame = malloc(frame_size);
+	if (!frame) {
+		close_mirror(mirror, shm_fd);
 		remove(PID_FILE);
 		return 1;
 	}
@@ -115,8 +151,8 @@ int main(int argc, char* argv[]) {
 	int pipe_fds[2];
 	if (pipe(pipe_fds) < 0) {
 		perror("pipe");
-		munmap(shm_ptr, frame_size);
-		close(shm_fd);
+		close_mirror(mirror, shm_fd);
+		free(frame);
 		remove(PID_FILE);
 		return 1;
 	}
@@ -131,8 +167,8 @@ int main(int argc, char* argv[]) {
 		perror("fork");
 		close(pipe_fds[0]);
 		close(pipe_fds[1]);
-		munmap(shm_ptr, frame_size);
-		close(shm_fd);
+		close_mirror(mirror, shm_fd);
+		free(frame);
 		remove(PID_FILE);
 		return 1;
 	}
@@ -163,36 +199,77 @@ int main(int argc, char* argv[]) {
 	if (waitpid(ffmpeg_pid, NULL, WNOHANG) != 0) {
 		fprintf(stderr, "ffmpeg failed to start\n");
 		close(pipe_fds[1]);
-		munmap(shm_ptr, frame_size);
-		close(shm_fd);
+		close_mirror(mirror, shm_fd);
+		free(frame);
 		remove(PID_FILE);
 		return 1;
 	}
 
-	// Main loop: read from shm, pipe to ffmpeg at ~30fps
+	// Main loop: sleep until the renderer publishes a frame, then pipe it to
+	// ffmpeg. Frames are placed on the RECORD_FPS grid by their capture
+	// timestamp, so late frames are repeated and early ones dropped.
+	uint32_t last_frame = 0;
+	uint32_t first_ts = 0;
+	uint32_t written = 0;
 	while (!quit) {
-		ssize_t total = 0;
-		const uint8_t* ptr = shm_ptr;
-		size_t remaining = frame_size;
-		while (remaining > 0) {
-			ssize_t n = write(pipe_fds[1], ptr, remaining);
-			if (n < 0) {
-				quit = 1;
-				break;
+		uint32_t latest = FBMirror_wait(mirror, last_frame, WAIT_TIMEOUT_MS);
+		if (!latest) {
+			// the renderer restarted capture (eg. launched another game), follow the new mirror
+			struct stat st;
+			if (stat(FB_MIRROR_PATH, &st) == 0 && st.st_ino != shm_stat.st_ino) {
+				int fd;
+				FBMirrorHeader* next = open_mirror(&fd, &st);
+				if (next && next->frame_size == mirror->frame_size) {
+					close_mirror(mirror, shm_fd);
+					mirror = next;
+					shm_fd = fd;
+					shm_stat = st;
+					last_frame = 0;
+				} else if (next) {
+					close_mirror(next, fd);
+				}
+			}
+			continue;
+		}
+
+		uint32_t ts;
+		uint32_t got = FBMirror_read(mirror, frame, &ts);
+		if (!got)
+			continue;
+		last_frame = got;
+
+		if (!written)
+			first_ts = ts;
+		uint32_t due = (ts - first_ts) * RECORD_FPS / 1000 + 1;
+		if (due <= written)
+			continue;
+		if (due - written > RECORD_FPS) {
+			// long stall (sleep, loading), don't pad the video with a frozen frame
+			first_ts += (due - written - 1) * 1000 / RECORD_FPS;
+			due = written + 1;
+		}
+
+		for (; written < due && !quit; written++) {
+			const uint8_t* ptr = frame;
+			size_t remaining = frame_size;
+			while (remaining > 0) {
+				ssize_t n = write(pipe_fds[1], ptr, remaining);
+				if (n < 0) {
+					quit = 1;
+					break;
+				}
+				ptr += n;
+				remaining -= n;
 			}
-			ptr += n;
-			remaining -= n;
-			total += n;
 		}
-		usleep(POLL_INTERVAL_US);
 	}
 
 	// Cleanup: close pipe (sends EOF to ffmpeg), wait for it to finish
 	close(pipe_fds[1]);
 	waitpid(ffmpeg_pid, NULL, 0);
 
-	munmap(shm_ptr, frame_size);
-	close(shm_fd);
+	close_mirror(mirror, shm_fd);
+	free(frame);
 	remove(PID_FILE);
 	return 0;
 }
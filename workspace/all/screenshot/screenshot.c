@@ -10,8 +10,11 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/wait.h>
+#include <sys/mman.h>
 #include <linux/input.h>
 
+#include "fb_mirror.h"
+
 #define PID_FILE "/tmp/screenshot.pid"
 #define SCREENSHOT_DIR "/mnt/SDCARD/Images/Screenshots"
 #define FFMPEG_PATH "/usr/bin/ffmpeg"
@@ -52,10 +55,39 @@ static void mkdir_p(const char* path) {
 	mkdir(tmp, 0755);
 }
 
-#define FB_MIRROR_PATH "/tmp/fb_mirror.raw"
-#define FB_MIRROR_WIDTH "1280"
-#define FB_MIRROR_HEIGHT "720"
-#define FB_MIRROR_VIDEO_SIZE FB_MIRROR_WIDTH "x" FB_MIRROR_HEIGHT
+// Copies the newest complete frame out of the renderer's frame mirror,
+// returns a malloc'd bottom-to-top RGBA buffer or NULL if there is none
+static uint8_t* read_mirror_frame(uint32_t* width, uint32_t* height) {
+	int fd = open(FB_MIRROR_PATH, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	uint8_t* pixels = NULL;
+	struct stat st;
+	FBMirrorHeader* header = mmap(NULL, FB_MIRROR_HEADER_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+	if (header != MAP_FAILED) {
+		uint32_t frame_size = header->frame_size;
+		int ready = __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == FB_MIRROR_MAGIC && header->version == FB_MIRROR_VERSION;
+		munmap(header, FB_MIRROR_HEADER_SIZE);
+
+		if (ready && fstat(fd, &st) == 0 && (size_t)st.st_size >= FBMirror_mapSize(frame_size)) {
+			FBMirrorHeader* mirror = mmap(NULL, FBMirror_mapSize(frame_size), PROT_READ, MAP_SHARED, fd, 0);
+			if (mirror != MAP_FAILED) {
+				pixels = malloc(frame_size);
+				if (pixels && FBMirror_read(mirror, pixels, NULL)) {
+					*width = mirror->width;
+					*height = mirror->height;
+				} else {
+					free(pixels);
+					pixels = NULL;
+				}
+				munmap(mirror, FBMirror_mapSize(frame_size));
+			}
+		}
+	}
+	close(fd);
+	return pixels;
+}
 
 static void capture_screenshot(void) {
 	mkdir_p(SCREENSHOT_DIR);
@@ -68,22 +100,44 @@ static void capture_screenshot(void) {
 			 t->tm_year + 1900, t->tm_mon + 1, t->tm_mday,
 			 t->tm_hour, t->tm_min, t->tm_sec);
 
-	int use_rawvideo = (access(FB_MIRROR_PATH, F_OK) == 0);
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint8_t* pixels = read_mirror_frame(&width, &height);
+	char video_size[32];
+	snprintf(video_size, sizeof(video_size), "%ux%u", width, height);
+
+	int pipe_fds[2] = {-1, -1};
+	if (pixels && pipe(pipe_fds) < 0) {
+		free(pixels);
+		pixels = NULL;
+	}
 
 	pid_t pid = fork();
-	if (pid < 0)
+	if (pid < 0) {
+		if (pixels) {
+			close(pipe_fds[0]);
+			close(pipe_fds[1]);
+			free(pixels);
+		}
 		return;
+	}
 
 	if (pid == 0) {
 		setsid();
-		freopen("/dev/null", "r", stdin);
+		if (pixels) {
+			close(pipe_fds[1]);
+			dup2(pipe_fds[0], STDIN_FILENO);
+			close(pipe_fds[0]);
+		} else {
+			freopen("/dev/null", "r", stdin);
+		}
 		freopen("/dev/null", "w", stdout);
 		freopen("/dev/null", "w", stderr);
-		if (use_rawvideo) {
+		if (pixels) {
 			execl(FFMPEG_PATH, "ffmpeg", "-nostdin",
 				  "-f", "rawvideo", "-pixel_format", "rgba",
-				  "-video_size", FB_MIRROR_VIDEO_SIZE,
-				  "-i", FB_MIRROR_PATH,
+				  "-video_size", video_size,
+				  "-i", "pipe:0",
 				  "-vf", "vflip",
 				  "-frames:v", "1", "-c:v", "mjpeg", "-q:v", "2",
 				  "-y", output,
@@ -98,6 +152,21 @@ static void capture_screenshot(void) {
 		_exit(1);
 	}
 
+	if (pixels) {
+		close(pipe_fds[0]);
+		const uint8_t* ptr = pixels;
+		size_t remaining = (size_t)width * height * 4;
+		while (remaining > 0) {
+			ssize_t n = write(pipe_fds[1], ptr, remaining);
+			if (n < 0)
+				break;
+			ptr += n;
+			remaining -= n;
+		}
+		close(pipe_fds[1]); // EOF for ffmpeg
+		free(pixels);
+	}
+
 	// Wait for ffmpeg to finish (single frame capture is fast)
 	waitpid(pid, NULL, 0);
 }
@@ -107,6 +176,8 @@ int main(int argc, char* argv[]) {
 	sa.sa_handler = on_term;
 	sigaction(SIGTERM, &sa, NULL);
 	sigaction(SIGINT, &sa, NULL);
+	sa.sa_handler = SIG_IGN; // a dead ffmpeg shows up as a failed write()
+	sigaction(SIGPIPE, &sa, NULL);
 
 	// Write PID file
 	FILE* f = fopen(PID_FILE, "w");
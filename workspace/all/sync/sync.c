@@ -16,25 +16,34 @@
 #include "api.h"
 #include "ui_components.h"
 #include "utils.h"
+#include "sync_engine.h"
 
 // Sync configuration
 #define SYNC_UDP_PORT 19999
-#define SYNC_RSYNC_PORT 18730
+#define SYNC_TCP_PORT 18730
 #define HELLO_MSG "HELLO_TRIMUI_SYNC:"
 #define ACK_MSG "TRIMUI_SYNC_ACK:"
-#define READY_MSG "TRIMUI_SYNC_READY"
-#define DONE_MSG "TRIMUI_SYNC_DONE"
 #define BROADCAST_INTERVAL_MS 1000
-#define RSYNC_CONF_PATH "/tmp/rsyncd.conf"
-#define RSYNC_PID_PATH "/tmp/rsyncd.pid"
+#define SERVER_WAIT_SEC 3600
+#define CLIENT_CONNECT_SEC 30
 
 // Paths to sync
 #define SAVES_PATH SDCARD_PATH "/Saves"
 #define SHARED_DATA_PATH SHARED_USERDATA_PATH
 // ROMS_PATH already defined in defines.h
 
-// rsync binary path (shared across platforms)
-#define RSYNC_BIN SHARED_BIN_PATH "/rsync"
+// Manifests of this device's files, kept per device (not synced)
+#define SYNC_STATE_PATH USERDATA_PATH "/sync"
+
+// Never synced, these belong to the device they are on
+static const char* shared_excludes[] = {
+	"battery_logs.sqlite",
+	"game_logs.sqlite",
+	"ledsettings.txt",
+	"ledsettings_brick.txt",
+	"minuisettings.txt",
+	NULL,
+};
 
 // Log buffer for terminal-like display
 #define LOG_MAX_LINES 20
@@ -72,7 +81,7 @@ static int udp_sock = -1;
 static volatile bool sync_cancel = false;
 static volatile bool sync_done = false;
 static volatile int sync_result = 0; // 0=success, -1=error
-static volatile int sync_phase = 0;	 // 1-4 for progress display
+static SyncProgress sync_progress;
 static pthread_t sync_thread;
 static bool sync_thread_active = false;
 static bool is_server = false;
@@ -167,17 +176,6 @@ static int compare_ips(const char* ip_a, const char* ip_b) {
 	return 0;
 }
 
-static int create_send_socket(void) {
-	int sock = socket(AF_INET, SOCK_DGRAM, 0);
-	if (sock < 0)
-		return -1;
-
-	int yes = 1;
-	setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &yes, sizeof(yes));
-
-	return sock;
-}
-
 static int create_recv_socket(void) {
 	int sock = socket(AF_INET, SOCK_DGRAM, 0);
 	if (sock < 0)
@@ -341,241 +339,6 @@ static void stop_discovery(void) {
 	// or immediately if discovery is stopped without syncing (B to exit).
 }
 
-static int wait_for_udp_message(const char* expected, int timeout_sec) {
-	int sock = create_recv_socket();
-	if (sock < 0)
-		return -1;
-
-	char buf[256];
-	time_t start = time(NULL);
-
-	while (!sync_cancel && !app_quit) {
-		if (time(NULL) - start > timeout_sec) {
-			close(sock);
-			return -1;
-		}
-
-		fd_set readfds;
-		FD_ZERO(&readfds);
-		FD_SET(sock, &readfds);
-		struct timeval tv = {1, 0};
-
-		int ret = select(sock + 1, &readfds, NULL, NULL, &tv);
-		if (ret > 0) {
-			ssize_t n = recvfrom(sock, buf, sizeof(buf) - 1, 0, NULL, NULL);
-			if (n > 0) {
-				buf[n] = '\0';
-				if (strcmp(buf, expected) == 0) {
-					close(sock);
-					return 0;
-				}
-			}
-		}
-	}
-
-	close(sock);
-	return -1;
-}
-
-static void write_rsync_config(void) {
-	FILE* fp = fopen(RSYNC_CONF_PATH, "w");
-	if (!fp)
-		return;
-
-	fprintf(fp, "pid file = %s\n", RSYNC_PID_PATH);
-	fprintf(fp, "port = %d\n", SYNC_RSYNC_PORT);
-	fprintf(fp, "use chroot = no\n");
-	fprintf(fp, "read only = no\n");
-	fprintf(fp, "uid = 0\n");
-	fprintf(fp, "gid = 0\n");
-	fprintf(fp, "log file = /tmp/rsyncd.log\n");
-	fprintf(fp, "transfer logging = yes\n");
-	fprintf(fp, "log format = %%o %%f (%%l bytes)\n\n");
-	fprintf(fp, "[shared]\n");
-	fprintf(fp, "  path = %s\n", SHARED_DATA_PATH);
-	fprintf(fp, "  read only = no\n\n");
-	fprintf(fp, "[saves]\n");
-	fprintf(fp, "  path = %s\n", SAVES_PATH);
-	fprintf(fp, "  read only = no\n\n");
-	fprintf(fp, "[roms]\n");
-	fprintf(fp, "  path = %s\n", ROMS_PATH);
-	fprintf(fp, "  read only = no\n");
-
-	fclose(fp);
-}
-
-static int start_rsync_daemon(void) {
-	if (access(RSYNC_BIN, X_OK) != 0)
-		return -1;
-
-	write_rsync_config();
-
-	char cmd[512];
-	snprintf(cmd, sizeof(cmd), "%s --daemon --config=%s", RSYNC_BIN, RSYNC_CONF_PATH);
-	int ret = system(cmd);
-	if (ret != 0)
-		return -1;
-
-	usleep(500000);
-	if (access(RSYNC_PID_PATH, F_OK) != 0)
-		return -1;
-
-	return 0;
-}
-
-static void stop_rsync_daemon(void) {
-	FILE* fp = fopen(RSYNC_PID_PATH, "r");
-	if (fp) {
-		int pid;
-		if (fscanf(fp, "%d", &pid) == 1 && pid > 0) {
-			kill(pid, SIGTERM);
-		}
-		fclose(fp);
-		unlink(RSYNC_PID_PATH);
-	}
-	system("killall rsync 2>/dev/null");
-	unlink(RSYNC_CONF_PATH);
-}
-
-// Progress tracking for current phase
-static volatile int phase_files_done = 0;
-static volatile int phase_files_total = 0;
-static volatile int phase_files_transferred = 0;
-
-// Parse "xfr#N, to-chk=X/Y" from rsync --info=progress2 output.
-static void parse_progress2(const char* line) {
-	// Parse xfr#N (actual files transferred)
-	const char* x = strstr(line, "xfr#");
-	if (x) {
-		int n = 0;
-		if (sscanf(x + 4, "%d", &n) == 1)
-			phase_files_transferred = n;
-	}
-
-	// Parse to-chk=X/Y (remaining/total scanned)
-	const char* p = strstr(line, "to-chk=");
-	if (!p)
-		p = strstr(line, "to-check=");
-	if (!p)
-		return;
-
-	p = strchr(p, '=');
-	if (!p)
-		return;
-	p++;
-
-	int remaining = 0, total = 0;
-	if (sscanf(p, "%d/%d", &remaining, &total) == 2 && total > 0) {
-		phase_files_total = total;
-		phase_files_done = total - remaining;
-	}
-}
-
-// Read a line delimited by \r or \n from a FILE stream.
-// rsync --info=progress2 uses \r to update progress in-place.
-static char* read_line_cr(char* buf, int size, FILE* fp) {
-	int i = 0;
-	int c;
-	while (i < size - 1) {
-		c = fgetc(fp);
-		if (c == EOF) {
-			if (i == 0)
-				return NULL;
-			break;
-		}
-		if (c == '\r' || c == '\n') {
-			if (i > 0)
-				break;
-			continue; // skip leading \r\n
-		}
-		buf[i++] = (char)c;
-	}
-	buf[i] = '\0';
-	return buf;
-}
-
-// Run rsync via popen() and capture output line by line into the log buffer
-static int run_rsync_phase(int phase) {
-	char cmd[1024];
-	const char* rsync_opts = "-rtv --update --inplace --no-perms --omit-dir-times --info=progress2";
-	const char* shared_excludes =
-		"--exclude=battery_logs.sqlite "
-		"--exclude=game_logs.sqlite "
-		"--exclude=ledsettings.txt "
-		"--exclude=ledsettings_brick.txt "
-		"--exclude=minuisettings.txt";
-
-	phase_files_done = 0;
-	phase_files_total = 0;
-	phase_files_transferred = 0;
-
-	switch (phase) {
-	case 1:
-		snprintf(cmd, sizeof(cmd), "%s %s %s %s/ rsync://%s:%d/shared/ 2>&1",
-				 RSYNC_BIN, rsync_opts, shared_excludes, SHARED_DATA_PATH, peer_ip, SYNC_RSYNC_PORT);
-		break;
-	case 2:
-		snprintf(cmd, sizeof(cmd), "%s %s %s/ rsync://%s:%d/saves/ 2>&1",
-				 RSYNC_BIN, rsync_opts, SAVES_PATH, peer_ip, SYNC_RSYNC_PORT);
-		break;
-	case 3:
-		snprintf(cmd, sizeof(cmd), "%s %s %s rsync://%s:%d/shared/ %s/ 2>&1",
-				 RSYNC_BIN, rsync_opts, shared_excludes, peer_ip, SYNC_RSYNC_PORT, SHARED_DATA_PATH);
-		break;
-	case 4:
-		snprintf(cmd, sizeof(cmd), "%s %s rsync://%s:%d/saves/ %s/ 2>&1",
-				 RSYNC_BIN, rsync_opts, peer_ip, SYNC_RSYNC_PORT, SAVES_PATH);
-		break;
-	case 5:
-		snprintf(cmd, sizeof(cmd), "%s %s %s/ rsync://%s:%d/roms/ 2>&1",
-				 RSYNC_BIN, rsync_opts, ROMS_PATH, peer_ip, SYNC_RSYNC_PORT);
-		break;
-	case 6:
-		snprintf(cmd, sizeof(cmd), "%s %s rsync://%s:%d/roms/ %s/ 2>&1",
-				 RSYNC_BIN, rsync_opts, peer_ip, SYNC_RSYNC_PORT, ROMS_PATH);
-		break;
-	default:
-		return -1;
-	}
-
-	FILE* fp = popen(cmd, "r");
-	if (!fp)
-		return -1;
-
-	char line[512];
-	while (read_line_cr(line, sizeof(line), fp) != NULL) {
-		if (sync_cancel)
-			break;
-
-		// Skip blank lines and rsync noise
-		if (line[0] == '\0')
-			continue;
-		if (strncmp(line, "sending incremental", 19) == 0)
-			continue;
-		if (strncmp(line, "receiving incremental", 20) == 0)
-			continue;
-		if (strncmp(line, "sent ", 5) == 0)
-			continue;
-		if (strncmp(line, "total size", 10) == 0)
-			continue;
-
-		// Check for progress2 info (contains "to-chk=" or "xfr#")
-		if (strstr(line, "to-chk=") || strstr(line, "to-check=")) {
-			parse_progress2(line);
-			continue; // don't add raw progress lines to log
-		}
-
-		// Skip lines that are just progress percentages (e.g. "  1,234,567  50%  ...")
-		if (line[0] == ' ' && strstr(line, "%"))
-			continue;
-
-		log_add(line);
-	}
-
-	int status = pclose(fp);
-	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
-}
-
 static void* sync_thread_func(void* arg) {
 	(void)arg;
 
@@ -584,193 +347,39 @@ static void* sync_thread_func(void* arg) {
 	if (sync_roms)
 		mkdir_p(ROMS_PATH);
 
-	if (is_server) {
-		log_add("Starting as server...");
-
-		// Truncate daemon log before starting daemon so we read a clean file
-		FILE* trunc = fopen("/tmp/rsyncd.log", "w");
-		if (trunc)
-			fclose(trunc);
-
-		if (start_rsync_daemon() != 0) {
-			log_add("ERROR: Failed to start rsync daemon");
-			sync_result = -1;
-			sync_done = true;
-			return NULL;
-		}
-
-		log_add("rsync daemon started, waiting for client...");
-		sync_phase = 0; // 0 = no phase yet; UI shows "Waiting for client..."
-
-		int notify_sock = create_send_socket();
-		int done_sock = create_recv_socket();
-		if (done_sock < 0) {
-			if (notify_sock >= 0)
-				close(notify_sock);
-			stop_rsync_daemon();
-			log_add("ERROR: Failed to create socket");
-			sync_result = -1;
-			sync_done = true;
-			return NULL;
-		}
-
-		char buf[256];
-		time_t start = time(NULL);
-		int ret = -1;
-		uint32_t last_ready = 0;
-
-		FILE* daemon_log = fopen("/tmp/rsyncd.log", "r");
-
-		while (!sync_cancel && !app_quit) {
-			if (time(NULL) - start > 3600) {
-				log_add("ERROR: Timeout waiting for client");
-				break;
-			}
-
-			uint32_t now = SDL_GetTicks();
-			if (notify_sock >= 0 && now - last_ready >= 1000) {
-				send_udp_message(notify_sock, READY_MSG, peer_ip);
-				last_ready = now;
-			}
-
-			// Tail the rsync daemon log for new lines
-			if (!daemon_log)
-				daemon_log = fopen("/tmp/rsyncd.log", "r");
-			if (daemon_log) {
-				char logline[512];
-				while (fgets(logline, sizeof(logline), daemon_log) != NULL) {
-					// Strip trailing newline
-					int ll = strlen(logline);
-					if (ll > 0 && logline[ll - 1] == '\n')
-						logline[ll - 1] = '\0';
-					if (!logline[0])
-						continue;
-
-					// Strip "YYYY/MM/DD HH:MM:SS [PID] " prefix
-					const char* msg = logline;
-					const char* bracket = strchr(msg, ']');
-					if (bracket && *(bracket + 1) == ' ')
-						msg = bracket + 2;
-
-					// For transfer lines ("send X" / "recv X"), show just the path
-					if (strncmp(msg, "send ", 5) == 0)
-						msg += 5;
-					else if (strncmp(msg, "recv ", 5) == 0)
-						msg += 5;
-
-					if (msg[0])
-						log_add(msg);
-				}
-				// fgets returns NULL at EOF; file handle stays valid for subsequent reads
-			}
-
-			fd_set readfds;
-			FD_ZERO(&readfds);
-			FD_SET(done_sock, &readfds);
-			struct timeval tv = {0, 200000};
-
-			int sel = select(done_sock + 1, &readfds, NULL, NULL, &tv);
-			if (sel > 0) {
-				ssize_t n = recvfrom(done_sock, buf, sizeof(buf) - 1, 0, NULL, NULL);
-				if (n > 0) {
-					buf[n] = '\0';
-					if (strcmp(buf, DONE_MSG) == 0) {
-						log_add("Client finished sync");
-						ret = 0;
-						break;
-					}
-				}
-			}
-		}
-
-		if (daemon_log)
-			fclose(daemon_log);
-		if (notify_sock >= 0)
-			close(notify_sock);
-		close(done_sock);
-		stop_rsync_daemon();
-
-		sync_result = (ret == 0) ? 0 : -1;
-		sync_done = true;
+	SyncRoot roots[] = {
+		{"shared", SHARED_DATA_PATH, shared_excludes},
+		{"saves", SAVES_PATH, NULL},
+		{"roms", ROMS_PATH, NULL},
+	};
+	SyncConfig config = {
+		.roots = roots,
+		.root_count = sync_roms ? 3 : 2,
+		.state_dir = SYNC_STATE_PATH,
+		.is_server = is_server,
+		.peer_ip = peer_ip,
+		.port = SYNC_TCP_PORT,
+		.connect_timeout_sec = is_server ? SERVER_WAIT_SEC : CLIENT_CONNECT_SEC,
+		.cancel = &sync_cancel,
+		.log = log_add,
+	};
+
+	log_add(is_server ? "Starting as server..." : "Starting as client...");
+	int ret = SyncEngine_run(&config, &sync_progress);
+
+	char summary[LOG_LINE_LEN];
+	if (ret == 0) {
+		snprintf(summary, sizeof(summary), "Sync complete: %d sent, %d received",
+				 sync_progress.files_sent, sync_progress.files_received);
+	} else if (sync_progress.files_failed) {
+		snprintf(summary, sizeof(summary), "ERROR: %d files failed to sync", sync_progress.files_failed);
 	} else {
-		log_add("Starting as client...");
-		log_add("Waiting for server...");
-		sync_phase = 0;
-
-		int ret = wait_for_udp_message(READY_MSG, 30);
-		if (ret != 0) {
-			log_add("ERROR: Server not ready (timeout)");
-			sync_result = -1;
-			sync_done = true;
-			return NULL;
-		}
-
-		log_add("Server ready!");
-		usleep(500000);
-
-		int total_phases = sync_roms ? 6 : 4;
-		const char* phase_names_4[] = {
-			"",
-			"[1/4] Pushing settings",
-			"[2/4] Pushing saves",
-			"[3/4] Pulling settings",
-			"[4/4] Pulling saves",
-		};
-		const char* phase_names_6[] = {
-			"",
-			"[1/6] Pushing settings",
-			"[2/6] Pushing saves",
-			"[3/6] Pulling settings",
-			"[4/6] Pulling saves",
-			"[5/6] Pushing ROMs",
-			"[6/6] Pulling ROMs",
-		};
-		const char** phase_names = sync_roms ? phase_names_6 : phase_names_4;
-
-		int total_transferred = 0;
-		int total_scanned = 0;
-		for (int phase = 1; phase <= total_phases && !sync_cancel; phase++) {
-			sync_phase = phase;
-			log_add(phase_names[phase]);
-			int result = run_rsync_phase(phase);
-			if (result != 0) {
-				char err[LOG_LINE_LEN];
-				snprintf(err, sizeof(err), "ERROR: Phase %d failed (exit %d)", phase, result);
-				log_add(err);
-				sync_result = -1;
-				sync_done = true;
-				return NULL;
-			}
-			total_transferred += phase_files_transferred;
-			total_scanned += phase_files_total;
-
-			char summary[LOG_LINE_LEN];
-			snprintf(summary, sizeof(summary), "  Done: %d files changed out of %d",
-					 phase_files_transferred, phase_files_total);
-			log_add(summary);
-		}
-
-		{
-			char final_summary[LOG_LINE_LEN];
-			snprintf(final_summary, sizeof(final_summary),
-					 "Sync complete: %d files changed out of %d total",
-					 total_transferred, total_scanned);
-			log_add(final_summary);
-		}
-
-		int notify_sock = create_send_socket();
-		if (notify_sock >= 0) {
-			for (int i = 0; i < 5; i++) {
-				send_udp_message(notify_sock, DONE_MSG, peer_ip);
-				usleep(200000);
-			}
-			close(notify_sock);
-		}
-
-		sync_result = 0;
-		sync_done = true;
+		snprintf(summary, sizeof(summary), "ERROR: Sync did not finish");
 	}
+	log_add(summary);
 
+	sync_result = (ret == 0) ? 0 : -1;
+	sync_done = true;
 	return NULL;
 }
 
@@ -784,7 +393,7 @@ static void start_sync(void) {
 	sync_cancel = false;
 	sync_done = false;
 	sync_result = 0;
-	sync_phase = 0;
+	memset(&sync_progress, 0, sizeof(sync_progress));
 
 	log_clear();
 	char msg[LOG_LINE_LEN];
@@ -809,8 +418,7 @@ static void start_sync(void) {
 }
 
 static void cancel_sync(void) {
-	sync_cancel = true;
-	stop_rsync_daemon(); // kills daemon + killall rsync, unblocks popen in sync thread
+	sync_cancel = true; // the engine checks this at least every 200ms
 	if (sync_thread_active) {
 		pthread_join(sync_thread, NULL);
 		sync_thread_active = false;
@@ -932,38 +540,32 @@ static void render_screen(void) {
 		int top_y = menu_h + SCALE1(PADDING);
 		int bottom_y = screen->h - SCALE1(PILL_SIZE + PADDING);
 
-		// Show phase progress header at top
+		// Show progress header at top
 		{
-			int total_phases = sync_roms ? 6 : 4;
-			const char* phase_labels[] = {
-				"",
-				"Pushing settings",
-				"Pushing saves",
-				"Pulling settings",
-				"Pulling saves",
-				"Pushing ROMs",
-				"Pulling ROMs",
-			};
-			int p = sync_phase;
-			if (p >= 1 && p <= total_phases) {
-				char hdr[128];
-				int done = phase_files_done;
-				int total = phase_files_total;
-				int xfr = phase_files_transferred;
-				if (total > 0)
-					snprintf(hdr, sizeof(hdr), "[%d/%d] %s - %d/%d files (%d changed)",
-							 p, total_phases, phase_labels[p], done, total, xfr);
-				else
-					snprintf(hdr, sizeof(hdr), "[%d/%d] %s",
-							 p, total_phases, phase_labels[p]);
-				GFX_blitText(font.large, hdr, 0, COLOR_WHITE, screen,
-							 &(SDL_Rect){SCALE1(PADDING), top_y,
-										 screen->w - SCALE1(PADDING * 2), SCALE1(FONT_LARGE)});
-			} else if (is_server) {
-				GFX_blitText(font.large, "Waiting for client...", 0, COLOR_WHITE, screen,
-							 &(SDL_Rect){SCALE1(PADDING), top_y,
-										 screen->w - SCALE1(PADDING * 2), SCALE1(FONT_LARGE)});
+			char hdr[128];
+			switch (sync_progress.stage) {
+			case SYNC_STAGE_CONNECTING:
+				snprintf(hdr, sizeof(hdr), is_server ? "Waiting for client..." : "Connecting...");
+				break;
+			case SYNC_STAGE_SCANNING:
+				snprintf(hdr, sizeof(hdr), "Scanning - %d files", sync_progress.files_scanned);
+				break;
+			case SYNC_STAGE_COMPARING:
+				snprintf(hdr, sizeof(hdr), "Comparing with other device...");
+				break;
+			case SYNC_STAGE_TRANSFERRING: {
+				int total_mb = sync_progress.bytes_total >> 20;
+				int done_mb = sync_progress.bytes_done >> 20;
+				snprintf(hdr, sizeof(hdr), "Syncing - %d/%d files (%d/%d MB)",
+						 sync_progress.files_done, sync_progress.files_total, done_mb, total_mb);
+			} break;
+			default:
+				snprintf(hdr, sizeof(hdr), "Finishing...");
+				break;
 			}
+			GFX_blitText(font.large, hdr, 0, COLOR_WHITE, screen,
+						 &(SDL_Rect){SCALE1(PADDING), top_y,
+									 screen->w - SCALE1(PADDING * 2), SCALE1(FONT_LARGE)});
 			top_y += TTF_FontLineSkip(font.large) + SCALE1(PADDING);
 		}
 
@@ -1083,7 +685,6 @@ int main(int argc, char* argv[]) {
 					pthread_join(sync_thread, NULL);
 					sync_thread_active = false;
 				}
-				stop_rsync_daemon();
 				PWR_enableSleep();
 				PWR_enableAutosleep();
 
@@ -1146,7 +747,6 @@ int main(int argc, char* argv[]) {
 		sync_cancel = true;
 		pthread_join(sync_thread, NULL);
 	}
-	stop_rsync_daemon();
 
 	if (udp_sock >= 0)
 		close(udp_sock);
@@ -0,0 +1,1133 @@
+#include "sync_engine.h"
+#include "sync_manifest.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <limits.h>
+#include <pthread.h>
+#include <zlib.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+// Wire format: every message is a frame of
+//   u8 type | u32 payload length | payload
+// with integers little-endian. Each side has one writer (the sender thread)
+// and one reader (the calling thread), so both directions stream at once
+// and neither can block the other.
+
+#define PROTO_MAGIC 0x59534E58 // "XNSY"
+#define PROTO_VERSION 1
+
+#define FRAME_HEADER 5
+#define FRAME_MAX (64 << 20)
+#define DATA_CHUNK (64 * 1024)
+#define OUT_BUFFER (256 * 1024)
+#define IN_BUFFER (256 * 1024)
+
+#define POLL_MS 200
+#define IO_TIMEOUT_SEC 30
+#define MTIME_WINDOW 1		 // FAT keeps mtimes in 2 second steps
+#define RESUME_ALIGN (64 * 1024) // Partial data is only trusted up to here
+
+enum {
+	MSG_HELLO = 1, // u32 magic, u16 version, u8 roots, roots * (u8 len, name)
+	MSG_MANIFEST,  // u32 entries, u32 raw size, deflated entries
+	MSG_WANT,	   // u32 count, count * (u32 index, u64 offset)
+	MSG_FILE,	   // u32 index, u64 offset, u64 size, i64 mtime
+	MSG_DATA,	   // file bytes
+	MSG_END,	   // u64 hash of the whole file
+	MSG_SKIP,	   // u32 index, sender could not read it
+	MSG_DONE,	   // sender has nothing more
+};
+
+typedef struct {
+	uint32_t index; // Into the sender's manifest, roots in order
+	uint64_t offset;
+} Want;
+
+typedef struct {
+	uint8_t* data;
+	size_t len;
+	size_t capacity;
+} Buffer;
+
+typedef struct {
+	const uint8_t* p;
+	size_t left;
+	bool bad;
+} Cursor;
+
+typedef struct {
+	bool active;
+	bool broken; // Write failed, drop the rest of the data
+	int fd;
+	int root;
+	const char* path; // Peer manifest entry
+	char part[PATH_MAX];
+	char target[PATH_MAX];
+	uint64_t offset;
+	uint64_t size;
+	uint64_t received;
+	int64_t mtime;
+	uint64_t hash;
+} Incoming;
+
+typedef struct {
+	const SyncConfig* config;
+	SyncProgress* progress;
+	int sock;
+	volatile bool failed;
+
+	SyncManifest local[SYNC_MAX_ROOTS];
+	SyncManifest peer[SYNC_MAX_ROOTS];
+	SyncManifest received[SYNC_MAX_ROOTS]; // Applied to local after the session
+	int local_base[SYNC_MAX_ROOTS + 1];	   // Flat index of each root's first entry
+	int peer_base[SYNC_MAX_ROOTS + 1];
+	bool* wanted; // Per peer entry
+
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool manifest_ready;
+	bool wants_ready;
+	bool peer_wants_ready;
+	Want* wants;
+	int want_count;
+	Want* peer_wants;
+	int peer_want_count;
+
+	uint8_t* out; // Sender thread only
+	size_t out_len;
+	uint8_t* in; // Reading thread only
+	size_t in_len;
+	size_t in_pos;
+	Buffer frame;
+} Session;
+
+static void session_log(Session* s, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void session_log(Session* s, const char* fmt, ...) {
+	if (!s->config->log)
+		return;
+	char line[256];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(line, sizeof(line), fmt, args);
+	va_end(args);
+	s->config->log(line);
+}
+
+static bool is_cancelled(Session* s) {
+	return s->failed || (s->config->cancel && *s->config->cancel);
+}
+
+// Stop both threads: the other one notices on its next poll
+static void session_fail(Session* s) {
+	pthread_mutex_lock(&s->mutex);
+	s->failed = true;
+	pthread_cond_broadcast(&s->cond);
+	pthread_mutex_unlock(&s->mutex);
+}
+
+///////////////////////////////
+// Encoding
+
+static bool buffer_reserve(Buffer* b, size_t extra) {
+	if (b->len + extra <= b->capacity)
+		return true;
+	size_t capacity = b->capacity ? b->capacity * 2 : 4096;
+	while (capacity < b->len + extra)
+		capacity *= 2;
+	uint8_t* data = realloc(b->data, capacity);
+	if (!data)
+		return false;
+	b->data = data;
+	b->capacity = capacity;
+	return true;
+}
+
+static void put_bytes(Buffer* b, const void* data, size_t len) {
+	if (buffer_reserve(b, len)) {
+		memcpy(b->data + b->len, data, len);
+		b->len += len;
+	}
+}
+
+static void put_uint(Buffer* b, uint64_t value, int bytes) {
+	uint8_t raw[8];
+	for (int i = 0; i < bytes; i++)
+		raw[i] = value >> (8 * i);
+	put_bytes(b, raw, bytes);
+}
+
+static uint64_t get_uint(Cursor* c, int bytes) {
+	if (c->left < (size_t)bytes) {
+		c->bad = true;
+		return 0;
+	}
+	uint64_t value = 0;
+	for (int i = 0; i < bytes; i++)
+		value |= (uint64_t)c->p[i] << (8 * i);
+	c->p += bytes;
+	c->left -= bytes;
+	return value;
+}
+
+static const uint8_t* get_bytes(Cursor* c, size_t len) {
+	if (c->left < len) {
+		c->bad = true;
+		return NULL;
+	}
+	const uint8_t* p = c->p;
+	c->p += len;
+	c->left -= len;
+	return p;
+}
+
+///////////////////////////////
+// Socket I/O
+
+// Wait for the socket; timeout_sec 0 waits until cancelled
+static int wait_socket(Session* s, short events, int timeout_sec) {
+	time_t start = time(NULL);
+	while (!is_cancelled(s)) {
+		struct pollfd pfd = {s->sock, events, 0};
+		int ret = poll(&pfd, 1, POLL_MS);
+		if (ret > 0)
+			return 0;
+		if (ret < 0 && errno != EINTR)
+			return -1;
+		if (timeout_sec > 0 && time(NULL) - start > timeout_sec) {
+			session_log(s, "ERROR: Peer stopped responding");
+			return -1;
+		}
+	}
+	return -1;
+}
+
+static int send_all(Session* s, const uint8_t* data, size_t len) {
+	while (len > 0) {
+		ssize_t n = send(s->sock, data, len, MSG_NOSIGNAL);
+		if (n > 0) {
+			data += n;
+			len -= n;
+		} else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+			if (wait_socket(s, POLLOUT, IO_TIMEOUT_SEC) != 0)
+				return -1;
+		} else {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int out_flush(Session* s) {
+	int ret = send_all(s, s->out, s->out_len);
+	s->out_len = 0;
+	return ret;
+}
+
+static int out_write(Session* s, const void* data, size_t len) {
+	if (s->out_len + len > OUT_BUFFER) {
+		if (out_flush(s) != 0)
+			return -1;
+		if (len > OUT_BUFFER)
+			return send_all(s, data, len);
+	}
+	memcpy(s->out + s->out_len, data, len);
+	s->out_len += len;
+	return 0;
+}
+
+static int send_frame(Session* s, int type, const void* payload, size_t len) {
+	uint8_t header[FRAME_HEADER] = {type, len, len >> 8, len >> 16, len >> 24};
+	if (out_write(s, header, sizeof(header)) != 0)
+		return -1;
+	return len ? out_write(s, payload, len) : 0;
+}
+
+static int in_read(Session* s, void* dst, size_t len, int timeout_sec) {
+	uint8_t* p = dst;
+	while (len > 0) {
+		if (s->in_pos < s->in_len) {
+			size_t n = s->in_len - s->in_pos;
+			if (n > len)
+				n = len;
+			memcpy(p, s->in + s->in_pos, n);
+			s->in_pos += n;
+			p += n;
+			len -= n;
+			continue;
+		}
+
+		ssize_t n = recv(s->sock, s->in, IN_BUFFER, 0);
+		if (n > 0) {
+			s->in_len = n;
+			s->in_pos = 0;
+		} else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+			if (wait_socket(s, POLLIN, timeout_sec) != 0)
+				return -1;
+		} else {
+			if (!is_cancelled(s))
+				session_log(s, "ERROR: Connection closed by peer");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+// Read the next frame into s->frame. Returns the type, -1 on error.
+static int read_frame(Session* s, int timeout_sec) {
+	uint8_t header[FRAME_HEADER];
+	if (in_read(s, header, sizeof(header), timeout_sec) != 0)
+		return -1;
+	size_t len = header[1] | header[2] << 8 | header[3] << 16 | (size_t)header[4] << 24;
+	if (len > FRAME_MAX) {
+		session_log(s, "ERROR: Invalid message from peer");
+		return -1;
+	}
+	s->frame.len = 0;
+	if (!buffer_reserve(&s->frame, len))
+		return -1;
+	if (in_read(s, s->frame.data, len, IO_TIMEOUT_SEC) != 0)
+		return -1;
+	s->frame.len = len;
+	return header[0];
+}
+
+///////////////////////////////
+// Connecting
+
+static int set_nonblocking(int sock) {
+	int flags = fcntl(sock, F_GETFL, 0);
+	return flags < 0 ? -1 : fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+}
+
+static int accept_peer(Session* s) {
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (listener < 0)
+		return -1;
+
+	int yes = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(s->config->port);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 1) < 0) {
+		close(listener);
+		return -1;
+	}
+
+	time_t start = time(NULL);
+	int sock = -1;
+	while (!is_cancelled(s) && time(NULL) - start <= s->config->connect_timeout_sec) {
+		struct pollfd pfd = {listener, POLLIN, 0};
+		if (poll(&pfd, 1, POLL_MS) > 0) {
+			sock = accept(listener, NULL, NULL);
+			if (sock >= 0)
+				break;
+		}
+	}
+	close(listener);
+	return sock;
+}
+
+static int connect_peer(Session* s) {
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(s->config->port);
+	if (inet_pton(AF_INET, s->config->peer_ip, &addr.sin_addr) != 1)
+		return -1;
+
+	// The server may still be starting up, keep trying until the timeout
+	time_t start = time(NULL);
+	while (!is_cancelled(s) && time(NULL) - start <= s->config->connect_timeout_sec) {
+		int sock = socket(AF_INET, SOCK_STREAM, 0);
+		if (sock < 0)
+			return -1;
+		set_nonblocking(sock);
+
+		if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == 0)
+			return sock;
+		if (errno == EINPROGRESS) {
+			struct pollfd pfd = {sock, POLLOUT, 0};
+			if (poll(&pfd, 1, 1000) > 0) {
+				int err = 0;
+				socklen_t len = sizeof(err);
+				if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0)
+					return sock;
+			}
+		}
+		close(sock);
+		usleep(500000);
+	}
+	return -1;
+}
+
+///////////////////////////////
+// Files
+
+static void make_parent_dirs(const char* path) {
+	char dir[PATH_MAX];
+	snprintf(dir, sizeof(dir), "%s", path);
+	for (char* p = dir + 1; *p; p++) {
+		if (*p != '/')
+			continue;
+		*p = '\0';
+		mkdir(dir, 0755);
+		*p = '/';
+	}
+}
+
+// Peer paths are only accepted if they stay inside the root
+static bool is_safe_path(const char* path) {
+	if (!path[0] || path[0] == '/')
+		return false;
+	const char* p = path;
+	while (*p) {
+		const char* end = strchr(p, '/');
+		size_t len = end ? (size_t)(end - p) : strlen(p);
+		if (len == 0 || (len == 1 && p[0] == '.') || (len == 2 && p[0] == '.' && p[1] == '.'))
+			return false;
+		if (!end)
+			break;
+		p = end + 1;
+	}
+	return true;
+}
+
+// Where a peer file lands and where its partial download goes, false if
+// either wouldn't fit in PATH_MAX
+static bool incoming_paths(const char* root_path, const char* path, char* target, char* part) {
+	int len = snprintf(target, PATH_MAX, "%s/%s", root_path, path);
+	if (len < 0 || len + sizeof(SYNC_PART_SUFFIX) > PATH_MAX)
+		return false;
+	return snprintf(part, PATH_MAX, "%s" SYNC_PART_SUFFIX, target) < PATH_MAX;
+}
+
+static int root_of(const int* base, int root_count, uint32_t index) {
+	for (int r = 0; r < root_count; r++) {
+		if (index < (uint32_t)base[r + 1])
+			return r;
+	}
+	return -1;
+}
+
+///////////////////////////////
+// Manifests
+
+static void encode_manifest(Session* s, Buffer* payload) {
+	Buffer raw = {0};
+	int total = 0;
+	for (int r = 0; r < s->config->root_count; r++) {
+		const SyncManifest* m = &s->local[r];
+		for (int i = 0; i < m->count; i++) {
+			const SyncEntry* e = &m->entries[i];
+			size_t len = strlen(e->path);
+			put_uint(&raw, r, 1);
+			put_uint(&raw, len, 2);
+			put_bytes(&raw, e->path, len);
+			put_uint(&raw, e->size, 8);
+			put_uint(&raw, e->mtime, 8);
+			put_uint(&raw, e->hash, 8);
+		}
+		total += m->count;
+	}
+
+	// Paths compress very well, this is what the slow link carries
+	uLongf packed = compressBound(raw.len);
+	put_uint(payload, total, 4);
+	put_uint(payload, raw.len, 4);
+	if (buffer_reserve(payload, packed) && compress2(payload->data + payload->len, &packed, raw.data, raw.len, 1) == Z_OK)
+		payload->len += packed;
+	else
+		payload->len = 0;
+	free(raw.data);
+}
+
+static int decode_manifest(Session* s) {
+	Cursor c = {s->frame.data, s->frame.len, false};
+	uint32_t total = get_uint(&c, 4);
+	uLongf raw_len = get_uint(&c, 4);
+	if (c.bad || raw_len > (uLongf)FRAME_MAX * 4)
+		return -1;
+
+	uint8_t* raw = malloc(raw_len ? raw_len : 1);
+	if (!raw || uncompress(raw, &raw_len, c.p, c.left) != Z_OK) {
+		free(raw);
+		return -1;
+	}
+
+	// Entries arrive grouped by root in the sender's order, which is what
+	// the flat indexes in WANT and FILE refer to
+	Cursor e = {raw, raw_len, false};
+	int last_root = 0;
+	char path[PATH_MAX];
+	for (uint32_t i = 0; i < total && !e.bad; i++) {
+		int root = get_uint(&e, 1);
+		size_t len = get_uint(&e, 2);
+		const uint8_t* name = get_bytes(&e, len);
+		uint64_t size = get_uint(&e, 8);
+		int64_t mtime = get_uint(&e, 8);
+		uint64_t hash = get_uint(&e, 8);
+		if (e.bad || root < last_root || root >= s->config->root_count || len >= sizeof(path))
+			break;
+		memcpy(path, name, len);
+		path[len] = '\0';
+		last_root = root;
+		if (!SyncManifest_append(&s->peer[root], path, size, mtime, hash))
+			e.bad = true;
+	}
+	free(raw);
+
+	int count = 0;
+	for (int r = 0; r < s->config->root_count; r++)
+		count += s->peer[r].count;
+	if (e.bad || count != (int)total)
+		return -1;
+
+	s->peer_base[0] = 0;
+	for (int r = 0; r < s->config->root_count; r++)
+		s->peer_base[r + 1] = s->peer_base[r] + s->peer[r].count;
+	return 0;
+}
+
+// Exactly one side decides to pull a file that differs, so nothing is sent
+// both ways: the newer copy wins and the client's copy wins a tie
+static bool should_pull(const SyncEntry* local, const SyncEntry* peer, bool is_server) {
+	if (!local)
+		return true;
+
+	int64_t age = peer->mtime - local->mtime;
+	if (local->size == peer->size) {
+		if (age >= -MTIME_WINDOW && age <= MTIME_WINDOW)
+			return false;
+		if (local->hash && local->hash == peer->hash)
+			return false; // Same content, only the timestamps differ
+	}
+
+	if (age > MTIME_WINDOW)
+		return true;
+	if (age < -MTIME_WINDOW)
+		return false;
+	return is_server;
+}
+
+// Existing partial download of the same version of a file, to resume from
+static uint64_t resume_offset(const char* part, const SyncEntry* peer) {
+	struct stat st;
+	if (stat(part, &st) != 0)
+		return 0;
+	if (st.st_mtime != peer->mtime || (uint64_t)st.st_size >= peer->size)
+		return 0;
+	return st.st_size & ~(uint64_t)(RESUME_ALIGN - 1);
+}
+
+static void plan_wants(Session* s) {
+	const SyncConfig* config = s->config;
+	int peer_total = s->peer_base[config->root_count];
+	s->wanted = calloc(peer_total ? peer_total : 1, sizeof(bool));
+	s->wants = malloc((peer_total ? peer_total : 1) * sizeof(Want));
+	if (!s->wanted || !s->wants)
+		return;
+
+	int64_t bytes = 0;
+	for (int r = 0; r < config->root_count; r++) {
+		for (int i = 0; i < s->peer[r].count; i++) {
+			const SyncEntry* peer = &s->peer[r].entries[i];
+			if (!is_safe_path(peer->path))
+				continue;
+			const SyncEntry* local = SyncManifest_find(&s->local[r], peer->path);
+			if (!should_pull(local, peer, config->is_server))
+				continue;
+
+			char target[PATH_MAX];
+			char part[PATH_MAX];
+			if (!incoming_paths(config->roots[r].path, peer->path, target, part)) {
+				session_log(s, "ERROR: Path too long %s", peer->path);
+				__sync_fetch_and_add(&s->progress->files_failed, 1);
+				continue;
+			}
+			Want* want = &s->wants[s->want_count++];
+			want->index = s->peer_base[r] + i;
+			want->offset = resume_offset(part, peer);
+			s->wanted[want->index] = true;
+			bytes += peer->size - want->offset;
+		}
+	}
+
+	__sync_fetch_and_add(&s->progress->files_total, s->want_count);
+	__sync_fetch_and_add(&s->progress->bytes_total, bytes);
+}
+
+///////////////////////////////
+// Sending
+
+static void wait_for(Session* s, bool* flag) {
+	pthread_mutex_lock(&s->mutex);
+	while (!*flag && !is_cancelled(s)) {
+		struct timespec until;
+		clock_gettime(CLOCK_REALTIME, &until);
+		until.tv_nsec += POLL_MS * 1000000L;
+		if (until.tv_nsec >= 1000000000L) {
+			until.tv_sec++;
+			until.tv_nsec -= 1000000000L;
+		}
+		pthread_cond_timedwait(&s->cond, &s->mutex, &until);
+	}
+	pthread_mutex_unlock(&s->mutex);
+}
+
+static void signal_flag(Session* s, bool* flag) {
+	pthread_mutex_lock(&s->mutex);
+	*flag = true;
+	pthread_cond_broadcast(&s->cond);
+	pthread_mutex_unlock(&s->mutex);
+}
+
+static int send_hello(Session* s) {
+	Buffer b = {0};
+	put_uint(&b, PROTO_MAGIC, 4);
+	put_uint(&b, PROTO_VERSION, 2);
+	put_uint(&b, s->config->root_count, 1);
+	for (int r = 0; r < s->config->root_count; r++) {
+		size_t len = strlen(s->config->roots[r].name);
+		put_uint(&b, len, 1);
+		put_bytes(&b, s->config->roots[r].name, len);
+	}
+	int ret = b.data ? send_frame(s, MSG_HELLO, b.data, b.len) : -1;
+	free(b.data);
+	return ret;
+}
+
+static int send_skip(Session* s, uint32_t index) {
+	uint8_t msg[4] = {index, index >> 8, index >> 16, index >> 24};
+	return send_frame(s, MSG_SKIP, msg, sizeof(msg));
+}
+
+// Stream one requested file. Returns -1 only if the connection failed.
+static int send_file(Session* s, const Want* want, uint8_t* chunk) {
+	int root = root_of(s->local_base, s->config->root_count, want->index);
+	if (root < 0)
+		return -1;
+	SyncEntry* entry = &s->local[root].entries[want->index - s->local_base[root]];
+
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%s", s->config->roots[root].path, entry->path);
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		if (fd >= 0)
+			close(fd);
+		session_log(s, "ERROR: Can't read %s", entry->path);
+		__sync_fetch_and_add(&s->progress->files_failed, 1);
+		return send_skip(s, want->index);
+	}
+
+	// Only resume if the file is still the version the peer planned with
+	uint64_t size = st.st_size;
+	uint64_t offset = want->offset;
+	if (st.st_mtime != entry->mtime || size != entry->size || offset > size)
+		offset = 0;
+	uint64_t hash = SYNC_HASH_SEED;
+	if (offset && SyncManifest_hashFd(fd, offset, &hash) != 0) {
+		offset = 0;
+		hash = SYNC_HASH_SEED;
+		lseek(fd, 0, SEEK_SET);
+	}
+
+	Buffer b = {0};
+	put_uint(&b, want->index, 4);
+	put_uint(&b, offset, 8);
+	put_uint(&b, size, 8);
+	put_uint(&b, st.st_mtime, 8);
+	int ret = b.data ? send_frame(s, MSG_FILE, b.data, b.len) : -1;
+	free(b.data);
+
+	uint64_t left = size - offset;
+	while (ret == 0 && left > 0) {
+		ssize_t n = read(fd, chunk, left < DATA_CHUNK ? (size_t)left : DATA_CHUNK);
+		if (n <= 0)
+			break;
+		hash = SyncManifest_hash(hash, chunk, n);
+		ret = send_frame(s, MSG_DATA, chunk, n);
+		left -= n;
+		__sync_fetch_and_add(&s->progress->bytes_done, n);
+	}
+	close(fd);
+	if (ret != 0)
+		return -1;
+
+	if (left > 0) {
+		// Shrunk or unreadable while sending
+		session_log(s, "ERROR: Can't read %s", entry->path);
+		__sync_fetch_and_add(&s->progress->files_failed, 1);
+		return send_skip(s, want->index);
+	}
+
+	uint8_t end[8];
+	for (int i = 0; i < 8; i++)
+		end[i] = hash >> (8 * i);
+	if (send_frame(s, MSG_END, end, sizeof(end)) != 0)
+		return -1;
+
+	// Learned for free, the next scan keeps it
+	if ((int64_t)st.st_mtime == entry->mtime && size == entry->size)
+		entry->hash = hash;
+
+	session_log(s, "-> %s/%s", s->config->roots[root].name, entry->path);
+	__sync_fetch_and_add(&s->progress->files_sent, 1);
+	__sync_fetch_and_add(&s->progress->files_done, 1);
+	return 0;
+}
+
+static void* sender_thread(void* arg) {
+	Session* s = arg;
+	int ret = send_hello(s);
+	if (ret == 0)
+		ret = out_flush(s);
+
+	if (ret == 0) {
+		wait_for(s, &s->manifest_ready);
+		Buffer payload = {0};
+		if (!is_cancelled(s)) {
+			encode_manifest(s, &payload);
+			ret = payload.len ? send_frame(s, MSG_MANIFEST, payload.data, payload.len) : -1;
+			if (ret == 0)
+				ret = out_flush(s);
+		}
+		free(payload.data);
+	}
+
+	if (ret == 0 && !is_cancelled(s)) {
+		wait_for(s, &s->wants_ready);
+		Buffer b = {0};
+		put_uint(&b, s->want_count, 4);
+		for (int i = 0; i < s->want_count; i++) {
+			put_uint(&b, s->wants[i].index, 4);
+			put_uint(&b, s->wants[i].offset, 8);
+		}
+		ret = (!is_cancelled(s) && b.data) ? send_frame(s, MSG_WANT, b.data, b.len) : -1;
+		free(b.data);
+		if (ret == 0)
+			ret = out_flush(s);
+	}
+
+	if (ret == 0 && !is_cancelled(s)) {
+		wait_for(s, &s->peer_wants_ready);
+		uint8_t* chunk = malloc(DATA_CHUNK);
+		if (!chunk)
+			ret = -1;
+		for (int i = 0; ret == 0 && i < s->peer_want_count && !is_cancelled(s); i++)
+			ret = send_file(s, &s->peer_wants[i], chunk);
+		free(chunk);
+	}
+
+	if (ret == 0 && !is_cancelled(s)) {
+		ret = send_frame(s, MSG_DONE, NULL, 0);
+		if (ret == 0)
+			ret = out_flush(s);
+	}
+
+	if (ret != 0)
+		session_fail(s);
+	return NULL;
+}
+
+///////////////////////////////
+// Receiving
+
+static int check_hello(Session* s) {
+	Cursor c = {s->frame.data, s->frame.len, false};
+	uint32_t magic = get_uint(&c, 4);
+	int version = get_uint(&c, 2);
+	int roots = get_uint(&c, 1);
+	if (c.bad || magic != PROTO_MAGIC || version != PROTO_VERSION) {
+		session_log(s, "ERROR: Other device runs an incompatible Sync");
+		return -1;
+	}
+	if (roots != s->config->root_count) {
+		session_log(s, "ERROR: Devices disagree on what to sync");
+		return -1;
+	}
+	for (int r = 0; r < roots; r++) {
+		size_t len = get_uint(&c, 1);
+		const uint8_t* name = get_bytes(&c, len);
+		if (c.bad || len != strlen(s->config->roots[r].name) || memcmp(name, s->config->roots[r].name, len) != 0) {
+			session_log(s, "ERROR: Devices disagree on what to sync");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int read_peer_wants(Session* s) {
+	Cursor c = {s->frame.data, s->frame.len, false};
+	uint32_t count = get_uint(&c, 4);
+	int local_total = s->local_base[s->config->root_count];
+	if (c.bad || count > (uint32_t)local_total)
+		return -1;
+
+	s->peer_wants = malloc((count ? count : 1) * sizeof(Want));
+	if (!s->peer_wants)
+		return -1;
+
+	int64_t bytes = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		Want* want = &s->peer_wants[i];
+		want->index = get_uint(&c, 4);
+		want->offset = get_uint(&c, 8);
+		if (c.bad || want->index >= (uint32_t)local_total)
+			return -1;
+		int root = root_of(s->local_base, s->config->root_count, want->index);
+		const SyncEntry* entry = &s->local[root].entries[want->index - s->local_base[root]];
+		if (want->offset < entry->size)
+			bytes += entry->size - want->offset;
+	}
+	s->peer_want_count = count;
+
+	__sync_fetch_and_add(&s->progress->files_total, count);
+	__sync_fetch_and_add(&s->progress->bytes_total, bytes);
+	signal_flag(s, &s->peer_wants_ready);
+	return 0;
+}
+
+// Stop receiving the current file. What arrived is kept and stamped with
+// the mtime of the version it belongs to, so the next sync can resume it.
+static void incoming_discard(Incoming* in) {
+	if (!in->active)
+		return;
+	if (in->fd >= 0) {
+		if (!in->broken) {
+			struct timespec times[2] = {{in->mtime, 0}, {in->mtime, 0}};
+			futimens(in->fd, times);
+		}
+		close(in->fd);
+	}
+	if (in->broken)
+		unlink(in->part);
+	in->fd = -1;
+	in->active = false;
+}
+
+static int begin_file(Session* s, Incoming* in) {
+	Cursor c = {s->frame.data, s->frame.len, false};
+	uint32_t index = get_uint(&c, 4);
+	in->offset = get_uint(&c, 8);
+	in->size = get_uint(&c, 8);
+	in->mtime = get_uint(&c, 8);
+	if (c.bad || in->active || index >= (uint32_t)s->peer_base[s->config->root_count] || !s->wanted[index] ||
+		in->offset > in->size)
+		return -1;
+	s->wanted[index] = false;
+
+	in->root = root_of(s->peer_base, s->config->root_count, index);
+	in->path = s->peer[in->root].entries[index - s->peer_base[in->root]].path;
+	// Only wanted files get here and plan_wants checked those paths fit
+	if (!incoming_paths(s->config->roots[in->root].path, in->path, in->target, in->part))
+		return -1;
+
+	in->active = true;
+	in->broken = false;
+	in->received = 0;
+	in->hash = SYNC_HASH_SEED;
+
+	make_parent_dirs(in->part);
+	if (in->offset > 0) {
+		// Resuming: the hash covers the whole file, so read the part we have
+		in->fd = open(in->part, O_RDWR);
+		if (in->fd < 0 || SyncManifest_hashFd(in->fd, in->offset, &in->hash) != 0 ||
+			ftruncate(in->fd, in->offset) != 0)
+			in->broken = true;
+	} else {
+		in->fd = open(in->part, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (in->fd < 0)
+			in->broken = true;
+	}
+	if (in->broken)
+		session_log(s, "ERROR: Can't write %s", in->path);
+	return 0;
+}
+
+static int write_data(Session* s, Incoming* in) {
+	if (!in->active || in->received + s->frame.len > in->size - in->offset)
+		return -1;
+
+	in->received += s->frame.len;
+	__sync_fetch_and_add(&s->progress->bytes_done, s->frame.len);
+	if (in->broken)
+		return 0;
+
+	in->hash = SyncManifest_hash(in->hash, s->frame.data, s->frame.len);
+	const uint8_t* p = s->frame.data;
+	size_t left = s->frame.len;
+	while (left > 0) {
+		ssize_t n = write(in->fd, p, left);
+		if (n <= 0) {
+			session_log(s, "ERROR: Can't write %s", in->path);
+			in->broken = true;
+			return 0;
+		}
+		p += n;
+		left -= n;
+	}
+
+	return 0;
+}
+
+static int end_file(Session* s, Incoming* in) {
+	Cursor c = {s->frame.data, s->frame.len, false};
+	uint64_t hash = get_uint(&c, 8);
+	if (c.bad || !in->active || in->received != in->size - in->offset)
+		return -1;
+
+	bool ok = !in->broken;
+	if (ok && hash != in->hash) {
+		session_log(s, "ERROR: %s arrived damaged", in->path);
+		ok = false;
+	}
+	if (ok) {
+		struct timespec times[2] = {{in->mtime, 0}, {in->mtime, 0}};
+		ok = futimens(in->fd, times) == 0;
+	}
+	if (close(in->fd) != 0)
+		ok = false;
+	in->fd = -1;
+	if (ok && rename(in->part, in->target) != 0) {
+		session_log(s, "ERROR: Can't replace %s", in->path);
+		ok = false;
+	}
+	in->active = false;
+
+	if (!ok) {
+		unlink(in->part);
+		__sync_fetch_and_add(&s->progress->files_failed, 1);
+		return 0;
+	}
+
+	SyncManifest_append(&s->received[in->root], in->path, in->size, in->mtime, in->hash);
+	session_log(s, "<- %s/%s", s->config->roots[in->root].name, in->path);
+	__sync_fetch_and_add(&s->progress->files_received, 1);
+	__sync_fetch_and_add(&s->progress->files_done, 1);
+	return 0;
+}
+
+static int skip_file(Session* s, Incoming* in) {
+	Cursor c = {s->frame.data, s->frame.len, false};
+	uint32_t index = get_uint(&c, 4);
+	if (c.bad)
+		return -1;
+
+	if (in->active) {
+		// Aborted mid-file, keep what arrived for the next attempt
+		incoming_discard(in);
+	} else if (index < (uint32_t)s->peer_base[s->config->root_count]) {
+		s->wanted[index] = false;
+	}
+	__sync_fetch_and_add(&s->progress->files_failed, 1);
+	return 0;
+}
+
+// Files the peer never sent count as failed
+static int check_all_received(Session* s) {
+	int missing = 0;
+	for (int i = 0; i < s->peer_base[s->config->root_count]; i++)
+		missing += s->wanted[i];
+	if (missing)
+		__sync_fetch_and_add(&s->progress->files_failed, missing);
+	return 0;
+}
+
+// Handle frames until the peer is done sending
+static int receive_files(Session* s) {
+	Incoming in = {.fd = -1};
+	int ret = 0;
+	while (ret == 0) {
+		int type = read_frame(s, IO_TIMEOUT_SEC);
+		switch (type) {
+		case MSG_WANT:
+			ret = s->peer_wants ? -1 : read_peer_wants(s);
+			break;
+		case MSG_FILE:
+			ret = begin_file(s, &in);
+			break;
+		case MSG_DATA:
+			ret = write_data(s, &in);
+			break;
+		case MSG_END:
+			ret = end_file(s, &in);
+			break;
+		case MSG_SKIP:
+			ret = skip_file(s, &in);
+			break;
+		case MSG_DONE:
+			if (in.active)
+				ret = -1;
+			else
+				return check_all_received(s);
+			break;
+		default:
+			if (type >= 0)
+				session_log(s, "ERROR: Invalid message from peer");
+			ret = -1;
+			break;
+		}
+	}
+	incoming_discard(&in);
+	return -1;
+}
+
+///////////////////////////////
+// Session
+
+static void manifest_path(const SyncConfig* config, int root, char* out, size_t size) {
+	snprintf(out, size, "%s/%s.manifest", config->state_dir, config->roots[root].name);
+}
+
+static int scan_roots(Session* s) {
+	const SyncConfig* config = s->config;
+	for (int r = 0; r < config->root_count; r++) {
+		char path[PATH_MAX];
+		manifest_path(config, r, path, sizeof(path));
+		SyncManifest_load(&s->local[r], path);
+		if (SyncManifest_scan(&s->local[r], config->roots[r].path, config->roots[r].excludes,
+							  config->cancel, &s->progress->files_scanned) != 0)
+			return -1;
+	}
+
+	s->local_base[0] = 0;
+	for (int r = 0; r < config->root_count; r++)
+		s->local_base[r + 1] = s->local_base[r] + s->local[r].count;
+	session_log(s, "%d files on this device", s->local_base[config->root_count]);
+	return 0;
+}
+
+static void save_manifests(Session* s) {
+	const SyncConfig* config = s->config;
+	make_parent_dirs(config->state_dir);
+	mkdir(config->state_dir, 0755);
+	for (int r = 0; r < config->root_count; r++) {
+		SyncManifest* received = &s->received[r];
+		for (int i = 0; i < received->count; i++) {
+			const SyncEntry* e = &received->entries[i];
+			SyncManifest_set(&s->local[r], e->path, e->size, e->mtime, e->hash);
+		}
+
+		char path[PATH_MAX];
+		manifest_path(config, r, path, sizeof(path));
+		SyncManifest_save(&s->local[r], path);
+	}
+}
+
+int SyncEngine_run(const SyncConfig* config, SyncProgress* progress) {
+	if (config->root_count < 1 || config->root_count > SYNC_MAX_ROOTS)
+		return -1;
+
+	Session* s = calloc(1, sizeof(Session));
+	if (!s)
+		return -1;
+	s->config = config;
+	s->progress = progress;
+	s->out = malloc(OUT_BUFFER);
+	s->in = malloc(IN_BUFFER);
+	pthread_mutex_init(&s->mutex, NULL);
+	pthread_cond_init(&s->cond, NULL);
+	memset(progress, 0, sizeof(*progress));
+
+	int ret = -1;
+	bool scanned = false;
+	pthread_t sender;
+	bool sender_started = false;
+
+	progress->stage = SYNC_STAGE_CONNECTING;
+	s->sock = (s->out && s->in) ? (config->is_server ? accept_peer(s) : connect_peer(s)) : -1;
+	if (s->sock < 0) {
+		if (!is_cancelled(s))
+			session_log(s, "ERROR: Could not connect to the other device");
+		goto finish;
+	}
+	set_nonblocking(s->sock);
+	int yes = 1;
+	setsockopt(s->sock, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+	if (pthread_create(&sender, NULL, sender_thread, s) != 0)
+		goto finish;
+	sender_started = true;
+
+	// Both devices scan at the same time, the peer's manifest waits in the
+	// socket until this side is ready for it
+	progress->stage = SYNC_STAGE_SCANNING;
+	session_log(s, "Scanning files...");
+	if (scan_roots(s) != 0)
+		goto finish;
+	scanned = true;
+	signal_flag(s, &s->manifest_ready);
+
+	progress->stage = SYNC_STAGE_COMPARING;
+	session_log(s, "Comparing with the other device...");
+	// The peer may still be scanning, which has no time limit
+	if (read_frame(s, 0) != MSG_HELLO || check_hello(s) != 0)
+		goto finish;
+	if (read_frame(s, 0) != MSG_MANIFEST || decode_manifest(s) != 0) {
+		if (!is_cancelled(s))
+			session_log(s, "ERROR: Invalid file list from the other device");
+		goto finish;
+	}
+
+	plan_wants(s);
+	if (!s->wanted || !s->wants)
+		goto finish;
+	session_log(s, "%d files to receive", s->want_count);
+	progress->stage = SYNC_STAGE_TRANSFERRING;
+	signal_flag(s, &s->wants_ready);
+
+	if (receive_files(s) != 0)
+		goto finish;
+
+	// Everything from the peer is in, wait for our side to go out
+	pthread_join(sender, NULL);
+	sender_started = false;
+	if (!s->failed && !is_cancelled(s))
+		ret = progress->files_failed ? -1 : 0;
+
+finish:
+	if (ret != 0 || sender_started)
+		session_fail(s);
+	if (sender_started)
+		pthread_join(sender, NULL);
+	if (s->sock >= 0)
+		close(s->sock);
+	if (scanned) {
+		save_manifests(s);
+		sync();
+	}
+	progress->stage = SYNC_STAGE_DONE;
+
+	for (int r = 0; r < SYNC_MAX_ROOTS; r++) {
+		SyncManifest_free(&s->local[r]);
+		SyncManifest_free(&s->peer[r]);
+		SyncManifest_free(&s->received[r]);
+	}
+	free(s->wanted);
+	free(s->wants);
+	free(s->peer_wants);
+	free(s->frame.data);
+	free(s->out);
+	free(s->in);
+	pthread_mutex_destroy(&s->mutex);
+	pthread_cond_destroy(&s->cond);
+	free(s);
+	return ret;
+}
@@ -0,0 +1,61 @@
+#ifndef __SYNC_ENGINE_H__
+#define __SYNC_ENGINE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Two-way sync of a set of directories between two devices over a single
+// TCP session:
+//   1. both sides rescan their manifests (sync_manifest.h)
+//   2. manifests are exchanged once
+//   3. each side works out which of the peer's files it needs (newer or
+//      missing here) and asks for them, resuming partial downloads
+//   4. both sides stream the requested files at the same time, back to
+//      back, without waiting for per-file replies
+// Files are never deleted, a file missing on one side is copied over.
+
+#define SYNC_MAX_ROOTS 8
+
+typedef struct {
+	const char* name;			 // Identifies the root on both devices, e.g. "saves"
+	const char* path;			 // Local directory
+	const char* const* excludes; // NULL terminated file names never synced, or NULL
+} SyncRoot;
+
+typedef struct {
+	const SyncRoot* roots; // Same names in the same order on both devices
+	int root_count;
+	const char* state_dir; // Where this device keeps its manifests
+	bool is_server;		   // Server listens, client connects to peer_ip
+	const char* peer_ip;
+	int port;
+	int connect_timeout_sec;
+	const volatile bool* cancel;
+	void (*log)(const char* line); // Optional
+} SyncConfig;
+
+enum SyncStage {
+	SYNC_STAGE_CONNECTING,
+	SYNC_STAGE_SCANNING,
+	SYNC_STAGE_COMPARING,
+	SYNC_STAGE_TRANSFERRING,
+	SYNC_STAGE_DONE,
+};
+
+typedef struct {
+	volatile int stage;
+	volatile int files_scanned;
+	volatile int files_total; // Both directions, known once the plan is exchanged
+	volatile int files_done;
+	volatile int files_sent;
+	volatile int files_received;
+	volatile int files_failed;
+	volatile int64_t bytes_total;
+	volatile int64_t bytes_done;
+} SyncProgress;
+
+// Run one session. progress is updated as it goes and may be read from
+// other threads. Returns 0 when every file was synced.
+int SyncEngine_run(const SyncConfig* config, SyncProgress* progress);
+
+#endif
@@ -0,0 +1,354 @@
+#include "sync_manifest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#define MANIFEST_MAGIC 0x4D534E58 // "XNSM"
+#define MANIFEST_VERSION 1
+#define HASH_CHUNK (64 * 1024)
+
+///////////////////////////////
+// Entries
+
+void SyncManifest_init(SyncManifest* manifest) {
+	memset(manifest, 0, sizeof(*manifest));
+}
+
+void SyncManifest_free(SyncManifest* manifest) {
+	for (int i = 0; i < manifest->count; i++)
+		free(manifest->entries[i].path);
+	free(manifest->entries);
+	SyncManifest_init(manifest);
+}
+
+static int compare_entries(const void* a, const void* b) {
+	return strcmp(((const SyncEntry*)a)->path, ((const SyncEntry*)b)->path);
+}
+
+// Index of path, or -(insertion point) - 1
+static int find_index(const SyncManifest* manifest, const char* path) {
+	int lo = 0;
+	int hi = manifest->count - 1;
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		int cmp = strcmp(manifest->entries[mid].path, path);
+		if (cmp == 0)
+			return mid;
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	return -lo - 1;
+}
+
+SyncEntry* SyncManifest_find(const SyncManifest* manifest, const char* path) {
+	int index = find_index(manifest, path);
+	return index >= 0 ? &manifest->entries[index] : NULL;
+}
+
+static int reserve(SyncManifest* manifest, int count) {
+	if (count <= manifest->capacity)
+		return 0;
+	int capacity = manifest->capacity ? manifest->capacity * 2 : 256;
+	while (capacity < count)
+		capacity *= 2;
+	SyncEntry* entries = realloc(manifest->entries, capacity * sizeof(SyncEntry));
+	if (!entries)
+		return -1;
+	manifest->entries = entries;
+	manifest->capacity = capacity;
+	return 0;
+}
+
+SyncEntry* SyncManifest_append(SyncManifest* manifest, const char* path, uint64_t size, int64_t mtime, uint64_t hash) {
+	if (reserve(manifest, manifest->count + 1) != 0)
+		return NULL;
+	char* copy = strdup(path);
+	if (!copy)
+		return NULL;
+
+	SyncEntry* entry = &manifest->entries[manifest->count++];
+	entry->path = copy;
+	entry->size = size;
+	entry->mtime = mtime;
+	entry->hash = hash;
+	return entry;
+}
+
+SyncEntry* SyncManifest_set(SyncManifest* manifest, const char* path, uint64_t size, int64_t mtime, uint64_t hash) {
+	int index = find_index(manifest, path);
+	if (index < 0) {
+		index = -index - 1;
+		if (!SyncManifest_append(manifest, path, size, mtime, hash))
+			return NULL;
+		// Move the appended entry into place
+		SyncEntry entry = manifest->entries[manifest->count - 1];
+		memmove(&manifest->entries[index + 1], &manifest->entries[index],
+				(manifest->count - 1 - index) * sizeof(SyncEntry));
+		manifest->entries[index] = entry;
+		return &manifest->entries[index];
+	}
+
+	SyncEntry* entry = &manifest->entries[index];
+	entry->size = size;
+	entry->mtime = mtime;
+	entry->hash = hash;
+	return entry;
+}
+
+void SyncManifest_sort(SyncManifest* manifest) {
+	if (manifest->count > 1)
+		qsort(manifest->entries, manifest->count, sizeof(SyncEntry), compare_entries);
+}
+
+///////////////////////////////
+// Hashing
+
+uint64_t SyncManifest_hash(uint64_t hash, const void* data, size_t len) {
+	const uint8_t* p = data;
+	for (size_t i = 0; i < len; i++) {
+		hash ^= p[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+int SyncManifest_hashFd(int fd, uint64_t length, uint64_t* hash) {
+	uint8_t* buffer = malloc(HASH_CHUNK);
+	if (!buffer)
+		return -1;
+
+	uint64_t h = *hash;
+	while (length > 0) {
+		size_t want = length < HASH_CHUNK ? (size_t)length : HASH_CHUNK;
+		ssize_t n = read(fd, buffer, want);
+		if (n <= 0) {
+			free(buffer);
+			return -1;
+		}
+		h = SyncManifest_hash(h, buffer, n);
+		length -= n;
+	}
+
+	free(buffer);
+	*hash = h;
+	return 0;
+}
+
+static uint64_t hash_file(const char* path, uint64_t size) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	uint64_t hash = SYNC_HASH_SEED;
+	if (SyncManifest_hashFd(fd, size, &hash) != 0)
+		hash = 0;
+	close(fd);
+	return hash;
+}
+
+///////////////////////////////
+// Persistence
+
+int SyncManifest_load(SyncManifest* manifest, const char* path) {
+	SyncManifest_init(manifest);
+
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return 0;
+
+	uint32_t header[3];
+	if (fread(header, sizeof(header), 1, file) != 1 || header[0] != MANIFEST_MAGIC || header[1] != MANIFEST_VERSION) {
+		fclose(file);
+		return 0;
+	}
+
+	uint32_t count = header[2];
+	char name[PATH_MAX];
+	for (uint32_t i = 0; i < count; i++) {
+		uint16_t len;
+		SyncEntry entry;
+		if (fread(&len, sizeof(len), 1, file) != 1 || len == 0 || len >= sizeof(name) ||
+			fread(name, len, 1, file) != 1 ||
+			fread(&entry.size, sizeof(entry.size), 1, file) != 1 ||
+			fread(&entry.mtime, sizeof(entry.mtime), 1, file) != 1 ||
+			fread(&entry.hash, sizeof(entry.hash), 1, file) != 1) {
+			// Truncated, start over with a full scan
+			SyncManifest_free(manifest);
+			break;
+		}
+		name[len] = '\0';
+		if (!SyncManifest_append(manifest, name, entry.size, entry.mtime, entry.hash)) {
+			SyncManifest_free(manifest);
+			fclose(file);
+			return -1;
+		}
+	}
+	fclose(file);
+
+	// Written sorted, but never trust the order a binary search relies on
+	SyncManifest_sort(manifest);
+	return 0;
+}
+
+int SyncManifest_save(const SyncManifest* manifest, const char* path) {
+	char temp_path[PATH_MAX];
+	snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+	FILE* file = fopen(temp_path, "wb");
+	if (!file)
+		return -1;
+
+	uint32_t header[3] = {MANIFEST_MAGIC, MANIFEST_VERSION, manifest->count};
+	bool ok = fwrite(header, sizeof(header), 1, file) == 1;
+	for (int i = 0; ok && i < manifest->count; i++) {
+		const SyncEntry* entry = &manifest->entries[i];
+		uint16_t len = strlen(entry->path);
+		ok = fwrite(&len, sizeof(len), 1, file) == 1 &&
+			 fwrite(entry->path, len, 1, file) == 1 &&
+			 fwrite(&entry->size, sizeof(entry->size), 1, file) == 1 &&
+			 fwrite(&entry->mtime, sizeof(entry->mtime), 1, file) == 1 &&
+			 fwrite(&entry->hash, sizeof(entry->hash), 1, file) == 1;
+	}
+	if (fflush(file) != 0)
+		ok = false;
+	if (ok)
+		fsync(fileno(file));
+	if (fclose(file) != 0)
+		ok = false;
+
+	if (!ok || rename(temp_path, path) != 0) {
+		unlink(temp_path);
+		return -1;
+	}
+	return 0;
+}
+
+///////////////////////////////
+// Scanning
+
+typedef struct {
+	SyncManifest* found;
+	const char* const* excludes;
+	const volatile bool* cancel;
+	volatile int* scanned;
+	char path[PATH_MAX]; // Absolute path being walked
+	size_t root_len;
+} ScanContext;
+
+static bool is_excluded(const ScanContext* ctx, const char* name) {
+	if (!ctx->excludes)
+		return false;
+	for (int i = 0; ctx->excludes[i]; i++) {
+		if (strcmp(ctx->excludes[i], name) == 0)
+			return true;
+	}
+	return false;
+}
+
+static bool is_partial(const char* name) {
+	size_t len = strlen(name);
+	size_t suffix_len = strlen(SYNC_PART_SUFFIX);
+	return len > suffix_len && strcmp(name + len - suffix_len, SYNC_PART_SUFFIX) == 0;
+}
+
+static int scan_dir(ScanContext* ctx) {
+	DIR* dir = opendir(ctx->path);
+	if (!dir)
+		return 0; // Unreadable directories are skipped, like missing ones
+
+	size_t dir_len = strlen(ctx->path);
+	struct dirent* ent;
+	int ret = 0;
+	while ((ent = readdir(dir)) != NULL) {
+		if (ctx->cancel && *ctx->cancel) {
+			ret = -1;
+			break;
+		}
+
+		const char* name = ent->d_name;
+		if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+			continue;
+		if (is_excluded(ctx, name) || is_partial(name))
+			continue;
+
+		size_t name_len = strlen(name);
+		if (dir_len + 1 + name_len >= sizeof(ctx->path))
+			continue;
+
+		struct stat st;
+		if (fstatat(dirfd(dir), name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+			continue;
+
+		ctx->path[dir_len] = '/';
+		memcpy(ctx->path + dir_len + 1, name, name_len + 1);
+
+		if (S_ISDIR(st.st_mode)) {
+			ret = scan_dir(ctx);
+		} else if (S_ISREG(st.st_mode)) {
+			// Hash is filled in by the caller
+			if (!SyncManifest_append(ctx->found, ctx->path + ctx->root_len + 1, st.st_size, st.st_mtime, 0))
+				ret = -1;
+			if (ctx->scanned)
+				(*ctx->scanned)++;
+		}
+		// Symlinks and special files are not synced
+
+		ctx->path[dir_len] = '\0';
+		if (ret != 0)
+			break;
+	}
+
+	closedir(dir);
+	return ret;
+}
+
+int SyncManifest_scan(SyncManifest* manifest, const char* root, const char* const* excludes,
+					  const volatile bool* cancel, volatile int* scanned) {
+	SyncManifest found;
+	SyncManifest_init(&found);
+
+	ScanContext ctx = {
+		.found = &found,
+		.excludes = excludes,
+		.cancel = cancel,
+		.scanned = scanned,
+	};
+	snprintf(ctx.path, sizeof(ctx.path), "%s", root);
+	ctx.root_len = strlen(ctx.path);
+	while (ctx.root_len > 1 && ctx.path[ctx.root_len - 1] == '/')
+		ctx.path[--ctx.root_len] = '\0';
+
+	if (scan_dir(&ctx) != 0) {
+		SyncManifest_free(&found);
+		return -1;
+	}
+	SyncManifest_sort(&found);
+
+	// Unchanged files keep their hash, small changed ones are hashed now
+	for (int i = 0; i < found.count; i++) {
+		if (cancel && *cancel) {
+			SyncManifest_free(&found);
+			return -1;
+		}
+
+		SyncEntry* entry = &found.entries[i];
+		SyncEntry* known = SyncManifest_find(manifest, entry->path);
+		if (known && known->size == entry->size && known->mtime == entry->mtime) {
+			entry->hash = known->hash;
+		} else if (entry->size <= SYNC_SCAN_HASH_MAX) {
+			snprintf(ctx.path + ctx.root_len, sizeof(ctx.path) - ctx.root_len, "/%s", entry->path);
+			entry->hash = hash_file(ctx.path, entry->size);
+		}
+	}
+
+	SyncManifest_free(manifest);
+	*manifest = found;
+	return 0;
+}
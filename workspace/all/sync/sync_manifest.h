@@ -0,0 +1,58 @@
+#ifndef __SYNC_MANIFEST_H__
+#define __SYNC_MANIFEST_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// What a device knows about one synced directory: every regular file with
+// its size, mtime and content hash. Kept on disk between syncs so a rescan
+// only has to stat files; content is only read again when size or mtime
+// changed.
+
+#define SYNC_HASH_SEED 0xcbf29ce484222325ULL // FNV-1a 64
+#define SYNC_SCAN_HASH_MAX (256 * 1024)		 // Bigger files are hashed when transferred
+#define SYNC_PART_SUFFIX ".syncpart"		 // Partial download, never synced itself
+
+typedef struct {
+	char* path; // Relative to the root, '/' separated
+	uint64_t size;
+	int64_t mtime;
+	uint64_t hash; // 0 = not hashed yet
+} SyncEntry;
+
+typedef struct {
+	SyncEntry* entries; // Sorted by path (strcmp)
+	int count;
+	int capacity;
+} SyncManifest;
+
+void SyncManifest_init(SyncManifest* manifest);
+void SyncManifest_free(SyncManifest* manifest);
+
+// Missing or invalid files load as an empty manifest. Returns 0 on success.
+int SyncManifest_load(SyncManifest* manifest, const char* path);
+int SyncManifest_save(const SyncManifest* manifest, const char* path);
+
+// Walk root and replace the manifest with what is on disk, reusing hashes
+// of files whose size and mtime did not change. excludes is a NULL
+// terminated list of file or directory names skipped at any depth.
+// scanned (optional) counts files as they are found.
+int SyncManifest_scan(SyncManifest* manifest, const char* root, const char* const* excludes,
+					  const volatile bool* cancel, volatile int* scanned);
+
+SyncEntry* SyncManifest_find(const SyncManifest* manifest, const char* path);
+
+// Insert or replace an entry, keeping the order. path is copied.
+SyncEntry* SyncManifest_set(SyncManifest* manifest, const char* path, uint64_t size, int64_t mtime, uint64_t hash);
+
+// Append without keeping the order (path is copied); call SyncManifest_sort after
+SyncEntry* SyncManifest_append(SyncManifest* manifest, const char* path, uint64_t size, int64_t mtime, uint64_t hash);
+void SyncManifest_sort(SyncManifest* manifest);
+
+uint64_t SyncManifest_hash(uint64_t hash, const void* data, size_t len);
+
+// Hash length bytes from fd's current position. Returns 0 on success.
+int SyncManifest_hashFd(int fd, uint64_t length, uint64_t* hash);
+
+#endif
@@ -0,0 +1,405 @@
+// Runs SyncEngine_run between two fake SD cards (a/ and b/) over loopback
+// and checks what ends up on each: the newer copy wins in both directions,
+// files missing on one side are copied, and an interrupted download resumes
+// from its .syncpart. A raw peer speaking the wire protocol then offers
+// paths that leave the root, which must never be asked for or written.
+// Run from an empty directory.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <zlib.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "sync_engine.h"
+#include "sync_manifest.h"
+
+#define ROOT_NAME "saves"
+#define BIG_SIZE (1024 * 1024)
+#define PARTIAL_SIZE 300000
+#define RESUME_FROM (PARTIAL_SIZE & ~(64 * 1024 - 1)) // what the engine trusts of it
+
+// Mirrors sync_engine.c
+#define PROTO_MAGIC 0x59534E58
+#define PROTO_VERSION 1
+enum {
+	MSG_HELLO = 1,
+	MSG_MANIFEST,
+	MSG_WANT,
+	MSG_FILE,
+	MSG_DATA,
+	MSG_END,
+	MSG_SKIP,
+	MSG_DONE,
+};
+
+static int port;
+static int failures = 0;
+
+static void expect(int ok, const char* what) {
+	printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok)
+		failures += 1;
+}
+
+static void quiet(const char* line) {
+}
+
+///////////////////////////////
+// Files
+
+static void putFile(const char* path, const char* data, size_t size, int64_t mtime) {
+	char dir[PATH_MAX];
+	snprintf(dir, sizeof(dir), "%s", path);
+	for (char* p = dir + 1; *p; p++) {
+		if (*p == '/') {
+			*p = '\0';
+			mkdir(dir, 0755);
+			*p = '/';
+		}
+	}
+	FILE* file = fopen(path, "w");
+	if (!file)
+		return;
+	fwrite(data, 1, size, file);
+	fclose(file);
+	struct timeval times[2] = {{mtime, 0}, {mtime, 0}};
+	utimes(path, times);
+}
+
+static void putText(const char* path, const char* text, int64_t mtime) {
+	putFile(path, text, strlen(text), mtime);
+}
+
+// Whole file, or NULL if missing
+static char* getFile(const char* path, size_t* size) {
+	FILE* file = fopen(path, "r");
+	if (!file)
+		return NULL;
+	fseek(file, 0, SEEK_END);
+	*size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	char* data = malloc(*size + 1);
+	*size = fread(data, 1, *size, file);
+	data[*size] = '\0';
+	fclose(file);
+	return data;
+}
+
+static int hasText(const char* path, const char* text, int64_t mtime) {
+	size_t size = 0;
+	char* data = getFile(path, &size);
+	struct stat st;
+	int ok = data && strcmp(data, text) == 0 && stat(path, &st) == 0 && st.st_mtime == mtime;
+	free(data);
+	return ok;
+}
+
+static int exists(const char* path) {
+	return access(path, F_OK) == 0;
+}
+
+///////////////////////////////
+// Two engines
+
+typedef struct {
+	SyncRoot root;
+	SyncConfig config;
+	SyncProgress progress;
+	int result;
+} Side;
+
+static void initSide(Side* side, const char* dir, bool is_server) {
+	static char paths[2][2][32];
+	int i = is_server ? 0 : 1;
+	snprintf(paths[i][0], sizeof(paths[i][0]), "%s/saves", dir);
+	snprintf(paths[i][1], sizeof(paths[i][1]), "%s/state", dir);
+	memset(side, 0, sizeof(*side));
+	side->root.name = ROOT_NAME;
+	side->root.path = paths[i][0];
+	side->config.roots = &side->root;
+	side->config.root_count = 1;
+	side->config.state_dir = paths[i][1];
+	side->config.is_server = is_server;
+	side->config.peer_ip = "127.0.0.1";
+	side->config.port = port;
+	side->config.connect_timeout_sec = 5;
+	side->config.log = quiet;
+}
+
+static void* runSide(void* arg) {
+	Side* side = arg;
+	side->result = SyncEngine_run(&side->config, &side->progress);
+	return NULL;
+}
+
+// a/ serves, b/ connects
+static void syncBoth(Side* a, Side* b) {
+	initSide(a, "a", true);
+	initSide(b, "b", false);
+	pthread_t server;
+	pthread_create(&server, NULL, runSide, a);
+	runSide(b);
+	pthread_join(server, NULL);
+}
+
+///////////////////////////////
+// Raw peer
+
+typedef struct {
+	uint8_t* data;
+	size_t len;
+} Message;
+
+static void put(Message* m, uint64_t value, int bytes) {
+	m->data = realloc(m->data, m->len + bytes);
+	for (int i = 0; i < bytes; i++)
+		m->data[m->len++] = value >> (8 * i);
+}
+
+static void putBytes(Message* m, const void* data, size_t len) {
+	m->data = realloc(m->data, m->len + len);
+	memcpy(m->data + m->len, data, len);
+	m->len += len;
+}
+
+static int sendAll(int sock, const void* data, size_t len) {
+	const uint8_t* p = data;
+	while (len > 0) {
+		ssize_t n = send(sock, p, len, MSG_NOSIGNAL);
+		if (n <= 0)
+			return -1;
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+// Sends and frees the message
+static int sendMessage(int sock, int type, Message* m) {
+	uint8_t header[5] = {type, m->len, m->len >> 8, m->len >> 16, m->len >> 24};
+	int ret = sendAll(sock, header, sizeof(header));
+	if (ret == 0 && m->len)
+		ret = sendAll(sock, m->data, m->len);
+	free(m->data);
+	m->data = NULL;
+	m->len = 0;
+	return ret;
+}
+
+static int recvAll(int sock, void* data, size_t len) {
+	uint8_t* p = data;
+	while (len > 0) {
+		ssize_t n = recv(sock, p, len, 0);
+		if (n <= 0)
+			return -1;
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+// Returns the type and fills m, -1 once the connection is gone
+static int recvMessage(int sock, Message* m) {
+	uint8_t header[5];
+	if (recvAll(sock, header, sizeof(header)) != 0)
+		return -1;
+	m->len = header[1] | header[2] << 8 | header[3] << 16 | (size_t)header[4] << 24;
+	m->data = realloc(m->data, m->len ? m->len : 1);
+	return recvAll(sock, m->data, m->len) == 0 ? header[0] : -1;
+}
+
+static uint64_t get(const uint8_t* p, int bytes) {
+	uint64_t value = 0;
+	for (int i = 0; i < bytes; i++)
+		value |= (uint64_t)p[i] << (8 * i);
+	return value;
+}
+
+static const char* offered[] = {
+	"../escape.sav",
+	"/tmp/absolute.sav",
+	"dir/../../up.sav",
+	"./dot.sav",
+	"dir//empty.sav",
+	"ok.sav", // the only one that may be asked for
+};
+#define OFFERED_COUNT (int)(sizeof(offered) / sizeof(offered[0]))
+#define OK_INDEX (OFFERED_COUNT - 1)
+#define PEER_TEXT "from the peer"
+#define PEER_MTIME 7000
+
+static int rawListen(void) {
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	int yes = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 1) < 0) {
+		close(listener);
+		return -1;
+	}
+	return listener;
+}
+
+static void sendFile(int sock, uint32_t index) {
+	Message m = {0};
+	size_t len = strlen(PEER_TEXT);
+	put(&m, index, 4);
+	put(&m, 0, 8);
+	put(&m, len, 8);
+	put(&m, PEER_MTIME, 8);
+	sendMessage(sock, MSG_FILE, &m);
+	putBytes(&m, PEER_TEXT, len);
+	sendMessage(sock, MSG_DATA, &m);
+	put(&m, SyncManifest_hash(SYNC_HASH_SEED, PEER_TEXT, len), 8);
+	sendMessage(sock, MSG_END, &m);
+}
+
+// Serves b/ a manifest of offered[], then pushes offered[push] whether it
+// was asked for or not. Returns the engine's result, wanted gets the
+// indexes it asked for.
+static int rawPeer(int push, int* wanted, int* wanted_count) {
+	Side b;
+	initSide(&b, "b", false);
+	*wanted_count = -1;
+
+	int listener = rawListen();
+	if (listener < 0)
+		return -2;
+	pthread_t engine;
+	pthread_create(&engine, NULL, runSide, &b);
+	int sock = accept(listener, NULL, NULL);
+	close(listener);
+
+	Message m = {0};
+	put(&m, PROTO_MAGIC, 4);
+	put(&m, PROTO_VERSION, 2);
+	put(&m, 1, 1);
+	put(&m, strlen(ROOT_NAME), 1);
+	putBytes(&m, ROOT_NAME, strlen(ROOT_NAME));
+	sendMessage(sock, MSG_HELLO, &m);
+
+	Message raw = {0};
+	for (int i = 0; i < OFFERED_COUNT; i++) {
+		put(&raw, 0, 1);
+		put(&raw, strlen(offered[i]), 2);
+		putBytes(&raw, offered[i], strlen(offered[i]));
+		put(&raw, strlen(PEER_TEXT), 8);
+		put(&raw, PEER_MTIME, 8);
+		put(&raw, 0, 8);
+	}
+	uLongf packed = compressBound(raw.len);
+	put(&m, OFFERED_COUNT, 4);
+	put(&m, raw.len, 4);
+	m.data = realloc(m.data, m.len + packed);
+	compress2(m.data + m.len, &packed, raw.data, raw.len, 1);
+	m.len += packed;
+	free(raw.data);
+	sendMessage(sock, MSG_MANIFEST, &m);
+
+	// The engine's HELLO and MANIFEST come first
+	int type;
+	while ((type = recvMessage(sock, &m)) > 0 && type != MSG_WANT)
+		;
+	if (type == MSG_WANT && m.len >= 4) {
+		int count = get(m.data, 4);
+		if (m.len == 4 + (size_t)count * 12) {
+			*wanted_count = count;
+			for (int i = 0; i < count && i < OFFERED_COUNT; i++)
+				wanted[i] = get(m.data + 4 + i * 12, 4);
+		}
+	}
+	free(m.data);
+	m.data = NULL;
+	m.len = 0;
+
+	put(&m, 0, 4);
+	sendMessage(sock, MSG_WANT, &m);
+	sendFile(sock, push);
+	sendMessage(sock, MSG_DONE, &m);
+
+	// Drain until the engine is done with the connection
+	while (recvMessage(sock, &m) > 0)
+		;
+	free(m.data);
+	close(sock);
+	pthread_join(engine, NULL);
+	return b.result;
+}
+
+///////////////////////////////
+
+int main(int argc, char* argv[]) {
+	port = 40000 + getpid() % 20000;
+	Side a, b;
+
+	// Newer wins both ways, missing files are copied both ways
+	putText("a/saves/older_on_a.sav", "a old", 1000);
+	putText("b/saves/older_on_a.sav", "b new", 2000);
+	putText("a/saves/newer_on_a.sav", "a new", 4000);
+	putText("b/saves/newer_on_a.sav", "b old", 3000);
+	putText("a/saves/only_a.sav", "only a", 1500);
+	putText("b/saves/deep/dir/only_b.sav", "only b", 2500);
+	syncBoth(&a, &b);
+	expect(a.result == 0 && b.result == 0, "first sync succeeds on both sides");
+	expect(hasText("a/saves/older_on_a.sav", "b new", 2000), "b's newer copy replaced a's");
+	expect(hasText("b/saves/older_on_a.sav", "b new", 2000), "b kept its newer copy");
+	expect(hasText("b/saves/newer_on_a.sav", "a new", 4000), "a's newer copy replaced b's");
+	expect(hasText("a/saves/newer_on_a.sav", "a new", 4000), "a kept its newer copy");
+	expect(hasText("b/saves/only_a.sav", "only a", 1500), "file only on a copied to b");
+	expect(hasText("a/saves/deep/dir/only_b.sav", "only b", 2500), "file only on b copied to a, directories made");
+	expect(a.progress.files_sent == 2 && a.progress.files_received == 2, "a sent 2 and received 2");
+
+	syncBoth(&a, &b);
+	expect(a.result == 0 && b.result == 0 && a.progress.files_total == 0, "second sync has nothing to do");
+
+	// Resume: a has the first PARTIAL_SIZE bytes of b's file from an
+	// interrupted sync, stamped with the version it belongs to
+	char* big = malloc(BIG_SIZE);
+	for (int i = 0; i < BIG_SIZE; i++)
+		big[i] = (char)(i * 131 + (i >> 12));
+	putFile("b/saves/big.bin", big, BIG_SIZE, 5000);
+	putFile("a/saves/big.bin" SYNC_PART_SUFFIX, big, PARTIAL_SIZE, 5000);
+	syncBoth(&a, &b);
+	size_t size = 0;
+	char* copy = getFile("a/saves/big.bin", &size);
+	expect(a.result == 0 && b.result == 0, "resumed sync succeeds");
+	expect(copy && size == BIG_SIZE && memcmp(copy, big, BIG_SIZE) == 0, "resumed file matches the source");
+	expect(a.progress.bytes_done == BIG_SIZE - RESUME_FROM, "only the missing tail was transferred");
+	expect(!exists("a/saves/big.bin" SYNC_PART_SUFFIX), ".syncpart renamed into place");
+	expect(!exists("b/saves/big.bin" SYNC_PART_SUFFIX), ".syncpart never synced itself");
+	free(copy);
+	free(big);
+
+	// Unsafe paths from the peer are neither asked for nor accepted
+	int wanted[OFFERED_COUNT];
+	int wanted_count;
+	int result = rawPeer(OK_INDEX, wanted, &wanted_count);
+	expect(wanted_count == 1 && wanted[0] == OK_INDEX, "only the safe path was asked for");
+	expect(result == 0 && hasText("b/saves/ok.sav", PEER_TEXT, PEER_MTIME), "safe path written");
+	for (int i = 0; i < OK_INDEX; i++) {
+		char what[128];
+		result = rawPeer(i, wanted, &wanted_count);
+		snprintf(what, sizeof(what), "pushing %s unasked ends the session", offered[i]);
+		expect(result != 0, what);
+	}
+	expect(!exists("escape.sav") && !exists("b/escape.sav") && !exists("b/up.sav") && !exists("b/saves/dot.sav") &&
+			   !exists("/tmp/absolute.sav") && !exists("b/saves/dir/empty.sav"),
+		   "nothing written outside or around the root");
+
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
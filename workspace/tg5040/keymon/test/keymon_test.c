@@ -0,0 +1,180 @@
+// Runs a keymon built against fifos (dev/event0-4), a plain file mute gpio
+// (dev/mute) and msettings_stub.c, then feeds it key events and counts both
+// the settings it changes and how often it gets scheduled while idle.
+// Usage: keymon_test <keymon binary>, run from an empty directory.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <linux/input.h>
+
+#define CODE_MENU2 316
+#define CODE_PLUS 115
+#define CODE_MINUS 114
+
+#define INPUT_COUNT 5
+#define IDLE_WAKEUPS_MAX 2 // a blocked epoll_wait shouldn't be woken at all
+
+static int inputs[INPUT_COUNT];
+static int failures = 0;
+
+static void expect(int ok, const char* what, long value) {
+	printf("%s %s: %li\n", ok ? "PASS" : "FAIL", what, value);
+	if (!ok)
+		failures += 1;
+}
+
+static long getWakeups(pid_t pid) {
+	char path[64];
+	char line[256];
+	long voluntary = 0;
+	long involuntary = 0;
+	snprintf(path, sizeof(path), "/proc/%i/status", pid);
+	FILE* file = fopen(path, "r");
+	if (!file)
+		return -1;
+	while (fgets(line, sizeof(line), file)) {
+		sscanf(line, "voluntary_ctxt_switches: %li", &voluntary);
+		sscanf(line, "nonvoluntary_ctxt_switches: %li", &involuntary);
+	}
+	fclose(file);
+	return voluntary + involuntary;
+}
+
+static long idleWakeups(pid_t pid, int ms) {
+	long start = getWakeups(pid);
+	usleep(ms * 1000);
+	return getWakeups(pid) - start;
+}
+
+static int countSetting(const char* name) {
+	char line[64];
+	int count = 0;
+	size_t length = strlen(name);
+	FILE* file = fopen("settings.log", "r");
+	if (!file)
+		return 0;
+	while (fgets(line, sizeof(line), file)) {
+		if (strncmp(line, name, length) == 0 && line[length] == ' ')
+			count += 1;
+	}
+	fclose(file);
+	return count;
+}
+
+static void sendKey(int fd, int code, int value) {
+	struct input_event event = {0};
+	event.type = EV_KEY;
+	event.code = code;
+	event.value = value;
+	if (write(fd, &event, sizeof(event)) != sizeof(event)) {
+		perror("sendKey");
+		failures += 1;
+	}
+}
+
+static void putFile(const char* path, const char* value) {
+	FILE* file = fopen(path, "w");
+	if (!file)
+		return;
+	fputs(value, file);
+	fclose(file);
+}
+
+static pid_t launch(const char* keymon) {
+	unlink("settings.log");
+	// O_RDWR keeps a writer on each fifo so keymon's opens don't block
+	char path[32];
+	for (int i = 0; i < INPUT_COUNT; i++) {
+		sprintf(path, "dev/event%i", i);
+		unlink(path);
+		mkfifo(path, 0600);
+		inputs[i] = open(path, O_RDWR);
+	}
+
+	pid_t pid = fork();
+	if (pid == 0) {
+		// keep keymon's own perror() output out of the report
+		int null_fd = open("/dev/null", O_WRONLY);
+		dup2(null_fd, STDERR_FILENO);
+		execl(keymon, keymon, NULL);
+		_exit(127);
+	}
+	usleep(300 * 1000);
+	return pid;
+}
+
+static void stop(pid_t pid) {
+	int status = 0;
+	kill(pid, SIGTERM);
+	waitpid(pid, &status, 0);
+	expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "exit status on SIGTERM", WEXITSTATUS(status));
+	for (int i = 0; i < INPUT_COUNT; i++) {
+		if (inputs[i] >= 0)
+			close(inputs[i]);
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <keymon binary>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	const char* keymon = argv[1];
+	mkdir("dev", 0700);
+
+	// No mute gpio, nothing to poll
+	unlink("dev/mute");
+	unlink("dev/edge");
+	pid_t pid = launch(keymon);
+
+	long wakeups = idleWakeups(pid, 5000);
+	expect(wakeups >= 0 && wakeups <= IDLE_WAKEUPS_MAX, "wakeups idle for 5 s", wakeups);
+
+	// 1 step on press, then one at 300 ms and every 100 ms after: 300 to
+	// 1000 ms is 8 more. Released halfway between two repeats so scheduling
+	// jitter can't add or drop one
+	sendKey(inputs[2], CODE_PLUS, 1);
+	usleep(1050 * 1000);
+	sendKey(inputs[2], CODE_PLUS, 0);
+	usleep(300 * 1000);
+	int steps = countSetting("volume");
+	expect(steps == 9, "volume steps holding + for 1.05 s", steps);
+
+	sendKey(inputs[0], CODE_MENU2, 1);
+	sendKey(inputs[0], CODE_MINUS, 1);
+	sendKey(inputs[0], CODE_MINUS, 0);
+	sendKey(inputs[0], CODE_MENU2, 0);
+	usleep(100 * 1000);
+	steps = countSetting("brightness");
+	expect(steps == 1, "brightness steps for menu + -", steps);
+
+	wakeups = idleWakeups(pid, 2000);
+	expect(wakeups <= IDLE_WAKEUPS_MAX, "wakeups idle for 2 s after the keys were released", wakeups);
+
+	// Losing the last writer hangs up the fifo, like an unplugged device
+	close(inputs[3]);
+	inputs[3] = -1;
+	usleep(200 * 1000);
+	wakeups = idleWakeups(pid, 1000);
+	expect(wakeups <= IDLE_WAKEUPS_MAX, "wakeups idle for 1 s after a device went away", wakeups);
+	stop(pid);
+
+	// A plain file can't raise POLLPRI, so this takes the timer fallback
+	putFile("dev/mute", "0\n");
+	putFile("dev/edge", "none\n");
+	pid = launch(keymon);
+	putFile("dev/mute", "1\n");
+	usleep(500 * 1000);
+	steps = countSetting("mute");
+	expect(steps == 2, "mute updates after the switch moved (initial + change)", steps);
+	stop(pid);
+
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
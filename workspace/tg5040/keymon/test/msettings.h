@@ -0,0 +1,21 @@
+#ifndef __MSETTINGS_H__
+#define __MSETTINGS_H__
+
+// The parts of libmsettings keymon uses, see msettings_stub.c
+
+void InitSettings(void);
+
+int GetBrightness(void);
+int GetColortemp(void);
+int GetVolume(void);
+
+void SetBrightness(int value); // 0-10
+void SetColortemp(int value);  // 0-40
+void SetVolume(int value);	   // 0-20
+
+void SetJack(int value); // 0-1
+
+int GetMute(void);
+void SetMute(int value); // 0-1
+
+#endif
@@ -0,0 +1,45 @@
+#include <stdio.h>
+
+#include "msettings.h"
+
+// Every setter appends "<name> <value>" to settings.log for keymon_test to count
+
+static int volume = 10;
+static int brightness = 5;
+static int colortemp = 20;
+static int mute = 0;
+
+static void record(const char* name, int value) {
+	FILE* file = fopen("settings.log", "a");
+	if (!file)
+		return;
+	fprintf(file, "%s %i\n", name, value);
+	fclose(file);
+}
+
+void InitSettings(void) {}
+
+int GetBrightness(void) { return brightness; }
+int GetColortemp(void) { return colortemp; }
+int GetVolume(void) { return volume; }
+
+void SetBrightness(int value) {
+	brightness = value;
+	record("brightness", value);
+}
+void SetColortemp(int value) {
+	colortemp = value;
+	record("colortemp", value);
+}
+void SetVolume(int value) {
+	volume = value;
+	record("volume", value);
+}
+
+void SetJack(int value) { record("jack", value); }
+
+int GetMute(void) { return mute; }
+void SetMute(int value) {
+	mute = value;
+	record("mute", value);
+}
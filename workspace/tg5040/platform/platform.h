@@ -147,6 +147,8 @@ extern int is_brick;
 
 #define MAX_LIGHTS 4
 
+#define CPU_FREQ_PATH "/sys/devices/system/cpu/cpu0/cpufreq"
+
 ///////////////////////////////
 
 #endif
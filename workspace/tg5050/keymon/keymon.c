@@ -4,9 +4,9 @@
 #include <unistd.h>
 #include <string.h>
 #include <fcntl.h>
-#include <dirent.h>
+#include <errno.h>
+#include <time.h>
 #include <linux/input.h>
-#include <pthread.h>
 #include <signal.h>
 
 #include <msettings.h>
@@ -14,6 +14,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
 
 // #include "defines.h"
 
@@ -39,56 +41,240 @@
 #define PRESSED 1
 #define REPEAT 2
 
+// test/makefile points these at fifos and plain files
+#ifndef INPUT_PATH
+#define INPUT_PATH "/dev/input/event%i"
+#endif
+#ifndef MUTE_STATE_PATH
 #define MUTE_STATE_PATH "/sys/class/gpio/gpio363/value"
+#endif
+#ifndef MUTE_EDGE_PATH
+#define MUTE_EDGE_PATH "/sys/class/gpio/gpio363/edge"
+#endif
+
+#define REPEAT_DELAY_MS 300
+#define REPEAT_INTERVAL_MS 100
+#define MUTE_POLL_MS 200	// only if the gpio can't raise an interrupt
+#define RUMBLE_PULSE_MS 100 // on, off, on, off
+#define SLEEP_GAP_MS 1000	// input older than a suspend this long is dropped
+
+// epoll_event.data.u32, inputs are SOURCE_INPUT + index
+enum {
+	SOURCE_MUTE,
+	SOURCE_MUTE_POLL,
+	SOURCE_REPEAT_UP,
+	SOURCE_REPEAT_DOWN,
+	SOURCE_RUMBLE,
+	SOURCE_INPUT,
+};
 
 #define INPUT_COUNT 5
 static int inputs[INPUT_COUNT] = {};
 static struct input_event ev;
 
+static int epoll_fd = -1;
+static int mute_fd = -1;
+static int mute_poll_fd = -1;
+static int repeat_up_fd = -1;
+static int repeat_down_fd = -1;
+static int rumble_fd = -1;
+
+static uint32_t menu_pressed = 0;
+static uint32_t menu2_pressed = 0;
+static int was_muted = 0;
+static int rumble_left = 0;
+
 static volatile int quit = 0;
 static void on_term(int sig) {
 	quit = 1;
 }
 
-static int getInt(char* path) {
-	int i = 0;
-	FILE* file = fopen(path, "r");
-	if (file != NULL) {
-		fscanf(file, "%i", &i);
-		fclose(file);
+///////////////////////////////
+
+static int watch(int fd, uint32_t events, uint32_t source) {
+	struct epoll_event event = {
+		.events = events,
+		.data.u32 = source,
+	};
+	return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+static int openTimer(uint32_t source) {
+	int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (fd >= 0 && watch(fd, EPOLLIN, source) != 0) {
+		close(fd);
+		fd = -1;
 	}
-	return i;
+	return fd;
+}
+static void setTimer(int fd, int delay_ms, int interval_ms) {
+	// a delay of 0 disarms
+	struct itimerspec spec = {
+		.it_value = {delay_ms / 1000, (delay_ms % 1000) * 1000000L},
+		.it_interval = {interval_ms / 1000, (interval_ms % 1000) * 1000000L},
+	};
+	timerfd_settime(fd, 0, &spec, NULL);
+}
+// returns 0 if the timer was disarmed or rearmed since epoll reported it
+static int ackTimer(int fd) {
+	uint64_t expirations;
+	return read(fd, &expirations, sizeof(expirations)) == sizeof(expirations);
 }
 
-static pthread_t mute_pt;
-static void* watchMute(void* arg) {
-	int is_muted, was_muted;
+// time spent suspended since boot, CLOCK_MONOTONIC stops during suspend
+static int64_t getSuspendedMs(void) {
+	struct timespec boot, mono;
+	clock_gettime(CLOCK_BOOTTIME, &boot);
+	clock_gettime(CLOCK_MONOTONIC, &mono);
+	return (int64_t)(boot.tv_sec - mono.tv_sec) * 1000 + (boot.tv_nsec - mono.tv_nsec) / 1000000;
+}
 
-	is_muted = was_muted = getInt(MUTE_STATE_PATH);
-	SetMute(is_muted);
+///////////////////////////////
 
-	while (!quit) {
-		usleep(200000); // 5 times per second
-
-		is_muted = getInt(MUTE_STATE_PATH);
-		// swallow mute val -1 on shutdown
-		if (is_muted >= 0 && was_muted != is_muted) {
-			was_muted = is_muted;
-			SetMute(is_muted);
-			if (GetMute()) {
-				// tmp solution
-				system("echo 32768 > /sys/class/motor/level");
-				usleep(100000);
-				system("echo 0 > /sys/class/motor/level");
-				usleep(100000);
-				system("echo 32768 > /sys/class/motor/level");
-				usleep(100000);
-				system("echo 0 > /sys/class/motor/level");
+static void putValue(const char* path, const char* value) {
+	int fd = open(path, O_WRONLY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+	if (write(fd, value, strlen(value)) < 0)
+		perror(path);
+	close(fd);
+}
+static void setRumble(int on) {
+	putValue("/sys/class/motor/level", on ? "32768" : "0");
+}
+static void stepRumble(void) {
+	rumble_left -= 1;
+	setRumble(rumble_left % 2);
+	if (rumble_left <= 0)
+		setTimer(rumble_fd, 0, 0);
+}
+static void startRumble(void) {
+	if (rumble_fd < 0)
+		return;
+	setRumble(1);
+	rumble_left = 3;
+	setTimer(rumble_fd, RUMBLE_PULSE_MS, RUMBLE_PULSE_MS);
+}
+
+static int getMute(void) {
+	char value[8];
+	if (mute_fd < 0 || lseek(mute_fd, 0, SEEK_SET) < 0)
+		return 0;
+	ssize_t size = read(mute_fd, value, sizeof(value) - 1);
+	if (size <= 0)
+		return 0;
+	value[size] = '\0';
+	return atoi(value);
+}
+static void checkMute(void) {
+	int is_muted = getMute();
+	// swallow mute val -1 on shutdown
+	if (is_muted >= 0 && was_muted != is_muted) {
+		was_muted = is_muted;
+		SetMute(is_muted);
+		if (GetMute())
+			startRumble();
+	}
+}
+static void initMute(void) {
+	mute_fd = open(MUTE_STATE_PATH, O_RDONLY | O_CLOEXEC);
+	was_muted = getMute(); // also clears the pending interrupt
+	SetMute(was_muted);
+	if (mute_fd < 0)
+		return;
+
+	// sysfs gpios report edges as POLLPRI once edge is set
+	int edge_fd = open(MUTE_EDGE_PATH, O_WRONLY | O_CLOEXEC);
+	int has_edge = edge_fd >= 0 && write(edge_fd, "both", 4) == 4;
+	if (edge_fd >= 0)
+		close(edge_fd);
+	if (has_edge && watch(mute_fd, EPOLLPRI | EPOLLERR, SOURCE_MUTE) == 0)
+		return;
+
+	mute_poll_fd = openTimer(SOURCE_MUTE_POLL);
+	if (mute_poll_fd >= 0)
+		setTimer(mute_poll_fd, MUTE_POLL_MS, MUTE_POLL_MS);
+}
+
+///////////////////////////////
+
+static void adjust(int delta) {
+	int val;
+	if (menu_pressed) {
+		val = GetBrightness() + delta;
+		if (val >= BRIGHTNESS_MIN && val <= BRIGHTNESS_MAX)
+			SetBrightness(val);
+	} else if (menu2_pressed) {
+		val = GetColortemp() + delta;
+		if (val >= COLORTEMP_MIN && val <= COLORTEMP_MAX)
+			SetColortemp(val);
+	} else {
+		val = GetVolume() + delta;
+		if (val >= VOLUME_MIN && val <= VOLUME_MAX)
+			SetVolume(val);
+	}
+}
+
+static void pressRepeat(int fd, int val, int delta) {
+	if (val) {
+		adjust(delta);
+		setTimer(fd, REPEAT_DELAY_MS, REPEAT_INTERVAL_MS);
+	} else {
+		setTimer(fd, 0, 0);
+	}
+}
+
+static void closeInput(int i) {
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, inputs[i], NULL);
+	close(inputs[i]);
+	inputs[i] = -1;
+}
+
+static void readInput(int i) {
+	uint32_t val;
+	while (read(inputs[i], &ev, sizeof(ev)) == sizeof(ev)) {
+		val = ev.value;
+		if (ev.type == EV_SW) {
+			//printf("switch: %i\n", ev.code);
+			if (ev.code == CODE_JACK) {
+				//printf("jack: %i\n", val);
+				SetJack(val);
 			}
 		}
+		if ((ev.type != EV_KEY) || (val > REPEAT))
+			continue;
+		//printf("code: %i (%i)\n", ev.code, val); fflush(stdout);
+		switch (ev.code) {
+		case CODE_MENU2:
+			menu_pressed = val;
+			break;
+		case CODE_MENU0:
+			menu2_pressed = val;
+			break;
+		case CODE_PLUS:
+			pressRepeat(repeat_up_fd, val, +1);
+			break;
+		case CODE_MINUS:
+			pressRepeat(repeat_down_fd, val, -1);
+			break;
+		default:
+			break;
+		}
 	}
+}
 
-	return NULL;
+// ignore input that arrived during sleep
+static void dropInput(void) {
+	for (int i = 0; i < INPUT_COUNT; i++) {
+		if (inputs[i] < 0)
+			continue;
+		while (read(inputs[i], &ev, sizeof(ev)) == sizeof(ev))
+			;
+	}
+	menu_pressed = 0;
+	menu2_pressed = 0;
+	setTimer(repeat_up_fd, 0, 0);
+	setTimer(repeat_down_fd, 0, 0);
 }
 
 int main(int argc, char* argv[]) {
@@ -97,143 +283,90 @@ int main(int argc, char* argv[]) {
 	sigaction(SIGTERM, &sa, NULL);
 
 	InitSettings();
-	pthread_create(&mute_pt, NULL, &watchMute, NULL);
+
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd < 0) {
+		perror("epoll_create1");
+		return EXIT_FAILURE;
+	}
+
+	initMute();
+	repeat_up_fd = openTimer(SOURCE_REPEAT_UP);
+	repeat_down_fd = openTimer(SOURCE_REPEAT_DOWN);
+	rumble_fd = openTimer(SOURCE_RUMBLE);
 
 	char path[32];
 	for (int i = 0; i < INPUT_COUNT; i++) {
-		sprintf(path, "/dev/input/event%i", i);
+		sprintf(path, INPUT_PATH, i);
 		inputs[i] = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+		if (inputs[i] >= 0 && watch(inputs[i], EPOLLIN, SOURCE_INPUT + i) != 0)
+			closeInput(i);
 	}
 
-	uint32_t input;
-	uint32_t val;
-	uint32_t menu_pressed = 0;
-	uint32_t menu2_pressed = 0;
-
-	uint32_t up_pressed = 0;
-	uint32_t up_just_pressed = 0;
-	uint32_t up_repeat_at = 0;
-
-	uint32_t down_pressed = 0;
-	uint32_t down_just_pressed = 0;
-	uint32_t down_repeat_at = 0;
-
-	uint8_t ignore;
-	uint32_t then;
-	uint32_t now;
-	struct timeval tod;
-
-	gettimeofday(&tod, NULL);
-	then = tod.tv_sec * 1000 + tod.tv_usec / 1000; // essential SDL_GetTicks()
-	ignore = 0;
+	struct epoll_event events[INPUT_COUNT + SOURCE_INPUT];
+	int64_t suspended_ms = getSuspendedMs();
 
 	while (!quit) {
-		gettimeofday(&tod, NULL);
-		now = tod.tv_sec * 1000 + tod.tv_usec / 1000;
-		if (now - then > 1000)
-			ignore = 1; // ignore input that arrived during sleep
-
-		for (int i = 0; i < INPUT_COUNT; i++) {
-			input = inputs[i];
-			while (read(input, &ev, sizeof(ev)) == sizeof(ev)) {
-				if (ignore)
-					continue;
-				val = ev.value;
-				if (ev.type == EV_SW) {
-					//printf("switch: %i\n", ev.code);
-					if (ev.code == CODE_JACK) {
-						//printf("jack: %i\n", val);
-						SetJack(val);
-					}
-				}
-				if ((ev.type != EV_KEY) || (val > REPEAT))
-					continue;
-				//printf("code: %i (%i)\n", ev.code, val); fflush(stdout);
-				switch (ev.code) {
-				case CODE_MENU2:
-					menu_pressed = val;
-					break;
-				case CODE_MENU0:
-					menu2_pressed = val;
-					break;
-				case CODE_PLUS:
-					up_pressed = up_just_pressed = val;
-					if (val)
-						up_repeat_at = now + 300;
-					break;
-				case CODE_MINUS:
-					down_pressed = down_just_pressed = val;
-					if (val)
-						down_repeat_at = now + 300;
-					break;
-				default:
-					break;
-				}
-			}
+		int count = epoll_wait(epoll_fd, events, INPUT_COUNT + SOURCE_INPUT, -1);
+		if (count < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("epoll_wait");
+			break;
 		}
 
-		if (ignore) {
-			menu_pressed = 0;
-			menu2_pressed = 0;
-			up_pressed = up_just_pressed = 0;
-			down_pressed = down_just_pressed = 0;
-			up_repeat_at = 0;
-			down_repeat_at = 0;
+		int64_t now_suspended_ms = getSuspendedMs();
+		if (now_suspended_ms - suspended_ms > SLEEP_GAP_MS) {
+			suspended_ms = now_suspended_ms;
+			dropInput();
+			continue;
 		}
-
-		if (up_just_pressed || (up_pressed && now >= up_repeat_at)) {
-			if (menu_pressed) {
-				val = GetBrightness();
-				if (val < BRIGHTNESS_MAX)
-					SetBrightness(++val);
-			} else if (menu2_pressed) {
-				val = GetColortemp();
-				if (val < COLORTEMP_MAX) {
-					SetColortemp(++val);
-				}
-			} else {
-				val = GetVolume();
-				if (val < VOLUME_MAX)
-					SetVolume(++val);
+		suspended_ms = now_suspended_ms;
+
+		for (int e = 0; e < count; e++) {
+			uint32_t source = events[e].data.u32;
+			switch (source) {
+			case SOURCE_MUTE:
+				checkMute();
+				break;
+			case SOURCE_MUTE_POLL:
+				if (ackTimer(mute_poll_fd))
+					checkMute();
+				break;
+			case SOURCE_REPEAT_UP:
+				if (ackTimer(repeat_up_fd))
+					adjust(+1);
+				break;
+			case SOURCE_REPEAT_DOWN:
+				if (ackTimer(repeat_down_fd))
+					adjust(-1);
+				break;
+			case SOURCE_RUMBLE:
+				if (ackTimer(rumble_fd))
+					stepRumble();
+				break;
+			default: {
+				int i = source - SOURCE_INPUT;
+				if (inputs[i] < 0)
+					break;
+				readInput(i);
+				// unplugged, don't spin on it
+				if (events[e].events & (EPOLLHUP | EPOLLERR))
+					closeInput(i);
+				break;
 			}
-
-			if (up_just_pressed)
-				up_just_pressed = 0;
-			else
-				up_repeat_at += 100;
-		}
-
-		if (down_just_pressed || (down_pressed && now >= down_repeat_at)) {
-			if (menu_pressed) {
-				val = GetBrightness();
-				if (val > BRIGHTNESS_MIN)
-					SetBrightness(--val);
-			} else if (menu2_pressed) {
-				val = GetColortemp();
-				if (val > COLORTEMP_MIN) {
-					SetColortemp(--val);
-				}
-			} else {
-				val = GetVolume();
-				if (val > VOLUME_MIN)
-					SetVolume(--val);
 			}
-
-			if (down_just_pressed)
-				down_just_pressed = 0;
-			else
-				down_repeat_at += 100;
 		}
-
-		then = now;
-		ignore = 0;
-
-		usleep(16666); // 60fps
 	}
 
-	for (int i = 0; i < INPUT_COUNT; i++)
-		close(inputs[i]);
+	if (rumble_left > 0)
+		setRumble(0);
 
-	pthread_cancel(mute_pt);
-	pthread_join(mute_pt, NULL);
+	for (int i = 0; i < INPUT_COUNT; i++) {
+		if (inputs[i] >= 0)
+			close(inputs[i]);
+	}
+	if (mute_fd >= 0)
+		close(mute_fd);
+	close(epoll_fd);
 }
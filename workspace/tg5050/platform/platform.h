@@ -145,6 +145,8 @@
 
 #define MAX_LIGHTS 4
 
+#define CPU_FREQ_PATH "/sys/devices/system/cpu/cpu4/cpufreq" // the big cluster minarch is pinned to
+
 ///////////////////////////////
 
 #endif